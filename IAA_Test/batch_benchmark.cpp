@@ -0,0 +1,243 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <immintrin.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+
+#include "hw_dispatcher.hpp"
+#include "hw_util.hpp"
+
+using namespace std;
+using qpl::ml::dispatcher::hw_dispatcher;
+
+static constexpr uint32_t page_sizes[]     = {4096u, 8192u, 16384u, 32768u, 65536u};
+static constexpr uint32_t default_pages    = 1024u;
+static constexpr uint32_t default_repeats  = 10u;
+static constexpr uint64_t wait_timeout_ns  = 5000000000ull;
+
+struct run_result_t {
+    uint64_t enqueues = 0u;    /**< Number of successful ENQCMD submissions */
+    uint64_t retries  = 0u;    /**< Number of ENQCMD submissions rejected by all queues */
+    uint64_t time_ns  = 0u;    /**< Time from the first submission to the last completion */
+    bool     ok       = true;  /**< All completion records reported success */
+};
+
+template <class value_t>
+static inline auto aligned_array(size_t count) -> value_t * {
+    const size_t size = (count * sizeof(value_t) + HW_PATH_STRUCTURES_REQUIRED_ALIGN - 1u)
+                        & ~(size_t) (HW_PATH_STRUCTURES_REQUIRED_ALIGN - 1u);
+
+    auto *ptr = static_cast<value_t *>(aligned_alloc(HW_PATH_STRUCTURES_REQUIRED_ALIGN, size));
+    memset(ptr, 0, size);
+
+    return ptr;
+}
+
+static inline void enqueue_with_retry(const hw_dispatcher &dispatcher, hw_descriptor *desc_ptr, run_result_t &result) {
+    while (QPL_STS_OK != dispatcher.enqueue_descriptor(desc_ptr)) {
+        result.retries++;
+        _mm_pause();
+    }
+
+    result.enqueues++;
+}
+
+static inline bool wait_all(hw_completion_record *records_ptr, uint32_t count) {
+    const uint64_t deadline = qpl::ml::dispatcher::hw_now_ns() + wait_timeout_ns;
+
+    for (uint32_t i = 0u; i < count; i++) {
+        while (0u == reinterpret_cast<volatile hw_completion_record *>(&records_ptr[i])->status) {
+            if (qpl::ml::dispatcher::hw_now_ns() > deadline) {
+                return false;
+            }
+            _mm_pause();
+        }
+
+        if (AD_STATUS_SUCCESS != (records_ptr[i].status & STATUS_MASK)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static auto run_single(const hw_dispatcher &dispatcher,
+                       hw_descriptor *descs_ptr,
+                       hw_completion_record *records_ptr,
+                       uint8_t *src_ptr,
+                       uint8_t *dst_ptr,
+                       uint32_t pages,
+                       uint32_t page_size) -> run_result_t {
+    run_result_t result{};
+
+    for (uint32_t i = 0u; i < pages; i++) {
+        hw_iaa_descriptor_init_mem_copy(&descs_ptr[i], src_ptr + (size_t) i * page_size,
+                                        dst_ptr + (size_t) i * page_size, page_size);
+        hw_iaa_descriptor_set_completion_record(&descs_ptr[i], &records_ptr[i]);
+        records_ptr[i].status = 0u;
+    }
+
+    const uint64_t start = qpl::ml::dispatcher::hw_now_ns();
+
+    for (uint32_t i = 0u; i < pages; i++) {
+        enqueue_with_retry(dispatcher, &descs_ptr[i], result);
+    }
+
+    result.ok      = wait_all(records_ptr, pages);
+    result.time_ns = qpl::ml::dispatcher::hw_now_ns() - start;
+
+    return result;
+}
+
+static auto run_batched(const hw_dispatcher &dispatcher,
+                        hw_descriptor *descs_ptr,
+                        hw_descriptor *batch_descs_ptr,
+                        hw_completion_record *batch_records_ptr,
+                        uint8_t *src_ptr,
+                        uint8_t *dst_ptr,
+                        uint32_t pages,
+                        uint32_t page_size) -> run_result_t {
+    run_result_t   result{};
+    const uint32_t max_batch_size = dispatcher.get_max_batch_size();
+
+    // Descriptors of a batch report through the batch completion record only
+    for (uint32_t i = 0u; i < pages; i++) {
+        hw_iaa_descriptor_init_mem_copy(&descs_ptr[i], src_ptr + (size_t) i * page_size,
+                                        dst_ptr + (size_t) i * page_size, page_size);
+    }
+
+    const uint64_t start       = qpl::ml::dispatcher::hw_now_ns();
+    uint32_t       batch_count = 0u;
+
+    for (uint32_t first = 0u; first < pages; first += max_batch_size, batch_count++) {
+        const uint32_t count = std::min(max_batch_size, pages - first);
+
+        if (1u == count) {
+            hw_iaa_descriptor_set_completion_record(&descs_ptr[first], &batch_records_ptr[batch_count]);
+            batch_records_ptr[batch_count].status = 0u;
+            enqueue_with_retry(dispatcher, &descs_ptr[first], result);
+            continue;
+        }
+
+        qpl_status status;
+        while (QPL_STS_QUEUES_ARE_BUSY_ERR == (status = dispatcher.enqueue_batch(&batch_descs_ptr[batch_count],
+                                                                                 &batch_records_ptr[batch_count],
+                                                                                 &descs_ptr[first],
+                                                                                 count))) {
+            result.retries++;
+            _mm_pause();
+        }
+
+        if (QPL_STS_OK != status) {
+            result.ok = false;
+            return result;
+        }
+
+        result.enqueues++;
+    }
+
+    result.ok      = wait_all(batch_records_ptr, batch_count);
+    result.time_ns = qpl::ml::dispatcher::hw_now_ns() - start;
+
+    return result;
+}
+
+static void print_result(const char *mode, uint32_t page_size, uint32_t pages, const run_result_t &result) {
+    const double bytes = (double) page_size * pages;
+
+    cout << setw(8) << page_size
+         << setw(10) << mode
+         << setw(10) << result.enqueues
+         << setw(10) << result.retries
+         << setw(12) << fixed << setprecision(1) << result.time_ns / 1000.0
+         << setw(10) << setprecision(2) << bytes / result.time_ns
+         << setw(12) << setprecision(0) << pages * 1e9 / result.time_ns
+         << (result.ok ? "" : "  FAILED") << endl;
+}
+
+int main(int argc, char **argv) {
+    const uint32_t pages   = (argc > 1) ? (uint32_t) atoi(argv[1]) : default_pages;
+    const uint32_t repeats = (argc > 2) ? (uint32_t) atoi(argv[2]) : default_repeats;
+
+    auto &dispatcher = hw_dispatcher::get_instance();
+
+    if (!dispatcher.is_hw_support() || 0u == pages) {
+        cout << "hw_dispatcher init status: " << dispatcher.get_hw_init_status() << endl;
+        return 1;
+    }
+
+    const uint32_t max_batch_size = dispatcher.get_max_batch_size();
+    const bool     batch_support  = max_batch_size >= 2u;
+    const uint32_t max_batches    = batch_support ? (pages + max_batch_size - 1u) / max_batch_size : 0u;
+    const size_t   buffer_size    = (size_t) pages * page_sizes[std::size(page_sizes) - 1u];
+
+    cout << "pages per group: " << pages << ", repeats: " << repeats
+         << ", max batch size: " << max_batch_size << endl;
+    if (!batch_support) {
+        cout << "batch descriptors are not supported by the devices, running per-descriptor mode only" << endl;
+    }
+
+    auto *src_ptr           = aligned_array<uint8_t>(buffer_size);
+    auto *dst_ptr           = aligned_array<uint8_t>(buffer_size);
+    auto *descs_ptr         = aligned_array<hw_descriptor>(pages);
+    auto *records_ptr       = aligned_array<hw_completion_record>(pages);
+    auto *batch_descs_ptr   = aligned_array<hw_descriptor>(max_batches + 1u);
+    auto *batch_records_ptr = aligned_array<hw_completion_record>(max_batches + 1u);
+
+    memset(src_ptr, 0xA5, buffer_size);
+
+    cout << setw(8) << "page" << setw(10) << "mode" << setw(10) << "enqueues" << setw(10) << "retries"
+         << setw(12) << "time, us" << setw(10) << "GB/s" << setw(12) << "pages/s" << endl;
+
+    for (const uint32_t page_size : page_sizes) {
+        run_result_t best_single{};
+        run_result_t best_batched{};
+
+        best_single.time_ns  = UINT64_MAX;
+        best_batched.time_ns = UINT64_MAX;
+
+        bool single_ok  = true;
+        bool batched_ok = true;
+
+        // Best of the repeats is reported, failure of any repeat marks the row as failed
+        for (uint32_t repeat = 0u; repeat < repeats; repeat++) {
+            auto single = run_single(dispatcher, descs_ptr, records_ptr, src_ptr, dst_ptr, pages, page_size);
+            single_ok = single_ok && single.ok;
+            if (single.time_ns < best_single.time_ns) {
+                best_single = single;
+            }
+
+            if (batch_support) {
+                auto batched = run_batched(dispatcher, descs_ptr, batch_descs_ptr, batch_records_ptr,
+                                           src_ptr, dst_ptr, pages, page_size);
+                batched_ok = batched_ok && batched.ok;
+                if (batched.time_ns < best_batched.time_ns) {
+                    best_batched = batched;
+                }
+            }
+        }
+
+        best_single.ok  = single_ok;
+        best_batched.ok = batched_ok;
+
+        print_result("single", page_size, pages, best_single);
+        if (batch_support) {
+            print_result("batch", page_size, pages, best_batched);
+        }
+    }
+
+    free(batch_records_ptr);
+    free(batch_descs_ptr);
+    free(records_ptr);
+    free(descs_ptr);
+    free(dst_ptr);
+    free(src_ptr);
+
+    return 0;
+}
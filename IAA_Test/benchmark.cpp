@@ -0,0 +1,942 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+/*
+ * Throughput and latency benchmark of the accelerator operations.
+ *
+ * Every combination of operation, buffer size, queue depth, thread count, device and work queue given on
+ * the command line is run for a fixed time after a warm-up. Each thread keeps `depth` jobs in flight through its
+ * own completion engine and resubmits a job as soon as it is reaped, the latency of a job is the time from its
+ * submission to its reaping. Results are printed as a table, CSV or JSON.
+ *
+ * The mean duration of one submission call is reported too. Small copies over a thread list, e.g.
+ * `--ops memcopy --sizes 64 --depths 1 --threads 1,8,64`, show how the enqueue cost grows with the number of
+ * threads submitting at once.
+ */
+
+#include <immintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hw_dispatcher.hpp"
+#include "hw_util.hpp"
+#include "hw_completion_engine.hpp"
+#include "hw_job_pool.hpp"
+#include "hw_autotuner.hpp"
+#include "hw_arbiter.hpp"
+#include "hw_descriptor_prototype.hpp"
+
+using namespace std;
+using namespace qpl::ml::dispatcher;
+
+static constexpr uint64_t crc64_ecma_polynomial = 0x42F0E1EBA9EA3693ull;
+static constexpr uint64_t setup_timeout_ns      = 1000000000ull;
+static constexpr uint64_t drain_timeout_ns      = 5000000000ull;
+static constexpr uint64_t reap_timeout_ns       = 10000000ull;
+static constexpr uint64_t submit_timeout_ns     = 1000000000ull;
+static constexpr int32_t  any_index             = -1;
+
+enum class operation_t {
+    memcopy,
+    crc64,
+    compress,
+    decompress,
+    scan,
+    extract,
+    select
+};
+
+enum class output_format_t {
+    table,
+    csv,
+    json
+};
+
+static const char *operation_names[] = {"memcopy", "crc64", "compress", "decompress", "scan", "extract", "select"};
+static const char *path_names[]      = {"hw", "auto", "cpu"};
+
+struct options_t {
+    vector<operation_t> operations = {operation_t::memcopy, operation_t::crc64, operation_t::compress,
+                                      operation_t::decompress, operation_t::scan, operation_t::extract,
+                                      operation_t::select};
+    vector<uint32_t>    sizes      = {4096u, 65536u, 1048576u};
+    vector<uint32_t>    depths     = {1u, 16u};
+    vector<uint32_t>    threads    = {1u};
+    vector<int32_t>     devices    = {any_index};
+    vector<int32_t>     queues     = {any_index};
+    uint32_t            path       = 0u;      /**< Index into path_names */
+    uint32_t            time_ms    = 1000u;
+    uint32_t            warmup_ms  = 200u;
+    output_format_t     format     = output_format_t::table;
+    const char          *output    = nullptr;
+    bool                wq_stats   = false;   /**< Print the work queue counters after the sweep */
+    bool                tune       = false;   /**< Retune the crossovers of the auto path before the sweep */
+};
+
+struct config_t {
+    operation_t operation;
+    uint32_t    size;
+    uint32_t    depth;
+    uint32_t    threads;
+    int32_t     device;
+    int32_t     queue;
+};
+
+struct result_t {
+    uint64_t   jobs      = 0u;      /**< Jobs completed in the measured interval */
+    uint64_t   bytes     = 0u;      /**< Source bytes of those jobs */
+    uint64_t   errors    = 0u;      /**< Jobs completed with an error in the measured interval */
+    uint64_t   retries   = 0u;      /**< Submissions refused by the queues */
+    uint64_t   submits   = 0u;      /**< Submission calls in the measured interval, refused ones included */
+    uint64_t   submit_ns = 0u;      /**< Time spent in those calls */
+    double     seconds   = 0.0;     /**< Length of the measured interval */
+    double     p50_us    = 0.0;
+    double     p99_us    = 0.0;
+    double     p999_us   = 0.0;
+    qpl_status status    = QPL_STS_OK;   /**< First failure, OK if every job succeeded */
+};
+
+/**
+ * @brief Phases of a run shared by the main thread and the workers
+ */
+struct run_state_t {
+    atomic<uint32_t> ready     = 0u;       /**< Workers that finished their setup */
+    atomic<bool>     start     = false;    /**< Workers may start submitting */
+    atomic<bool>     measuring = false;    /**< Completions are counted */
+    atomic<bool>     stop      = false;    /**< Workers stop resubmitting and drain */
+};
+
+/**
+ * @brief Buffers and descriptors of one worker
+ */
+struct worker_t {
+    vector<uint8_t>  source;
+    vector<uint8_t>  compressed;
+    vector<uint8_t>  mask;
+    vector<hw_job_t> jobs;
+    vector<uint8_t*> destinations;
+    vector<uint64_t> submit_ns;
+    vector<uint64_t> latencies_ns;
+    hw_iaa_aecs      *aecs_ptr     = nullptr;
+    const hw_device  *device_ptr   = nullptr;  /**< Pinned device, nullptr if jobs go through the dispatcher */
+    const hw_queue   *queue_ptr    = nullptr;  /**< Pinned queue, nullptr if the device queue policy chooses */
+    uint32_t         source_size   = 0u;       /**< Size of the job input, compressed size for decompress */
+    uint32_t         dst_capacity  = 0u;
+    result_t         result        = {};
+};
+
+static auto parse_size(const string &token) -> uint32_t {
+    char           *end_ptr = nullptr;
+    const uint64_t value    = strtoull(token.c_str(), &end_ptr, 10);
+
+    switch (*end_ptr) {
+        case 'k': case 'K':
+            return (uint32_t) (value << 10u);
+        case 'm': case 'M':
+            return (uint32_t) (value << 20u);
+        default:
+            return (uint32_t) value;
+    }
+}
+
+static auto split(const char *list_ptr) -> vector<string> {
+    vector<string> tokens;
+    string         token;
+
+    for (const char *char_ptr = list_ptr; ; char_ptr++) {
+        if (',' == *char_ptr || '\0' == *char_ptr) {
+            if (!token.empty()) {
+                tokens.push_back(token);
+            }
+            token.clear();
+
+            if ('\0' == *char_ptr) {
+                return tokens;
+            }
+        } else {
+            token.push_back(*char_ptr);
+        }
+    }
+}
+
+static auto parse_indices(const char *list_ptr) -> vector<int32_t> {
+    vector<int32_t> indices;
+
+    for (const auto &token : split(list_ptr)) {
+        indices.push_back(("all" == token) ? any_index : atoi(token.c_str()));
+    }
+
+    return indices;
+}
+
+static void print_usage(const char *name_ptr) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --ops LIST        memcopy,crc64,compress,decompress,scan,extract,select (default: all)\n"
+            "  --sizes LIST      buffer sizes, k/m suffixes allowed (default: 4k,64k,1m)\n"
+            "  --depths LIST     jobs in flight per thread (default: 1,16)\n"
+            "  --threads LIST    submitting threads (default: 1)\n"
+            "  --devices LIST    device indices or 'all' for dispatcher routing (default: all)\n"
+            "  --wqs LIST        work queue indices of a pinned device or 'all' (default: all)\n"
+            "  --path P          hw: device only, auto: jobs below the tuned crossover on the CPU, cpu: CPU only\n"
+            "                    (default: hw)\n"
+            "  --time-ms N       measured interval per configuration (default: 1000)\n"
+            "  --warmup-ms N     warm-up before measuring (default: 200)\n"
+            "  --format F        table, csv or json (default: table)\n"
+            "  --output FILE     write results to FILE instead of stdout\n"
+            "  --wq-stats        print per work queue counters of the whole sweep to stderr\n"
+            "  --tune            measure the crossovers before the sweep and print them to stderr\n",
+            name_ptr);
+}
+
+static auto parse_options(int argc, char **argv, options_t &options) -> bool {
+    for (int arg_idx = 1; arg_idx < argc; arg_idx++) {
+        const string key       = argv[arg_idx];
+        const char   *value_ptr = (arg_idx + 1 < argc) ? argv[arg_idx + 1] : nullptr;
+
+        // Options without a value
+        if ("--wq-stats" == key) {
+            options.wq_stats = true;
+            continue;
+        }
+
+        if ("--tune" == key) {
+            options.tune = true;
+            continue;
+        }
+
+        if (nullptr == value_ptr) {
+            return false;
+        }
+
+        arg_idx++;
+
+        if ("--ops" == key) {
+            options.operations.clear();
+
+            for (const auto &token : split(value_ptr)) {
+                const auto name_it = find(begin(operation_names), end(operation_names), token);
+
+                if (end(operation_names) == name_it) {
+                    return false;
+                }
+
+                options.operations.push_back((operation_t) distance(begin(operation_names), name_it));
+            }
+        } else if ("--sizes" == key || "--depths" == key || "--threads" == key) {
+            auto &values = ("--sizes" == key) ? options.sizes : ("--depths" == key) ? options.depths : options.threads;
+            values.clear();
+
+            for (const auto &token : split(value_ptr)) {
+                values.push_back(parse_size(token));
+            }
+
+            if (values.end() != find(values.begin(), values.end(), 0u)) {
+                return false;
+            }
+
+            // Every in-flight job of a thread is tracked by its engine
+            if ("--depths" == key && *max_element(values.begin(), values.end()) > hw_completion_engine::max_in_flight) {
+                return false;
+            }
+        } else if ("--devices" == key) {
+            options.devices = parse_indices(value_ptr);
+        } else if ("--wqs" == key) {
+            options.queues = parse_indices(value_ptr);
+        } else if ("--path" == key) {
+            const auto name_it = find(begin(path_names), end(path_names), string(value_ptr));
+
+            if (end(path_names) == name_it) {
+                return false;
+            }
+
+            options.path = (uint32_t) distance(begin(path_names), name_it);
+        } else if ("--time-ms" == key) {
+            options.time_ms = (uint32_t) atoi(value_ptr);
+        } else if ("--warmup-ms" == key) {
+            options.warmup_ms = (uint32_t) atoi(value_ptr);
+        } else if ("--format" == key) {
+            const string format = value_ptr;
+
+            if ("table" == format) {
+                options.format = output_format_t::table;
+            } else if ("csv" == format) {
+                options.format = output_format_t::csv;
+            } else if ("json" == format) {
+                options.format = output_format_t::json;
+            } else {
+                return false;
+            }
+        } else if ("--output" == key) {
+            options.output = value_ptr;
+        } else {
+            return false;
+        }
+    }
+
+    return !options.operations.empty() && !options.sizes.empty() && !options.depths.empty()
+           && !options.threads.empty() && !options.devices.empty() && !options.queues.empty();
+}
+
+/**
+ * @brief Fills the buffer with text-like data: words of a small vocabulary, compresses about 3 to 1
+ */
+static void fill_source(vector<uint8_t> &source, uint32_t seed) {
+    static const char *words[] = {"query ", "processing ", "library ", "analytics ", "accelerator ", "deflate ",
+                                  "scan ", "select ", "extract ", "column ", "table ", "index ", "row ", "page "};
+
+    uint32_t state = seed * 2654435761u + 1u;
+    size_t   offset = 0u;
+
+    while (offset < source.size()) {
+        state = state * 1664525u + 1013904223u;
+
+        const char   *word_ptr = words[(state >> 16u) % size(words)];
+        const size_t length    = min(strlen(word_ptr), source.size() - offset);
+
+        memcpy(source.data() + offset, word_ptr, length);
+        offset += length;
+    }
+}
+
+/**
+ * @brief Appends bits to a deflate stream, least significant bit first
+ */
+static void put_bits(vector<uint8_t> &stream, uint64_t &bit_count, uint32_t value, uint32_t length) {
+    for (uint32_t bit_idx = 0u; bit_idx < length; bit_idx++, bit_count++) {
+        if (0u == (bit_count & 7u)) {
+            stream.push_back(0u);
+        }
+
+        stream.back() |= (uint8_t) (((value >> bit_idx) & 1u) << (bit_count & 7u));
+    }
+}
+
+/**
+ * @brief Huffman codes are sent most significant bit first, so they are reversed for @ref put_bits
+ */
+static void put_code(vector<uint8_t> &stream, uint64_t &bit_count, uint32_t code, uint32_t length) {
+    uint32_t reversed = 0u;
+
+    for (uint32_t bit_idx = 0u; bit_idx < length; bit_idx++) {
+        reversed |= ((code >> bit_idx) & 1u) << (length - 1u - bit_idx);
+    }
+
+    put_bits(stream, bit_count, reversed, length);
+}
+
+/**
+ * @brief Encodes the source as a single final block of fixed-code literals
+ *
+ * @note Used for the decompress input when the device can't compress it, e.g. for the CPU path
+ */
+static void deflate_literals(const vector<uint8_t> &source, vector<uint8_t> &stream) {
+    uint64_t bit_count = 0u;
+
+    stream.clear();
+    put_bits(stream, bit_count, 0x3u, 3u);
+
+    for (const uint8_t symbol : source) {
+        if (symbol < 144u) {
+            put_code(stream, bit_count, 0x30u + symbol, 8u);
+        } else {
+            put_code(stream, bit_count, 0x190u + symbol - 144u, 9u);
+        }
+    }
+
+    put_code(stream, bit_count, 0u, 7u);
+}
+
+static void prepare_compress(hw_descriptor *desc_ptr, hw_iaa_aecs *aecs_ptr, uint8_t *src_ptr, uint32_t src_size,
+                             uint8_t *dst_ptr, uint32_t dst_size) {
+    hw_iaa_descriptor_init_compress_body(desc_ptr);
+    hw_iaa_descriptor_init_deflate_body(desc_ptr, src_ptr, src_size, dst_ptr, dst_size);
+    hw_iaa_descriptor_compress_set_termination_rule(desc_ptr, end_of_block);
+    hw_iaa_descriptor_compress_set_aecs(desc_ptr, aecs_ptr, hw_aecs_access_read);
+}
+
+static void prepare_job(const config_t &config, worker_t &worker, uint32_t slot) {
+    auto    *desc_ptr = worker.jobs[slot].descriptor_ptr;
+    uint8_t *dst_ptr  = worker.destinations[slot];
+    auto    *src_ptr  = worker.source.data();
+    auto    *aecs_ptr = (hw_iaa_aecs_analytic *) worker.aecs_ptr;
+
+    switch (config.operation) {
+        case operation_t::memcopy:
+            hw_iaa_descriptor_init_mem_copy(desc_ptr, src_ptr, dst_ptr, config.size);
+            break;
+        case operation_t::crc64:
+            hw_iaa_descriptor_init_crc64(desc_ptr, src_ptr, config.size, crc64_ecma_polynomial, true, true);
+            break;
+        case operation_t::compress:
+            prepare_compress(desc_ptr, worker.aecs_ptr, src_ptr, config.size, dst_ptr, worker.dst_capacity);
+            break;
+        case operation_t::decompress:
+            hw_iaa_descriptor_init_inflate(desc_ptr, nullptr, 0u, hw_aecs_access_read);
+            hw_iaa_descriptor_set_input_buffer(desc_ptr, worker.compressed.data(), worker.source_size);
+            hw_iaa_descriptor_set_output_buffer(desc_ptr, dst_ptr, worker.dst_capacity);
+            hw_iaa_descriptor_set_inflate_stop_check_rule(desc_ptr, stop_and_check_for_bfinal_eob, false);
+            break;
+        case operation_t::scan:
+            aecs_ptr->filtering_options.filter_low  = 'a';
+            aecs_ptr->filtering_options.filter_high = 'm';
+
+            hw_analytic_prototype_v<QPL_OPCODE_SCAN, hw_iaa_input_format_le, 8u, hw_iaa_output_format_nominal>
+                    .fill(desc_ptr, src_ptr, config.size, config.size, dst_ptr, worker.dst_capacity, aecs_ptr);
+            break;
+        case operation_t::extract:
+            aecs_ptr->filtering_options.filter_low  = config.size / 4u;
+            aecs_ptr->filtering_options.filter_high = config.size / 4u * 3u;
+
+            hw_analytic_prototype_v<QPL_OPCODE_EXTRACT, hw_iaa_input_format_le, 8u, hw_iaa_output_format_nominal>
+                    .fill(desc_ptr, src_ptr, config.size, config.size, dst_ptr, worker.dst_capacity, aecs_ptr);
+            break;
+        case operation_t::select:
+            hw_analytic_prototype_v<QPL_OPCODE_SELECT, hw_iaa_input_format_le, 8u, hw_iaa_output_format_nominal>
+                    .fill(desc_ptr, src_ptr, config.size, config.size, dst_ptr, worker.dst_capacity,
+                          worker.mask.data(), (uint32_t) worker.mask.size());
+            break;
+    }
+}
+
+/**
+ * @brief Submits a job through the engine, or straight into the pinned device or queue
+ */
+static auto submit_job(hw_completion_engine &engine, worker_t &worker, uint32_t slot) -> qpl_status {
+    auto       &job      = worker.jobs[slot];
+    void       *user_ptr = (void *) (uintptr_t) slot;
+    const auto *queue_ptr = worker.queue_ptr;
+
+    worker.submit_ns[slot] = hw_now_ns();
+
+    if (nullptr == worker.device_ptr) {
+        return engine.submit(job.descriptor_ptr, job.completion_record_ptr, user_ptr);
+    }
+
+    hw_iaa_descriptor_set_completion_record(job.descriptor_ptr, job.completion_record_ptr);
+    job.completion_record_ptr->status = AD_STATUS_INPROG;
+
+    if (nullptr == queue_ptr) {
+        if (worker.device_ptr->enqueue_descriptor(job.descriptor_ptr, &queue_ptr)) {
+            return QPL_STS_QUEUES_ARE_BUSY_ERR;
+        }
+    } else {
+        hw_iaa_descriptor_set_block_on_fault(job.descriptor_ptr, queue_ptr->get_block_on_fault());
+
+        if (QPL_STS_OK != queue_ptr->enqueue_descriptor(job.descriptor_ptr)) {
+            return QPL_STS_QUEUES_ARE_BUSY_ERR;
+        }
+
+        queue_ptr->increment_in_flight();
+    }
+
+    return engine.track(job.completion_record_ptr, user_ptr, queue_ptr);
+}
+
+/**
+ * @brief Resubmits a refused job until a queue takes it, the run stops or submit_timeout_ns pass
+ *
+ * @return QPL_STS_QUEUES_ARE_BUSY_ERR if the job is still refused then
+ */
+static auto submit_with_retry(hw_completion_engine &engine, const run_state_t &state, worker_t &worker,
+                              uint32_t slot) -> qpl_status {
+    qpl_status status;
+    uint64_t   deadline_ns = 0u;
+
+    while (true) {
+        status = submit_job(engine, worker, slot);
+
+        if (state.measuring.load(memory_order_relaxed)) {
+            worker.result.submits++;
+            worker.result.submit_ns += hw_now_ns() - worker.submit_ns[slot];
+        }
+
+        if (QPL_STS_QUEUES_ARE_BUSY_ERR != status) {
+            break;
+        }
+
+        worker.result.retries++;
+
+        // Queues that refuse every job, e.g. dedicated ones owned by another thread, end the configuration
+        if (0u == deadline_ns) {
+            deadline_ns = worker.submit_ns[slot] + submit_timeout_ns;
+        } else if (state.stop.load(memory_order_relaxed) || worker.submit_ns[slot] > deadline_ns) {
+            break;
+        }
+
+        _mm_pause();
+    }
+
+    return status;
+}
+
+/**
+ * @brief Whether the status of a resubmission fails the configuration, a job refused until the stop is just dropped
+ */
+static inline auto is_submit_failure(const run_state_t &state, qpl_status status) -> bool {
+    return QPL_STS_OK != status
+           && !(QPL_STS_QUEUES_ARE_BUSY_ERR == status && state.stop.load(memory_order_relaxed));
+}
+
+/**
+ * @brief Compresses the worker source once to get the decompress input, falls back to fixed-code literals
+ */
+static void prepare_compressed_input(hw_completion_engine &engine, const config_t &config, worker_t &worker) {
+    auto           &job    = worker.jobs[0];
+    const uint32_t capacity = worker.dst_capacity + worker.dst_capacity / 2u + 1024u;
+
+    worker.compressed.assign(capacity, 0u);
+    prepare_compress(job.descriptor_ptr, worker.aecs_ptr, worker.source.data(), config.size,
+                     worker.compressed.data(), capacity);
+
+    qpl_status status = submit_with_retry(engine, run_state_t(), worker, 0u);
+
+    if (QPL_STS_OK == status) {
+        status = engine.wait(job.completion_record_ptr, setup_timeout_ns);
+    }
+
+    hw_completion_engine::reaped_t reaped[1];
+    while (0u != engine.in_flight() && 0u != engine.wait_any(reaped, 1u, setup_timeout_ns)) {
+    }
+
+    const auto *record_ptr = reinterpret_cast<const hw_iaa_completion_record *>(job.completion_record_ptr);
+
+    if (QPL_STS_OK == status && 0u != record_ptr->output_size) {
+        worker.compressed.resize(record_ptr->output_size);
+    } else {
+        deflate_literals(worker.source, worker.compressed);
+    }
+
+    worker.source_size = (uint32_t) worker.compressed.size();
+}
+
+static void setup_worker(hw_completion_engine &engine, const config_t &config, worker_t &worker, uint32_t seed) {
+    auto &pool = hw_job_pool::get_instance();
+
+    worker.source.assign(config.size, 0u);
+    fill_source(worker.source, seed);
+
+    worker.mask.assign((config.size + 7u) / 8u, 0u);
+    for (size_t byte_idx = 0u; byte_idx < worker.mask.size(); byte_idx++) {
+        worker.mask[byte_idx] = (uint8_t) (byte_idx * 0x9Du + seed);
+    }
+
+    worker.source_size  = config.size;
+    worker.dst_capacity = config.size + config.size / 8u + 1024u;
+    worker.aecs_ptr     = pool.acquire(hw_pool_kind_t::aecs);
+    memset(worker.aecs_ptr, 0, HW_AECS_COMPRESSION_SIZE);
+
+    if (operation_t::compress == config.operation || operation_t::decompress == config.operation) {
+        hw_iaa_aecs_compress_write_deflate_fixed_header((hw_iaa_aecs_compress *) worker.aecs_ptr, 1u);
+    }
+
+    worker.jobs.resize(config.depth);
+    worker.destinations.resize(config.depth);
+    worker.submit_ns.assign(config.depth, 0u);
+
+    for (uint32_t slot = 0u; slot < config.depth; slot++) {
+        if (QPL_STS_OK != pool.acquire_job(worker.jobs[slot])) {
+            worker.result.status = QPL_STS_NO_MEM_ERR;
+            return;
+        }
+
+        worker.destinations[slot] = static_cast<uint8_t *>(aligned_alloc(64u, (worker.dst_capacity + 63u) & ~63u));
+    }
+
+    if (operation_t::decompress == config.operation && QPL_STS_OK == worker.result.status) {
+        prepare_compressed_input(engine, config, worker);
+    }
+
+    for (uint32_t slot = 0u; slot < config.depth; slot++) {
+        prepare_job(config, worker, slot);
+    }
+}
+
+static void release_worker(worker_t &worker) {
+    auto &pool = hw_job_pool::get_instance();
+
+    for (size_t slot = 0u; slot < worker.jobs.size(); slot++) {
+        if (nullptr != worker.jobs[slot].descriptor_ptr) {
+            static_cast<void>(pool.release_job(worker.jobs[slot]));
+        }
+
+        free(worker.destinations[slot]);
+    }
+
+    pool.release(hw_pool_kind_t::aecs, worker.aecs_ptr);
+
+    if (nullptr != worker.queue_ptr) {
+        worker.queue_ptr->release();
+    }
+}
+
+static void run_worker(const options_t &options, const config_t &config, run_state_t &state,
+                       worker_t &worker, uint32_t seed) {
+    hw_completion_engine engine;
+
+    if (0u == options.path) {
+        engine.set_cpu_path(nullptr);
+    } else if (2u == options.path) {
+        engine.set_cpu_path(hw_cpu_execute_descriptor, UINT32_MAX);
+    }
+
+    // A pinned dedicated queue has a single submitter, the other workers of the configuration fail
+    if (nullptr != worker.queue_ptr && worker.queue_ptr->is_dedicated() && !worker.queue_ptr->acquire()) {
+        worker.result.status = QPL_STS_QUEUES_ARE_BUSY_ERR;
+    }
+
+    setup_worker(engine, config, worker, seed);
+    state.ready++;
+
+    while (!state.start.load(memory_order_acquire)) {
+        _mm_pause();
+    }
+
+    vector<hw_completion_engine::reaped_t> reaped(config.depth);
+
+    // A job refused from the start until the stop means the configuration can't run at all
+    for (uint32_t slot = 0u; slot < config.depth && QPL_STS_OK == worker.result.status; slot++) {
+        worker.result.status = submit_with_retry(engine, state, worker, slot);
+    }
+
+    while (0u != engine.in_flight()) {
+        const bool     is_stopping = state.stop.load(memory_order_relaxed);
+        const uint32_t count       = engine.wait_any(reaped.data(), config.depth,
+                                                     is_stopping ? drain_timeout_ns : reap_timeout_ns);
+        const uint64_t reap_ns     = hw_now_ns();
+        const bool     is_counted  = state.measuring.load(memory_order_relaxed) && !is_stopping;
+
+        if (is_stopping && 0u == count) {
+            break;
+        }
+
+        for (uint32_t reaped_idx = 0u; reaped_idx < count; reaped_idx++) {
+            const auto slot = (uint32_t) (uintptr_t) reaped[reaped_idx].user_ptr;
+
+            if (QPL_STS_OK != reaped[reaped_idx].status) {
+                worker.result.errors += is_counted ? 1u : 0u;
+
+                if (QPL_STS_OK == worker.result.status) {
+                    worker.result.status = reaped[reaped_idx].status;
+                }
+            }
+
+            if (is_counted) {
+                worker.result.jobs++;
+                worker.result.bytes += worker.source_size;
+                worker.latencies_ns.push_back(reap_ns - worker.submit_ns[slot]);
+            }
+
+            if (!is_stopping && QPL_STS_OK == worker.result.status) {
+                const auto status = submit_with_retry(engine, state, worker, slot);
+
+                if (is_submit_failure(state, status)) {
+                    worker.result.status = status;
+                }
+            }
+        }
+    }
+
+    release_worker(worker);
+}
+
+static auto percentile_us(const vector<uint64_t> &sorted_ns, double fraction) -> double {
+    if (sorted_ns.empty()) {
+        return 0.0;
+    }
+
+    const auto rank = (size_t) (fraction * (double) sorted_ns.size());
+
+    return (double) sorted_ns[min(rank, sorted_ns.size() - 1u)] / 1000.0;
+}
+
+static auto run_config(const options_t &options, const config_t &config) -> result_t {
+    run_state_t      state;
+    vector<worker_t> workers(config.threads);
+    vector<thread>   threads;
+    result_t         result;
+
+    if (any_index != config.device) {
+        const auto &dispatcher = hw_dispatcher::get_instance();
+
+        if ((size_t) config.device >= dispatcher.device_count()
+            || (any_index != config.queue && (size_t) config.queue >= (dispatcher.begin() + config.device)->size())) {
+            result.status = QPL_STS_INIT_WORK_QUEUES_NOT_AVAILABLE;
+            return result;
+        }
+
+        for (auto &worker : workers) {
+            worker.device_ptr = &*(dispatcher.begin() + config.device);
+            worker.queue_ptr  = (any_index != config.queue) ? &*(worker.device_ptr->begin() + config.queue) : nullptr;
+        }
+
+        // Credits of a dedicated queue come back only when jobs are reaped, so the first `depth` submissions must fit
+        const hw_queue *queue_ptr = workers.empty() ? nullptr : workers[0].queue_ptr;
+
+        if (nullptr != queue_ptr && queue_ptr->is_dedicated() && config.depth > queue_ptr->get_size()) {
+            result.status = QPL_STS_QUEUES_ARE_BUSY_ERR;
+            return result;
+        }
+    }
+
+    for (uint32_t thread_idx = 0u; thread_idx < config.threads; thread_idx++) {
+        threads.emplace_back(run_worker, cref(options), cref(config), ref(state), ref(workers[thread_idx]),
+                             thread_idx + 1u);
+    }
+
+    while (state.ready.load() != config.threads) {
+        this_thread::yield();
+    }
+
+    state.start.store(true, memory_order_release);
+    this_thread::sleep_for(chrono::milliseconds(options.warmup_ms));
+
+    const uint64_t start_ns = hw_now_ns();
+    state.measuring.store(true);
+    this_thread::sleep_for(chrono::milliseconds(options.time_ms));
+    state.stop.store(true);
+    const uint64_t end_ns = hw_now_ns();
+
+    for (auto &worker_thread : threads) {
+        worker_thread.join();
+    }
+
+    vector<uint64_t> latencies_ns;
+
+    for (const auto &worker : workers) {
+        result.jobs      += worker.result.jobs;
+        result.bytes     += worker.result.bytes;
+        result.errors    += worker.result.errors;
+        result.retries   += worker.result.retries;
+        result.submits   += worker.result.submits;
+        result.submit_ns += worker.result.submit_ns;
+        latencies_ns.insert(latencies_ns.end(), worker.latencies_ns.begin(), worker.latencies_ns.end());
+
+        if (QPL_STS_OK == result.status) {
+            result.status = worker.result.status;
+        }
+    }
+
+    sort(latencies_ns.begin(), latencies_ns.end());
+
+    result.seconds = (double) (end_ns - start_ns) / 1e9;
+    result.p50_us  = percentile_us(latencies_ns, 0.5);
+    result.p99_us  = percentile_us(latencies_ns, 0.99);
+    result.p999_us = percentile_us(latencies_ns, 0.999);
+
+    return result;
+}
+
+static auto index_name(int32_t index) -> string {
+    return (any_index == index) ? string("all") : to_string(index);
+}
+
+static void print_header(FILE *file_ptr, const options_t &options) {
+    const auto &dispatcher = hw_dispatcher::get_instance();
+
+    switch (options.format) {
+        case output_format_t::table:
+            fprintf(file_ptr, "# init status %u, %zu device(s), path %s, %u ms per configuration\n",
+                    (uint32_t) dispatcher.get_hw_init_status(), dispatcher.device_count(), path_names[options.path],
+                    options.time_ms);
+            fprintf(file_ptr, "%-10s %8s %5s %7s %6s %4s %10s %8s %8s %12s %9s %9s %9s %8s %6s\n",
+                    "operation", "size", "depth", "threads", "device", "wq", "jobs", "errors", "GB/s", "jobs/s",
+                    "p50 us", "p99 us", "p99.9 us", "enq ns", "status");
+            break;
+        case output_format_t::csv:
+            fprintf(file_ptr, "operation,size,depth,threads,device,wq,path,jobs,errors,retries,seconds,"
+                              "gb_per_s,jobs_per_s,p50_us,p99_us,p999_us,submit_ns,status\n");
+            break;
+        case output_format_t::json:
+            fprintf(file_ptr, "{\n  \"init_status\": %u,\n  \"device_count\": %zu,\n  \"path\": \"%s\",\n"
+                              "  \"time_ms\": %u,\n  \"warmup_ms\": %u,\n  \"results\": [",
+                    (uint32_t) dispatcher.get_hw_init_status(), dispatcher.device_count(), path_names[options.path],
+                    options.time_ms, options.warmup_ms);
+            break;
+    }
+}
+
+static void print_result(FILE *file_ptr, const options_t &options, const config_t &config,
+                         const result_t &result, bool is_first) {
+    const double gb_per_s   = (result.seconds > 0.0) ? (double) result.bytes / result.seconds / 1e9 : 0.0;
+    const double jobs_per_s = (result.seconds > 0.0) ? (double) result.jobs / result.seconds : 0.0;
+    const double submit_ns  = (0u != result.submits) ? (double) result.submit_ns / (double) result.submits : 0.0;
+    const char   *name_ptr  = operation_names[(uint32_t) config.operation];
+    const string device     = index_name(config.device);
+    const string queue      = index_name(config.queue);
+
+    switch (options.format) {
+        case output_format_t::table:
+            fprintf(file_ptr, "%-10s %8u %5u %7u %6s %4s %10lu %8lu %8.2f %12.0f %9.2f %9.2f %9.2f %8.0f %6u\n",
+                    name_ptr, config.size, config.depth, config.threads, device.c_str(), queue.c_str(),
+                    result.jobs, result.errors, gb_per_s, jobs_per_s, result.p50_us, result.p99_us, result.p999_us,
+                    submit_ns, (uint32_t) result.status);
+            break;
+        case output_format_t::csv:
+            fprintf(file_ptr, "%s,%u,%u,%u,%s,%s,%s,%lu,%lu,%lu,%.6f,%.4f,%.1f,%.3f,%.3f,%.3f,%.1f,%u\n",
+                    name_ptr, config.size, config.depth, config.threads, device.c_str(), queue.c_str(),
+                    path_names[options.path], result.jobs, result.errors, result.retries, result.seconds,
+                    gb_per_s, jobs_per_s, result.p50_us, result.p99_us, result.p999_us, submit_ns,
+                    (uint32_t) result.status);
+            break;
+        case output_format_t::json:
+            fprintf(file_ptr, "%s\n    {\"operation\": \"%s\", \"size\": %u, \"depth\": %u, \"threads\": %u, "
+                              "\"device\": \"%s\", \"wq\": \"%s\", \"jobs\": %lu, \"errors\": %lu, \"retries\": %lu, "
+                              "\"seconds\": %.6f, \"gb_per_s\": %.4f, \"jobs_per_s\": %.1f, \"p50_us\": %.3f, "
+                              "\"p99_us\": %.3f, \"p999_us\": %.3f, \"submit_ns\": %.1f, \"status\": %u}",
+                    is_first ? "" : ",", name_ptr, config.size, config.depth, config.threads, device.c_str(),
+                    queue.c_str(), result.jobs, result.errors, result.retries, result.seconds, gb_per_s,
+                    jobs_per_s, result.p50_us, result.p99_us, result.p999_us, submit_ns, (uint32_t) result.status);
+            break;
+    }
+
+    fflush(file_ptr);
+}
+
+/**
+ * @brief Prints the counters the dispatcher collected for every work queue during the whole sweep
+ */
+static void print_queue_stats(FILE *file_ptr) {
+    const auto       &dispatcher = hw_dispatcher::get_instance();
+    hw_queue_stats_t stats;
+    uint32_t         device_idx  = 0u;
+
+    fprintf(file_ptr, "%6s %4s %12s %10s %12s %8s %8s %9s %9s %9s\n", "device", "wq", "submissions", "retries",
+            "completions", "faults", "errors", "p50 us", "p99 us", "p99.9 us");
+
+    for (const auto &device : dispatcher) {
+        uint32_t queue_idx = 0u;
+
+        for (auto queue_it = device.begin(); queue_it != device.begin() + device.size(); ++queue_it, ++queue_idx) {
+            queue_it->get_stats(stats);
+            fprintf(file_ptr, "%6u %4u %12lu %10lu %12lu %8lu %8lu %9.2f %9.2f %9.2f\n", device_idx, queue_idx,
+                    stats.submissions, stats.retries, stats.completions, stats.page_faults, stats.errors,
+                    (double) stats.get_latency_percentile_ns(0.5) / 1e3,
+                    (double) stats.get_latency_percentile_ns(0.99) / 1e3,
+                    (double) stats.get_latency_percentile_ns(0.999) / 1e3);
+        }
+
+        device_idx++;
+    }
+
+    const auto &arbiter = hw_arbiter::get_instance();
+
+    if (arbiter.is_attached()) {
+        const auto arbiter_stats = arbiter.get_stats();
+
+        fprintf(file_ptr, "arbiter: tokens %u, throttled submissions %lu, reclaimed slots %lu\n",
+                arbiter.get_tokens(), arbiter_stats.throttles, arbiter_stats.reaped);
+    }
+}
+
+static void print_crossovers(FILE *file_ptr) {
+    auto           &autotuner = hw_autotuner::get_instance();
+    const uint32_t node_count = static_cast<uint32_t>(hw_dispatcher::get_instance().numa_node_count());
+
+    fprintf(file_ptr, "%6s", "node");
+
+    for (uint32_t op_idx = 0u; op_idx < hw_autotuner::operation_count; op_idx++) {
+        fprintf(file_ptr, " %13s", hw_autotuner::get_operation_name(static_cast<hw_tuning_op_t>(op_idx)));
+    }
+
+    fprintf(file_ptr, "\n");
+
+    for (uint32_t node_idx = 0u; node_idx < node_count; node_idx++) {
+        fprintf(file_ptr, "%6u", node_idx);
+
+        for (uint32_t op_idx = 0u; op_idx < hw_autotuner::operation_count; op_idx++) {
+            const uint32_t size = autotuner.get_crossover_size(static_cast<hw_tuning_op_t>(op_idx),
+                                                               static_cast<int32_t>(node_idx));
+
+            if (hw_autotuner::never_offload == size) {
+                fprintf(file_ptr, " %13s", "cpu");
+            } else {
+                fprintf(file_ptr, " %13u", size);
+            }
+        }
+
+        fprintf(file_ptr, "\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    options_t options;
+
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    auto &dispatcher = hw_dispatcher::get_instance();
+
+    if (0u == options.path && !dispatcher.is_hw_support()) {
+        fprintf(stderr, "hw_dispatcher init status: %u, use --path auto or cpu to run without devices\n",
+                (uint32_t) dispatcher.get_hw_init_status());
+        return 1;
+    }
+
+    if (options.tune) {
+        const auto status = hw_autotuner::get_instance().tune();
+
+        if (QPL_STS_OK != status) {
+            fprintf(stderr, "tuning status: %u, crossovers of the failed operations are kept\n", (uint32_t) status);
+        }
+
+        print_crossovers(stderr);
+    }
+
+    FILE *file_ptr = (nullptr != options.output) ? fopen(options.output, "w") : stdout;
+
+    if (nullptr == file_ptr) {
+        fprintf(stderr, "can't open %s\n", options.output);
+        return 1;
+    }
+
+    print_header(file_ptr, options);
+
+    bool is_first = true;
+
+    for (const auto device : options.devices) {
+        // Queues are pinned only together with a device
+        const vector<int32_t> queues = (any_index == device) ? vector<int32_t>{any_index} : options.queues;
+
+        for (const auto queue : queues) {
+            for (const auto operation : options.operations) {
+                for (const auto size : options.sizes) {
+                    for (const auto depth : options.depths) {
+                        for (const auto threads : options.threads) {
+                            const config_t config = {operation, size, depth, threads, device, queue};
+
+                            print_result(file_ptr, options, config, run_config(options, config), is_first);
+                            is_first = false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (output_format_t::json == options.format) {
+        fprintf(file_ptr, "\n  ]\n}\n");
+    }
+
+    if (options.wq_stats) {
+        print_queue_stats(stderr);
+    }
+
+    if (stdout != file_ptr) {
+        fclose(file_ptr);
+    }
+
+    return 0;
+}
@@ -0,0 +1,479 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+/*
+ *  Intel® Query Processing Library (Intel® QPL)
+ *  Hardware Interconnect API (private C API)
+ */
+
+#include <string.h>
+
+#include "hw_aecs_api.h"
+
+#define OWN_DEFLATE_FIXED_BLOCK_TYPE     1u      /**< BTYPE value of a block compressed with fixed Huffman codes */
+#define OWN_DEFLATE_DYNAMIC_BLOCK_TYPE   2u      /**< BTYPE value of a block compressed with dynamic Huffman codes */
+#define OWN_DEFLATE_HEADER_BITS          3u      /**< BFINAL and BTYPE bits */
+#define OWN_OUTPUT_ACCUMULATOR_BITS      (sizeof(((hw_iaa_aecs_compress *) 0)->output_accum) * 8u)
+#define OWN_MAX_CODE_LENGTH              15u     /**< Longest literal/length and distance code */
+#define OWN_MAX_CL_CODE_LENGTH           7u      /**< Longest code length code */
+#define OWN_CL_ALPHABET_SIZE             19u     /**< Code length alphabet: lengths 0..15 and repeat codes 16..18 */
+#define OWN_MIN_HLIT                     257u    /**< Literal/length codes always declared */
+#define OWN_MIN_HDIST                    1u      /**< Distance codes always declared */
+#define OWN_MIN_HCLEN                    4u      /**< Code length codes always declared */
+#define OWN_EOB_SYMBOL                   256u    /**< End-of-block literal/length symbol */
+#define OWN_MAX_HEADER_BYTES             600u    /**< Dynamic header of the largest alphabets, rounded up */
+
+static inline uint32_t own_huffman_code(const uint32_t code, const uint32_t length) {
+    return (code & QPLC_HUFFMAN_CODE_MASK) | (length << QPLC_HUFFMAN_CODE_LENGTH_OFFSET);
+}
+
+/**
+ * @brief Appends bits to the output accumulator, deflate streams are filled starting from the least significant bit
+ */
+static inline uint32_t own_accumulator_append(hw_iaa_aecs_compress *const aecs_ptr,
+                                              const uint32_t value,
+                                              const uint32_t bit_count) {
+    uint32_t position = aecs_ptr->num_output_accum_bits;
+
+    if (position + bit_count > OWN_OUTPUT_ACCUMULATOR_BITS) {
+        return 1u;
+    }
+
+    for (uint32_t bit_idx = 0u; bit_idx < bit_count; bit_idx++, position++) {
+        const uint8_t bit_mask = (uint8_t) (1u << (position & 7u));
+
+        if ((value >> bit_idx) & 1u) {
+            aecs_ptr->output_accum[position >> 3u] |= bit_mask;
+        } else {
+            aecs_ptr->output_accum[position >> 3u] &= (uint8_t) ~bit_mask;
+        }
+    }
+
+    aecs_ptr->num_output_accum_bits = position;
+
+    return 0u;
+}
+
+/**
+ * @brief Reverses the bit order of a Huffman code, deflate streams carry codes starting from the most significant bit
+ */
+static inline uint32_t own_reverse_code(uint32_t code, const uint32_t length) {
+    uint32_t reversed = 0u;
+
+    for (uint32_t bit_idx = 0u; bit_idx < length; bit_idx++, code >>= 1u) {
+        reversed = (reversed << 1u) | (code & 1u);
+    }
+
+    return reversed;
+}
+
+/**
+ * @brief Order in which code length code lengths are stored, RFC 1951 3.2.7
+ */
+static const uint8_t own_cl_order[OWN_CL_ALPHABET_SIZE] = {
+        16u, 17u, 18u, 0u, 8u, 7u, 9u, 6u, 10u, 5u, 11u, 4u, 12u, 3u, 13u, 2u, 14u, 1u, 15u
+};
+
+/**
+ * @brief Bit writer for building a block header outside of the accumulator
+ */
+typedef struct {
+    uint8_t  *data_ptr;    /**< Zero-initialized header buffer */
+    uint32_t bit_count;    /**< Bits written */
+} own_bit_writer_t;
+
+static inline void own_write_bits(own_bit_writer_t *const writer_ptr, const uint32_t value, const uint32_t bit_count) {
+    for (uint32_t bit_idx = 0u; bit_idx < bit_count; bit_idx++, writer_ptr->bit_count++) {
+        writer_ptr->data_ptr[writer_ptr->bit_count >> 3u] |= (uint8_t) (((value >> bit_idx) & 1u)
+                                                                        << (writer_ptr->bit_count & 7u));
+    }
+}
+
+static inline void own_write_code(own_bit_writer_t *const writer_ptr, const uint32_t packed_code) {
+    const uint32_t length = packed_code >> QPLC_HUFFMAN_CODE_LENGTH_OFFSET;
+
+    own_write_bits(writer_ptr, own_reverse_code(packed_code & QPLC_HUFFMAN_CODE_MASK, length), length);
+}
+
+/**
+ * @brief Builds Huffman code lengths of at most `max_length` bits for the symbol counts.
+ *
+ * @details The tree is built with two queues over the symbols sorted by count. If it is too deep, counts are
+ * halved, keeping used symbols used, and the tree is rebuilt, which converges to a balanced tree.
+ */
+static void own_build_code_lengths(const uint32_t *const counts_ptr,
+                                   const uint32_t symbol_count,
+                                   const uint32_t max_length,
+                                   uint8_t *const lengths_ptr) {
+    uint32_t weights[QPLC_DEFLATE_LL_TABLE_SIZE];
+    uint16_t order[QPLC_DEFLATE_LL_TABLE_SIZE];
+    uint32_t node_weights[2u * QPLC_DEFLATE_LL_TABLE_SIZE];
+    uint16_t parents[2u * QPLC_DEFLATE_LL_TABLE_SIZE];
+    uint8_t  depths[2u * QPLC_DEFLATE_LL_TABLE_SIZE];
+    uint32_t used_count = 0u;
+
+    for (uint32_t symbol = 0u; symbol < symbol_count; symbol++) {
+        lengths_ptr[symbol] = 0u;
+        weights[symbol]     = counts_ptr[symbol];
+
+        if (0u != counts_ptr[symbol]) {
+            order[used_count++] = (uint16_t) symbol;
+        }
+    }
+
+    if (used_count < 2u) {
+        if (1u == used_count) {
+            lengths_ptr[order[0]] = 1u;
+        }
+
+        return;
+    }
+
+    for (;;) {
+        // Insertion sort keeps the order of equal counts, so the result doesn't depend on the previous pass
+        for (uint32_t idx = 1u; idx < used_count; idx++) {
+            const uint16_t symbol = order[idx];
+            uint32_t       pos    = idx;
+
+            for (; pos > 0u && weights[order[pos - 1u]] > weights[symbol]; pos--) {
+                order[pos] = order[pos - 1u];
+            }
+
+            order[pos] = symbol;
+        }
+
+        for (uint32_t idx = 0u; idx < used_count; idx++) {
+            node_weights[idx] = weights[order[idx]];
+        }
+
+        // Leaves are taken from the sorted symbols, inner nodes are created in non-decreasing weight order
+        const uint32_t node_count = 2u * used_count - 1u;
+        uint32_t       next_leaf  = 0u;
+        uint32_t       next_inner = used_count;
+
+        for (uint32_t node = used_count; node < node_count; node++) {
+            uint32_t children[2];
+
+            for (uint32_t child_idx = 0u; child_idx < 2u; child_idx++) {
+                if (next_leaf < used_count
+                    && (next_inner >= node || node_weights[next_leaf] <= node_weights[next_inner])) {
+                    children[child_idx] = next_leaf++;
+                } else {
+                    children[child_idx] = next_inner++;
+                }
+            }
+
+            node_weights[node]   = node_weights[children[0]] + node_weights[children[1]];
+            parents[children[0]] = (uint16_t) node;
+            parents[children[1]] = (uint16_t) node;
+        }
+
+        uint32_t deepest = 0u;
+
+        depths[node_count - 1u] = 0u;
+
+        for (uint32_t node = node_count - 1u; node-- > 0u;) {
+            depths[node] = (uint8_t) (depths[parents[node]] + 1u);
+            deepest      = (depths[node] > deepest) ? depths[node] : deepest;
+        }
+
+        if (deepest <= max_length) {
+            for (uint32_t idx = 0u; idx < used_count; idx++) {
+                lengths_ptr[order[idx]] = depths[idx];
+            }
+
+            return;
+        }
+
+        for (uint32_t idx = 0u; idx < used_count; idx++) {
+            weights[order[idx]] = (weights[order[idx]] >> 1u) | 1u;
+        }
+    }
+}
+
+/**
+ * @brief Assigns canonical codes to the code lengths, RFC 1951 3.2.2, in the accelerator table format
+ */
+static void own_assign_codes(const uint8_t *const lengths_ptr, const uint32_t symbol_count, uint32_t *const codes_ptr) {
+    uint32_t length_counts[OWN_MAX_CODE_LENGTH + 1u] = {0u};
+    uint32_t next_codes[OWN_MAX_CODE_LENGTH + 1u]    = {0u};
+    uint32_t code                                    = 0u;
+
+    for (uint32_t symbol = 0u; symbol < symbol_count; symbol++) {
+        length_counts[lengths_ptr[symbol]]++;
+    }
+
+    length_counts[0] = 0u;
+
+    for (uint32_t length = 1u; length <= OWN_MAX_CODE_LENGTH; length++) {
+        code               = (code + length_counts[length - 1u]) << 1u;
+        next_codes[length] = code;
+    }
+
+    for (uint32_t symbol = 0u; symbol < symbol_count; symbol++) {
+        const uint32_t length = lengths_ptr[symbol];
+
+        codes_ptr[symbol] = (0u != length) ? own_huffman_code(next_codes[length]++, length) : 0u;
+    }
+}
+
+/**
+ * @brief Makes a symbol count non-zero, deflate decoders reject a code with less than two used symbols
+ */
+static inline void own_ensure_two_symbols(uint32_t *const counts_ptr, const uint32_t symbol_count) {
+    uint32_t used_count = 0u;
+
+    for (uint32_t symbol = 0u; symbol < symbol_count; symbol++) {
+        used_count += (0u != counts_ptr[symbol]) ? 1u : 0u;
+    }
+
+    for (uint32_t symbol = 0u; symbol < symbol_count && used_count < 2u; symbol++) {
+        if (0u == counts_ptr[symbol]) {
+            counts_ptr[symbol] = 1u;
+            used_count++;
+        }
+    }
+}
+
+HW_PATH_IAA_AECS_API(uint32_t, compress_write_deflate_fixed_header, (hw_iaa_aecs_compress *const aecs_ptr,
+                                                                     const uint32_t b_final)) {
+    // Fixed codes of RFC 1951 3.2.6, the device expects them in the histogram area of the AECS
+    uint32_t *const ll_codes_ptr = aecs_ptr->histogram.ll_sym;
+    uint32_t *const d_codes_ptr  = aecs_ptr->histogram.d_sym;
+
+    for (uint32_t symbol = 0u; symbol < 144u; symbol++) {
+        ll_codes_ptr[symbol] = own_huffman_code(0x30u + symbol, 8u);
+    }
+
+    for (uint32_t symbol = 144u; symbol < 256u; symbol++) {
+        ll_codes_ptr[symbol] = own_huffman_code(0x190u + symbol - 144u, 9u);
+    }
+
+    for (uint32_t symbol = 256u; symbol < 280u; symbol++) {
+        ll_codes_ptr[symbol] = own_huffman_code(symbol - 256u, 7u);
+    }
+
+    for (uint32_t symbol = 280u; symbol < QPLC_DEFLATE_LL_TABLE_SIZE; symbol++) {
+        ll_codes_ptr[symbol] = own_huffman_code(0xC0u + symbol - 280u, 8u);
+    }
+
+    for (uint32_t symbol = 0u; symbol < QPLC_DEFLATE_D_TABLE_SIZE; symbol++) {
+        d_codes_ptr[symbol] = own_huffman_code(symbol, 5u);
+    }
+
+    return own_accumulator_append(aecs_ptr,
+                                  (b_final & BFINAL_BIT) | (OWN_DEFLATE_FIXED_BLOCK_TYPE << 1u),
+                                  OWN_DEFLATE_HEADER_BITS);
+}
+
+HW_PATH_IAA_AECS_API(void, compress_accumulator_flush, (hw_iaa_aecs_compress *const aecs_ptr,
+                                                        uint8_t **const next_out_pptr,
+                                                        const uint32_t bits)) {
+    const uint32_t bit_count  = (bits < OWN_OUTPUT_ACCUMULATOR_BITS) ? bits : OWN_OUTPUT_ACCUMULATOR_BITS;
+    const uint32_t byte_count = (bit_count + 7u) >> 3u;
+    uint8_t *const out_ptr    = *next_out_pptr;
+
+    for (uint32_t byte_idx = 0u; byte_idx < byte_count; byte_idx++) {
+        out_ptr[byte_idx] = aecs_ptr->output_accum[byte_idx];
+    }
+
+    // Bits past the valid ones are padding of the last byte
+    if (0u != (bit_count & 7u)) {
+        out_ptr[byte_count - 1u] &= (uint8_t) ((1u << (bit_count & 7u)) - 1u);
+    }
+
+    *next_out_pptr += byte_count;
+
+    hw_iaa_aecs_compress_clean_accumulator(aecs_ptr);
+}
+
+HW_PATH_IAA_AECS_API(void, compress_accumulator_insert_eob, (hw_iaa_aecs_compress *const eacs_deflate_ptr,
+                                                             const hw_huffman_code eob_symbol)) {
+    // Overflow leaves the accumulator as it was, which the caller detects by the unchanged bit count
+    (void) own_accumulator_append(eacs_deflate_ptr,
+                                  own_reverse_code(eob_symbol.code, eob_symbol.length),
+                                  eob_symbol.length);
+}
+
+HW_PATH_IAA_AECS_API(uint32_t, decompress_set_input_accumulator, (hw_iaa_aecs_decompress *const aecs_ptr,
+                                                                  const uint8_t *const source_ptr,
+                                                                  const uint32_t source_size,
+                                                                  const uint8_t ignore_start_bits,
+                                                                  const uint8_t ignore_end_bits)) {
+    // End bits belong to the accumulated byte only if it is the last one of the source
+    const uint32_t end_bits = (1u == source_size) ? ignore_end_bits : 0u;
+
+    if (0u == source_size || ignore_start_bits + end_bits >= 8u) {
+        return 1u;
+    }
+
+    aecs_ptr->input_accum[0]      = (uint64_t) ((source_ptr[0] & (0xFFu >> end_bits)) >> ignore_start_bits);
+    aecs_ptr->input_accum_size[0] = (uint8_t) (8u - ignore_start_bits - end_bits);
+
+    return 0u;
+}
+
+HW_PATH_IAA_AECS_API(uint32_t, compress_write_deflate_dynamic_header, (hw_iaa_aecs_compress *const aecs_ptr,
+                                                                        const uint8_t *const header_ptr,
+                                                                        const uint32_t header_bit_size,
+                                                                        const uint32_t b_final)) {
+    const uint32_t initial_bits = aecs_ptr->num_output_accum_bits;
+
+    if (0u == header_bit_size || initial_bits + header_bit_size > OWN_OUTPUT_ACCUMULATOR_BITS) {
+        return 1u;
+    }
+
+    // The first header bit is BFINAL, it is taken from the argument rather than the prepared header
+    (void) own_accumulator_append(aecs_ptr, b_final & BFINAL_BIT, 1u);
+
+    for (uint32_t bit_idx = 1u; bit_idx < header_bit_size; bit_idx += 8u) {
+        const uint32_t remaining = header_bit_size - bit_idx;
+        const uint32_t chunk     = (remaining < 8u) ? remaining : 8u;
+        const uint32_t value     = ((uint32_t) header_ptr[bit_idx >> 3u]
+                                    | ((uint32_t) header_ptr[(bit_idx + chunk - 1u) >> 3u] << 8u)) >> (bit_idx & 7u);
+
+        (void) own_accumulator_append(aecs_ptr, value, chunk);
+    }
+
+    return 0u;
+}
+
+HW_PATH_IAA_AECS_API(void, compress_set_deflate_huffman_table, (hw_iaa_aecs_compress *const aecs_ptr,
+                                                                const hw_iaa_huffman_codes *const literal_length_codes_ptr,
+                                                                const hw_iaa_huffman_codes *const distance_codes_ptr)) {
+    memcpy(aecs_ptr->histogram.ll_sym, literal_length_codes_ptr, sizeof(aecs_ptr->histogram.ll_sym));
+    memcpy(aecs_ptr->histogram.d_sym, distance_codes_ptr, sizeof(aecs_ptr->histogram.d_sym));
+}
+
+HW_PATH_IAA_AECS_API(void, compress_write_deflate_dynamic_header_from_histogram, (hw_iaa_aecs_compress *const aecs_ptr,
+                                                                                  hw_iaa_histogram *const histogram_ptr,
+                                                                                  const uint32_t b_final)) {
+    uint32_t ll_counts[QPLC_DEFLATE_LL_TABLE_SIZE];
+    uint32_t d_counts[QPLC_DEFLATE_D_TABLE_SIZE];
+    uint8_t  lengths[QPLC_DEFLATE_LL_TABLE_SIZE + QPLC_DEFLATE_D_TABLE_SIZE];
+    uint32_t ll_codes[QPLC_DEFLATE_LL_TABLE_SIZE];
+    uint32_t d_codes[QPLC_DEFLATE_D_TABLE_SIZE];
+
+    // Histogram may be the one of the AECS, whose codes are overwritten below
+    memcpy(ll_counts, histogram_ptr->ll_sym, sizeof(ll_counts));
+    memcpy(d_counts, histogram_ptr->d_sym, sizeof(d_counts));
+
+    ll_counts[OWN_EOB_SYMBOL] = (0u != ll_counts[OWN_EOB_SYMBOL]) ? ll_counts[OWN_EOB_SYMBOL] : 1u;
+    own_ensure_two_symbols(ll_counts, QPLC_DEFLATE_LL_TABLE_SIZE);
+    own_ensure_two_symbols(d_counts, QPLC_DEFLATE_D_TABLE_SIZE);
+
+    own_build_code_lengths(ll_counts, QPLC_DEFLATE_LL_TABLE_SIZE, OWN_MAX_CODE_LENGTH, lengths);
+    own_build_code_lengths(d_counts, QPLC_DEFLATE_D_TABLE_SIZE, OWN_MAX_CODE_LENGTH, lengths + QPLC_DEFLATE_LL_TABLE_SIZE);
+    own_assign_codes(lengths, QPLC_DEFLATE_LL_TABLE_SIZE, ll_codes);
+    own_assign_codes(lengths + QPLC_DEFLATE_LL_TABLE_SIZE, QPLC_DEFLATE_D_TABLE_SIZE, d_codes);
+
+    uint32_t hlit  = QPLC_DEFLATE_LL_TABLE_SIZE;
+    uint32_t hdist = QPLC_DEFLATE_D_TABLE_SIZE;
+
+    for (; hlit > OWN_MIN_HLIT && 0u == lengths[hlit - 1u]; hlit--) {
+    }
+
+    for (; hdist > OWN_MIN_HDIST && 0u == lengths[QPLC_DEFLATE_LL_TABLE_SIZE + hdist - 1u]; hdist--) {
+    }
+
+    // Literal/length and distance lengths are run-length coded as one sequence, RFC 1951 3.2.7
+    uint8_t  sequence[QPLC_DEFLATE_LL_TABLE_SIZE + QPLC_DEFLATE_D_TABLE_SIZE];
+    uint8_t  cl_symbols[QPLC_DEFLATE_LL_TABLE_SIZE + QPLC_DEFLATE_D_TABLE_SIZE];
+    uint8_t  cl_extras[QPLC_DEFLATE_LL_TABLE_SIZE + QPLC_DEFLATE_D_TABLE_SIZE];
+    uint32_t cl_counts[OWN_CL_ALPHABET_SIZE] = {0u};
+    uint32_t sequence_size = 0u;
+    uint32_t cl_size       = 0u;
+
+    for (uint32_t symbol = 0u; symbol < hlit; symbol++) {
+        sequence[sequence_size++] = lengths[symbol];
+    }
+
+    for (uint32_t symbol = 0u; symbol < hdist; symbol++) {
+        sequence[sequence_size++] = lengths[QPLC_DEFLATE_LL_TABLE_SIZE + symbol];
+    }
+
+    for (uint32_t idx = 0u; idx < sequence_size;) {
+        const uint8_t length = sequence[idx];
+        uint32_t      run    = 1u;
+
+        for (; idx + run < sequence_size && sequence[idx + run] == length; run++) {
+        }
+
+        idx += run;
+
+        if (0u == length) {
+            for (; run >= 11u; run -= (run < 138u) ? run : 138u) {
+                cl_symbols[cl_size] = 18u;
+                cl_extras[cl_size++] = (uint8_t) (((run < 138u) ? run : 138u) - 11u);
+            }
+
+            if (run >= 3u) {
+                cl_symbols[cl_size] = 17u;
+                cl_extras[cl_size++] = (uint8_t) (run - 3u);
+                run = 0u;
+            }
+        } else {
+            cl_symbols[cl_size] = length;
+            cl_extras[cl_size++] = 0u;
+
+            for (run--; run >= 3u; run -= (run < 6u) ? run : 6u) {
+                cl_symbols[cl_size] = 16u;
+                cl_extras[cl_size++] = (uint8_t) (((run < 6u) ? run : 6u) - 3u);
+            }
+        }
+
+        for (; run > 0u; run--) {
+            cl_symbols[cl_size] = length;
+            cl_extras[cl_size++] = 0u;
+        }
+    }
+
+    for (uint32_t idx = 0u; idx < cl_size; idx++) {
+        cl_counts[cl_symbols[idx]]++;
+    }
+
+    uint8_t  cl_lengths[OWN_CL_ALPHABET_SIZE];
+    uint32_t cl_codes[OWN_CL_ALPHABET_SIZE];
+    uint32_t hclen = OWN_CL_ALPHABET_SIZE;
+
+    own_ensure_two_symbols(cl_counts, OWN_CL_ALPHABET_SIZE);
+    own_build_code_lengths(cl_counts, OWN_CL_ALPHABET_SIZE, OWN_MAX_CL_CODE_LENGTH, cl_lengths);
+    own_assign_codes(cl_lengths, OWN_CL_ALPHABET_SIZE, cl_codes);
+
+    for (; hclen > OWN_MIN_HCLEN && 0u == cl_lengths[own_cl_order[hclen - 1u]]; hclen--) {
+    }
+
+    uint8_t          header[OWN_MAX_HEADER_BYTES] = {0u};
+    own_bit_writer_t writer                       = {header, 0u};
+
+    own_write_bits(&writer, b_final & BFINAL_BIT, 1u);
+    own_write_bits(&writer, OWN_DEFLATE_DYNAMIC_BLOCK_TYPE, 2u);
+    own_write_bits(&writer, hlit - OWN_MIN_HLIT, 5u);
+    own_write_bits(&writer, hdist - OWN_MIN_HDIST, 5u);
+    own_write_bits(&writer, hclen - OWN_MIN_HCLEN, 4u);
+
+    for (uint32_t idx = 0u; idx < hclen; idx++) {
+        own_write_bits(&writer, cl_lengths[own_cl_order[idx]], 3u);
+    }
+
+    for (uint32_t idx = 0u; idx < cl_size; idx++) {
+        static const uint8_t extra_bits[3] = {2u, 3u, 7u};
+
+        own_write_code(&writer, cl_codes[cl_symbols[idx]]);
+
+        if (cl_symbols[idx] >= 16u) {
+            own_write_bits(&writer, cl_extras[idx], extra_bits[cl_symbols[idx] - 16u]);
+        }
+    }
+
+    // A header that doesn't fit the accumulator is replaced with the always fitting fixed one
+    if (0u != hw_iaa_aecs_compress_write_deflate_dynamic_header(aecs_ptr, header, writer.bit_count, b_final)) {
+        (void) hw_iaa_aecs_compress_write_deflate_fixed_header(aecs_ptr, b_final);
+        return;
+    }
+
+    hw_iaa_aecs_compress_set_deflate_huffman_table(aecs_ptr, ll_codes, d_codes);
+}
@@ -0,0 +1,584 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+#include "hw_arbiter.hpp"
+#include "hw_util.hpp"
+#include "hw_queue.hpp"
+#include "hw_devices.h"
+
+#define OWN_SEGMENT_MAGIC       0x42524151u     /**< "QARB" */
+#define OWN_SEGMENT_VERSION     1u              /**< Bumped on any segment layout change */
+#define OWN_ATTACH_TIMEOUT_NS   1000000000u     /**< Time the creator of the segment has to initialize it */
+#define OWN_REAP_INTERVAL_NS    100000000u      /**< Throttled processes look for dead slots at most this often */
+#define OWN_TAG_SLOT_BITS       16u             /**< Low bits of a queue tag hold the slot plus one */
+#define OWN_TAG_SLOT_MASK       0xffffu         /**< Slot part of a queue tag */
+#define OWN_TAG_NO_SLOT         0xffffu         /**< Slot part of a queue the segment has no room for */
+
+static const char *arbiter_env        = "QPL_WQ_ARBITER";
+static const char *arbiter_tokens_env = "QPL_WQ_ARBITER_TOKENS";
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<int32_t>::is_always_lock_free,
+              "Counters in the shared segment must be address-free");
+
+/**
+ * @brief Work queue entry of the segment, matched by the portal path
+ */
+struct alignas(64) own_shared_queue_t {
+    uint32_t is_registered;      /**< Non-zero once the entry describes a queue */
+    uint32_t size;               /**< Number of WQ entries */
+    char     portal_path[64];    /**< Character device of the queue */
+
+    alignas(64) std::atomic<uint32_t> in_flight;       /**< Tracked descriptors of all processes */
+    std::atomic<uint32_t>             active_tokens;   /**< Tokens of the processes that submitted to the queue */
+};
+
+/**
+ * @brief Process entry of the segment
+ */
+struct alignas(64) own_shared_process_t {
+    static constexpr uint32_t max_queues = qpl::ml::dispatcher::hw_arbiter::max_queues;
+
+    std::atomic<int32_t>  pid;                      /**< Owner, 0 if free, negative while reclaimed */
+    std::atomic<uint32_t> tokens;                   /**< Weight of the owner */
+    std::atomic<uint32_t> in_flight[max_queues];    /**< Tracked descriptors per queue */
+    std::atomic<uint8_t>  is_active[max_queues];    /**< Tokens of the owner are counted on the queue */
+};
+
+/**
+ * @brief Subtracts up to the given amount without wrapping, returns what was subtracted
+ */
+static inline auto own_subtract(std::atomic<uint32_t> &counter, const uint32_t amount) noexcept -> uint32_t {
+    uint32_t value = counter.load(std::memory_order_relaxed);
+
+    while (0u != value) {
+        const uint32_t subtracted = std::min(value, amount);
+
+        if (counter.compare_exchange_weak(value, value - subtracted, std::memory_order_relaxed)) {
+            return subtracted;
+        }
+    }
+
+    return 0u;
+}
+
+/**
+ * @brief Locks the segment, a lock its holder died with is taken over
+ */
+static inline auto own_lock(pthread_mutex_t *mutex_ptr) noexcept -> bool {
+    const int status = pthread_mutex_lock(mutex_ptr);
+
+    // Every table change is finished by a single store, and a reclaim cut short is resumed by the next one
+    if (EOWNERDEAD == status) {
+        return 0 == pthread_mutex_consistent(mutex_ptr);
+    }
+
+    return 0 == status;
+}
+
+/**
+ * @brief Entries of the calling process once the queue is past its reserve
+ */
+static inline auto own_get_share(const uint32_t size,
+                                 const uint32_t tokens,
+                                 const uint32_t active_tokens,
+                                 const bool is_active) noexcept -> uint32_t {
+    const uint64_t total_tokens = std::max<uint64_t>((uint64_t) active_tokens + (is_active ? 0u : tokens), tokens);
+    const uint64_t share        = (uint64_t) size * tokens / std::max<uint64_t>(total_tokens, 1u);
+
+    return std::max<uint32_t>(static_cast<uint32_t>(share), 1u);
+}
+
+namespace qpl::ml::dispatcher {
+
+/**
+ * @brief Layout of the shared-memory segment
+ */
+struct hw_arbiter::segment_t {
+    std::atomic<uint32_t> magic;                        /**< OWN_SEGMENT_MAGIC once initialized */
+    uint32_t              version;                      /**< OWN_SEGMENT_VERSION of the creator */
+    uint32_t              segment_size;                 /**< sizeof(segment_t) of the creator */
+    uint32_t              queue_capacity;               /**< max_queues of the creator */
+    uint32_t              process_capacity;             /**< max_processes of the creator */
+    pthread_mutex_t       lock;                         /**< Process-shared robust lock of the tables */
+    own_shared_queue_t    queues[max_queues];           /**< Queues registered by any process */
+    own_shared_process_t  processes[max_processes];     /**< Attached processes */
+};
+
+/**
+ * @brief Opens or creates the segment and maps it, nullptr on failure
+ */
+static auto own_map_segment(const char *name_ptr, const size_t segment_size, bool &is_created) noexcept -> void * {
+    int fd = shm_open(name_ptr, O_RDWR | O_CREAT | O_EXCL, 0660);
+
+    is_created = 0 <= fd;
+
+    if (!is_created && EEXIST == errno) {
+        fd = shm_open(name_ptr, O_RDWR, 0);
+    }
+
+    if (0 > fd) {
+        return nullptr;
+    }
+
+    if (is_created && 0 != ftruncate(fd, static_cast<off_t>(segment_size))) {
+        close(fd);
+        shm_unlink(name_ptr);
+        return nullptr;
+    }
+
+    // Process that created the segment may not have sized it yet
+    const uint64_t deadline_ns = hw_now_ns() + OWN_ATTACH_TIMEOUT_NS;
+    struct stat    segment_stat = {};
+
+    while (0 == fstat(fd, &segment_stat) && static_cast<size_t>(segment_stat.st_size) < segment_size) {
+        if (hw_now_ns() > deadline_ns) {
+            close(fd);
+            return nullptr;
+        }
+
+        sched_yield();
+    }
+
+    void *segment_ptr = mmap(nullptr, segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    return (MAP_FAILED != segment_ptr) ? segment_ptr : nullptr;
+}
+
+hw_arbiter::hw_arbiter() noexcept {
+    const char *name_ptr = getenv(arbiter_env);
+
+    if (nullptr == name_ptr || '\0' == name_ptr[0]) {
+        return;
+    }
+
+    const char *tokens_ptr = getenv(arbiter_tokens_env);
+    const auto tokens      = (nullptr != tokens_ptr) ? static_cast<uint32_t>(strtoul(tokens_ptr, nullptr, 10)) : 0u;
+
+    const auto status = hw_arbiter::attach(name_ptr, tokens);
+
+    DIAG("arbiter %s: %s\n", name_ptr, (QPL_STS_OK == status) ? "attached" : "can't attach");
+    (void) status;
+}
+
+hw_arbiter::~hw_arbiter() noexcept {
+    hw_arbiter::detach();
+}
+
+auto hw_arbiter::get_instance() noexcept -> hw_arbiter & {
+    static hw_arbiter instance{};
+
+    return instance;
+}
+
+auto hw_arbiter::attach(const char *name_ptr, uint32_t tokens) noexcept -> qpl_status {
+    if (nullptr == name_ptr || '\0' == name_ptr[0]) {
+        return QPL_STS_INVALID_PARAM_ERR;
+    }
+
+    std::lock_guard<std::mutex> guard(attach_mutex_);
+
+    if (is_attached_.load(std::memory_order_relaxed)) {
+        return QPL_STS_BEING_PROCESSED;
+    }
+
+    char shm_name[NAME_MAX];
+    const int length = snprintf(shm_name, sizeof(shm_name), "%s%s", ('/' == name_ptr[0]) ? "" : "/", name_ptr);
+
+    if (0 > length || static_cast<size_t>(length) >= sizeof(shm_name)) {
+        return QPL_STS_INVALID_PARAM_ERR;
+    }
+
+    bool is_created   = false;
+    auto *segment_ptr = static_cast<segment_t *>(own_map_segment(shm_name, sizeof(segment_t), is_created));
+
+    if (nullptr == segment_ptr) {
+        return QPL_STS_LIBRARY_INTERNAL_ERR;
+    }
+
+    if (is_created) {
+        pthread_mutexattr_t attributes;
+
+        pthread_mutexattr_init(&attributes);
+        pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+        pthread_mutex_init(&segment_ptr->lock, &attributes);
+        pthread_mutexattr_destroy(&attributes);
+
+        segment_ptr->version          = OWN_SEGMENT_VERSION;
+        segment_ptr->segment_size     = sizeof(segment_t);
+        segment_ptr->queue_capacity   = max_queues;
+        segment_ptr->process_capacity = max_processes;
+        segment_ptr->magic.store(OWN_SEGMENT_MAGIC, std::memory_order_release);
+    }
+
+    const uint64_t deadline_ns = hw_now_ns() + OWN_ATTACH_TIMEOUT_NS;
+
+    while (OWN_SEGMENT_MAGIC != segment_ptr->magic.load(std::memory_order_acquire) && hw_now_ns() < deadline_ns) {
+        sched_yield();
+    }
+
+    // Segment of another build, or one its creator never finished
+    if (OWN_SEGMENT_MAGIC != segment_ptr->magic.load(std::memory_order_acquire)
+        || OWN_SEGMENT_VERSION != segment_ptr->version
+        || sizeof(segment_t) != segment_ptr->segment_size
+        || max_queues != segment_ptr->queue_capacity
+        || max_processes != segment_ptr->process_capacity) {
+        munmap(segment_ptr, sizeof(segment_t));
+        return QPL_STS_LIBRARY_INTERNAL_ERR;
+    }
+
+    // A segment mapped by an earlier attach stays mapped, submissions racing with the detach may still read it
+    segment_ptr_.store(segment_ptr, std::memory_order_release);
+
+    int32_t process_slot = -1;
+
+    if (own_lock(&segment_ptr->lock)) {
+        reaped_.fetch_add(hw_arbiter::reap_locked(), std::memory_order_relaxed);
+
+        for (uint32_t slot = 0u; slot < max_processes && 0 > process_slot; slot++) {
+            auto &process = segment_ptr->processes[slot];
+
+            if (0 == process.pid.load(std::memory_order_relaxed)) {
+                process.tokens.store((0u != tokens) ? tokens : default_tokens, std::memory_order_relaxed);
+                process.pid.store(getpid(), std::memory_order_release);
+                process_slot = static_cast<int32_t>(slot);
+            }
+        }
+
+        pthread_mutex_unlock(&segment_ptr->lock);
+    }
+
+    if (0 > process_slot) {
+        return QPL_STS_LIBRARY_INTERNAL_ERR;
+    }
+
+    process_slot_.store(static_cast<uint32_t>(process_slot), std::memory_order_relaxed);
+    generation_.fetch_add(1u, std::memory_order_release);
+    is_attached_.store(true, std::memory_order_release);
+
+    return QPL_STS_OK;
+}
+
+void hw_arbiter::detach() noexcept {
+    std::lock_guard<std::mutex> guard(attach_mutex_);
+
+    if (!is_attached_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    is_attached_.store(false, std::memory_order_release);
+
+    auto *segment_ptr = segment_ptr_.load(std::memory_order_relaxed);
+
+    if (own_lock(&segment_ptr->lock)) {
+        hw_arbiter::release_process(process_slot_.load(std::memory_order_relaxed));
+        pthread_mutex_unlock(&segment_ptr->lock);
+    }
+}
+
+auto hw_arbiter::is_attached() const noexcept -> bool {
+    return is_attached_.load(std::memory_order_acquire);
+}
+
+void hw_arbiter::set_tokens(uint32_t tokens) noexcept {
+    std::lock_guard<std::mutex> guard(attach_mutex_);
+
+    if (!is_attached_.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    tokens = (0u != tokens) ? tokens : default_tokens;
+
+    auto       *segment_ptr = segment_ptr_.load(std::memory_order_relaxed);
+    auto       &process     = segment_ptr->processes[process_slot_.load(std::memory_order_relaxed)];
+    const auto old_tokens   = process.tokens.exchange(tokens, std::memory_order_relaxed);
+
+    for (uint32_t slot = 0u; slot < max_queues; slot++) {
+        if (0u != process.is_active[slot].load(std::memory_order_relaxed)) {
+            auto &queue = segment_ptr->queues[slot];
+
+            queue.active_tokens.fetch_add(tokens, std::memory_order_relaxed);
+            (void) own_subtract(queue.active_tokens, old_tokens);
+        }
+    }
+}
+
+auto hw_arbiter::get_tokens() const noexcept -> uint32_t {
+    if (!is_attached_.load(std::memory_order_acquire)) {
+        return 0u;
+    }
+
+    const auto *segment_ptr = segment_ptr_.load(std::memory_order_relaxed);
+
+    return segment_ptr->processes[process_slot_.load(std::memory_order_relaxed)].tokens.load(std::memory_order_relaxed);
+}
+
+auto hw_arbiter::resolve(const hw_queue &queue) noexcept -> int32_t {
+    const uint32_t generation = generation_.load(std::memory_order_acquire) & OWN_TAG_SLOT_MASK;
+    const uint32_t tag        = queue.get_arbiter_tag();
+
+    if (generation == (tag >> OWN_TAG_SLOT_BITS) && 0u != (tag & OWN_TAG_SLOT_MASK)) {
+        const uint32_t slot = tag & OWN_TAG_SLOT_MASK;
+
+        return (OWN_TAG_NO_SLOT != slot) ? static_cast<int32_t>(slot - 1u) : -1;
+    }
+
+    auto       *segment_ptr = segment_ptr_.load(std::memory_order_acquire);
+    const char *path_ptr    = queue.get_portal_path();
+    int32_t    queue_slot   = -1;
+
+    if (nullptr == segment_ptr || !own_lock(&segment_ptr->lock)) {
+        return -1;
+    }
+
+    int32_t free_slot = -1;
+
+    for (uint32_t slot = 0u; slot < max_queues && 0 > queue_slot; slot++) {
+        const auto &shared = segment_ptr->queues[slot];
+
+        if (0u == shared.is_registered) {
+            free_slot = (0 > free_slot) ? static_cast<int32_t>(slot) : free_slot;
+        } else if (0 == strncmp(shared.portal_path, path_ptr, sizeof(shared.portal_path))) {
+            queue_slot = static_cast<int32_t>(slot);
+        }
+    }
+
+    if (0 > queue_slot && 0 <= free_slot) {
+        auto &shared = segment_ptr->queues[free_slot];
+
+        strncpy(shared.portal_path, path_ptr, sizeof(shared.portal_path) - 1u);
+        shared.portal_path[sizeof(shared.portal_path) - 1u] = '\0';
+        shared.size          = queue.get_size();
+        shared.is_registered = 1u;
+
+        queue_slot = free_slot;
+    }
+
+    pthread_mutex_unlock(&segment_ptr->lock);
+
+    // Queue the table has no room for is remembered, so it doesn't take the lock on every submission
+    const uint32_t slot_tag = (0 <= queue_slot) ? static_cast<uint32_t>(queue_slot) + 1u : OWN_TAG_NO_SLOT;
+
+    queue.set_arbiter_tag((generation << OWN_TAG_SLOT_BITS) | slot_tag);
+
+    return queue_slot;
+}
+
+auto hw_arbiter::is_admitted(const hw_queue &queue) noexcept -> bool {
+    if (!is_attached_.load(std::memory_order_acquire)) {
+        return true;
+    }
+
+    const int32_t queue_slot = hw_arbiter::resolve(queue);
+
+    if (0 > queue_slot) {
+        return true;
+    }
+
+    auto       *segment_ptr = segment_ptr_.load(std::memory_order_relaxed);
+    const auto &shared      = segment_ptr->queues[queue_slot];
+
+    // Queue with more than the reserve free takes anyone
+    if (shared.in_flight.load(std::memory_order_relaxed) + shared.size / reserve_denominator < shared.size) {
+        return true;
+    }
+
+    const auto     &process  = segment_ptr->processes[process_slot_.load(std::memory_order_relaxed)];
+    const uint32_t share     = own_get_share(shared.size,
+                                             process.tokens.load(std::memory_order_relaxed),
+                                             shared.active_tokens.load(std::memory_order_relaxed),
+                                             0u != process.is_active[queue_slot].load(std::memory_order_relaxed));
+
+    if (process.in_flight[queue_slot].load(std::memory_order_relaxed) < share) {
+        return true;
+    }
+
+    throttles_.fetch_add(1u, std::memory_order_relaxed);
+
+    // Slots of dead processes keep their descriptors counted, so a throttled process checks for them now and then
+    const uint64_t now_ns       = hw_now_ns();
+    uint64_t       last_reap_ns = last_reap_ns_.load(std::memory_order_relaxed);
+
+    if (now_ns - last_reap_ns > OWN_REAP_INTERVAL_NS
+        && last_reap_ns_.compare_exchange_strong(last_reap_ns, now_ns, std::memory_order_relaxed)) {
+        (void) hw_arbiter::reap_dead_processes();
+    }
+
+    return false;
+}
+
+void hw_arbiter::on_submit(const hw_queue &queue) noexcept {
+    if (!is_attached_.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    const int32_t queue_slot = hw_arbiter::resolve(queue);
+
+    if (0 > queue_slot) {
+        return;
+    }
+
+    auto *segment_ptr = segment_ptr_.load(std::memory_order_relaxed);
+    auto &shared      = segment_ptr->queues[queue_slot];
+    auto &process     = segment_ptr->processes[process_slot_.load(std::memory_order_relaxed)];
+
+    process.in_flight[queue_slot].fetch_add(1u, std::memory_order_relaxed);
+    shared.in_flight.fetch_add(1u, std::memory_order_relaxed);
+
+    // Tokens join the queue on the first submission and stay until the process leaves
+    if (0u == process.is_active[queue_slot].load(std::memory_order_relaxed)
+        && 0u == process.is_active[queue_slot].exchange(1u, std::memory_order_relaxed)) {
+        shared.active_tokens.fetch_add(process.tokens.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+void hw_arbiter::on_complete(const hw_queue &queue) noexcept {
+    if (!is_attached_.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    const int32_t queue_slot = hw_arbiter::resolve(queue);
+
+    if (0 > queue_slot) {
+        return;
+    }
+
+    auto *segment_ptr = segment_ptr_.load(std::memory_order_relaxed);
+    auto &process     = segment_ptr->processes[process_slot_.load(std::memory_order_relaxed)];
+
+    // Descriptors submitted before the attach were never counted
+    if (0u != own_subtract(process.in_flight[queue_slot], 1u)) {
+        (void) own_subtract(segment_ptr->queues[queue_slot].in_flight, 1u);
+    }
+}
+
+auto hw_arbiter::get_global_in_flight(const hw_queue &queue, uint32_t &in_flight) noexcept -> bool {
+    if (!is_attached_.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    const int32_t queue_slot = hw_arbiter::resolve(queue);
+
+    if (0 > queue_slot) {
+        return false;
+    }
+
+    in_flight = segment_ptr_.load(std::memory_order_relaxed)->queues[queue_slot].in_flight.load(std::memory_order_relaxed);
+
+    return true;
+}
+
+auto hw_arbiter::get_queue_state(const hw_queue &queue, hw_arbiter_queue_state_t &state) noexcept -> bool {
+    if (!is_attached_.load(std::memory_order_acquire)) {
+        return false;
+    }
+
+    const int32_t queue_slot = hw_arbiter::resolve(queue);
+
+    if (0 > queue_slot) {
+        return false;
+    }
+
+    const auto *segment_ptr = segment_ptr_.load(std::memory_order_relaxed);
+    const auto &shared      = segment_ptr->queues[queue_slot];
+    const auto &process     = segment_ptr->processes[process_slot_.load(std::memory_order_relaxed)];
+
+    state.size          = shared.size;
+    state.in_flight     = shared.in_flight.load(std::memory_order_relaxed);
+    state.own_in_flight = process.in_flight[queue_slot].load(std::memory_order_relaxed);
+    state.active_tokens = shared.active_tokens.load(std::memory_order_relaxed);
+    state.share         = own_get_share(shared.size,
+                                        process.tokens.load(std::memory_order_relaxed),
+                                        state.active_tokens,
+                                        0u != process.is_active[queue_slot].load(std::memory_order_relaxed));
+
+    return true;
+}
+
+auto hw_arbiter::get_stats() const noexcept -> hw_arbiter_stats_t {
+    hw_arbiter_stats_t stats;
+
+    stats.throttles = throttles_.load(std::memory_order_relaxed);
+    stats.reaped    = reaped_.load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+auto hw_arbiter::reap_dead_processes() noexcept -> uint32_t {
+    if (!is_attached_.load(std::memory_order_acquire)) {
+        return 0u;
+    }
+
+    auto     *segment_ptr = segment_ptr_.load(std::memory_order_relaxed);
+    uint32_t reaped_count = 0u;
+
+    if (own_lock(&segment_ptr->lock)) {
+        reaped_count = hw_arbiter::reap_locked();
+        pthread_mutex_unlock(&segment_ptr->lock);
+    }
+
+    reaped_.fetch_add(reaped_count, std::memory_order_relaxed);
+
+    return reaped_count;
+}
+
+auto hw_arbiter::reap_locked() noexcept -> uint32_t {
+    auto     *segment_ptr = segment_ptr_.load(std::memory_order_relaxed);
+    uint32_t reaped_count = 0u;
+
+    for (uint32_t slot = 0u; slot < max_processes; slot++) {
+        auto          &process = segment_ptr->processes[slot];
+        const int32_t pid      = process.pid.load(std::memory_order_relaxed);
+
+        // Negative pid is a reclaim whose process died holding the lock
+        if (0 == pid || (0 < pid && (0 == kill(pid, 0) || ESRCH != errno))) {
+            continue;
+        }
+
+        process.pid.store(-std::abs(pid), std::memory_order_relaxed);
+        hw_arbiter::release_process(slot);
+
+        reaped_count++;
+    }
+
+    return reaped_count;
+}
+
+void hw_arbiter::release_process(const uint32_t process_slot) noexcept {
+    auto *segment_ptr = segment_ptr_.load(std::memory_order_relaxed);
+    auto &process     = segment_ptr->processes[process_slot];
+
+    const uint32_t tokens = process.tokens.load(std::memory_order_relaxed);
+
+    for (uint32_t slot = 0u; slot < max_queues; slot++) {
+        auto &shared = segment_ptr->queues[slot];
+
+        (void) own_subtract(shared.in_flight, process.in_flight[slot].exchange(0u, std::memory_order_relaxed));
+
+        if (0u != process.is_active[slot].exchange(0u, std::memory_order_relaxed)) {
+            (void) own_subtract(shared.active_tokens, tokens);
+        }
+    }
+
+    process.tokens.store(0u, std::memory_order_relaxed);
+    process.pid.store(0, std::memory_order_release);
+}
+
+}
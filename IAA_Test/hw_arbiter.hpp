@@ -0,0 +1,170 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_ARBITER_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_ARBITER_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "status.h"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief View of one shared work queue across the processes attached to the arbiter
+ */
+struct hw_arbiter_queue_state_t {
+    uint32_t size          = 0u;    /**< Number of WQ entries */
+    uint32_t in_flight     = 0u;    /**< Tracked descriptors of all processes */
+    uint32_t own_in_flight = 0u;    /**< Tracked descriptors of the calling process */
+    uint32_t active_tokens = 0u;    /**< Tokens of the processes that submitted to the queue */
+    uint32_t share         = 0u;    /**< Entries the calling process is entitled to once the queue is busy */
+};
+
+/**
+ * @brief Counters of the calling process
+ */
+struct hw_arbiter_stats_t {
+    uint64_t throttles = 0u;    /**< Submissions kept off a queue because the process was over its share */
+    uint64_t reaped    = 0u;    /**< Slots of dead processes reclaimed by the calling process */
+};
+
+class hw_queue;
+
+/**
+ * @brief Fair sharing of shared work queues between processes through a shared-memory segment.
+ *
+ * @details Processes that map the same portals submit to the same queues, and the ENQCMD retry loop of each one
+ * only sees its own jobs. Attached processes publish their tracked descriptors per queue in a POSIX shared-memory
+ * segment, keyed by the portal path, so every one of them sees how full a queue is overall:
+ * hw_queue::get_occupancy() and with it the queue policy and the congestion backoff work on the global count.
+ *
+ * Every process holds a number of tokens. A queue with more than the reserve of its entries free takes any
+ * submission. Past that point a process is admitted only while it has fewer descriptors in flight than its
+ * share, the queue size split by the tokens of the processes that have submitted to the queue since they
+ * attached. A bulk process thus fills an otherwise idle queue up to the reserve, and once another process shows
+ * up it is held to its share, leaving the rest of the entries to the other process. A refused submission moves
+ * on to the next queue as a rejected ENQCMD does, and ends in @ref hw_backpressure when no queue admits it.
+ *
+ * Only descriptors tracked until completion, that is submitted with a queue_pptr, are counted; the others are
+ * admitted under the same rule. Dedicated queues have a single submitter and are not arbitrated.
+ *
+ * The arbiter is opt-in: @ref attach joins or creates the segment, the first use of the instance does it for the
+ * segment named by the `QPL_WQ_ARBITER` environment variable with the tokens of `QPL_WQ_ARBITER_TOKENS`.
+ * The segment outlives its processes. Slots of processes that exited without @ref detach are reclaimed by the
+ * next process that attaches or is throttled, their descriptors are taken off the queue counts.
+ */
+class hw_arbiter final {
+public:
+    static constexpr uint32_t max_queues          = 256u;   /**< Distinct work queues in a segment */
+    static constexpr uint32_t max_processes       = 64u;    /**< Processes attached to a segment at once */
+    static constexpr uint32_t default_tokens      = 1u;     /**< Tokens of a process that sets none */
+    static constexpr uint32_t reserve_denominator = 4u;     /**< A quarter of each queue is kept for processes under their share */
+
+    static auto get_instance() noexcept -> hw_arbiter &;
+
+    /**
+     * @brief Joins the segment, creating it if no process did yet
+     *
+     * @param name_ptr POSIX shared-memory object name, a leading '/' is added if missing
+     * @param tokens   weight of the calling process, 0 is taken as @ref default_tokens
+     *
+     * @return QPL_STS_OK, QPL_STS_BEING_PROCESSED if already attached, QPL_STS_INVALID_PARAM_ERR for an empty name,
+     * or QPL_STS_LIBRARY_INTERNAL_ERR if the segment can't be mapped, is of another layout or has no free slot
+     */
+    auto attach(const char *name_ptr, uint32_t tokens = default_tokens) noexcept -> qpl_status;
+
+    /**
+     * @brief Leaves the segment, the descriptors still in flight are taken off the queue counts
+     */
+    void detach() noexcept;
+
+    [[nodiscard]] auto is_attached() const noexcept -> bool;
+
+    /**
+     * @brief Changes the tokens of the calling process, queues it already uses are updated at once
+     */
+    void set_tokens(uint32_t tokens) noexcept;
+
+    [[nodiscard]] auto get_tokens() const noexcept -> uint32_t;
+
+    /**
+     * @brief Whether the calling process may submit to the queue now, always true if not attached
+     */
+    [[nodiscard]] auto is_admitted(const hw_queue &queue) noexcept -> bool;
+
+    /**
+     * @brief Counts a tracked descriptor the queue accepted
+     */
+    void on_submit(const hw_queue &queue) noexcept;
+
+    /**
+     * @brief Takes a completed tracked descriptor off the counts
+     */
+    void on_complete(const hw_queue &queue) noexcept;
+
+    /**
+     * @brief Tracked descriptors of all attached processes on the queue
+     *
+     * @return false if not attached or the queue has no slot in the segment
+     */
+    [[nodiscard]] auto get_global_in_flight(const hw_queue &queue, uint32_t &in_flight) noexcept -> bool;
+
+    [[nodiscard]] auto get_queue_state(const hw_queue &queue, hw_arbiter_queue_state_t &state) noexcept -> bool;
+
+    [[nodiscard]] auto get_stats() const noexcept -> hw_arbiter_stats_t;
+
+    /**
+     * @brief Reclaims the slots of processes that exited while attached
+     *
+     * @return Number of slots reclaimed
+     */
+    auto reap_dead_processes() noexcept -> uint32_t;
+
+    hw_arbiter(const hw_arbiter &) = delete;
+
+    auto operator=(const hw_arbiter &) -> hw_arbiter & = delete;
+
+private:
+    struct segment_t;
+
+    hw_arbiter() noexcept;
+
+    ~hw_arbiter() noexcept;
+
+    /**
+     * @brief Slot of the queue in the segment, registered on the first call, -1 if the table is full
+     */
+    [[nodiscard]] auto resolve(const hw_queue &queue) noexcept -> int32_t;
+
+    /**
+     * @brief Gives back the descriptors and tokens of a process slot and frees it, the segment lock is held
+     */
+    void release_process(uint32_t process_slot) noexcept;
+
+    /**
+     * @brief Releases the slots of dead processes, the segment lock is held
+     */
+    auto reap_locked() noexcept -> uint32_t;
+
+    std::atomic<segment_t *> segment_ptr_  = nullptr;  /**< Mapped segment, kept mapped after @ref detach */
+    std::atomic<bool>        is_attached_  = false;    /**< Segment is mapped and the process has a slot */
+    std::atomic<uint32_t>    generation_   = 0u;       /**< Bumped on every attach, invalidates the queue slot tags */
+    std::atomic<uint32_t>    process_slot_ = 0u;       /**< Slot of the calling process */
+    std::atomic<uint64_t>    last_reap_ns_ = 0u;       /**< Time of the last reclaim scan */
+    std::atomic<uint64_t>    throttles_    = 0u;       /**< See @ref hw_arbiter_stats_t */
+    std::atomic<uint64_t>    reaped_       = 0u;       /**< See @ref hw_arbiter_stats_t */
+    std::mutex               attach_mutex_;            /**< Guards attach, detach and token changes */
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_ARBITER_HPP_
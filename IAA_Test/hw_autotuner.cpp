@@ -0,0 +1,743 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <cpuid.h>
+#include <immintrin.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "hw_autotuner.hpp"
+#include "hw_util.hpp"
+#include "hw_dispatcher.hpp"
+#include "hw_completion_engine.hpp"
+#include "hw_cpu_executor.hpp"
+#include "hw_descriptors_api.h"
+#include "hw_aecs_api.h"
+#include "hw_iaa_flags.h"
+
+#define OWN_PROFILE_MAGIC       0x4e555451u             /**< "QTUN" */
+#define OWN_PROFILE_VERSION     1u                      /**< Bumped on any layout or measurement change */
+#define OWN_FILE_MAX_LENGTH     128u                    /**< Longest content of a fingerprinted file that is hashed */
+#define OWN_CPULIST_MAX_LENGTH  4096u                   /**< Longest NUMA node CPU list that is parsed */
+#define OWN_TUNING_MIN_SIZE     256u                    /**< First `source-1` size measured */
+#define OWN_TUNING_MAX_SIZE     262144u                 /**< Last `source-1` size measured */
+#define OWN_TUNING_JOBS         32u                     /**< Descriptors timed at once */
+#define OWN_TUNING_REPEATS      3u                      /**< Measurements of one size, the fastest counts */
+#define OWN_TUNING_GRANULARITY  64u                     /**< Crossovers are rounded up to it */
+#define OWN_TUNING_TIMEOUT_NS   1000000000ull           /**< Longest time every queue may refuse a measurement */
+#define OWN_CRC64_POLYNOMIAL    0x42F0E1EBA9EA3693ull   /**< ECMA-182, the speed doesn't depend on it */
+
+static const char *tuning_profile_env  = "QPL_TUNING_PROFILE";
+static const char *fingerprint_paths[] = {"/sys/devices/system/cpu/cpu0/microcode/version",
+                                          "/sys/class/dmi/id/bios_version",
+                                          "/sys/class/dmi/id/bios_date",
+                                          "/proc/sys/kernel/osrelease"};
+
+/**
+ * @brief Profile file header, a crossover per NUMA node and family follows it, families of a node together
+ */
+struct own_profile_header_t {
+    uint32_t magic;                 /**< Must be OWN_PROFILE_MAGIC */
+    uint32_t version;               /**< Must be OWN_PROFILE_VERSION */
+    uint32_t operation_count;       /**< Families per node of the writer */
+    uint32_t numa_node_count;       /**< Nodes of the writer */
+    uint64_t fingerprint;           /**< Host fingerprint at the time of tuning */
+};
+
+/**
+ * @brief 64-byte block, descriptors, completion records and the AECS of the measurements are carved from them
+ */
+struct alignas(64) own_block_t {
+    uint8_t bytes[64];
+};
+
+/**
+ * @brief Buffers of a tuning run, shared by every family and node
+ */
+struct own_tuning_buffers_t {
+    std::unique_ptr<uint8_t[]>     src;                 /**< Source of every descriptor */
+    std::unique_ptr<uint8_t[]>     dst;                 /**< Destination of every descriptor, dst_stride apart */
+    std::unique_ptr<own_block_t[]> blocks;              /**< Descriptors, records, batches and the AECS */
+    hw_descriptor                  *descs_ptr         = nullptr;
+    hw_completion_record           *records_ptr       = nullptr;
+    hw_descriptor                  *batch_descs_ptr   = nullptr;
+    hw_completion_record           *batch_records_ptr = nullptr;
+    hw_iaa_aecs_analytic           *aecs_ptr          = nullptr;
+    uint32_t                       dst_stride         = 0u;
+};
+
+static inline auto own_hash_file(const uint64_t hash, const char *path_ptr) noexcept -> uint64_t {
+    char content[OWN_FILE_MAX_LENGTH] = {};
+    FILE *file_ptr = fopen(path_ptr, "r");
+
+    if (nullptr == file_ptr) {
+        return qpl::ml::dispatcher::hw_fnv_hash(hash, content, 1u);
+    }
+
+    const size_t length = fread(content, 1u, sizeof(content), file_ptr);
+    fclose(file_ptr);
+
+    return qpl::ml::dispatcher::hw_fnv_hash(hash, content, length);
+}
+
+/**
+ * @brief Binds the calling thread to the CPUs of the NUMA node, the previous binding is saved for restoring
+ */
+static auto own_bind_to_node(const uint32_t numa_id, cpu_set_t &saved_set) noexcept -> bool {
+    char path[64];
+    char cpu_list[OWN_CPULIST_MAX_LENGTH] = {};
+
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%u/cpulist", numa_id);
+
+    FILE *file_ptr = fopen(path, "r");
+
+    if (nullptr == file_ptr) {
+        return false;
+    }
+
+    const size_t length = fread(cpu_list, 1u, sizeof(cpu_list) - 1u, file_ptr);
+    fclose(file_ptr);
+    cpu_list[length] = '\0';
+
+    cpu_set_t node_set;
+    CPU_ZERO(&node_set);
+
+    // The list is a comma separated list of CPUs and CPU ranges, e.g. "0-3,8-11"
+    for (char *token_ptr = cpu_list; '\0' != *token_ptr;) {
+        char      *end_ptr = nullptr;
+        const int first    = (int) strtol(token_ptr, &end_ptr, 10);
+        int       last     = first;
+
+        if (end_ptr == token_ptr) {
+            break;
+        }
+
+        if ('-' == *end_ptr) {
+            token_ptr = end_ptr + 1;
+            last      = (int) strtol(token_ptr, &end_ptr, 10);
+        }
+
+        for (int cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, &node_set);
+        }
+
+        token_ptr = (',' == *end_ptr) ? end_ptr + 1 : end_ptr;
+
+        if ('\n' == *token_ptr) {
+            break;
+        }
+    }
+
+    if (0 == CPU_COUNT(&node_set) || 0 != pthread_getaffinity_np(pthread_self(), sizeof(saved_set), &saved_set)) {
+        return false;
+    }
+
+    return 0 == pthread_setaffinity_np(pthread_self(), sizeof(node_set), &node_set);
+}
+
+static inline auto own_get_filter_width(qpl::ml::dispatcher::hw_tuning_op_t operation) noexcept -> uint32_t {
+    using qpl::ml::dispatcher::hw_tuning_op_t;
+
+    return (hw_tuning_op_t::filter_8u == operation) ? 8u : ((hw_tuning_op_t::filter_16u == operation) ? 16u : 32u);
+}
+
+static void own_init_descriptor(const qpl::ml::dispatcher::hw_tuning_op_t operation,
+                                hw_descriptor *desc_ptr,
+                                own_tuning_buffers_t &buffers,
+                                uint8_t *dst_ptr,
+                                const uint32_t size) noexcept {
+    using qpl::ml::dispatcher::hw_tuning_op_t;
+
+    switch (operation) {
+        case hw_tuning_op_t::copy:
+            hw_iaa_descriptor_init_mem_copy(desc_ptr, buffers.src.get(), dst_ptr, size);
+            break;
+        case hw_tuning_op_t::zero_compress:
+            hw_iaa_descriptor_init_zero_compress(desc_ptr,
+                                                 QPL_OPCODE_Z_COMP32,
+                                                 buffers.src.get(),
+                                                 dst_ptr,
+                                                 size,
+                                                 buffers.dst_stride);
+            break;
+        case hw_tuning_op_t::crc64:
+            hw_iaa_descriptor_init_crc64(desc_ptr, buffers.src.get(), size, OWN_CRC64_POLYNOMIAL, true, true);
+            break;
+        default: {
+            const uint32_t bit_width = own_get_filter_width(operation);
+
+            // Half of the elements pass, so the output is as busy as it gets
+            hw_iaa_descriptor_reset(desc_ptr);
+            hw_iaa_descriptor_analytic_set_filter_input(desc_ptr,
+                                                        buffers.src.get(),
+                                                        size,
+                                                        size * 8u / bit_width,
+                                                        hw_iaa_input_format_le,
+                                                        bit_width);
+            hw_iaa_descriptor_analytic_set_filter_output(desc_ptr, dst_ptr, buffers.dst_stride, hw_iaa_output_format_nominal);
+            hw_iaa_descriptor_analytic_set_scan_operation(desc_ptr,
+                                                          0u,
+                                                          (uint32_t) ((1ull << bit_width) / 2u),
+                                                          buffers.aecs_ptr);
+            break;
+        }
+    }
+}
+
+/**
+ * @brief Runs the descriptors on the CPU, UINT64_MAX if any of them fails
+ */
+static auto own_time_cpu(own_tuning_buffers_t &buffers, const uint32_t count) noexcept -> uint64_t {
+    for (uint32_t desc_idx = 0u; desc_idx < count; desc_idx++) {
+        hw_iaa_descriptor_set_completion_record(&buffers.descs_ptr[desc_idx], &buffers.records_ptr[desc_idx]);
+        buffers.records_ptr[desc_idx].status = AD_STATUS_INPROG;
+    }
+
+    const uint64_t start = qpl::ml::dispatcher::hw_now_ns();
+
+    for (uint32_t desc_idx = 0u; desc_idx < count; desc_idx++) {
+        if (!qpl::ml::dispatcher::hw_cpu_execute_descriptor(&buffers.descs_ptr[desc_idx])) {
+            return UINT64_MAX;
+        }
+    }
+
+    const uint64_t time_ns = qpl::ml::dispatcher::hw_now_ns() - start;
+
+    for (uint32_t desc_idx = 0u; desc_idx < count; desc_idx++) {
+        if (AD_STATUS_SUCCESS != (buffers.records_ptr[desc_idx].status & STATUS_MASK)) {
+            return UINT64_MAX;
+        }
+    }
+
+    return time_ns;
+}
+
+/**
+ * @brief Runs the descriptors on the devices in batches of up to the device batch size, UINT64_MAX if any fails
+ */
+static auto own_time_device(qpl::ml::dispatcher::hw_completion_engine &engine,
+                            own_tuning_buffers_t &buffers,
+                            const uint32_t count,
+                            const uint32_t batch_size) noexcept -> uint64_t {
+    using qpl::ml::dispatcher::hw_completion_engine;
+
+    hw_completion_engine::reaped_t reaped[OWN_TUNING_JOBS];
+
+    const uint64_t start      = qpl::ml::dispatcher::hw_now_ns();
+    uint32_t       batch_idx  = 0u;
+    bool           is_success = true;
+
+    for (uint32_t first = 0u; first < count && is_success;) {
+        const uint32_t batch_count = std::min(batch_size, count - first);
+        auto           *desc_ptr   = &buffers.descs_ptr[first];
+        auto           *record_ptr = &buffers.records_ptr[first];
+
+        if (1u != batch_count) {
+            for (uint32_t desc_idx = first; desc_idx < first + batch_count; desc_idx++) {
+                hw_iaa_descriptor_set_completion_record(&buffers.descs_ptr[desc_idx], &buffers.records_ptr[desc_idx]);
+                buffers.records_ptr[desc_idx].status = AD_STATUS_INPROG;
+            }
+
+            hw_iaa_descriptor_init_batch(&buffers.batch_descs_ptr[batch_idx], desc_ptr, batch_count);
+
+            desc_ptr   = &buffers.batch_descs_ptr[batch_idx];
+            record_ptr = &buffers.batch_records_ptr[batch_idx];
+        }
+
+        const auto status = engine.submit(desc_ptr, record_ptr);
+
+        if (QPL_STS_QUEUES_ARE_BUSY_ERR == status) {
+            if (0u != engine.in_flight()) {
+                const uint32_t reaped_count = engine.wait_any(reaped, OWN_TUNING_JOBS);
+
+                for (uint32_t reaped_idx = 0u; reaped_idx < reaped_count; reaped_idx++) {
+                    is_success = is_success && QPL_STS_OK == reaped[reaped_idx].status;
+                }
+            } else {
+                // Queues busy with work of others for this long make the measurement meaningless
+                is_success = qpl::ml::dispatcher::hw_now_ns() - start < OWN_TUNING_TIMEOUT_NS;
+                _mm_pause();
+            }
+
+            continue;
+        }
+
+        is_success = QPL_STS_OK == status;
+        first     += batch_count;
+        batch_idx++;
+    }
+
+    while (0u != engine.in_flight()) {
+        const uint32_t reaped_count = engine.wait_any(reaped, OWN_TUNING_JOBS);
+
+        for (uint32_t reaped_idx = 0u; reaped_idx < reaped_count; reaped_idx++) {
+            is_success = is_success && QPL_STS_OK == reaped[reaped_idx].status;
+        }
+    }
+
+    const uint64_t time_ns = qpl::ml::dispatcher::hw_now_ns() - start;
+
+    return is_success ? time_ns : UINT64_MAX;
+}
+
+/**
+ * @brief Measures the crossover of one family on the calling thread
+ */
+static auto own_measure(const qpl::ml::dispatcher::hw_tuning_op_t operation,
+                        own_tuning_buffers_t &buffers,
+                        const uint32_t batch_size,
+                        uint32_t &crossover_size) noexcept -> qpl_status {
+    using qpl::ml::dispatcher::hw_completion_engine;
+    using qpl::ml::dispatcher::hw_autotuner;
+
+    hw_completion_engine engine;
+
+    // Every descriptor goes to the devices, the CPU is timed apart
+    engine.set_cpu_path(nullptr, 0u);
+
+    uint32_t previous_size = 0u;
+    int64_t  previous_gain = 0;
+
+    for (uint32_t size = OWN_TUNING_MIN_SIZE; size <= OWN_TUNING_MAX_SIZE; size *= 2u) {
+        uint64_t cpu_ns    = UINT64_MAX;
+        uint64_t device_ns = UINT64_MAX;
+
+        for (uint32_t repeat = 0u; repeat < OWN_TUNING_REPEATS; repeat++) {
+            for (uint32_t desc_idx = 0u; desc_idx < OWN_TUNING_JOBS; desc_idx++) {
+                own_init_descriptor(operation,
+                                    &buffers.descs_ptr[desc_idx],
+                                    buffers,
+                                    buffers.dst.get() + (size_t) desc_idx * buffers.dst_stride,
+                                    size);
+            }
+
+            cpu_ns    = std::min(cpu_ns, own_time_cpu(buffers, OWN_TUNING_JOBS));
+            device_ns = std::min(device_ns, own_time_device(engine, buffers, OWN_TUNING_JOBS, batch_size));
+        }
+
+        if (UINT64_MAX == cpu_ns || UINT64_MAX == device_ns) {
+            return QPL_STS_LIBRARY_INTERNAL_ERR;
+        }
+
+        const int64_t gain = (int64_t) cpu_ns - (int64_t) device_ns;
+
+        if (gain > 0) {
+            // Devices win already at the smallest size, the sizes below it weren't measured and stay on the CPU
+            if (0u == previous_size) {
+                crossover_size = size;
+                return QPL_STS_OK;
+            }
+
+            // Time difference is taken as linear between the two sizes around the crossing
+            const double fraction = (double) -previous_gain / (double) (gain - previous_gain);
+            const auto   crossing = (uint32_t) (previous_size + fraction * (size - previous_size));
+
+            crossover_size = (crossing + OWN_TUNING_GRANULARITY - 1u) & ~(OWN_TUNING_GRANULARITY - 1u);
+            return QPL_STS_OK;
+        }
+
+        previous_size = size;
+        previous_gain = gain;
+    }
+
+    crossover_size = hw_autotuner::never_offload;
+
+    return QPL_STS_OK;
+}
+
+namespace qpl::ml::dispatcher {
+
+hw_autotuner::hw_autotuner() noexcept {
+    for (auto &node_sizes : crossover_sizes_) {
+        for (auto &size : node_sizes) {
+            size.store(hw_completion_engine::default_cpu_threshold, std::memory_order_relaxed);
+        }
+    }
+}
+
+auto hw_autotuner::get_instance() noexcept -> hw_autotuner & {
+    static hw_autotuner instance{};
+
+    return instance;
+}
+
+auto hw_autotuner::get_profile_path() noexcept -> const char * {
+    const char *path_ptr = getenv(tuning_profile_env);
+
+    return (nullptr != path_ptr && '\0' != path_ptr[0]) ? path_ptr : nullptr;
+}
+
+auto hw_autotuner::get_fingerprint() noexcept -> uint64_t {
+    const auto &dispatcher = hw_dispatcher::get_instance();
+    const auto version     = OWN_PROFILE_VERSION;
+    const auto node_count  = static_cast<uint32_t>(dispatcher.numa_node_count());
+
+    std::unique_ptr<hw_queue_record_t[]> queues(new (std::nothrow) hw_queue_record_t[MAX_NUM_WQ]);
+
+    if (nullptr == queues) {
+        return 0u;
+    }
+
+    uint64_t hash = hw_fnv_hash(hw_fnv_offset_basis, &version, sizeof(version));
+    hash = hw_fnv_hash(hash, &node_count, sizeof(node_count));
+
+    // Records are zeroed first, so padding and unused portal path bytes hash the same every time
+    for (const auto &device : dispatcher) {
+        hw_device_record_t record = {};
+
+        memset(queues.get(), 0, sizeof(hw_queue_record_t) * MAX_NUM_WQ);
+        device.fill_record(record, queues.get());
+
+        hash = hw_fnv_hash(hash, &record, sizeof(record));
+        hash = hw_fnv_hash(hash, queues.get(), sizeof(hw_queue_record_t) * record.queue_count);
+    }
+
+    uint32_t registers[12] = {};
+
+    if (0 != __get_cpuid(1u, &registers[0], &registers[1], &registers[2], &registers[3])) {
+        hash = hw_fnv_hash(hash, &registers[0], sizeof(registers[0]));
+    }
+
+    // Brand string tells models of the same family and stepping apart
+    for (uint32_t leaf = 0u; leaf < 3u; leaf++) {
+        if (0 == __get_cpuid(0x80000002u + leaf,
+                             &registers[4u * leaf],
+                             &registers[4u * leaf + 1u],
+                             &registers[4u * leaf + 2u],
+                             &registers[4u * leaf + 3u])) {
+            break;
+        }
+    }
+
+    hash = hw_fnv_hash(hash, registers, sizeof(registers));
+
+    for (const char *path_ptr : fingerprint_paths) {
+        hash = own_hash_file(hash, path_ptr);
+    }
+
+    // Zero is reserved for "can't be validated"
+    return hash | 1u;
+}
+
+auto hw_autotuner::get_operation(const hw_descriptor *desc_ptr) noexcept -> hw_tuning_op_t {
+    const auto     *this_ptr = reinterpret_cast<const hw_iaa_analytics_descriptor *>(desc_ptr);
+    const uint32_t opcode    = ADOF_GET_OPCODE(this_ptr->op_code_op_flags);
+
+    switch (opcode) {
+        case QPL_OPCODE_MEMMOVE:
+            return hw_tuning_op_t::copy;
+        case QPL_OPCODE_Z_COMP16:
+        case QPL_OPCODE_Z_COMP32:
+        case QPL_OPCODE_Z_DECOMP16:
+        case QPL_OPCODE_Z_DECOMP32:
+            return hw_tuning_op_t::zero_compress;
+        case QPL_OPCODE_CRC64:
+            return hw_tuning_op_t::crc64;
+        case QPL_OPCODE_SCAN:
+        case QPL_OPCODE_SET_MEMBERSHIP:
+        case QPL_OPCODE_EXTRACT:
+        case QPL_OPCODE_SELECT:
+        case QPL_OPCODE_RLE_BURST:
+        case QPL_OPCODE_FIND_UNIQUE:
+        case QPL_OPCODE_EXPAND: {
+            // The inflate pass in front of the filter dominates, none of the filter crossovers fits it
+            if (0u != (this_ptr->decomp_flags & ADDF_ENABLE_DECOMPRESS)) {
+                return hw_tuning_op_t::count;
+            }
+
+            const uint32_t bit_width = ADFF_GET_SRC1_WIDTH(this_ptr->filter_flags);
+
+            return (bit_width <= 8u)
+                   ? hw_tuning_op_t::filter_8u
+                   : ((bit_width <= 16u) ? hw_tuning_op_t::filter_16u : hw_tuning_op_t::filter_32u);
+        }
+        default:
+            return hw_tuning_op_t::count;
+    }
+}
+
+auto hw_autotuner::get_operation_name(const hw_tuning_op_t operation) noexcept -> const char * {
+    switch (operation) {
+        case hw_tuning_op_t::copy:
+            return "copy";
+        case hw_tuning_op_t::zero_compress:
+            return "zero_compress";
+        case hw_tuning_op_t::crc64:
+            return "crc64";
+        case hw_tuning_op_t::filter_8u:
+            return "filter_8u";
+        case hw_tuning_op_t::filter_16u:
+            return "filter_16u";
+        case hw_tuning_op_t::filter_32u:
+            return "filter_32u";
+        default:
+            return "unknown";
+    }
+}
+
+auto hw_autotuner::get_crossover_size(const hw_tuning_op_t operation, int32_t numa_id) noexcept -> uint32_t {
+    const auto op_idx = static_cast<uint32_t>(operation);
+
+    if (op_idx >= operation_count) {
+        return hw_completion_engine::default_cpu_threshold;
+    }
+
+    if (!is_ready_.load(std::memory_order_acquire)) {
+        hw_autotuner::initialize();
+    }
+
+    if (0 > numa_id) {
+        numa_id = hw_dispatcher::get_current_numa_id();
+    }
+
+    const auto node_count = static_cast<uint32_t>(hw_dispatcher::get_instance().numa_node_count());
+    const auto node_idx   = (static_cast<uint32_t>(numa_id) < node_count) ? static_cast<uint32_t>(numa_id) : 0u;
+
+    return crossover_sizes_[node_idx][op_idx].load(std::memory_order_relaxed);
+}
+
+void hw_autotuner::set_crossover_size(const hw_tuning_op_t operation, const uint32_t size, const int32_t numa_id) noexcept {
+    const auto op_idx = static_cast<uint32_t>(operation);
+
+    if (op_idx >= operation_count || (0 <= numa_id && static_cast<uint32_t>(numa_id) >= max_numa_nodes)) {
+        return;
+    }
+
+    if (!is_ready_.load(std::memory_order_acquire)) {
+        hw_autotuner::initialize();
+    }
+
+    for (uint32_t node_idx = 0u; node_idx < max_numa_nodes; node_idx++) {
+        if (0 > numa_id || static_cast<uint32_t>(numa_id) == node_idx) {
+            crossover_sizes_[node_idx][op_idx].store(size, std::memory_order_relaxed);
+        }
+    }
+}
+
+void hw_autotuner::initialize() noexcept {
+    std::lock_guard<std::mutex> lock(init_mutex_);
+
+    if (is_ready_.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    const auto &dispatcher = hw_dispatcher::get_instance();
+    const char *path_ptr   = get_profile_path();
+
+    if (!dispatcher.is_hw_support()) {
+        for (auto &node_sizes : crossover_sizes_) {
+            for (auto &size : node_sizes) {
+                size.store(never_offload, std::memory_order_relaxed);
+            }
+        }
+    } else if (nullptr == path_ptr || !hw_autotuner::load_profile(path_ptr)) {
+        const auto node_count = static_cast<uint32_t>(dispatcher.numa_node_count());
+        bool       is_tuned   = true;
+
+        for (uint32_t node_idx = 0u; node_idx < node_count; node_idx++) {
+            is_tuned = QPL_STS_OK == hw_autotuner::tune_node(node_idx) && is_tuned;
+        }
+
+        // A partly failed tuning is redone by the next process rather than persisted
+        if (nullptr != path_ptr && is_tuned) {
+            (void) hw_autotuner::store_profile(path_ptr);
+        }
+    }
+
+    is_ready_.store(true, std::memory_order_release);
+}
+
+auto hw_autotuner::tune(const int32_t numa_id) noexcept -> qpl_status {
+    std::unique_lock<std::mutex> lock(init_mutex_, std::try_to_lock);
+
+    if (!lock.owns_lock()) {
+        return QPL_STS_BEING_PROCESSED;
+    }
+
+    const auto &dispatcher = hw_dispatcher::get_instance();
+    const auto node_count  = static_cast<uint32_t>(dispatcher.numa_node_count());
+    qpl_status status      = QPL_STS_OK;
+
+    if (!dispatcher.is_hw_support()) {
+        return QPL_STS_OK;
+    }
+
+    for (uint32_t node_idx = 0u; node_idx < node_count; node_idx++) {
+        if (0 <= numa_id && static_cast<uint32_t>(numa_id) != node_idx) {
+            continue;
+        }
+
+        const auto node_status = hw_autotuner::tune_node(node_idx);
+
+        status = (QPL_STS_OK == status) ? node_status : status;
+    }
+
+    const char *path_ptr = get_profile_path();
+
+    if (nullptr != path_ptr && QPL_STS_OK == status) {
+        (void) hw_autotuner::store_profile(path_ptr);
+    }
+
+    is_ready_.store(true, std::memory_order_release);
+
+    return status;
+}
+
+auto hw_autotuner::tune_node(const uint32_t numa_id) noexcept -> qpl_status {
+    const auto     &dispatcher     = hw_dispatcher::get_instance();
+    const uint32_t max_batch_size  = dispatcher.get_max_batch_size();
+    const uint32_t batch_size      = (max_batch_size < 2u) ? 1u : std::min(max_batch_size, OWN_TUNING_JOBS);
+    const uint32_t aecs_blocks     = (sizeof(hw_iaa_aecs_analytic) + sizeof(own_block_t) - 1u) / sizeof(own_block_t);
+    const uint32_t block_count     = 4u * OWN_TUNING_JOBS + aecs_blocks;
+
+    own_tuning_buffers_t buffers;
+
+    // Zero compression of data without zeros is the largest output of any family
+    buffers.dst_stride = OWN_TUNING_MAX_SIZE + OWN_TUNING_MAX_SIZE / 32u + OWN_TUNING_GRANULARITY;
+    buffers.src.reset(new (std::nothrow) uint8_t[OWN_TUNING_MAX_SIZE]);
+    buffers.dst.reset(new (std::nothrow) uint8_t[(size_t) buffers.dst_stride * OWN_TUNING_JOBS]);
+    buffers.blocks.reset(new (std::nothrow) own_block_t[block_count]);
+
+    if (nullptr == buffers.src || nullptr == buffers.dst || nullptr == buffers.blocks) {
+        return QPL_STS_NO_MEM_ERR;
+    }
+
+    memset(buffers.blocks.get(), 0, sizeof(own_block_t) * block_count);
+
+    buffers.descs_ptr         = reinterpret_cast<hw_descriptor *>(&buffers.blocks[0]);
+    buffers.records_ptr       = reinterpret_cast<hw_completion_record *>(&buffers.blocks[OWN_TUNING_JOBS]);
+    buffers.batch_descs_ptr   = reinterpret_cast<hw_descriptor *>(&buffers.blocks[2u * OWN_TUNING_JOBS]);
+    buffers.batch_records_ptr = reinterpret_cast<hw_completion_record *>(&buffers.blocks[3u * OWN_TUNING_JOBS]);
+    buffers.aecs_ptr          = reinterpret_cast<hw_iaa_aecs_analytic *>(&buffers.blocks[4u * OWN_TUNING_JOBS]);
+
+    // A quarter of the 32-bit elements are zero, as in a moderately sparse page
+    for (uint32_t idx = 0u; idx < OWN_TUNING_MAX_SIZE; idx++) {
+        buffers.src[idx] = (3u == ((idx >> 2u) & 3u)) ? 0u : static_cast<uint8_t>(idx * 0x9Du + (idx >> 8u) + 1u);
+    }
+
+    // The destination is touched up front so the first device run doesn't stop on page faults
+    memset(buffers.dst.get(), 0, (size_t) buffers.dst_stride * OWN_TUNING_JOBS);
+
+    cpu_set_t  saved_set;
+    const bool is_bound = dispatcher.numa_node_count() > 1u && own_bind_to_node(numa_id, saved_set);
+
+    if (dispatcher.numa_node_count() > 1u && !is_bound) {
+        // A node without CPUs of its own never asks for its crossovers
+        return QPL_STS_OK;
+    }
+
+    qpl_status status = QPL_STS_OK;
+
+    for (uint32_t op_idx = 0u; op_idx < operation_count; op_idx++) {
+        uint32_t   crossover_size = never_offload;
+        const auto op_status      = own_measure(static_cast<hw_tuning_op_t>(op_idx), buffers, batch_size, crossover_size);
+
+        if (QPL_STS_OK == op_status) {
+            crossover_sizes_[numa_id][op_idx].store(crossover_size, std::memory_order_relaxed);
+        } else if (QPL_STS_OK == status) {
+            status = op_status;
+        }
+    }
+
+    if (is_bound) {
+        (void) pthread_setaffinity_np(pthread_self(), sizeof(saved_set), &saved_set);
+    }
+
+    return status;
+}
+
+auto hw_autotuner::load_profile(const char *path_ptr) noexcept -> bool {
+    const auto node_count  = static_cast<uint32_t>(hw_dispatcher::get_instance().numa_node_count());
+    const auto fingerprint = get_fingerprint();
+
+    FILE *file_ptr = fopen(path_ptr, "rb");
+
+    if (nullptr == file_ptr) {
+        return false;
+    }
+
+    own_profile_header_t header = {};
+    uint32_t             sizes[max_numa_nodes][operation_count];
+
+    const bool is_valid = 1u == fread(&header, sizeof(header), 1u, file_ptr)
+                          && OWN_PROFILE_MAGIC == header.magic
+                          && OWN_PROFILE_VERSION == header.version
+                          && operation_count == header.operation_count
+                          && node_count == header.numa_node_count
+                          && node_count <= max_numa_nodes
+                          && 0u != fingerprint
+                          && fingerprint == header.fingerprint
+                          && node_count == fread(sizes, sizeof(sizes[0]), node_count, file_ptr);
+
+    fclose(file_ptr);
+
+    if (!is_valid) {
+        return false;
+    }
+
+    for (uint32_t node_idx = 0u; node_idx < node_count; node_idx++) {
+        for (uint32_t op_idx = 0u; op_idx < operation_count; op_idx++) {
+            crossover_sizes_[node_idx][op_idx].store(sizes[node_idx][op_idx], std::memory_order_relaxed);
+        }
+    }
+
+    return true;
+}
+
+auto hw_autotuner::store_profile(const char *path_ptr) const noexcept -> bool {
+    const auto node_count = static_cast<uint32_t>(hw_dispatcher::get_instance().numa_node_count());
+    char       temp_path[PATH_MAX];
+
+    const own_profile_header_t header = {OWN_PROFILE_MAGIC,
+                                         OWN_PROFILE_VERSION,
+                                         operation_count,
+                                         node_count,
+                                         get_fingerprint()};
+
+    const int temp_length = snprintf(temp_path, sizeof(temp_path), "%s.%d.tmp", path_ptr, getpid());
+
+    if (0u == header.fingerprint || temp_length < 0 || static_cast<size_t>(temp_length) >= sizeof(temp_path)) {
+        return false;
+    }
+
+    FILE *file_ptr = fopen(temp_path, "wb");
+
+    if (nullptr == file_ptr) {
+        return false;
+    }
+
+    bool is_written = 1u == fwrite(&header, sizeof(header), 1u, file_ptr);
+
+    for (uint32_t node_idx = 0u; node_idx < node_count && is_written; node_idx++) {
+        uint32_t sizes[operation_count];
+
+        for (uint32_t op_idx = 0u; op_idx < operation_count; op_idx++) {
+            sizes[op_idx] = crossover_sizes_[node_idx][op_idx].load(std::memory_order_relaxed);
+        }
+
+        is_written = 1u == fwrite(sizes, sizeof(sizes), 1u, file_ptr);
+    }
+
+    is_written = 0 == fflush(file_ptr) && is_written;
+    fclose(file_ptr);
+
+    // Processes racing to refresh the profile never observe a partial file
+    if (!is_written || 0 != rename(temp_path, path_ptr)) {
+        unlink(temp_path);
+        return false;
+    }
+
+    return true;
+}
+
+}
@@ -0,0 +1,127 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_AUTOTUNER_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_AUTOTUNER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+
+#include "status.h"
+#include "hw_definitions.h"
+#include "hw_devices.h"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief Operation family with a crossover size of its own
+ */
+enum class hw_tuning_op_t : uint32_t {
+    copy,               /**< Memory move */
+    zero_compress,      /**< Zero compress and zero decompress of either element width */
+    crc64,              /**< CRC64 */
+    filter_8u,          /**< Filter operations on uncompressed elements of up to 8 bits */
+    filter_16u,         /**< Filter operations on uncompressed elements of 9 to 16 bits */
+    filter_32u,         /**< Filter operations on uncompressed elements of 17 to 32 bits */
+    count               /**< Number of families, also returned for descriptors no family covers */
+};
+
+/**
+ * @brief Crossover sizes between the CPU and the devices, measured on the running host and kept in a profile.
+ *
+ * @details For every operation family and NUMA node the tuner times batches of descriptors of growing size run by
+ * @ref hw_cpu_execute_descriptor and by the devices, with the tuning thread bound to the CPUs of the node, so the
+ * NUMA distance to the devices the dispatcher picks is part of the measurement. The crossover is interpolated
+ * between the largest measured size the CPU is faster at and the next one; a family the devices never win stays
+ * on the CPU.
+ *
+ * Tuning runs on the first query or on a @ref tune call. If the `QPL_TUNING_PROFILE` environment variable names a
+ * file, crossovers are loaded from it instead, as long as its fingerprint matches the host: the devices and their
+ * work queues, the CPU model and microcode, the BIOS and the kernel release. Any change of those retunes on the
+ * next first query and rewrites the profile, the file is replaced atomically as the topology snapshot is.
+ *
+ * Without devices every crossover is @ref never_offload and nothing is measured.
+ */
+class hw_autotuner final {
+public:
+    static constexpr uint32_t never_offload   = UINT32_MAX;                                      /**< Crossover keeping an operation on the CPU */
+    static constexpr uint32_t operation_count = static_cast<uint32_t>(hw_tuning_op_t::count);    /**< Number of families */
+    static constexpr uint32_t max_numa_nodes  = MAX_NUM_NUMA_NODES;                              /**< Nodes with crossovers */
+
+    static auto get_instance() noexcept -> hw_autotuner &;
+
+    /**
+     * @brief Smallest `source-1` the devices are faster at for the family, tunes or loads the profile on first use
+     *
+     * @param numa_id node of the caller, -1 for the node of the calling thread
+     */
+    [[nodiscard]] auto get_crossover_size(hw_tuning_op_t operation, int32_t numa_id = -1) noexcept -> uint32_t;
+
+    /**
+     * @brief Overrides the crossover of the family, on one node or on every node for -1, until the next tuning
+     */
+    void set_crossover_size(hw_tuning_op_t operation, uint32_t size, int32_t numa_id = -1) noexcept;
+
+    /**
+     * @brief Measures the crossovers now and rewrites the profile if one is configured
+     *
+     * @param numa_id node to tune, -1 for every node
+     *
+     * @return QPL_STS_OK, QPL_STS_BEING_PROCESSED if another thread is tuning, or the error of a failed measurement;
+     * a failed family keeps its previous crossover
+     */
+    auto tune(int32_t numa_id = -1) noexcept -> qpl_status;
+
+    [[nodiscard]] auto load_profile(const char *path_ptr) noexcept -> bool;
+
+    [[nodiscard]] auto store_profile(const char *path_ptr) const noexcept -> bool;
+
+    /**
+     * @brief Profile file named by `QPL_TUNING_PROFILE`, nullptr if the variable is not set
+     */
+    [[nodiscard]] static auto get_profile_path() noexcept -> const char *;
+
+    /**
+     * @brief Hash of everything the crossovers depend on, see the class description
+     */
+    [[nodiscard]] static auto get_fingerprint() noexcept -> uint64_t;
+
+    /**
+     * @brief Family of the descriptor, @ref hw_tuning_op_t::count if the descriptor has no crossover
+     */
+    [[nodiscard]] static auto get_operation(const hw_descriptor *desc_ptr) noexcept -> hw_tuning_op_t;
+
+    [[nodiscard]] static auto get_operation_name(hw_tuning_op_t operation) noexcept -> const char *;
+
+    hw_autotuner(const hw_autotuner &) = delete;
+
+    auto operator=(const hw_autotuner &) -> hw_autotuner & = delete;
+
+private:
+    /**
+     * @brief Crossover of every family on every node
+     */
+    using crossover_table_t = std::array<std::array<std::atomic<uint32_t>, operation_count>, max_numa_nodes>;
+
+    hw_autotuner() noexcept;
+
+    void initialize() noexcept;
+
+    [[nodiscard]] auto tune_node(uint32_t numa_id) noexcept -> qpl_status;
+
+    crossover_table_t crossover_sizes_;            /**< Per node and family */
+    std::atomic<bool> is_ready_        = false;    /**< Crossovers were loaded or tuned */
+    std::mutex        init_mutex_;                 /**< Guards tuning and the first use */
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_AUTOTUNER_HPP_
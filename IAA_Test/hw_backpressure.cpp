@@ -0,0 +1,98 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <sched.h>
+#include <immintrin.h>
+#include <algorithm>
+
+#include "hw_backpressure.hpp"
+#include "hw_util.hpp"
+#include "hw_dispatcher.hpp"
+
+#define OWN_YIELD_DELAY_NS  20000u   /**< Delays at least this long give the CPU away instead of spinning */
+
+static inline void own_delay(const uint64_t delay_ns) noexcept {
+    const uint64_t deadline_ns = qpl::ml::dispatcher::hw_now_ns() + delay_ns;
+
+    while (qpl::ml::dispatcher::hw_now_ns() < deadline_ns) {
+        if (delay_ns >= OWN_YIELD_DELAY_NS) {
+            sched_yield();
+        } else {
+            _mm_pause();
+        }
+    }
+}
+
+namespace qpl::ml::dispatcher {
+
+hw_backpressure::hw_backpressure(const hw_backpressure_config_t &config) noexcept
+        : config_(config) {
+    config_.initial_backoff_ns = std::max<uint64_t>(config_.initial_backoff_ns, 1u);
+    config_.max_backoff_ns     = std::max(config_.max_backoff_ns, config_.initial_backoff_ns);
+
+    // Seed differs between instances and runs, xorshift state must be non-zero
+    rng_state_ = (reinterpret_cast<uint64_t>(this) ^ hw_now_ns()) | 1u;
+}
+
+auto hw_backpressure::get_jittered_delay(uint64_t backoff_ns) noexcept -> uint64_t {
+    rng_state_ ^= rng_state_ << 13u;
+    rng_state_ ^= rng_state_ >> 7u;
+    rng_state_ ^= rng_state_ << 17u;
+
+    return backoff_ns / 2u + rng_state_ % (backoff_ns - backoff_ns / 2u + 1u);
+}
+
+auto hw_backpressure::submit(hw_descriptor *desc_ptr,
+                             int32_t numa_id,
+                             const hw_queue **queue_pptr,
+                             hw_traffic_class_t traffic_class) noexcept -> qpl_status {
+    const auto     &dispatcher = hw_dispatcher::get_instance();
+    const uint64_t start_ns    = hw_now_ns();
+
+    // Congested node starts with a longer delay, so fewer retries hit queues that are still full
+    uint64_t backoff_ns = config_.initial_backoff_ns
+                          + config_.initial_backoff_ns * dispatcher.get_congestion(numa_id) / hw_queue::occupancy_full;
+
+    if (nullptr != queue_pptr) {
+        *queue_pptr = nullptr;
+    }
+
+    while (true) {
+        const auto status = dispatcher.enqueue_descriptor(desc_ptr, numa_id, queue_pptr, traffic_class);
+
+        if (QPL_STS_QUEUES_ARE_BUSY_ERR != status) {
+            stats_.submissions += (QPL_STS_OK == status) ? 1u : 0u;
+            return status;
+        }
+
+        const uint64_t elapsed_ns = hw_now_ns() - start_ns;
+
+        if (elapsed_ns >= config_.latency_budget_ns) {
+            if (nullptr != config_.cpu_executor && config_.cpu_executor(desc_ptr)) {
+                stats_.spills++;
+                return QPL_STS_OK;
+            }
+
+            stats_.rejections++;
+            return QPL_STS_QUEUES_ARE_BUSY_ERR;
+        }
+
+        own_delay(std::min(hw_backpressure::get_jittered_delay(backoff_ns), config_.latency_budget_ns - elapsed_ns));
+
+        stats_.retries++;
+        backoff_ns = std::min(backoff_ns * 2u, config_.max_backoff_ns);
+    }
+}
+
+auto hw_backpressure::get_config() const noexcept -> const hw_backpressure_config_t & {
+    return config_;
+}
+
+auto hw_backpressure::get_stats() const noexcept -> const hw_backpressure_stats_t & {
+    return stats_;
+}
+
+}
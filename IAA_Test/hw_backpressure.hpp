@@ -0,0 +1,76 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_BACKPRESSURE_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_BACKPRESSURE_HPP_
+
+#include <cstdint>
+
+#include "status.h"
+#include "hw_definitions.h"
+#include "hw_queue.hpp"
+#include "hw_queue_policy.hpp"
+#include "hw_cpu_executor.hpp"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief Retry behaviour applied when every work queue rejects a descriptor
+ */
+struct hw_backpressure_config_t {
+    uint64_t          initial_backoff_ns = 250u;      /**< First delay, scaled up to 2x by the NUMA node congestion */
+    uint64_t          max_backoff_ns     = 32000u;    /**< Upper bound of a single delay */
+    uint64_t          latency_budget_ns  = 500000u;   /**< Time a submission may spend retrying, 0 for one attempt */
+    hw_cpu_executor_t cpu_executor       = nullptr;   /**< Spill target once the budget is spent, nullptr disables spill */
+};
+
+/**
+ * @brief Submission counters of one @ref hw_backpressure instance
+ */
+struct hw_backpressure_stats_t {
+    uint64_t submissions = 0u;    /**< Descriptors accepted by hardware */
+    uint64_t retries     = 0u;    /**< Backoff delays taken */
+    uint64_t spills      = 0u;    /**< Descriptors executed by the CPU executor */
+    uint64_t rejections  = 0u;    /**< Descriptors returned to the caller as QPL_STS_QUEUES_ARE_BUSY_ERR */
+};
+
+/**
+ * @brief Submits descriptors with bounded exponential backoff and optional software spill.
+ *
+ * @details When all queues reject ENQCMD the submission sleeps for a delay drawn uniformly from
+ * [backoff / 2, backoff] and doubles the backoff up to the bound. The jitter keeps threads that were rejected
+ * together from retrying together. Once the latency budget is spent the descriptor is given to the CPU executor
+ * if one is configured and accepts it, otherwise QPL_STS_QUEUES_ARE_BUSY_ERR is returned.
+ *
+ * @note Instances are not thread-safe, each submitting thread is expected to own one.
+ */
+class hw_backpressure final {
+public:
+    explicit hw_backpressure(const hw_backpressure_config_t &config = {}) noexcept;
+
+    [[nodiscard]] auto submit(hw_descriptor *desc_ptr,
+                              int32_t numa_id = -1,
+                              const hw_queue **queue_pptr = nullptr,
+                              hw_traffic_class_t traffic_class = hw_traffic_class_t::normal) noexcept -> qpl_status;
+
+    [[nodiscard]] auto get_config() const noexcept -> const hw_backpressure_config_t &;
+
+    [[nodiscard]] auto get_stats() const noexcept -> const hw_backpressure_stats_t &;
+
+private:
+    [[nodiscard]] auto get_jittered_delay(uint64_t backoff_ns) noexcept -> uint64_t;
+
+    hw_backpressure_config_t config_    = {};   /**< Retry behaviour */
+    hw_backpressure_stats_t  stats_     = {};   /**< Submission counters */
+    uint64_t                 rng_state_ = 0u;   /**< Xorshift state of the jitter generator */
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_BACKPRESSURE_HPP_
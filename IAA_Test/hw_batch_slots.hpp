@@ -0,0 +1,238 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_BATCH_SLOTS_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_BATCH_SLOTS_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include "status.h"
+#include "hw_definitions.h"
+#include "hw_completion_engine.hpp"
+#include "hw_dispatcher.hpp"
+#include "hw_job_pool.hpp"
+#include "hw_descriptors_api.h"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief Batch descriptors of a service that sends many small independent jobs to the devices.
+ *
+ * @details A slot is one batch: its descriptor and completion record from @ref hw_job_pool, a list of up to
+ * @ref get_batch_size descriptors with a completion record each, and the work item of every descriptor, which
+ * the owner reads back when the batch is reaped. A slot of one descriptor is submitted as is, since a batch of
+ * one is refused by the device. Slots and their lists are allocated on the first @ref prepare and kept.
+ *
+ * @tparam item_t work item the owner keeps per descriptor, copied into the slot
+ *
+ * @note Not thread-safe, it belongs to a service that owns its completion engine.
+ */
+template <typename item_t>
+class hw_batch_slots final {
+public:
+    static constexpr uint32_t batches_per_device = 4u;     /**< Default batches in flight per device */
+    static constexpr uint32_t max_batch_size     = 32u;    /**< Descriptors per batch, bounds the memory of a slot */
+
+    /**
+     * @brief Batch in flight or free
+     */
+    struct slot_t {
+        hw_job_t             job         = {};          /**< Batch descriptor and its completion record */
+        hw_descriptor        *descs_ptr   = nullptr;    /**< Descriptor list of the batch */
+        hw_completion_record *records_ptr = nullptr;    /**< Completion record of every descriptor in the list */
+        item_t               *items_ptr   = nullptr;    /**< Work item of every descriptor in the list */
+        uint32_t             count        = 0u;         /**< Descriptors in the list */
+    };
+
+    /**
+     * @param max_in_flight batches in progress at once, 0 picks @ref batches_per_device per device
+     */
+    explicit hw_batch_slots(uint32_t max_in_flight) noexcept {
+        const auto &dispatcher = hw_dispatcher::get_instance();
+
+        if (0u == max_in_flight) {
+            const auto device_count = static_cast<uint32_t>(dispatcher.device_count());
+
+            max_in_flight = batches_per_device * ((0u != device_count) ? device_count : 1u);
+        }
+
+        max_in_flight_ = (max_in_flight > hw_completion_engine::max_in_flight)
+                         ? hw_completion_engine::max_in_flight
+                         : max_in_flight;
+
+        const uint32_t device_batch_size = dispatcher.get_max_batch_size();
+
+        batch_size_ = (device_batch_size < 2u)
+                      ? 1u
+                      : ((device_batch_size > max_batch_size) ? max_batch_size : device_batch_size);
+    }
+
+    /**
+     * @note The owner waits for its batches first, nothing may be in flight
+     */
+    ~hw_batch_slots() noexcept {
+        auto &pool = hw_job_pool::get_instance();
+
+        for (auto &slot : slots_) {
+            // A batch refused by every queue still looks submitted
+            hw_iaa_descriptor_reset(slot.job.descriptor_ptr);
+            (void) pool.release_job(slot.job);
+        }
+    }
+
+    hw_batch_slots(const hw_batch_slots &) = delete;
+
+    auto operator=(const hw_batch_slots &) -> hw_batch_slots & = delete;
+
+    /**
+     * @brief Allocates the slots once, every slot is free afterwards
+     */
+    [[nodiscard]] auto prepare() noexcept -> qpl_status {
+        if (!slots_.empty()) {
+            return QPL_STS_OK;
+        }
+
+        auto &pool = hw_job_pool::get_instance();
+
+        // Every slot takes a descriptor list and a completion record list of a batch
+        blocks_.reset(new (std::nothrow) block_t[2u * batch_size_ * max_in_flight_]);
+        items_.reset(new (std::nothrow) item_t[batch_size_ * max_in_flight_]);
+
+        if (nullptr == blocks_ || nullptr == items_) {
+            blocks_.reset();
+            items_.reset();
+
+            return QPL_STS_NO_MEM_ERR;
+        }
+
+        slots_.resize(max_in_flight_);
+        free_slots_.reserve(max_in_flight_);
+
+        for (uint32_t slot_idx = 0u; slot_idx < max_in_flight_; slot_idx++) {
+            auto &slot = slots_[slot_idx];
+
+            slot.descs_ptr   = reinterpret_cast<hw_descriptor *>(&blocks_[2u * batch_size_ * slot_idx]);
+            slot.records_ptr = reinterpret_cast<hw_completion_record *>(&blocks_[2u * batch_size_ * slot_idx + batch_size_]);
+            slot.items_ptr   = &items_[batch_size_ * slot_idx];
+
+            if (QPL_STS_OK != pool.acquire_job(slot.job)) {
+                for (auto &acquired_slot : slots_) {
+                    (void) pool.release_job(acquired_slot.job);
+                }
+
+                slots_.clear();
+                blocks_.reset();
+                items_.reset();
+
+                return QPL_STS_NO_MEM_ERR;
+            }
+        }
+
+        for (auto &slot : slots_) {
+            free_slots_.push_back(&slot);
+        }
+
+        return QPL_STS_OK;
+    }
+
+    /**
+     * @brief Free slot to fill, nullptr if every slot is in flight
+     */
+    [[nodiscard]] auto get_free() const noexcept -> slot_t * {
+        return free_slots_.empty() ? nullptr : free_slots_.back();
+    }
+
+    /**
+     * @brief Submits the descriptors the owner wrote into the list of the slot returned by @ref get_free
+     *
+     * @return status of hw_completion_engine::submit(), the slot is in flight on success only
+     */
+    [[nodiscard]] auto submit(slot_t &slot, hw_completion_engine &engine) noexcept -> qpl_status {
+        qpl_status status = QPL_STS_OK;
+
+        if (1u == slot.count) {
+            status = engine.submit(slot.descs_ptr, slot.records_ptr, &slot);
+        } else {
+            // Descriptors of the list report through records of their own, the batch record only tells all of them ended
+            for (uint32_t desc_idx = 0u; desc_idx < slot.count; desc_idx++) {
+                hw_iaa_descriptor_set_completion_record(&slot.descs_ptr[desc_idx], &slot.records_ptr[desc_idx]);
+                slot.records_ptr[desc_idx].status = AD_STATUS_INPROG;
+            }
+
+            hw_iaa_descriptor_init_batch(slot.job.descriptor_ptr, slot.descs_ptr, slot.count);
+
+            status = engine.submit(slot.job.descriptor_ptr, slot.job.completion_record_ptr, &slot);
+        }
+
+        if (QPL_STS_OK == status) {
+            free_slots_.pop_back();
+        }
+
+        return status;
+    }
+
+    /**
+     * @brief Slot of a batch reaped from the engine, given the user pointer it was submitted with
+     */
+    [[nodiscard]] static auto get_slot(const hw_completion_engine::reaped_t &reaped) noexcept -> slot_t & {
+        return *static_cast<slot_t *>(reaped.user_ptr);
+    }
+
+    /**
+     * @brief Status of one descriptor of a reaped batch, whatever the status of the batch itself
+     */
+    [[nodiscard]] static auto get_status(const slot_t &slot, const uint32_t desc_idx) noexcept -> qpl_status {
+        return convert_hw_status_to_qpl_status(&slot.records_ptr[desc_idx]);
+    }
+
+    [[nodiscard]] static auto get_record(const slot_t &slot, const uint32_t desc_idx) noexcept
+    -> const hw_iaa_completion_record & {
+        return *reinterpret_cast<const hw_iaa_completion_record *>(&slot.records_ptr[desc_idx]);
+    }
+
+    /**
+     * @brief Returns a reaped slot once the owner has read its items and records
+     */
+    void release(slot_t &slot) noexcept {
+        free_slots_.push_back(&slot);
+    }
+
+    [[nodiscard]] auto get_max_in_flight() const noexcept -> uint32_t {
+        return max_in_flight_;
+    }
+
+    /**
+     * @brief Descriptors per batch, 1 if the devices don't support batches
+     */
+    [[nodiscard]] auto get_batch_size() const noexcept -> uint32_t {
+        return batch_size_;
+    }
+
+private:
+    /**
+     * @brief 64-byte block, descriptors and completion records of the batches are carved from them
+     */
+    struct alignas(64) block_t {
+        uint8_t bytes[64];
+    };
+
+    std::unique_ptr<block_t[]> blocks_;               /**< Descriptor lists and records of all slots */
+    std::unique_ptr<item_t[]>  items_;                /**< Work items of all slots */
+    std::vector<slot_t>        slots_;                /**< Batches, in flight or not */
+    std::vector<slot_t *>      free_slots_;           /**< Slots not in flight */
+    uint32_t                   max_in_flight_ = 0u;   /**< Number of slots */
+    uint32_t                   batch_size_    = 0u;   /**< Descriptors per batch */
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_BATCH_SLOTS_HPP_
@@ -0,0 +1,177 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <cstring>
+
+#include "hw_column_scan.hpp"
+#include "hw_dispatcher.hpp"
+#include "hw_aecs_api.h"
+#include "hw_descriptors_api.h"
+
+#define OWN_PAGES_PER_DEVICE    16u      /**< Default pages in flight per device */
+#define OWN_MAX_BIT_WIDTH       32u      /**< Widest element of an analytic operation */
+
+namespace qpl::ml::dispatcher {
+
+hw_column_scan::hw_column_scan(uint32_t max_in_flight) noexcept {
+    if (0u == max_in_flight) {
+        const auto device_count = static_cast<uint32_t>(hw_dispatcher::get_instance().device_count());
+
+        max_in_flight = OWN_PAGES_PER_DEVICE * ((0u != device_count) ? device_count : 1u);
+    }
+
+    max_in_flight_ = (max_in_flight > hw_completion_engine::max_in_flight)
+                     ? hw_completion_engine::max_in_flight
+                     : max_in_flight;
+
+    engine_.set_traffic_class(hw_traffic_class_t::latency);
+}
+
+void hw_column_scan::set_cpu_path(hw_cpu_executor_t executor, const uint32_t threshold_bytes) noexcept {
+    engine_.set_cpu_path(executor, threshold_bytes);
+}
+
+auto hw_column_scan::get_max_in_flight() const noexcept -> uint32_t {
+    return max_in_flight_;
+}
+
+auto hw_column_scan::get_output_size_bound(const uint32_t element_count,
+                                           const hw_iaa_output_format output_format) noexcept -> uint32_t {
+    switch (static_cast<uint32_t>(output_format) & 3u) {
+        case hw_iaa_output_format_8u:
+            return element_count;
+        case hw_iaa_output_format_16u:
+            return element_count * 2u;
+        case hw_iaa_output_format_32u:
+            return element_count * 4u;
+        default:
+            return (element_count + 7u) / 8u;
+    }
+}
+
+auto hw_column_scan::submit(slot_t &slot,
+                            const hw_column_page_t &page,
+                            const hw_analytic_prototype &prototype) noexcept -> qpl_status {
+    auto *const desc_ptr = slot.job.descriptor_ptr;
+
+    prototype.fill(desc_ptr,
+                   page.src_ptr,
+                   page.src_size,
+                   page.element_count,
+                   page.dst_ptr,
+                   page.dst_capacity,
+                   slot.job.aecs_ptr);
+
+    return engine_.submit(desc_ptr, slot.job.completion_record_ptr, &slot);
+}
+
+void hw_column_scan::reap(hw_column_scan_result_t *results_ptr) noexcept {
+    hw_completion_engine::reaped_t reaped[hw_completion_engine::max_in_flight];
+
+    const uint32_t reaped_count = engine_.wait_any(reaped, hw_completion_engine::max_in_flight);
+
+    for (uint32_t reaped_idx = 0u; reaped_idx < reaped_count; reaped_idx++) {
+        auto *const slot_ptr   = static_cast<slot_t *>(reaped[reaped_idx].user_ptr);
+        const auto  *record_ptr = reinterpret_cast<const hw_iaa_completion_record *>(reaped[reaped_idx].record_ptr);
+        auto        &result     = results_ptr[slot_ptr->page_idx];
+
+        result.status      = reaped[reaped_idx].status;
+        result.output_size = (QPL_STS_OK == result.status) ? record_ptr->output_size : 0u;
+        result.match_count = (QPL_STS_OK == result.status) ? record_ptr->sum_agg : 0u;
+
+        free_slots_.push_back(slot_ptr);
+    }
+}
+
+auto hw_column_scan::scan(const hw_column_page_t *pages_ptr,
+                          const uint32_t page_count,
+                          const uint32_t bit_width,
+                          const uint32_t low,
+                          const uint32_t high,
+                          const hw_iaa_output_format output_format,
+                          hw_column_scan_result_t *results_ptr) noexcept -> qpl_status {
+    if ((nullptr == pages_ptr || nullptr == results_ptr) && 0u != page_count) {
+        return QPL_STS_NULL_PTR_ERR;
+    }
+
+    if (0u == bit_width || bit_width > OWN_MAX_BIT_WIDTH) {
+        return QPL_STS_BIT_WIDTH_ERR;
+    }
+
+    // Jobs are kept between calls, the pool memory is already bound and touched
+    const auto status = slots_.prepare(max_in_flight_);
+
+    if (QPL_STS_OK != status) {
+        return status;
+    }
+
+    // Page is a complete stream ending on a byte boundary, the inflate state never leaves the device
+    const hw_analytic_prototype plain_prototype(QPL_OPCODE_SCAN, hw_iaa_input_format_le, bit_width, output_format);
+    const hw_analytic_prototype compressed_prototype(QPL_OPCODE_SCAN,
+                                                     hw_iaa_input_format_le,
+                                                     bit_width,
+                                                     output_format,
+                                                     true);
+
+    free_slots_.clear();
+    free_slots_.reserve(slots_.size());
+
+    for (auto &slot : slots_) {
+        auto *const aecs_ptr = static_cast<hw_iaa_aecs_analytic *>(slot.job.aecs_ptr);
+
+        memset(aecs_ptr, 0, HW_AECS_ANALYTIC_FILTER_ONLY_SIZE);
+        aecs_ptr->filtering_options.filter_low  = low;
+        aecs_ptr->filtering_options.filter_high = high;
+
+        free_slots_.push_back(&slot);
+    }
+
+    uint32_t next_page = 0u;
+
+    while (next_page < page_count || 0u != engine_.in_flight()) {
+        while (next_page < page_count && !free_slots_.empty()) {
+            const auto &page     = pages_ptr[next_page];
+            auto       *slot_ptr = free_slots_.back();
+
+            if (nullptr == page.src_ptr || nullptr == page.dst_ptr) {
+                results_ptr[next_page++] = {QPL_STS_NULL_PTR_ERR, 0u, 0u};
+                continue;
+            }
+
+            slot_ptr->page_idx = next_page;
+
+            const auto page_status = hw_column_scan::submit(*slot_ptr,
+                                                            page,
+                                                            page.is_compressed ? compressed_prototype : plain_prototype);
+
+            if (QPL_STS_QUEUES_ARE_BUSY_ERR == page_status) {
+                break;
+            }
+
+            if (QPL_STS_OK != page_status) {
+                results_ptr[next_page++] = {page_status, 0u, 0u};
+                continue;
+            }
+
+            free_slots_.pop_back();
+            next_page++;
+        }
+
+        if (next_page < page_count || 0u != engine_.in_flight()) {
+            (void) hw_job_slots<slot_t>::wait(engine_, [this, results_ptr] { hw_column_scan::reap(results_ptr); });
+        }
+    }
+
+    for (uint32_t page_idx = 0u; page_idx < page_count; page_idx++) {
+        if (QPL_STS_OK != results_ptr[page_idx].status) {
+            return results_ptr[page_idx].status;
+        }
+    }
+
+    return QPL_STS_OK;
+}
+
+}
@@ -0,0 +1,124 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_COLUMN_SCAN_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_COLUMN_SCAN_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "status.h"
+#include "hw_definitions.h"
+#include "hw_iaa_flags.h"
+#include "hw_completion_engine.hpp"
+#include "hw_job_slots.hpp"
+#include "hw_descriptor_prototype.hpp"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief One page of a column and the buffer receiving its scan result
+ */
+struct hw_column_page_t {
+    const uint8_t *src_ptr       = nullptr;   /**< Complete raw deflate stream, or packed elements if not compressed */
+    uint32_t      src_size       = 0u;        /**< Page size in bytes */
+    uint32_t      element_count  = 0u;        /**< Elements stored in the page */
+    bool          is_compressed  = true;      /**< Page is inflated by the same descriptor that scans it */
+    uint8_t       *dst_ptr       = nullptr;   /**< Bit-vector or index list, see @ref hw_column_scan::get_output_size_bound */
+    uint32_t      dst_capacity   = 0u;        /**< Destination size in bytes */
+};
+
+/**
+ * @brief Outcome of the scan of one page
+ */
+struct hw_column_scan_result_t {
+    qpl_status status       = QPL_STS_OK;     /**< Page status, the other fields are valid on success only */
+    uint32_t   output_size  = 0u;             /**< Bytes written to the page destination */
+    uint32_t   match_count  = 0u;             /**< Elements within the predicate range */
+};
+
+/**
+ * @brief Scans column pages for values within [low, high], inflating compressed pages on the fly.
+ *
+ * @details Every page is one analytics descriptor: with decompression enabled the device inflates the page
+ * into its internal buffer and filters the elements there, so decompressed data never goes through memory.
+ * Pages are independent deflate streams, so the descriptor needs only the filter part of the AECS. Pages are
+ * submitted as long as slots are free and results are stored in page order, whatever order they complete in.
+ *
+ * Descriptors of a call share everything but their buffers: the call builds an @ref hw_analytic_prototype for
+ * compressed and one for plain pages and writes the predicate into the AECS of every slot once, a page then
+ * costs a single descriptor copy.
+ *
+ * The output format selects the result kind: @ref hw_iaa_output_format_nominal writes a bit-vector with
+ * a bit per element, 8u, 16u or 32u write the indices of the matching elements with that width.
+ *
+ * @note The object owns a completion engine and its jobs, each thread is expected to use its own one.
+ */
+class hw_column_scan final {
+public:
+    /**
+     * @param max_in_flight pages in progress at once, 0 picks 16 per device
+     */
+    explicit hw_column_scan(uint32_t max_in_flight = 0u) noexcept;
+
+    hw_column_scan(const hw_column_scan &) = delete;
+
+    auto operator=(const hw_column_scan &) -> hw_column_scan & = delete;
+
+    /**
+     * @brief Scans all pages, every page gets its result even if others fail
+     *
+     * @param bit_width element bit-width of every page, 1..32
+     *
+     * @return QPL_STS_OK if every page succeeded, the status of the first failed page otherwise
+     */
+    [[nodiscard]] auto scan(const hw_column_page_t *pages_ptr,
+                            uint32_t page_count,
+                            uint32_t bit_width,
+                            uint32_t low,
+                            uint32_t high,
+                            hw_iaa_output_format output_format,
+                            hw_column_scan_result_t *results_ptr) noexcept -> qpl_status;
+
+    /**
+     * @brief Replaces the CPU path of the internal engine, see hw_completion_engine::set_cpu_path()
+     */
+    void set_cpu_path(hw_cpu_executor_t executor, uint32_t threshold_bytes) noexcept;
+
+    [[nodiscard]] auto get_max_in_flight() const noexcept -> uint32_t;
+
+    /**
+     * @brief Destination size that always holds the result of a page with the given number of elements
+     */
+    [[nodiscard]] static auto get_output_size_bound(uint32_t element_count, hw_iaa_output_format output_format) noexcept -> uint32_t;
+
+private:
+    /**
+     * @brief Page in progress
+     */
+    struct slot_t {
+        hw_job_t job      = {};       /**< Descriptor, completion record and AECS of the page */
+        uint32_t page_idx = 0u;       /**< Page the slot is used by */
+    };
+
+    [[nodiscard]] auto submit(slot_t &slot,
+                              const hw_column_page_t &page,
+                              const hw_analytic_prototype &prototype) noexcept -> qpl_status;
+
+    void reap(hw_column_scan_result_t *results_ptr) noexcept;
+
+    hw_completion_engine  engine_;                     /**< Tracks the pages of this object */
+    hw_job_slots<slot_t>  slots_;                      /**< Jobs of the pages in flight */
+    std::vector<slot_t *> free_slots_;                 /**< Slots not in flight */
+    uint32_t              max_in_flight_ = 0u;         /**< Number of slots */
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_COLUMN_SCAN_HPP_
@@ -0,0 +1,436 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <cpuid.h>
+#include <sched.h>
+#include <unistd.h>
+#include <immintrin.h>
+
+#include "hw_completion_engine.hpp"
+#include "hw_util.hpp"
+#include "hw_autotuner.hpp"
+#include "hw_iaa_flags.h"
+
+#define OWN_CPUID_WAITPKG_BIT      (1u << 5u)   /**< CPUID.(EAX=07H, ECX=0):ECX[5] */
+#define OWN_UMWAIT_STATE_C01       1u           /**< UMWAIT control: light C0.1 state with the fastest wake-up */
+#define OWN_UMWAIT_SLICE_CYCLES    100000u      /**< TSC cycles of one UMWAIT before the deadline is re-checked */
+#define OWN_SPIN_CHECKS_LIMIT      4096u        /**< Record checks with PAUSE before the spinner starts to yield */
+#define OWN_MAX_FAULT_RESUMES      4096u        /**< Faults of one job after which it is reported, e.g. under memory pressure */
+
+static_assert(sizeof(hw_iaa_completion_record) == HW_PATH_COMPLETION_RECORD_SIZE, "completion record layout");
+
+static inline auto own_deadline_ns(const uint64_t timeout_ns) noexcept -> uint64_t {
+    const uint64_t now = qpl::ml::dispatcher::hw_now_ns();
+
+    return (timeout_ns > UINT64_MAX - now) ? UINT64_MAX : now + timeout_ns;
+}
+
+static inline auto own_status_ptr(const hw_completion_record *record_ptr) noexcept -> const volatile uint8_t * {
+    return &reinterpret_cast<const volatile hw_completion_record *>(record_ptr)->status;
+}
+
+/**
+ * @brief Arms the monitor on the record cache line and sleeps until it is written or the time slice is over
+ *
+ * @note The status is re-checked after UMONITOR, otherwise a write that lands between the caller's check and
+ * the monitor arming would be missed until the slice expires
+ */
+__attribute__((target("waitpkg")))
+static inline void own_umwait(const volatile uint8_t *status_ptr) noexcept {
+    _umonitor(const_cast<uint8_t *>(status_ptr));
+
+    if (AD_STATUS_INPROG == *status_ptr) {
+        _umwait(OWN_UMWAIT_STATE_C01, __rdtsc() + OWN_UMWAIT_SLICE_CYCLES);
+    }
+}
+
+static inline auto own_page_size() noexcept -> uintptr_t {
+    static const auto page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+
+    return page_size;
+}
+
+/**
+ * @brief Makes the page resident, a write touch is an atomic OR with zero so concurrent writers lose nothing
+ */
+static inline void own_touch(uint8_t *address_ptr, const bool is_write) noexcept {
+    if (is_write) {
+        (void) __atomic_fetch_or(address_ptr, 0u, __ATOMIC_RELAXED);
+    } else {
+        (void) *reinterpret_cast<volatile uint8_t *>(address_ptr);
+    }
+}
+
+static inline void own_touch_range(uint8_t *begin_ptr, const uint32_t size, const bool is_write) noexcept {
+    if (nullptr == begin_ptr || 0u == size) {
+        return;
+    }
+
+    const uintptr_t page_size = own_page_size();
+    const uintptr_t end       = reinterpret_cast<uintptr_t>(begin_ptr) + size;
+
+    for (uintptr_t page = reinterpret_cast<uintptr_t>(begin_ptr) & ~(page_size - 1u); page < end; page += page_size) {
+        own_touch(reinterpret_cast<uint8_t *>((page < reinterpret_cast<uintptr_t>(begin_ptr))
+                                              ? reinterpret_cast<uintptr_t>(begin_ptr)
+                                              : page),
+                  is_write);
+    }
+}
+
+static inline auto own_is_within(const uint64_t address, const uint8_t *begin_ptr, const uint32_t size) noexcept -> bool {
+    const auto begin = reinterpret_cast<uintptr_t>(begin_ptr);
+
+    return nullptr != begin_ptr && address >= begin && address - begin < size;
+}
+
+namespace qpl::ml::dispatcher {
+
+auto convert_hw_status_to_qpl_status(const hw_completion_record *record_ptr) noexcept -> qpl_status {
+    const auto *iaa_record_ptr = reinterpret_cast<const hw_iaa_completion_record *>(record_ptr);
+
+    switch (*own_status_ptr(record_ptr) & STATUS_MASK) {
+        case AD_STATUS_INPROG:
+            return QPL_STS_BEING_PROCESSED;
+        case AD_STATUS_SUCCESS:
+            return QPL_STS_OK;
+        case AD_STATUS_ANALYTICS_ERROR:
+            // Hardware error codes are mirrored by the operation error range of qpl_status
+            return static_cast<qpl_status>(QPL_OPERATION_ERROR(iaa_record_ptr->error_code));
+        case AD_STATUS_OUTPUT_OVERFLOW:
+            return QPL_STS_DST_IS_SHORT_ERR;
+        case AD_STATUS_PAGE_FAULT:
+            return QPL_STS_PAGE_FAULT_ERR;
+        case AD_STATUS_OVERLAPPING_BUFFERS:
+            return QPL_STS_BUFFER_OVERLAP_ERR;
+        case AD_STATUS_TRANSFER_SIZE_INVALID:
+        case AD_STATUS_INVALID_NUM_ELEM:
+        case AD_STATUS_INVALID_INPUT_SIZE:
+            return QPL_STS_SIZE_ERR;
+        case AD_STATUS_INVALID_SRC1_WIDTH:
+            return QPL_STS_BIT_WIDTH_ERR;
+        case AD_STATUS_INVALID_OP_FLAG:
+        case AD_STATUS_INVALID_DECOMP_FLAG:
+        case AD_STATUS_INVALID_FILTER_FLAG:
+        case AD_STATUS_INVALID_INV_OUTPUT:
+            return QPL_STS_INVALID_PARAM_ERR;
+        default:
+            return QPL_STS_LIBRARY_INTERNAL_ERR;
+    }
+}
+
+hw_completion_engine::hw_completion_engine(hw_wait_mode_t mode) noexcept {
+    if (hw_wait_mode_t::spin == mode || !is_umwait_available()) {
+        mode_ = hw_wait_mode_t::spin;
+    } else {
+        mode_ = hw_wait_mode_t::umwait;
+    }
+}
+
+auto hw_completion_engine::is_umwait_available() noexcept -> bool {
+    static const bool is_available = []() -> bool {
+        uint32_t eax = 0u;
+        uint32_t ebx = 0u;
+        uint32_t ecx = 0u;
+        uint32_t edx = 0u;
+
+        if (!__get_cpuid_count(7u, 0u, &eax, &ebx, &ecx, &edx)) {
+            return false;
+        }
+
+        return 0u != (ecx & OWN_CPUID_WAITPKG_BIT);
+    }();
+
+    return is_available;
+}
+
+auto hw_completion_engine::submit(hw_descriptor *desc_ptr,
+                                  hw_completion_record *record_ptr,
+                                  void *user_ptr,
+                                  int32_t numa_id) noexcept -> qpl_status {
+    if (count_ >= max_in_flight) {
+        return QPL_STS_QUEUES_ARE_BUSY_ERR;
+    }
+
+    hw_iaa_descriptor_set_completion_record(desc_ptr, record_ptr);
+    record_ptr->status = AD_STATUS_INPROG;
+
+    if (hw_completion_engine::is_cpu_preferred(desc_ptr, numa_id) && cpu_executor_(desc_ptr)) {
+        return hw_completion_engine::track(record_ptr, user_ptr, nullptr);
+    }
+
+    if (hw_page_fault_mode_t::prefault == fault_mode_) {
+        hw_completion_engine::prefault(desc_ptr);
+    }
+
+    const hw_queue *queue_ptr = nullptr;
+    const auto     status     = hw_completion_engine::enqueue(desc_ptr, numa_id, &queue_ptr);
+
+    if (QPL_STS_OK != status) {
+        return status;
+    }
+
+    return hw_completion_engine::track(record_ptr, user_ptr, queue_ptr, desc_ptr);
+}
+
+auto hw_completion_engine::enqueue(hw_descriptor *desc_ptr,
+                                   int32_t numa_id,
+                                   const hw_queue **queue_pptr) noexcept -> qpl_status {
+    return (nullptr != backpressure_ptr_)
+           ? backpressure_ptr_->submit(desc_ptr, numa_id, queue_pptr, traffic_class_)
+           : hw_dispatcher::get_instance().enqueue_descriptor(desc_ptr, numa_id, queue_pptr, traffic_class_);
+}
+
+void hw_completion_engine::prefault(const hw_descriptor *desc_ptr) const noexcept {
+    const auto     *this_ptr = reinterpret_cast<const hw_iaa_analytics_descriptor *>(desc_ptr);
+    const uint32_t opcode    = ADOF_GET_OPCODE(this_ptr->op_code_op_flags);
+
+    // Batch `source-1` is the descriptor list, its descriptors are touched when they are built
+    if (QPL_OPCODE_BATCH == opcode || QPL_OPCODE_NOOP == opcode || QPL_OPCODE_DRAIN == opcode) {
+        return;
+    }
+
+    own_touch_range(this_ptr->src1_ptr, this_ptr->src1_size, false);
+    own_touch_range(this_ptr->dst_ptr, this_ptr->max_dst_size, true);
+
+    if (0u != (this_ptr->op_code_op_flags & (ADOF_READ_SRC2(3u) | ADOF_WRITE_SRC2(3u)))) {
+        own_touch_range(this_ptr->src2_ptr,
+                        this_ptr->src2_size,
+                        0u != (this_ptr->op_code_op_flags & ADOF_WRITE_SRC2(3u)));
+    }
+}
+
+auto hw_completion_engine::resume(entry_t &entry) noexcept -> bool {
+    auto *const desc_ptr   = reinterpret_cast<hw_iaa_analytics_descriptor *>(entry.desc_ptr);
+    auto *const record_ptr = reinterpret_cast<hw_iaa_completion_record *>(entry.record_ptr);
+
+    if (!entry.is_pending) {
+        const uint8_t  status   = *own_status_ptr(entry.record_ptr);
+        const bool     is_write = 0u != (status & FAULT_TYPE_IS_WRITE);
+        const uint64_t address  = record_ptr->fault_address;
+
+        if (hw_page_fault_mode_t::report == fault_mode_ || nullptr == desc_ptr
+            || entry.fault_count >= OWN_MAX_FAULT_RESUMES) {
+            return false;
+        }
+
+        // An address outside of the job buffers is a real error, touching it could crash the process
+        const bool is_aecs_used = 0u != (desc_ptr->op_code_op_flags & (ADOF_READ_SRC2(3u) | ADOF_WRITE_SRC2(3u)));
+
+        if (!own_is_within(address, desc_ptr->src1_ptr, desc_ptr->src1_size)
+            && !own_is_within(address, desc_ptr->dst_ptr, desc_ptr->max_dst_size)
+            && !(is_aecs_used && own_is_within(address, desc_ptr->src2_ptr, desc_ptr->src2_size))) {
+            return false;
+        }
+
+        if (nullptr != entry.queue_ptr) {
+            entry.queue_ptr->record_completion(AD_STATUS_PAGE_FAULT, entry.submit_ticks);
+            entry.queue_ptr->decrement_in_flight();
+            entry.queue_ptr = nullptr;
+        }
+
+        own_touch(reinterpret_cast<uint8_t *>(address), is_write);
+
+        // Stateless operations continue after the completed part, the rest start over
+        switch (ADOF_GET_OPCODE(desc_ptr->op_code_op_flags)) {
+            case QPL_OPCODE_MEMMOVE:
+                desc_ptr->src1_ptr     += record_ptr->bytes_completed;
+                desc_ptr->src1_size    -= record_ptr->bytes_completed;
+                desc_ptr->dst_ptr      += record_ptr->bytes_completed;
+                desc_ptr->max_dst_size -= record_ptr->bytes_completed;
+                break;
+            case QPL_OPCODE_Z_COMP16:
+            case QPL_OPCODE_Z_COMP32:
+            case QPL_OPCODE_Z_DECOMP16:
+            case QPL_OPCODE_Z_DECOMP32:
+                desc_ptr->src1_ptr     += record_ptr->bytes_completed;
+                desc_ptr->src1_size    -= record_ptr->bytes_completed;
+                desc_ptr->dst_ptr      += record_ptr->output_size;
+                desc_ptr->max_dst_size -= record_ptr->output_size;
+                break;
+            default:
+                break;
+        }
+
+        entry.fault_count++;
+        entry.is_pending = true;
+        resumed_faults_++;
+    }
+
+    const hw_queue *queue_ptr = nullptr;
+
+    record_ptr->status = AD_STATUS_INPROG;
+
+    if (QPL_STS_OK != hw_completion_engine::enqueue(entry.desc_ptr, -1, &queue_ptr)) {
+        // The fault status is kept, so the job is retried on the next poll
+        record_ptr->status = AD_STATUS_PAGE_FAULT;
+        return true;
+    }
+
+    entry.queue_ptr    = queue_ptr;
+    entry.submit_ticks = (nullptr != queue_ptr) ? hw_stats_ticks() : 0u;
+    entry.is_pending   = false;
+
+    return true;
+}
+
+auto hw_completion_engine::track(hw_completion_record *record_ptr,
+                                 void *user_ptr,
+                                 const hw_queue *queue_ptr,
+                                 hw_descriptor *desc_ptr) noexcept -> qpl_status {
+    if (count_ >= max_in_flight) {
+        if (nullptr != queue_ptr) {
+            queue_ptr->decrement_in_flight();
+        }
+
+        return QPL_STS_QUEUES_ARE_BUSY_ERR;
+    }
+
+    // Jobs run by the CPU path aren't counted by any queue, so they skip the time stamp
+    const uint64_t submit_ticks = (nullptr != queue_ptr) ? hw_stats_ticks() : 0u;
+
+    entries_[count_++] = {record_ptr, user_ptr, queue_ptr, submit_ticks, desc_ptr, 0u, false};
+
+    return QPL_STS_OK;
+}
+
+auto hw_completion_engine::is_cpu_preferred(const hw_descriptor *desc_ptr, int32_t numa_id) const noexcept -> bool {
+    if (nullptr == cpu_executor_) {
+        return false;
+    }
+
+    if (!hw_dispatcher::get_instance().is_hw_support()) {
+        return true;
+    }
+
+    const auto *this_ptr = reinterpret_cast<const hw_iaa_analytics_descriptor *>(desc_ptr);
+
+    // Batch descriptor keeps the descriptor count in the `source-1` size
+    if (QPL_OPCODE_BATCH == ADOF_GET_OPCODE(this_ptr->op_code_op_flags)) {
+        return false;
+    }
+
+    if (tuned_cpu_threshold != cpu_threshold_) {
+        return this_ptr->src1_size < cpu_threshold_;
+    }
+
+    const auto operation = hw_autotuner::get_operation(desc_ptr);
+
+    if (hw_tuning_op_t::count == operation) {
+        return this_ptr->src1_size < default_cpu_threshold;
+    }
+
+    return this_ptr->src1_size < hw_autotuner::get_instance().get_crossover_size(operation, numa_id);
+}
+
+auto hw_completion_engine::test(const hw_completion_record *record_ptr) noexcept -> qpl_status {
+    return convert_hw_status_to_qpl_status(record_ptr);
+}
+
+void hw_completion_engine::wait_step(const volatile uint8_t *status_ptr, uint32_t &checks) const noexcept {
+    if (hw_wait_mode_t::umwait == mode_) {
+        own_umwait(status_ptr);
+    } else if (checks < OWN_SPIN_CHECKS_LIMIT) {
+        checks++;
+        _mm_pause();
+    } else {
+        sched_yield();
+    }
+}
+
+auto hw_completion_engine::wait(const hw_completion_record *record_ptr,
+                                uint64_t timeout_ns) const noexcept -> qpl_status {
+    const uint64_t deadline_ns = own_deadline_ns(timeout_ns);
+    const auto     *status_ptr = own_status_ptr(record_ptr);
+    uint32_t       checks      = 0u;
+
+    while (AD_STATUS_INPROG == *status_ptr && hw_now_ns() < deadline_ns) {
+        hw_completion_engine::wait_step(status_ptr, checks);
+    }
+
+    return convert_hw_status_to_qpl_status(record_ptr);
+}
+
+auto hw_completion_engine::poll(reaped_t *reaped_ptr, uint32_t capacity) noexcept -> uint32_t {
+    uint32_t reaped_count = 0u;
+    uint32_t kept_count   = 0u;
+
+    // Finished records are moved out, the rest are compacted keeping the submission order
+    for (uint32_t entry_idx = 0u; entry_idx < count_; entry_idx++) {
+        auto       entry  = entries_[entry_idx];
+        const auto status = convert_hw_status_to_qpl_status(entry.record_ptr);
+
+        if (QPL_STS_PAGE_FAULT_ERR == status && hw_completion_engine::resume(entry)) {
+            entries_[kept_count++] = entry;
+            continue;
+        }
+
+        if (QPL_STS_BEING_PROCESSED != status && reaped_count < capacity) {
+            if (nullptr != entry.queue_ptr) {
+                entry.queue_ptr->record_completion(*own_status_ptr(entry.record_ptr), entry.submit_ticks);
+                entry.queue_ptr->decrement_in_flight();
+            }
+
+            reaped_ptr[reaped_count++] = {entry.record_ptr, entry.user_ptr, status};
+        } else {
+            entries_[kept_count++] = entry;
+        }
+    }
+
+    count_ = kept_count;
+
+    return reaped_count;
+}
+
+auto hw_completion_engine::wait_any(reaped_t *reaped_ptr,
+                                    uint32_t capacity,
+                                    uint64_t timeout_ns) noexcept -> uint32_t {
+    const uint64_t deadline_ns = own_deadline_ns(timeout_ns);
+    uint32_t       checks      = 0u;
+
+    while (0u != count_ && 0u != capacity) {
+        const uint32_t reaped_count = hw_completion_engine::poll(reaped_ptr, capacity);
+
+        if (0u != reaped_count || hw_now_ns() >= deadline_ns) {
+            return reaped_count;
+        }
+
+        // The oldest submission is the most likely one to finish first, so it is the one to sleep on
+        hw_completion_engine::wait_step(own_status_ptr(entries_[0].record_ptr), checks);
+    }
+
+    return 0u;
+}
+
+auto hw_completion_engine::in_flight() const noexcept -> uint32_t {
+    return count_;
+}
+
+void hw_completion_engine::set_backpressure(hw_backpressure *backpressure_ptr) noexcept {
+    backpressure_ptr_ = backpressure_ptr;
+}
+
+void hw_completion_engine::set_page_fault_mode(hw_page_fault_mode_t mode) noexcept {
+    fault_mode_ = mode;
+}
+
+void hw_completion_engine::set_traffic_class(hw_traffic_class_t traffic_class) noexcept {
+    traffic_class_ = traffic_class;
+}
+
+auto hw_completion_engine::get_resumed_faults() const noexcept -> uint64_t {
+    return resumed_faults_;
+}
+
+void hw_completion_engine::set_cpu_path(hw_cpu_executor_t executor, uint32_t threshold_bytes) noexcept {
+    cpu_executor_  = executor;
+    cpu_threshold_ = threshold_bytes;
+}
+
+auto hw_completion_engine::get_wait_mode() const noexcept -> hw_wait_mode_t {
+    return mode_;
+}
+
+}
@@ -0,0 +1,156 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_COMPLETION_ENGINE_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_COMPLETION_ENGINE_HPP_
+
+#include <array>
+#include <cstdint>
+
+#include "status.h"
+#include "hw_definitions.h"
+#include "hw_dispatcher.hpp"
+#include "hw_backpressure.hpp"
+#include "hw_cpu_executor.hpp"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief Strategy used to wait for a completion record write
+ */
+enum class hw_wait_mode_t {
+    automatic,    /**< UMONITOR/UMWAIT if the CPU supports WAITPKG, spin otherwise */
+    umwait,       /**< Sleep in C0.1 state until the record cache line is written */
+    spin          /**< Spin with PAUSE, then yield the CPU to other threads */
+};
+
+/**
+ * @brief Handling of jobs that stop on a page fault in a work queue that doesn't block on faults
+ */
+enum class hw_page_fault_mode_t {
+    report,      /**< Job is reaped with QPL_STS_PAGE_FAULT_ERR */
+    resume,      /**< Faulting page is touched and the rest of the job is resubmitted */
+    prefault     /**< Pages of all buffers are touched on submission, faults that still happen are resumed */
+};
+
+/**
+ * @brief Tracks in-flight descriptors of one submitting thread and reaps their completion records.
+ *
+ * @details Records submitted through the engine are counted in the occupancy of the work queue that accepted
+ * them until they are reaped by @ref poll or @ref wait_any, which also report their status and latency to the
+ * queue counters. Jobs with a `source-1` below the CPU threshold, and all jobs on a host without accelerators,
+ * are run by the CPU executor on submission and reaped the same way. Unless set, the threshold is the crossover
+ * @ref hw_autotuner measured for the operation family of the job on the node it is submitted from.
+ *
+ * A job that stops on a page fault is not reaped in the resume modes. The engine touches the faulting page,
+ * which must lie within the job buffers, and resubmits the job: memory move and zero (de)compress continue
+ * after the completed bytes, other operations carry state the record doesn't describe and are restarted.
+ * Restarting is safe since the device writes an AECS only on completion. Only jobs submitted through
+ * @ref submit, or tracked with their descriptor, are resumed.
+ *
+ * @note The engine is not thread-safe, each worker thread is expected to own one.
+ */
+class hw_completion_engine final {
+public:
+    static constexpr uint32_t max_in_flight         = 256u;         /**< Records one engine can track at once */
+    static constexpr uint64_t infinite_timeout      = UINT64_MAX;   /**< Wait without deadline */
+    static constexpr uint32_t default_cpu_threshold = 1024u;        /**< Smaller jobs finish sooner on the CPU */
+    static constexpr uint32_t tuned_cpu_threshold   = 0u - 2u;      /**< Threshold of @ref hw_autotuner per operation */
+
+    /**
+     * @brief Finished job returned by @ref poll and @ref wait_any
+     */
+    struct reaped_t {
+        hw_completion_record *record_ptr = nullptr;           /**< Completion record of the job */
+        void                 *user_ptr   = nullptr;           /**< Pointer passed on submission */
+        qpl_status           status      = QPL_STS_OK;        /**< Converted completion status */
+    };
+
+    explicit hw_completion_engine(hw_wait_mode_t mode = hw_wait_mode_t::automatic) noexcept;
+
+    [[nodiscard]] auto submit(hw_descriptor *desc_ptr,
+                              hw_completion_record *record_ptr,
+                              void *user_ptr = nullptr,
+                              int32_t numa_id = -1) noexcept -> qpl_status;
+
+    [[nodiscard]] auto track(hw_completion_record *record_ptr,
+                             void *user_ptr = nullptr,
+                             const hw_queue *queue_ptr = nullptr,
+                             hw_descriptor *desc_ptr = nullptr) noexcept -> qpl_status;
+
+    [[nodiscard]] auto wait(const hw_completion_record *record_ptr,
+                            uint64_t timeout_ns = infinite_timeout) const noexcept -> qpl_status;
+
+    [[nodiscard]] auto poll(reaped_t *reaped_ptr, uint32_t capacity) noexcept -> uint32_t;
+
+    [[nodiscard]] auto wait_any(reaped_t *reaped_ptr,
+                                uint32_t capacity,
+                                uint64_t timeout_ns = infinite_timeout) noexcept -> uint32_t;
+
+    [[nodiscard]] auto in_flight() const noexcept -> uint32_t;
+
+    void set_backpressure(hw_backpressure *backpressure_ptr) noexcept;
+
+    void set_cpu_path(hw_cpu_executor_t executor, uint32_t threshold_bytes = tuned_cpu_threshold) noexcept;
+
+    void set_page_fault_mode(hw_page_fault_mode_t mode) noexcept;
+
+    /**
+     * @brief Traffic class of the jobs submitted to the devices from now on, see hw_dispatcher::set_traffic_config()
+     */
+    void set_traffic_class(hw_traffic_class_t traffic_class) noexcept;
+
+    /**
+     * @brief Number of page faults the engine resumed jobs from
+     */
+    [[nodiscard]] auto get_resumed_faults() const noexcept -> uint64_t;
+
+    [[nodiscard]] auto get_wait_mode() const noexcept -> hw_wait_mode_t;
+
+    [[nodiscard]] static auto test(const hw_completion_record *record_ptr) noexcept -> qpl_status;
+
+    [[nodiscard]] static auto is_umwait_available() noexcept -> bool;
+
+private:
+    struct entry_t {
+        hw_completion_record *record_ptr   = nullptr;         /**< Tracked completion record */
+        void                 *user_ptr     = nullptr;         /**< Pointer passed on submission */
+        const hw_queue       *queue_ptr    = nullptr;         /**< Queue whose occupancy counts the record */
+        uint64_t             submit_ticks  = 0u;              /**< Tracking time stamp for the queue latency */
+        hw_descriptor        *desc_ptr     = nullptr;         /**< Descriptor to resubmit after a page fault, optional */
+        uint32_t             fault_count   = 0u;              /**< Page faults the job was resumed from */
+        bool                 is_pending    = false;           /**< Resumed job was refused by every queue */
+    };
+
+    void wait_step(const volatile uint8_t *status_ptr, uint32_t &checks) const noexcept;
+
+    [[nodiscard]] auto is_cpu_preferred(const hw_descriptor *desc_ptr, int32_t numa_id) const noexcept -> bool;
+
+    [[nodiscard]] auto enqueue(hw_descriptor *desc_ptr, int32_t numa_id, const hw_queue **queue_pptr) noexcept -> qpl_status;
+
+    [[nodiscard]] auto resume(entry_t &entry) noexcept -> bool;
+
+    void prefault(const hw_descriptor *desc_ptr) const noexcept;
+
+    std::array<entry_t, max_in_flight> entries_          = {};                         /**< In-flight records in submission order */
+    uint32_t                           count_            = 0u;                         /**< Number of in-flight records */
+    hw_wait_mode_t                     mode_             = hw_wait_mode_t::spin;       /**< Resolved wait strategy */
+    hw_backpressure                    *backpressure_ptr_ = nullptr;                   /**< Retry policy, one attempt if not set */
+    hw_cpu_executor_t                  cpu_executor_     = hw_cpu_execute_descriptor;  /**< CPU path, nullptr disables it */
+    uint32_t                           cpu_threshold_    = tuned_cpu_threshold;        /**< Smallest `source-1` sent to the device */
+    hw_page_fault_mode_t               fault_mode_       = hw_page_fault_mode_t::resume; /**< Handling of partial completions */
+    uint64_t                           resumed_faults_   = 0u;                         /**< Faults jobs were resumed from */
+    hw_traffic_class_t                 traffic_class_    = hw_traffic_class_t::normal; /**< Class of the submitted jobs */
+};
+
+[[nodiscard]] auto convert_hw_status_to_qpl_status(const hw_completion_record *record_ptr) noexcept -> qpl_status;
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_COMPLETION_ENGINE_HPP_
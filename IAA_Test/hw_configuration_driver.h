@@ -51,6 +51,16 @@ HW_PATH_GENERAL_API(hw_accelerator_status, initialize_accelerator_driver, (hw_dr
 
 HW_PATH_GENERAL_API(void, finalize_accelerator_driver, (hw_driver_t *driver_ptr));
 
+/**
+ * @brief Checks whether the software-emulated devices replace the configuration driver, see `hw_emulator`
+ */
+HW_PATH_GENERAL_API(bool, emulator_is_enabled, (void));
+
+/**
+ * @brief Returns the emulated implementation of a configuration driver function, NULL if there is none
+ */
+HW_PATH_GENERAL_API(library_function, emulator_get_function, (const char *function_name));
+
 HW_PATH_GENERAL_API(int32_t, driver_new_context, (accfg_ctx **ctx));
 
 HW_PATH_GENERAL_API(accfg_dev *, context_get_first_device,(accfg_ctx *ctx));
@@ -87,6 +97,14 @@ HW_PATH_GENERAL_API (unsigned int,  device_get_version, (accfg_dev *device));
 
 HW_PATH_GENERAL_API (int,  work_queue_get_block_on_fault, (accfg_wq *wq));
 
+HW_PATH_GENERAL_API (unsigned int, device_get_max_batch_size, (accfg_dev *device));
+
+HW_PATH_GENERAL_API (unsigned int, work_queue_get_max_batch_size, (accfg_wq *wq));
+
+HW_PATH_GENERAL_API (uint64_t, work_queue_get_size, (accfg_wq *wq));
+
+HW_PATH_GENERAL_API (uint64_t, work_queue_get_max_transfer_size, (accfg_wq *wq));
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,287 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <cstring>
+
+#include "hw_cpu_executor.hpp"
+#include "hw_iaa_flags.h"
+#include "hw_aecs_api.h"
+#include "qplc_analytics.h"
+#include "qplc_crc64.h"
+#include "qplc_zero.h"
+
+#define OWN_READ_SRC2_AECS  1u    /**< ADOF_READ_SRC2 value for AECS in `source-2` */
+
+using own_analytic_kernel_t = uint32_t (*)(const qplc_analytic_request *, qplc_analytic_result *);
+
+static inline auto own_get_opcode(const hw_iaa_analytics_descriptor *desc_ptr) noexcept -> uint32_t {
+    return ADOF_GET_OPCODE(desc_ptr->op_code_op_flags);
+}
+
+static inline bool own_is_supported(const hw_iaa_analytics_descriptor *desc_ptr) noexcept {
+    switch (own_get_opcode(desc_ptr)) {
+        case QPL_OPCODE_NOOP:
+        case QPL_OPCODE_DRAIN:
+        case QPL_OPCODE_MEMMOVE:
+        case QPL_OPCODE_CRC64:
+        case QPL_OPCODE_Z_COMP16:
+        case QPL_OPCODE_Z_COMP32:
+        case QPL_OPCODE_Z_DECOMP16:
+        case QPL_OPCODE_Z_DECOMP32:
+            return true;
+        case QPL_OPCODE_SCAN:
+        case QPL_OPCODE_SET_MEMBERSHIP:
+        case QPL_OPCODE_EXTRACT:
+        case QPL_OPCODE_SELECT:
+        case QPL_OPCODE_RLE_BURST:
+        case QPL_OPCODE_FIND_UNIQUE:
+        case QPL_OPCODE_EXPAND:
+            // Filtering of a compressed stream needs the inflate pass, which is not on the CPU
+            return 0u == (desc_ptr->decomp_flags & ADDF_ENABLE_DECOMPRESS);
+        default:
+            return false;
+    }
+}
+
+static inline auto own_get_analytic_kernel(uint32_t opcode) noexcept -> own_analytic_kernel_t {
+    switch (opcode) {
+        case QPL_OPCODE_SCAN:
+            return qplc_analytic_scan;
+        case QPL_OPCODE_SET_MEMBERSHIP:
+            return qplc_analytic_set_membership;
+        case QPL_OPCODE_EXTRACT:
+            return qplc_analytic_extract;
+        case QPL_OPCODE_SELECT:
+            return qplc_analytic_select;
+        case QPL_OPCODE_RLE_BURST:
+            return qplc_analytic_rle_burst;
+        case QPL_OPCODE_FIND_UNIQUE:
+            return qplc_analytic_find_unique;
+        default:
+            return qplc_analytic_expand;
+    }
+}
+
+/**
+ * @brief Fills the completion record, the status byte goes last so a poller never sees a half-written record
+ */
+static inline void own_complete(const hw_iaa_analytics_descriptor *desc_ptr,
+                                uint8_t status,
+                                uint32_t bytes_completed,
+                                uint32_t output_size,
+                                uint8_t error_code = AD_ERROR_CODE_OK,
+                                const qplc_analytic_result *result_ptr = nullptr,
+                                const uint64_t *crc64_ptr = nullptr) noexcept {
+    if (0u == (desc_ptr->op_code_op_flags & ADOF_CR_ADDR_VALID) || nullptr == desc_ptr->completion_record_ptr) {
+        return;
+    }
+
+    auto *record_ptr = reinterpret_cast<hw_iaa_completion_record *>(desc_ptr->completion_record_ptr);
+
+    memset(reinterpret_cast<uint8_t *>(record_ptr) + 1u, 0, sizeof(hw_iaa_completion_record) - 1u);
+    record_ptr->error_code      = error_code;
+    record_ptr->bytes_completed = bytes_completed;
+    record_ptr->output_size     = output_size;
+
+    if (nullptr != result_ptr) {
+        record_ptr->output_bits   = (uint8_t) result_ptr->output_bits;
+        record_ptr->xor_checksum  = (uint16_t) result_ptr->xor_checksum;
+        record_ptr->crc           = result_ptr->crc;
+        record_ptr->min_first_agg = result_ptr->min_first_agg;
+        record_ptr->max_last_agg  = result_ptr->max_last_agg;
+        record_ptr->sum_agg       = result_ptr->sum_agg;
+    }
+
+    if (nullptr != crc64_ptr) {
+        record_ptr->crc           = (uint32_t) *crc64_ptr;
+        record_ptr->min_first_agg = (uint32_t) (*crc64_ptr >> 32u);
+    }
+
+    __atomic_store_n(&record_ptr->status, status, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Runs a CRC64 descriptor, the 64-bit result takes the place of the CRC32 and the first aggregate fields
+ */
+static inline auto own_execute_crc64(const hw_iaa_analytics_descriptor *desc_ptr) noexcept -> uint8_t {
+    // Contexts take a few microseconds to build, a thread usually works with a single polynomial
+    static thread_local qplc_crc64_context context{};
+    static thread_local bool               is_context_ready = false;
+
+    const uint64_t polynomial      = ((uint64_t) desc_ptr->num_input_elements << 32u) | desc_ptr->filter_flags;
+    const uint32_t is_be_bit_order = (0u != (desc_ptr->decomp_flags & ADC64F_MSB_FIRST)) ? 1u : 0u;
+    const uint32_t is_inverse      = (0u != (desc_ptr->decomp_flags & ADC64F_INVERT_CRC)) ? 1u : 0u;
+
+    if (!is_context_ready || context.polynomial != polynomial || context.is_be_bit_order != is_be_bit_order
+        || context.is_inverse != is_inverse) {
+        qplc_crc64_init(&context, polynomial, is_be_bit_order, is_inverse);
+        is_context_ready = true;
+    }
+
+    const uint64_t crc = qplc_crc64(&context, 0u, desc_ptr->src1_ptr, desc_ptr->src1_size);
+
+    own_complete(desc_ptr, AD_STATUS_SUCCESS, desc_ptr->src1_size, 0u, AD_ERROR_CODE_OK, nullptr, &crc);
+
+    return AD_STATUS_SUCCESS;
+}
+
+/**
+ * @brief Runs a zero compress or zero decompress descriptor
+ */
+static inline auto own_execute_zero(const hw_iaa_analytics_descriptor *desc_ptr, uint32_t opcode) noexcept -> uint8_t {
+    const bool     is_compress   = QPL_OPCODE_Z_COMP16 == opcode || QPL_OPCODE_Z_COMP32 == opcode;
+    const uint32_t element_width = (QPL_OPCODE_Z_COMP16 == opcode || QPL_OPCODE_Z_DECOMP16 == opcode) ? 16u : 32u;
+    uint32_t       output_size   = 0u;
+
+    const uint32_t status = is_compress
+                            ? qplc_zero_compress(element_width, desc_ptr->src1_ptr, desc_ptr->src1_size,
+                                                 desc_ptr->dst_ptr, desc_ptr->max_dst_size, &output_size)
+                            : qplc_zero_decompress(element_width, desc_ptr->src1_ptr, desc_ptr->src1_size,
+                                                   desc_ptr->dst_ptr, desc_ptr->max_dst_size, &output_size);
+
+    if (AD_STATUS_SUCCESS != status) {
+        own_complete(desc_ptr, (uint8_t) status, 0u, 0u);
+        return (uint8_t) status;
+    }
+
+    own_complete(desc_ptr, AD_STATUS_SUCCESS, desc_ptr->src1_size, output_size);
+
+    return AD_STATUS_SUCCESS;
+}
+
+/**
+ * @brief Runs a filter descriptor with the software kernels, reporting the way the device does
+ */
+static inline auto own_execute_analytic(const hw_iaa_analytics_descriptor *desc_ptr) noexcept -> uint8_t {
+    const uint32_t opcode       = ADOF_GET_OPCODE(desc_ptr->op_code_op_flags);
+    const uint32_t filter_flags = desc_ptr->filter_flags;
+    const bool     is_bit_vector_output = QPL_OPCODE_SCAN == opcode
+                                          || QPL_OPCODE_SET_MEMBERSHIP == opcode
+                                          || QPL_OPCODE_FIND_UNIQUE == opcode;
+
+    if (0u == desc_ptr->num_input_elements) {
+        own_complete(desc_ptr, AD_STATUS_INVALID_NUM_ELEM, 0u, 0u);
+        return AD_STATUS_INVALID_NUM_ELEM;
+    }
+
+    if (!is_bit_vector_output && 0u != (filter_flags & ADFF_INVERT_OUTPUT)) {
+        own_complete(desc_ptr, AD_STATUS_INVALID_INV_OUTPUT, 0u, 0u);
+        return AD_STATUS_INVALID_INV_OUTPUT;
+    }
+
+    qplc_analytic_request request{};
+
+    request.src1_ptr       = desc_ptr->src1_ptr;
+    request.src1_size      = desc_ptr->src1_size;
+    request.elements_count = desc_ptr->num_input_elements;
+    request.src1_format    = ADFF_GET_SRC1_PARSER(filter_flags);
+    request.src1_bit_width = ADFF_GET_SRC1_WIDTH(filter_flags);
+    request.dst_ptr        = desc_ptr->dst_ptr;
+    request.dst_size       = desc_ptr->max_dst_size;
+    request.output_format  = ADFF_GET_OUTPUT_WIDTH(filter_flags)
+                             | (filter_flags & (ADFF_OUTPUT_BE | ADFF_INVERT_OUTPUT));
+    request.drop_low_bits  = ADFF_GET_DROP_LOW_BITS(filter_flags);
+    request.drop_high_bits = ADFF_GET_DROP_HIGH_BITS(filter_flags);
+
+    if (ADOF_READ_SRC2(OWN_READ_SRC2_AECS) == (desc_ptr->op_code_op_flags & ADOF_READ_SRC2(3u))) {
+        const auto *aecs_ptr = reinterpret_cast<const hw_iaa_aecs_analytic *>(desc_ptr->src2_ptr);
+
+        request.param_low            = aecs_ptr->filtering_options.filter_low;
+        request.param_high           = aecs_ptr->filtering_options.filter_high;
+        request.initial_output_index = aecs_ptr->filtering_options.output_mod_idx;
+        request.crc_seed             = aecs_ptr->filtering_options.crc;
+        request.xor_seed             = aecs_ptr->filtering_options.xor_checksum;
+    } else {
+        request.src2_ptr        = desc_ptr->src2_ptr;
+        request.src2_size       = desc_ptr->src2_size;
+        request.src2_bit_width  = ADFF_GET_SRC2_WIDTH(filter_flags);
+        request.src2_big_endian = filter_flags & ADFF_SRC2_BE;
+    }
+
+    qplc_analytic_result result{};
+    const uint32_t       error_code = own_get_analytic_kernel(opcode)(&request, &result);
+
+    if (QPLC_ANALYTIC_INVALID_FLAGS == error_code) {
+        own_complete(desc_ptr, AD_STATUS_INVALID_FILTER_FLAG, 0u, 0u);
+        return AD_STATUS_INVALID_FILTER_FLAG;
+    }
+
+    if (AD_ERROR_CODE_OK != error_code) {
+        own_complete(desc_ptr, AD_STATUS_ANALYTICS_ERROR, 0u, 0u, (uint8_t) error_code);
+        return AD_STATUS_ANALYTICS_ERROR;
+    }
+
+    own_complete(desc_ptr, AD_STATUS_SUCCESS, desc_ptr->src1_size, result.output_size, AD_ERROR_CODE_OK, &result);
+
+    return AD_STATUS_SUCCESS;
+}
+
+static inline auto own_execute(const hw_iaa_analytics_descriptor *desc_ptr) noexcept -> uint8_t {
+    switch (own_get_opcode(desc_ptr)) {
+        case QPL_OPCODE_MEMMOVE:
+            if (desc_ptr->max_dst_size < desc_ptr->src1_size) {
+                own_complete(desc_ptr, AD_STATUS_OUTPUT_OVERFLOW, 0u, 0u);
+                return AD_STATUS_OUTPUT_OVERFLOW;
+            }
+
+            memmove(desc_ptr->dst_ptr, desc_ptr->src1_ptr, desc_ptr->src1_size);
+            own_complete(desc_ptr, AD_STATUS_SUCCESS, desc_ptr->src1_size, desc_ptr->src1_size);
+            return AD_STATUS_SUCCESS;
+        case QPL_OPCODE_NOOP:
+        case QPL_OPCODE_DRAIN:
+            own_complete(desc_ptr, AD_STATUS_SUCCESS, 0u, 0u);
+            return AD_STATUS_SUCCESS;
+        case QPL_OPCODE_CRC64:
+            return own_execute_crc64(desc_ptr);
+        case QPL_OPCODE_Z_COMP16:
+        case QPL_OPCODE_Z_COMP32:
+        case QPL_OPCODE_Z_DECOMP16:
+        case QPL_OPCODE_Z_DECOMP32:
+            return own_execute_zero(desc_ptr, own_get_opcode(desc_ptr));
+        default:
+            return own_execute_analytic(desc_ptr);
+    }
+}
+
+namespace qpl::ml::dispatcher {
+
+auto hw_cpu_execute_descriptor(hw_descriptor *desc_ptr) noexcept -> bool {
+    const auto *this_ptr = reinterpret_cast<const hw_iaa_analytics_descriptor *>(desc_ptr);
+
+    if (QPL_OPCODE_BATCH != own_get_opcode(this_ptr)) {
+        if (!own_is_supported(this_ptr)) {
+            return false;
+        }
+
+        own_execute(this_ptr);
+        return true;
+    }
+
+    const auto     *list_ptr  = reinterpret_cast<const hw_iaa_analytics_descriptor *>(this_ptr->src1_ptr);
+    const uint32_t desc_count = this_ptr->src1_size;
+
+    // A batch is spilled as a whole or not at all
+    for (uint32_t desc_idx = 0u; desc_idx < desc_count; desc_idx++) {
+        if (!own_is_supported(&list_ptr[desc_idx])) {
+            return false;
+        }
+    }
+
+    uint32_t completed_count = 0u;
+
+    for (uint32_t desc_idx = 0u; desc_idx < desc_count; desc_idx++) {
+        completed_count += (AD_STATUS_SUCCESS == own_execute(&list_ptr[desc_idx])) ? 1u : 0u;
+    }
+
+    own_complete(this_ptr,
+                 (completed_count == desc_count) ? AD_STATUS_SUCCESS : AD_STATUS_BATCH_FAILED,
+                 completed_count,
+                 0u);
+
+    return true;
+}
+
+}
@@ -0,0 +1,30 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_CPU_EXECUTOR_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_CPU_EXECUTOR_HPP_
+
+#include "hw_definitions.h"
+
+namespace qpl::ml::dispatcher {
+
+/**
+ * @brief Executes a prepared hardware descriptor on the CPU.
+ *
+ * @details Executor writes the completion record attached to the descriptor the same way the device would, so
+ * the caller reaps spilled jobs along with the hardware ones. Returns false without touching any memory if
+ * the descriptor can't be executed on the CPU.
+ */
+using hw_cpu_executor_t = auto (*)(hw_descriptor *desc_ptr) noexcept -> bool;
+
+/**
+ * @brief Default executor, supports no-op, drain, memory move, CRC64, zero compress and decompress, filter operations
+ * on uncompressed input and batches of those
+ */
+auto hw_cpu_execute_descriptor(hw_descriptor *desc_ptr) noexcept -> bool;
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_CPU_EXECUTOR_HPP_
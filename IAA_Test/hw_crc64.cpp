@@ -0,0 +1,187 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <algorithm>
+
+#include "hw_crc64.hpp"
+#include "hw_autotuner.hpp"
+#include "hw_descriptors_api.h"
+
+namespace qpl::ml::dispatcher {
+
+hw_crc64::hw_crc64(const uint64_t polynomial,
+                   const bool is_be_bit_order,
+                   const bool is_inverse,
+                   const uint32_t max_in_flight) noexcept
+        : batches_(max_in_flight) {
+    qplc_crc64_init(&context_, polynomial, is_be_bit_order ? 1u : 0u, is_inverse ? 1u : 0u);
+
+    // The crossover alone decides what runs on the CPU
+    engine_.set_cpu_path(nullptr, 0u);
+}
+
+void hw_crc64::set_crossover_size(const uint32_t size) noexcept {
+    crossover_size_   = size;
+    is_crossover_set_ = true;
+}
+
+auto hw_crc64::get_crossover_size() const noexcept -> uint32_t {
+    return is_crossover_set_ ? crossover_size_ : get_measured_crossover_size();
+}
+
+auto hw_crc64::get_max_in_flight() const noexcept -> uint32_t {
+    return batches_.get_max_in_flight();
+}
+
+auto hw_crc64::get_measured_crossover_size() noexcept -> uint32_t {
+    return hw_autotuner::get_instance().get_crossover_size(hw_tuning_op_t::crc64);
+}
+
+void hw_crc64::compute_on_cpu(const hw_crc64_buffer_t &buffer, hw_crc64_result_t &result) const noexcept {
+    result.status = QPL_STS_OK;
+    result.crc    = qplc_crc64(&context_, 0u, buffer.src_ptr, buffer.size);
+}
+
+auto hw_crc64::submit(batch_slots_t::slot_t &slot, const hw_crc64_buffer_t *buffers_ptr) noexcept -> qpl_status {
+    for (uint32_t desc_idx = 0u; desc_idx < slot.count; desc_idx++) {
+        const auto &buffer = buffers_ptr[slot.items_ptr[desc_idx]];
+
+        hw_iaa_descriptor_init_crc64(&slot.descs_ptr[desc_idx],
+                                     buffer.src_ptr,
+                                     buffer.size,
+                                     context_.polynomial,
+                                     0u != context_.is_be_bit_order,
+                                     0u != context_.is_inverse);
+    }
+
+    return batches_.submit(slot, engine_);
+}
+
+void hw_crc64::reap(const hw_crc64_buffer_t *buffers_ptr, hw_crc64_result_t *results_ptr, const bool is_blocking) noexcept {
+    hw_completion_engine::reaped_t reaped[hw_completion_engine::max_in_flight];
+
+    const uint32_t reaped_count = is_blocking
+                                  ? engine_.wait_any(reaped, hw_completion_engine::max_in_flight)
+                                  : engine_.poll(reaped, hw_completion_engine::max_in_flight);
+
+    for (uint32_t reaped_idx = 0u; reaped_idx < reaped_count; reaped_idx++) {
+        auto &slot = batch_slots_t::get_slot(reaped[reaped_idx]);
+
+        for (uint32_t desc_idx = 0u; desc_idx < slot.count; desc_idx++) {
+            const auto &record    = batch_slots_t::get_record(slot, desc_idx);
+            const auto buffer_idx = slot.items_ptr[desc_idx];
+            auto       &result    = results_ptr[buffer_idx];
+
+            // A descriptor the batch did not run to success is a buffer the CPU still can do
+            if (QPL_STS_OK != batch_slots_t::get_status(slot, desc_idx)) {
+                hw_crc64::compute_on_cpu(buffers_ptr[buffer_idx], result);
+                continue;
+            }
+
+            result.status = QPL_STS_OK;
+            result.crc    = ((uint64_t) record.min_first_agg << 32u) | record.crc;
+        }
+
+        batches_.release(slot);
+    }
+}
+
+auto hw_crc64::compute(const hw_crc64_buffer_t *buffers_ptr,
+                       const uint32_t buffer_count,
+                       hw_crc64_result_t *results_ptr) noexcept -> qpl_status {
+    if ((nullptr == buffers_ptr || nullptr == results_ptr) && 0u != buffer_count) {
+        return QPL_STS_NULL_PTR_ERR;
+    }
+
+    const uint32_t crossover_size = hw_crc64::get_crossover_size();
+
+    offloaded_.clear();
+    on_cpu_.clear();
+
+    for (uint32_t buffer_idx = 0u; buffer_idx < buffer_count; buffer_idx++) {
+        const auto &buffer = buffers_ptr[buffer_idx];
+
+        if (nullptr == buffer.src_ptr && 0u != buffer.size) {
+            results_ptr[buffer_idx] = {QPL_STS_NULL_PTR_ERR, 0u};
+        } else if (buffer.size >= crossover_size && 0u != buffer.size) {
+            offloaded_.push_back(buffer_idx);
+        } else {
+            on_cpu_.push_back(buffer_idx);
+        }
+    }
+
+    if (!offloaded_.empty() && QPL_STS_OK != batches_.prepare()) {
+        on_cpu_.insert(on_cpu_.end(), offloaded_.begin(), offloaded_.end());
+        offloaded_.clear();
+    }
+
+    const auto offloaded_count = static_cast<uint32_t>(offloaded_.size());
+    const auto on_cpu_count    = static_cast<uint32_t>(on_cpu_.size());
+    uint32_t   next_offloaded  = 0u;
+    uint32_t   next_on_cpu     = 0u;
+
+    while (next_offloaded < offloaded_count || next_on_cpu < on_cpu_count || 0u != engine_.in_flight()) {
+        for (auto *slot_ptr = batches_.get_free();
+             next_offloaded < offloaded_count && nullptr != slot_ptr;
+             slot_ptr = batches_.get_free()) {
+            slot_ptr->count = std::min(batches_.get_batch_size(), offloaded_count - next_offloaded);
+            std::copy_n(&offloaded_[next_offloaded], slot_ptr->count, slot_ptr->items_ptr);
+
+            const auto status = hw_crc64::submit(*slot_ptr, buffers_ptr);
+
+            if (QPL_STS_QUEUES_ARE_BUSY_ERR == status) {
+                break;
+            }
+
+            if (QPL_STS_OK != status) {
+                for (uint32_t desc_idx = 0u; desc_idx < slot_ptr->count; desc_idx++) {
+                    hw_crc64::compute_on_cpu(buffers_ptr[slot_ptr->items_ptr[desc_idx]],
+                                             results_ptr[slot_ptr->items_ptr[desc_idx]]);
+                }
+            }
+
+            next_offloaded += slot_ptr->count;
+        }
+
+        // Small buffers are computed while the batches are in flight
+        if (next_on_cpu < on_cpu_count) {
+            const uint32_t buffer_idx = on_cpu_[next_on_cpu++];
+
+            hw_crc64::compute_on_cpu(buffers_ptr[buffer_idx], results_ptr[buffer_idx]);
+
+            if (0u != engine_.in_flight()) {
+                hw_crc64::reap(buffers_ptr, results_ptr, false);
+            }
+
+            continue;
+        }
+
+        if (0u == engine_.in_flight()) {
+            // Every queue refused while none of our batches is in flight, the CPU takes the next batch
+            const uint32_t count = std::min(batches_.get_batch_size(), offloaded_count - next_offloaded);
+
+            for (uint32_t idx = next_offloaded; idx < next_offloaded + count; idx++) {
+                hw_crc64::compute_on_cpu(buffers_ptr[offloaded_[idx]], results_ptr[offloaded_[idx]]);
+            }
+
+            next_offloaded += count;
+
+            continue;
+        }
+
+        hw_crc64::reap(buffers_ptr, results_ptr, true);
+    }
+
+    for (uint32_t buffer_idx = 0u; buffer_idx < buffer_count; buffer_idx++) {
+        if (QPL_STS_OK != results_ptr[buffer_idx].status) {
+            return results_ptr[buffer_idx].status;
+        }
+    }
+
+    return QPL_STS_OK;
+}
+
+}
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_CRC64_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_CRC64_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "status.h"
+#include "hw_definitions.h"
+#include "hw_completion_engine.hpp"
+#include "hw_batch_slots.hpp"
+#include "qplc_crc64.h"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief Buffer to compute the CRC64 of
+ */
+struct hw_crc64_buffer_t {
+    const uint8_t *src_ptr = nullptr;   /**< Data */
+    uint32_t      size     = 0u;        /**< Data size in bytes */
+};
+
+/**
+ * @brief CRC64 of one buffer
+ */
+struct hw_crc64_result_t {
+    qpl_status status = QPL_STS_OK;     /**< Buffer status, the CRC is valid on success only */
+    uint64_t   crc    = 0u;             /**< CRC64 as the device reports it */
+};
+
+/**
+ * @brief Computes CRC64 of many buffers, batching the large ones to the devices and folding the small ones on the CPU.
+ *
+ * @details A CRC64 descriptor costs the same submission and completion round trip whatever the buffer size, while
+ * the CPU kernel folds 64 bytes per carry-less multiplication step, so small buffers finish sooner on the CPU.
+ * Buffers below the crossover size are computed in place, the others are packed into batch descriptors of up to
+ * the device batch size, one completion record per buffer, and the batches are kept in flight while the CPU
+ * works on the small buffers.
+ *
+ * Unless set, the crossover is the one @ref hw_autotuner measured for CRC64 on the node of the calling thread,
+ * loaded from the tuning profile or tuned on the first computation. Without devices every buffer goes to the CPU.
+ *
+ * A buffer the device fails on, for instance with a page fault inside a batch, is recomputed on the CPU, so
+ * every buffer with valid arguments gets its CRC.
+ *
+ * @note The object owns a completion engine and its batches, each thread is expected to use its own one.
+ */
+class hw_crc64 final {
+public:
+    static constexpr uint64_t ecma_polynomial = 0x42F0E1EBA9EA3693ull;   /**< ECMA-182 polynomial */
+    static constexpr uint32_t never_offload   = UINT32_MAX;              /**< Crossover keeping every buffer on the CPU */
+
+    /**
+     * @param max_in_flight batches in progress at once, 0 picks 4 per device
+     */
+    explicit hw_crc64(uint64_t polynomial = ecma_polynomial,
+                      bool is_be_bit_order = true,
+                      bool is_inverse = true,
+                      uint32_t max_in_flight = 0u) noexcept;
+
+    hw_crc64(const hw_crc64 &) = delete;
+
+    auto operator=(const hw_crc64 &) -> hw_crc64 & = delete;
+
+    /**
+     * @brief Computes CRC64 of all buffers, every buffer gets its result even if others fail
+     *
+     * @return QPL_STS_OK if every buffer succeeded, the status of the first failed buffer otherwise
+     */
+    [[nodiscard]] auto compute(const hw_crc64_buffer_t *buffers_ptr,
+                               uint32_t buffer_count,
+                               hw_crc64_result_t *results_ptr) noexcept -> qpl_status;
+
+    /**
+     * @brief Replaces the measured crossover, @ref never_offload keeps every buffer on the CPU
+     */
+    void set_crossover_size(uint32_t size) noexcept;
+
+    /**
+     * @brief Smallest buffer sent to the devices
+     */
+    [[nodiscard]] auto get_crossover_size() const noexcept -> uint32_t;
+
+    [[nodiscard]] auto get_max_in_flight() const noexcept -> uint32_t;
+
+    /**
+     * @brief Crossover @ref hw_autotuner measured for CRC64 on the node of the calling thread
+     */
+    [[nodiscard]] static auto get_measured_crossover_size() noexcept -> uint32_t;
+
+private:
+    using batch_slots_t = hw_batch_slots<uint32_t>;    /**< Work item of a descriptor is the index of its buffer */
+
+    [[nodiscard]] auto submit(batch_slots_t::slot_t &slot, const hw_crc64_buffer_t *buffers_ptr) noexcept -> qpl_status;
+
+    void compute_on_cpu(const hw_crc64_buffer_t &buffer, hw_crc64_result_t &result) const noexcept;
+
+    void reap(const hw_crc64_buffer_t *buffers_ptr, hw_crc64_result_t *results_ptr, bool is_blocking) noexcept;
+
+    qplc_crc64_context    context_          = {};            /**< CPU kernel tables of the polynomial */
+    hw_completion_engine  engine_;                           /**< Tracks the batches of this object */
+    batch_slots_t         batches_;                          /**< Batches, in flight or not */
+    std::vector<uint32_t> offloaded_;                        /**< Buffers going to the devices, in batch order */
+    std::vector<uint32_t> on_cpu_;                           /**< Buffers computed on the CPU */
+    uint32_t              crossover_size_   = never_offload; /**< Smallest buffer sent to the devices */
+    bool                  is_crossover_set_ = false;         /**< Crossover was set, the measured one is not used */
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_CRC64_HPP_
@@ -154,6 +154,30 @@ HW_PATH_BYTE_PACKED_STRUCTURE_BEGIN {
 } hw_iaa_analytics_descriptor;
 HW_PATH_BYTE_PACKED_STRUCTURE_END
 
+/**
+ * @todo hide details
+ */
+HW_PATH_BYTE_PACKED_STRUCTURE_BEGIN {
+    HW_PATH_VOLATILE uint8_t status;    /**< Completion status field, see @ref HW_STATUS_CODES */
+    uint8_t  error_code;                /**< Operation error if status is AD_STATUS_ANALYTICS_ERROR, see @ref HW_ERROR_CODES */
+    uint8_t  fault_info;                /**< Page fault details */
+    uint8_t  reserved0;                 /**< Reserved bytes */
+    uint32_t bytes_completed;           /**< Number of source bytes processed before stop */
+    uint64_t fault_address;             /**< Faulting address if the operation stopped on page fault */
+    uint32_t invalid_flags;             /**< Flags that caused AD_STATUS_INVALID_*_FLAG status */
+    uint32_t reserved1;                 /**< Reserved bytes */
+    uint32_t output_size;               /**< Number of bytes written to the destination */
+    uint8_t  output_bits;               /**< Number of valid bits in the last output element */
+    uint8_t  reserved2;                 /**< Reserved bytes */
+    uint16_t xor_checksum;              /**< XOR checksum of the processed data */
+    uint32_t crc;                       /**< CRC32 of the processed data | Crc64 low half */
+    uint32_t min_first_agg;             /**< Minimal value or index of the first set bit aggregate | Crc64 high half */
+    uint32_t max_last_agg;              /**< Maximal value or index of the last set bit aggregate */
+    uint32_t sum_agg;                   /**< Sum or number of set bits aggregate */
+    uint32_t reserved3[4];              /**< Reserved bytes */
+} hw_iaa_completion_record;
+HW_PATH_BYTE_PACKED_STRUCTURE_END
+
 #ifdef __cplusplus
 }
 #endif
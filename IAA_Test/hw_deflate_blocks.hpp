@@ -0,0 +1,126 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_DEFLATE_BLOCKS_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_DEFLATE_BLOCKS_HPP_
+
+#include <cstdint>
+#include <cstring>
+
+#include "hw_aecs_api.h"
+#include "qplc_compression_consts.h"
+
+namespace qpl::ml::dispatcher {
+
+constexpr uint32_t hw_deflate_stored_block_max_size = 65535u;  /**< Largest LEN of a deflate stored block */
+constexpr uint32_t hw_deflate_stored_header_size    = 5u;      /**< Block header byte, LEN and NLEN */
+constexpr uint32_t hw_deflate_trailer_size          = 2u;      /**< Empty final fixed block: 3 header bits and the 7-bit EOB */
+constexpr uint32_t hw_deflate_eob_symbol            = 256u;    /**< End-of-block literal/length symbol */
+constexpr uint32_t hw_deflate_fixed_eob_code        = 0u;      /**< Fixed code of the end-of-block symbol */
+constexpr uint32_t hw_deflate_fixed_eob_length      = 7u;      /**< Bit length of the fixed end-of-block code */
+
+/**
+ * @brief Size of the source written as stored blocks, also the largest output a descriptor is allowed to take
+ */
+constexpr auto hw_deflate_stored_size(const uint64_t source_size) noexcept -> uint64_t {
+    const uint64_t block_count = (source_size + hw_deflate_stored_block_max_size - 1u) / hw_deflate_stored_block_max_size;
+
+    return source_size + hw_deflate_stored_header_size * ((0u != block_count) ? block_count : 1u);
+}
+
+/**
+ * @brief Writes the source as non-final stored blocks
+ *
+ * @param out_ptr    position past the last written byte
+ * @param bit_offset bits of the last written byte taken by the stream, 0 if it is byte aligned. The zero padding
+ *                   of a partial byte holds the first block header if at least 3 bits are left
+ *
+ * @return position past the written blocks, at most @ref hw_deflate_stored_size bytes further
+ */
+inline auto hw_deflate_write_stored_blocks(uint8_t *out_ptr,
+                                           const uint8_t *src_ptr,
+                                           uint32_t src_size,
+                                           const uint32_t bit_offset = 0u) noexcept -> uint8_t * {
+    bool is_header_written = (0u != bit_offset && bit_offset <= 5u);
+
+    while (0u != src_size) {
+        const uint32_t block_size = (src_size < hw_deflate_stored_block_max_size) ? src_size : hw_deflate_stored_block_max_size;
+        const uint32_t block_nlen = ~block_size & 0xFFFFu;
+
+        // BFINAL = 0 and BTYPE = 00, the rest of the byte is padding up to the LEN field
+        if (!is_header_written) {
+            *out_ptr++ = 0u;
+        }
+
+        out_ptr[0] = static_cast<uint8_t>(block_size);
+        out_ptr[1] = static_cast<uint8_t>(block_size >> 8u);
+        out_ptr[2] = static_cast<uint8_t>(block_nlen);
+        out_ptr[3] = static_cast<uint8_t>(block_nlen >> 8u);
+        memcpy(out_ptr + hw_deflate_stored_header_size - 1u, src_ptr, block_size);
+
+        out_ptr          += hw_deflate_stored_header_size - 1u + block_size;
+        src_ptr          += block_size;
+        src_size         -= block_size;
+        is_header_written = false;
+    }
+
+    return out_ptr;
+}
+
+/**
+ * @brief Moves the whole bytes of the output accumulator to the output, the partial byte stays in the accumulator
+ *
+ * @return position past the written bytes
+ */
+inline auto hw_deflate_drain_accumulator(hw_iaa_aecs_compress &aecs, uint8_t *out_ptr) noexcept -> uint8_t * {
+    const uint32_t byte_count = aecs.num_output_accum_bits >> 3u;
+
+    memcpy(out_ptr, aecs.output_accum, byte_count);
+
+    if (byte_count < sizeof(aecs.output_accum)) {
+        aecs.output_accum[0] = aecs.output_accum[byte_count];
+    }
+
+    aecs.num_output_accum_bits &= 7u;
+
+    return out_ptr + byte_count;
+}
+
+/**
+ * @brief Appends the EOB of the block opened with the codes of the AECS, the codes are the ones the device uses
+ */
+inline void hw_deflate_end_block(hw_iaa_aecs_compress &aecs) noexcept {
+    const uint32_t        packed_code = aecs.histogram.ll_sym[hw_deflate_eob_symbol];
+    const hw_huffman_code eob_symbol  = {static_cast<uint16_t>(packed_code & QPLC_HUFFMAN_CODE_MASK),
+                                         0u,
+                                         static_cast<uint8_t>((packed_code >> QPLC_HUFFMAN_CODE_LENGTH_OFFSET)
+                                                              & QPLC_HUFFMAN_CODE_LENGTH_MASK)};
+
+    hw_iaa_aecs_compress_accumulator_insert_eob(&aecs, eob_symbol);
+}
+
+/**
+ * @brief Ends the stream with an empty final fixed block after the bits of the accumulator and writes them out
+ *
+ * @details The accumulator must not hold a block still open, see @ref hw_deflate_end_block. Written are
+ * @ref hw_deflate_trailer_size bytes on a clean accumulator, its whole bytes and at most 3 more otherwise.
+ *
+ * @return position past the end of the stream
+ */
+inline auto hw_deflate_write_trailer(hw_iaa_aecs_compress &aecs, uint8_t *out_ptr) noexcept -> uint8_t * {
+    const hw_huffman_code eob_symbol = {hw_deflate_fixed_eob_code, 0u, hw_deflate_fixed_eob_length};
+
+    out_ptr = hw_deflate_drain_accumulator(aecs, out_ptr);
+
+    (void) hw_iaa_aecs_compress_write_deflate_fixed_header(&aecs, BFINAL_BIT);
+    hw_iaa_aecs_compress_accumulator_insert_eob(&aecs, eob_symbol);
+    hw_iaa_aecs_compress_accumulator_flush(&aecs, &out_ptr, aecs.num_output_accum_bits);
+
+    return out_ptr;
+}
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_DEFLATE_BLOCKS_HPP_
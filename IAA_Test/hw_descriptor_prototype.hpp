@@ -0,0 +1,146 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_DESCRIPTOR_PROTOTYPE_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_DESCRIPTOR_PROTOTYPE_HPP_
+
+#include <cstdint>
+#include <cstring>
+
+#include "hw_definitions.h"
+#include "hw_iaa_flags.h"
+#include "hw_aecs_api.h"
+
+namespace qpl::ml::dispatcher {
+
+static_assert(sizeof(hw_iaa_analytics_descriptor) == sizeof(hw_descriptor), "Analytics descriptor must fill the descriptor");
+
+/**
+ * @brief Analytics descriptor with everything but the buffers of the job filled in.
+ *
+ * @details Jobs of one operation on one stream format differ only in their pointers, sizes and element count.
+ * The prototype holds the descriptor those setters would leave behind: opcode, `source-2` mode, parser, bit-width,
+ * output format, decompress flags and the completion record flags. @ref fill takes a copy, patches the fields of
+ * the job in registers and writes the descriptor with one 64-byte copy, in place of a reset and a chain of
+ * read-modify-write setters. Once its completion record is set, the descriptor is byte for byte the one the
+ * setters build.
+ *
+ * Operations with their parameters in the AECS (scan, extract, find unique) point `source-2` to the filter part
+ * of the AECS, the parameters themselves are written by the caller. Select and expand read a 1-bit
+ * little-endian mask as `source-2`. Prototypes known at compile time are @ref hw_analytic_prototype_v constants,
+ * others are built once where their parameters become known.
+ */
+class hw_analytic_prototype final {
+public:
+    /**
+     * @param opcode        analytic opcode, QPL_OPCODE_SCAN, EXTRACT, FIND_UNIQUE, SELECT or EXPAND
+     * @param bit_width     element bit-width, 1..32, not used for @ref hw_iaa_input_format_prle
+     * @param is_compressed `source-1` is a little-endian deflate stream ending on a byte boundary
+     */
+    constexpr hw_analytic_prototype(const uint32_t opcode,
+                                    const hw_iaa_input_format input_format,
+                                    const uint32_t bit_width,
+                                    const hw_iaa_output_format output_format,
+                                    const bool is_compressed = false) noexcept
+            : image_{0u,
+                     ADOF_OPCODE(opcode) | ADOF_CR_ADDR_VALID | ADOF_REQ_COMPL
+                     | ADOF_READ_SRC2(is_aecs_opcode(opcode) ? 1u : 2u),
+                     nullptr,
+                     nullptr,
+                     nullptr,
+                     0u,
+                     0u,
+                     static_cast<uint16_t>(is_compressed ? ADDF_ENABLE_DECOMPRESS : 0u),
+                     nullptr,
+                     0u,
+                     is_aecs_opcode(opcode) ? HW_AECS_ANALYTIC_FILTER_ONLY_SIZE : 0u,
+                     ADFF_SRC1_PARSER(input_format)
+                     | ((hw_iaa_input_format_prle == input_format) ? 0u : ADFF_SRC1_WIDTH(bit_width))
+                     | ADFF_OUTPUT_WIDTH(output_format)
+                     | (static_cast<uint32_t>(output_format) & (ADFF_OUTPUT_BE | ADFF_INVERT_OUTPUT))
+                     | (is_aecs_opcode(opcode) ? 0u : ADFF_SRC2_WIDTH(1u)),
+                     0u},
+              is_aecs_(is_aecs_opcode(opcode)) {
+    }
+
+    /**
+     * @brief Writes the descriptor of a job
+     *
+     * @param src2_ptr  filter AECS, or the mask of select and expand
+     * @param src2_size mask size in bytes, the AECS size of the prototype is kept for AECS operations
+     */
+    inline void fill(hw_descriptor *const desc_ptr,
+                     const uint8_t *const src_ptr,
+                     const uint32_t src_size,
+                     const uint32_t element_count,
+                     uint8_t *const dst_ptr,
+                     const uint32_t dst_size,
+                     const void *const src2_ptr,
+                     const uint32_t src2_size = 0u) const noexcept {
+        hw_iaa_analytics_descriptor desc = image_;
+
+        desc.src1_ptr           = const_cast<uint8_t *>(src_ptr);
+        desc.src1_size          = src_size;
+        desc.num_input_elements = element_count;
+        desc.dst_ptr            = dst_ptr;
+        desc.max_dst_size       = dst_size;
+        desc.src2_ptr           = static_cast<uint8_t *>(const_cast<void *>(src2_ptr));
+        desc.src2_size          = is_aecs_ ? image_.src2_size : src2_size;
+
+        memcpy(desc_ptr, &desc, sizeof(desc));
+    }
+
+    [[nodiscard]] constexpr auto get_opcode() const noexcept -> uint32_t {
+        return ADOF_GET_OPCODE(image_.op_code_op_flags);
+    }
+
+    [[nodiscard]] constexpr auto get_filter_flags() const noexcept -> uint32_t {
+        return image_.filter_flags;
+    }
+
+    /**
+     * @brief Whether the operation reads its parameters from the AECS rather than a secondary input
+     */
+    [[nodiscard]] static constexpr auto is_aecs_opcode(const uint32_t opcode) noexcept -> bool {
+        return QPL_OPCODE_SELECT != opcode && QPL_OPCODE_EXPAND != opcode;
+    }
+
+private:
+    hw_iaa_analytics_descriptor image_;              /**< Descriptor without the job buffers */
+    bool                        is_aecs_ = true;     /**< See @ref is_aecs_opcode */
+};
+
+/**
+ * @brief Checks the parameters of a prototype fixed at compile time, see @ref hw_analytic_prototype_v
+ */
+template <uint32_t opcode,
+          hw_iaa_input_format input_format,
+          uint32_t bit_width,
+          hw_iaa_output_format output_format,
+          bool is_compressed>
+constexpr auto make_analytic_prototype() noexcept -> hw_analytic_prototype {
+    static_assert(QPL_OPCODE_SCAN == opcode || QPL_OPCODE_EXTRACT == opcode || QPL_OPCODE_FIND_UNIQUE == opcode
+                  || QPL_OPCODE_SELECT == opcode || QPL_OPCODE_EXPAND == opcode,
+                  "Prototype of an operation with no analytic setter");
+    static_assert(hw_iaa_input_format_prle == input_format || (0u < bit_width && 32u >= bit_width),
+                  "Bit-width out of 1..32");
+
+    return hw_analytic_prototype(opcode, input_format, bit_width, output_format, is_compressed);
+}
+
+/**
+ * @brief Prototype of a combination fixed at compile time, built by the compiler into read-only data
+ */
+template <uint32_t opcode,
+          hw_iaa_input_format input_format,
+          uint32_t bit_width,
+          hw_iaa_output_format output_format,
+          bool is_compressed = false>
+inline constexpr hw_analytic_prototype hw_analytic_prototype_v =
+        make_analytic_prototype<opcode, input_format, bit_width, output_format, is_compressed>();
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_DESCRIPTOR_PROTOTYPE_HPP_
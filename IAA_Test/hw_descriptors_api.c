@@ -0,0 +1,392 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+/*
+ *  Intel® Query Processing Library (Intel® QPL)
+ *  Hardware Interconnect API (private C API)
+ */
+
+#include <string.h>
+
+#include "hw_descriptors_api.h"
+
+HW_PATH_IAA_API(void, descriptor_reset, (hw_descriptor *const descriptor_ptr)) {
+    memset(descriptor_ptr, 0, sizeof(hw_descriptor));
+}
+
+HW_PATH_IAA_API(void, descriptor_set_completion_record, (hw_descriptor *const descriptor_ptr,
+                                                         HW_PATH_VOLATILE hw_completion_record *const completion_record)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    this_ptr->op_code_op_flags      |= ADOF_CR_ADDR_VALID | ADOF_REQ_COMPL;
+    this_ptr->completion_record_ptr  = (uint8_t *) completion_record;
+}
+
+HW_PATH_IAA_API(void, descriptor_init_mem_copy, (hw_descriptor *descriptor_ptr,
+                                                 const uint8_t *source_ptr,
+                                                 uint8_t *destination_ptr,
+                                                 uint32_t size)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    hw_iaa_descriptor_reset(descriptor_ptr);
+
+    this_ptr->op_code_op_flags = ADOF_OPCODE(QPL_OPCODE_MEMMOVE);
+    this_ptr->src1_ptr         = (uint8_t *) source_ptr;
+    this_ptr->dst_ptr          = destination_ptr;
+    this_ptr->src1_size        = size;
+    this_ptr->max_dst_size     = size;
+}
+
+HW_PATH_IAA_API(void, descriptor_init_zero_compress, (hw_descriptor *descriptor_ptr,
+                                                      uint32_t zero_opcode,
+                                                      const uint8_t *source_ptr,
+                                                      uint8_t *destination_ptr,
+                                                      uint32_t input_size,
+                                                      uint32_t output_size)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    hw_iaa_descriptor_reset(descriptor_ptr);
+
+    this_ptr->op_code_op_flags = ADOF_OPCODE(zero_opcode);
+    this_ptr->src1_ptr         = (uint8_t *) source_ptr;
+    this_ptr->dst_ptr          = destination_ptr;
+    this_ptr->src1_size        = input_size;
+    this_ptr->max_dst_size     = output_size;
+}
+
+HW_PATH_IAA_API(void, descriptor_init_batch, (hw_descriptor *descriptor_ptr,
+                                              hw_descriptor *descriptor_list_ptr,
+                                              uint32_t descriptor_count)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    hw_iaa_descriptor_reset(descriptor_ptr);
+
+    // Batch descriptor reuses `source-1` address and size fields as descriptor list address and count
+    this_ptr->op_code_op_flags = ADOF_OPCODE(QPL_OPCODE_BATCH);
+    this_ptr->src1_ptr         = (uint8_t *) descriptor_list_ptr;
+    this_ptr->src1_size        = descriptor_count;
+}
+
+HW_PATH_IAA_API(void, descriptor_init_crc64, (hw_descriptor *descriptor_ptr,
+                                              const uint8_t *source_ptr,
+                                              uint32_t size,
+                                              uint64_t polynomial,
+                                              bool is_be_bit_order,
+                                              bool is_inverse)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    hw_iaa_descriptor_reset(descriptor_ptr);
+
+    // Polynomial takes the place of the filter flags and the number of elements
+    this_ptr->op_code_op_flags   = ADOF_OPCODE(QPL_OPCODE_CRC64);
+    this_ptr->src1_ptr           = (uint8_t *) source_ptr;
+    this_ptr->src1_size          = size;
+    this_ptr->decomp_flags       = (uint16_t) ((is_be_bit_order ? ADC64F_MSB_FIRST : 0u)
+                                               | (is_inverse ? ADC64F_INVERT_CRC : 0u));
+    this_ptr->filter_flags       = (uint32_t) polynomial;
+    this_ptr->num_input_elements = (uint32_t) (polynomial >> 32u);
+}
+
+/**
+ * @brief Points `source-2` at the AECS and sets read/write flags according to the access policy
+ */
+static inline void own_set_aecs(hw_iaa_analytics_descriptor *const this_ptr,
+                                hw_iaa_aecs *const aecs_ptr,
+                                const uint32_t aecs_size,
+                                const hw_iaa_aecs_access_policy access_policy) {
+    const uint32_t policy = (uint32_t) access_policy;
+
+    this_ptr->op_code_op_flags |= ((policy & hw_aecs_access_read) ? ADOF_READ_SRC2(1u) : 0u)
+                                  | ((policy & hw_aecs_access_write) ? ADOF_WRITE_SRC2(1u) : 0u)
+                                  | ((policy & hw_aecs_access_maybe_write) ? ADOF_WRITE_SRC2(2u) : 0u)
+                                  | ((policy & hw_aecs_toggle_rw) ? ADOF_AECS_SEL : 0u);
+    this_ptr->src2_ptr          = (uint8_t *) aecs_ptr;
+    this_ptr->src2_size         = aecs_size;
+}
+
+HW_PATH_IAA_API(void, descriptor_init_compress_body, (hw_descriptor *const descriptor_ptr)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    hw_iaa_descriptor_reset(descriptor_ptr);
+
+    this_ptr->op_code_op_flags = ADOF_OPCODE(QPL_OPCODE_COMPRESS);
+    this_ptr->decomp_flags     = ADCF_FLUSH_OUTPUT;
+}
+
+HW_PATH_IAA_API(void, descriptor_init_statistic_collector, (hw_descriptor *const descriptor_ptr,
+                                                            const uint8_t *const source_ptr,
+                                                            const uint32_t source_size,
+                                                            hw_iaa_aecs_compress *const aecs_ptr)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    hw_iaa_descriptor_reset(descriptor_ptr);
+
+    this_ptr->op_code_op_flags = ADOF_OPCODE(QPL_OPCODE_COMPRESS);
+    this_ptr->decomp_flags     = ADCF_STATS_MODE;
+
+    hw_iaa_descriptor_set_input_buffer(descriptor_ptr, (uint8_t *) source_ptr, source_size);
+
+    // Device writes the whole AECS back, the histogram at its place in it
+    own_set_aecs(this_ptr, aecs_ptr, HW_AECS_COMPRESSION_SIZE, hw_aecs_access_write);
+}
+
+HW_PATH_IAA_API(void, descriptor_init_deflate_body, (hw_descriptor *const descriptor_ptr,
+                                                     uint8_t *const source_ptr,
+                                                     const uint32_t source_size,
+                                                     uint8_t *const destination_ptr,
+                                                     const uint32_t destination_size)) {
+    hw_iaa_descriptor_set_input_buffer(descriptor_ptr, source_ptr, source_size);
+    hw_iaa_descriptor_set_output_buffer(descriptor_ptr, destination_ptr, destination_size);
+}
+
+HW_PATH_IAA_API(void, descriptor_compress_set_aecs, (hw_descriptor *const descriptor_ptr,
+                                                     hw_iaa_aecs *const aecs_ptr,
+                                                     const hw_iaa_aecs_access_policy access_policy)) {
+    own_set_aecs((hw_iaa_analytics_descriptor *) descriptor_ptr, aecs_ptr, HW_AECS_COMPRESSION_SIZE, access_policy);
+}
+
+HW_PATH_IAA_API(void, descriptor_init_inflate, (hw_descriptor *const descriptor_ptr,
+                                                hw_iaa_aecs *const aecs_ptr,
+                                                const uint32_t aecs_size,
+                                                const hw_iaa_aecs_access_policy access_policy)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    hw_iaa_descriptor_reset(descriptor_ptr);
+
+    this_ptr->op_code_op_flags = ADOF_OPCODE(QPL_OPCODE_DECOMPRESS);
+    this_ptr->decomp_flags     = ADDF_ENABLE_DECOMPRESS | ADDF_FLUSH_OUTPUT;
+
+    // Stream that starts at a block boundary needs no state
+    if (NULL != aecs_ptr) {
+        own_set_aecs(this_ptr, aecs_ptr, aecs_size, access_policy);
+    }
+}
+
+HW_PATH_IAA_API(void, descriptor_init_inflate_header, (hw_descriptor *const descriptor_ptr,
+                                                       hw_iaa_aecs *const aecs_ptr,
+                                                       const uint8_t ignore_end_bits,
+                                                       const hw_iaa_aecs_access_policy access_policy)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    // Source ends right after the block header, so the device stops with the Huffman tables parsed into the AECS
+    hw_iaa_descriptor_init_inflate(descriptor_ptr, aecs_ptr, HW_AECS_ANALYTIC_RANDOM_ACCESS_SIZE, access_policy);
+
+    this_ptr->decomp_flags |= (uint16_t) ADDF_IGNORE_END_BITS(ignore_end_bits);
+}
+
+HW_PATH_IAA_API(void, descriptor_init_inflate_body, (hw_descriptor *const descriptor_ptr,
+                                                     hw_iaa_aecs *const aecs_ptr,
+                                                     const uint8_t ignore_end_bit)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    // Body continues from the tables and input accumulator kept in the AECS, the history is not read
+    hw_iaa_descriptor_init_inflate(descriptor_ptr, aecs_ptr, HW_AECS_ANALYTIC_RANDOM_ACCESS_SIZE, hw_aecs_access_read);
+
+    this_ptr->decomp_flags |= (uint16_t) ADDF_IGNORE_END_BITS(ignore_end_bit);
+}
+
+HW_PATH_IAA_API(void, descriptor_init_compress_verification, (hw_descriptor *descriptor_ptr)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    hw_iaa_descriptor_reset(descriptor_ptr);
+
+    // Stream is decoded without writing the data, the destination receives the index table instead
+    this_ptr->op_code_op_flags = ADOF_OPCODE(QPL_OPCODE_DECOMPRESS);
+    this_ptr->decomp_flags     = ADDF_ENABLE_DECOMPRESS | ADDF_FLUSH_OUTPUT | ADDF_SUPPRESS_OUTPUT;
+
+    hw_iaa_descriptor_set_inflate_stop_check_rule(descriptor_ptr, stop_and_check_for_bfinal_eob, false);
+}
+
+HW_PATH_IAA_API(void, descriptor_compress_verification_write_initial_index, (hw_descriptor *const descriptor_ptr,
+                                                                             hw_iaa_aecs_analytic *const aecs_analytic_ptr,
+                                                                             uint32_t crc,
+                                                                             uint32_t bit_offset)) {
+    aecs_analytic_ptr->filtering_options.crc          = crc;
+    aecs_analytic_ptr->inflate_options.idx_bit_offset = bit_offset;
+
+    own_set_aecs((hw_iaa_analytics_descriptor *) descriptor_ptr,
+                 aecs_analytic_ptr,
+                 HW_AECS_ANALYTIC_RANDOM_ACCESS_SIZE,
+                 hw_aecs_access_read);
+}
+
+HW_PATH_IAA_API(void, descriptor_inflate_set_aecs, (hw_descriptor *const descriptor_ptr,
+                                                    hw_iaa_aecs *const aecs_ptr,
+                                                    const uint32_t aecs_size,
+                                                    const hw_iaa_aecs_access_policy access_policy)) {
+    own_set_aecs((hw_iaa_analytics_descriptor *) descriptor_ptr, aecs_ptr, aecs_size, access_policy);
+}
+
+HW_PATH_IAA_API(void, descriptor_set_inflate_stop_check_rule, (hw_descriptor *const descriptor_ptr,
+                                                               hw_iaa_decompress_start_stop_rule_t rules,
+                                                               bool check_for_eob)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    static const uint16_t rule_flags[] = {
+            ADDF_STOP_ON_EOB | ADDF_CHECK_FOR_EOB | ADDF_SELECT_BFINAL_EOB,    // stop_and_check_for_bfinal_eob
+            0u,                                                               // dont_stop_or_check
+            ADDF_STOP_ON_EOB | ADDF_CHECK_FOR_EOB,                            // stop_and_check_for_any_eob
+            ADDF_STOP_ON_EOB,                                                 // stop_on_any_eob
+            ADDF_STOP_ON_EOB | ADDF_SELECT_BFINAL_EOB,                        // stop_on_bfinal_eob
+            ADDF_CHECK_FOR_EOB,                                               // check_for_any_eob
+            ADDF_CHECK_FOR_EOB | ADDF_SELECT_BFINAL_EOB                       // check_for_bfinal_eob
+    };
+
+    const uint16_t rule_mask = ADDF_STOP_ON_EOB | ADDF_CHECK_FOR_EOB | ADDF_SELECT_BFINAL_EOB;
+    uint16_t       flags     = ((uint32_t) rules < sizeof(rule_flags) / sizeof(rule_flags[0])) ? rule_flags[rules] : 0u;
+
+    if (check_for_eob) {
+        flags |= ADDF_CHECK_FOR_EOB;
+    }
+
+    this_ptr->decomp_flags = (uint16_t) ((this_ptr->decomp_flags & ~rule_mask) | flags);
+}
+
+static inline void own_analytic_set_opcode(hw_iaa_analytics_descriptor *const this_ptr, const uint32_t opcode) {
+    this_ptr->op_code_op_flags = ADOF_OPCODE(opcode) | (this_ptr->op_code_op_flags & ~ADOF_OPCODE(0xFFu));
+}
+
+static inline void own_analytic_set_aecs(hw_iaa_analytics_descriptor *const this_ptr,
+                                         hw_iaa_aecs_analytic *const aecs_ptr) {
+    this_ptr->op_code_op_flags |= ADOF_READ_SRC2(1u);
+    this_ptr->src2_ptr          = (uint8_t *) aecs_ptr;
+    this_ptr->src2_size         = HW_AECS_ANALYTIC_FILTER_ONLY_SIZE;
+}
+
+static inline void own_analytic_set_source2(hw_iaa_analytics_descriptor *const this_ptr,
+                                            uint8_t *const source_ptr,
+                                            const uint32_t source_size,
+                                            const uint32_t bit_width,
+                                            const bool is_big_endian) {
+    this_ptr->op_code_op_flags |= ADOF_READ_SRC2(2u);
+    this_ptr->src2_ptr          = source_ptr;
+    this_ptr->src2_size         = source_size;
+    this_ptr->filter_flags     |= ADFF_SRC2_WIDTH(bit_width) | (is_big_endian ? ADFF_SRC2_BE : 0u);
+}
+
+HW_PATH_IAA_API(void, descriptor_analytic_set_filter_input, (hw_descriptor *const descriptor_ptr,
+                                                             uint8_t *const source_ptr,
+                                                             const uint32_t source_size,
+                                                             const uint32_t elements_count,
+                                                             const hw_iaa_input_format input_format,
+                                                             const uint32_t input_bit_width)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    this_ptr->src1_ptr           = source_ptr;
+    this_ptr->src1_size          = source_size;
+    this_ptr->num_input_elements = elements_count;
+
+    // PRLE stream carries its own bit-width in the first byte
+    this_ptr->filter_flags |= ADFF_SRC1_PARSER(input_format)
+                              | ((hw_iaa_input_format_prle == input_format) ? 0u : ADFF_SRC1_WIDTH(input_bit_width));
+}
+
+HW_PATH_IAA_API(void, descriptor_analytic_set_filter_output, (hw_descriptor *const descriptor_ptr,
+                                                              uint8_t *const output_ptr,
+                                                              const uint32_t output_size,
+                                                              const hw_iaa_output_format output_format)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    this_ptr->dst_ptr       = output_ptr;
+    this_ptr->max_dst_size  = output_size;
+
+    // Output modifiers of hw_iaa_output_format match the filter flags bits
+    this_ptr->filter_flags |= ADFF_OUTPUT_WIDTH(output_format)
+                              | ((uint32_t) output_format & (ADFF_OUTPUT_BE | ADFF_INVERT_OUTPUT));
+}
+
+HW_PATH_IAA_API(void, descriptor_analytic_set_scan_operation, (hw_descriptor *const descriptor_ptr,
+                                                               const uint32_t low_border,
+                                                               const uint32_t high_border,
+                                                               hw_iaa_aecs_analytic *const filter_config_ptr)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    filter_config_ptr->filtering_options.filter_low  = low_border;
+    filter_config_ptr->filtering_options.filter_high = high_border;
+
+    own_analytic_set_opcode(this_ptr, QPL_OPCODE_SCAN);
+    own_analytic_set_aecs(this_ptr, filter_config_ptr);
+}
+
+HW_PATH_IAA_API(void, descriptor_analytic_set_extract_operation, (hw_descriptor *const descriptor_ptr,
+                                                                  const uint32_t first_element_index,
+                                                                  const uint32_t last_element_index,
+                                                                  hw_iaa_aecs_analytic *const filter_config_ptr)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    filter_config_ptr->filtering_options.filter_low  = first_element_index;
+    filter_config_ptr->filtering_options.filter_high = last_element_index;
+
+    own_analytic_set_opcode(this_ptr, QPL_OPCODE_EXTRACT);
+    own_analytic_set_aecs(this_ptr, filter_config_ptr);
+}
+
+HW_PATH_IAA_API(void, descriptor_analytic_set_find_unique_operation, (hw_descriptor *const descriptor_ptr,
+                                                                      const uint32_t drop_low_bits,
+                                                                      const uint32_t drop_high_bits,
+                                                                      hw_iaa_aecs_analytic *const filter_config_ptr)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    this_ptr->filter_flags |= ADFF_DROP_LOW_BITS(drop_low_bits) | ADFF_DROP_HIGH_BITS(drop_high_bits);
+
+    own_analytic_set_opcode(this_ptr, QPL_OPCODE_FIND_UNIQUE);
+    own_analytic_set_aecs(this_ptr, filter_config_ptr);
+}
+
+HW_PATH_IAA_API(void, descriptor_analytic_set_select_operation, (hw_descriptor *const descriptor_ptr,
+                                                                 uint8_t *const mask_ptr,
+                                                                 const uint32_t mask_size,
+                                                                 const bool is_mask_big_endian)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    own_analytic_set_opcode(this_ptr, QPL_OPCODE_SELECT);
+    own_analytic_set_source2(this_ptr, mask_ptr, mask_size, 1u, is_mask_big_endian);
+}
+
+HW_PATH_IAA_API(void, descriptor_analytic_set_expand_operation, (hw_descriptor *const descriptor_ptr,
+                                                                 uint8_t *const mask_ptr,
+                                                                 const uint32_t mask_size,
+                                                                 const bool is_mask_big_endian)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    own_analytic_set_opcode(this_ptr, QPL_OPCODE_EXPAND);
+    own_analytic_set_source2(this_ptr, mask_ptr, mask_size, 1u, is_mask_big_endian);
+}
+
+HW_PATH_IAA_API(void, descriptor_analytic_set_membership_operation, (hw_descriptor *const descriptor_ptr,
+                                                                     const uint32_t drop_source_low_bits,
+                                                                     const uint32_t drop_source_high_bits,
+                                                                     uint8_t *const set_ptr,
+                                                                     const uint32_t set_byte_size,
+                                                                     const bool is_set_big_endian)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    this_ptr->filter_flags |= ADFF_DROP_LOW_BITS(drop_source_low_bits) | ADFF_DROP_HIGH_BITS(drop_source_high_bits);
+
+    own_analytic_set_opcode(this_ptr, QPL_OPCODE_SET_MEMBERSHIP);
+    own_analytic_set_source2(this_ptr, set_ptr, set_byte_size, 1u, is_set_big_endian);
+}
+
+HW_PATH_IAA_API(void, descriptor_analytic_set_rle_burst_operation, (hw_descriptor *const descriptor_ptr,
+                                                                    uint8_t *const element_array_ptr,
+                                                                    const uint32_t element_array_size,
+                                                                    const uint32_t element_bit_width,
+                                                                    const bool is_set_big_endian)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    own_analytic_set_opcode(this_ptr, QPL_OPCODE_RLE_BURST);
+    own_analytic_set_source2(this_ptr, element_array_ptr, element_array_size, element_bit_width, is_set_big_endian);
+}
+
+HW_PATH_IAA_API(void, descriptor_analytic_enable_decompress, (hw_descriptor *const descriptor_ptr,
+                                                              bool is_big_endian_compressed_stream,
+                                                              uint32_t ignore_last_bits)) {
+    hw_iaa_analytics_descriptor *const this_ptr = (hw_iaa_analytics_descriptor *) descriptor_ptr;
+
+    this_ptr->decomp_flags |= (uint16_t) (ADDF_ENABLE_DECOMPRESS
+                                          | (is_big_endian_compressed_stream ? ADDF_DECOMPRESS_BE : 0u)
+                                          | ADDF_IGNORE_END_BITS(ignore_last_bits));
+}
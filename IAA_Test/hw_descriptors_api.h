@@ -97,6 +97,19 @@ HW_PATH_IAA_API(void, descriptor_init_zero_compress, (hw_descriptor * descriptor
                                                       uint8_t              *destination_ptr,
                                                       uint32_t             input_size,
                                                       uint32_t             output_size));
+
+/**
+ * @brief Inits @ref hw_descriptor for BATCH operation
+ * @param[in,out] descriptor_ptr        pointer to allocated descriptor to init
+ * @param[in] descriptor_list_ptr       pointer to the 64-byte aligned array of prepared descriptors
+ * @param[in] descriptor_count          number of descriptors in the array
+ *
+ * @note Number of descriptors must be in range [2, max batch size] of the work queue the batch is submitted to
+ * @note Memory pointed with `completion_record_ptr` will be changed after all descriptors of the batch executed
+ */
+HW_PATH_IAA_API(void, descriptor_init_batch, (hw_descriptor *descriptor_ptr,
+                                              hw_descriptor *descriptor_list_ptr,
+                                              uint32_t      descriptor_count));
 /** @} */
 
 
@@ -343,19 +356,19 @@ HW_PATH_IAA_API(void, descriptor_analytic_enable_decompress, (hw_descriptor *con
  */
 
 /**
- * @brief Setup descriptor to collect statistic for `source_ptr` and save one into `histogram_ptr` (creates `compress descriptor`).
+ * @brief Setup descriptor to collect statistic for `source_ptr` and save one into `aecs_ptr->histogram` (creates `compress descriptor`).
  * Statistics can be used to build huffman tree.
  *
  * @param[out] descriptor_ptr  @ref hw_descriptor
  * @param[in] source_ptr       source stream
  * @param[in] source_size      source size
- * @param[in] histogram_ptr    pointer to @ref hw_iaa_histogram to fill
+ * @param[out] aecs_ptr        pointer to @ref hw_iaa_aecs_compress, the device writes all of its HW_AECS_COMPRESSION_SIZE bytes
  *
  */
 HW_PATH_IAA_API(void, descriptor_init_statistic_collector, (hw_descriptor *const descriptor_ptr,
                                                             const uint8_t *const source_ptr,
                                                             const uint32_t source_size,
-                                                            hw_iaa_histogram *const histogram_ptr));
+                                                            hw_iaa_aecs_compress *const aecs_ptr));
 
 /**
  * @brief Setup descriptor to perform `Compress` operation (creates `compress descriptor`)
@@ -446,6 +459,21 @@ HW_PATH_IAA_API(void, descriptor_compress_set_termination_rule, (hw_descriptor *
     *(uint16_t *) (&descriptor_ptr->data[COMPRESSION_FLAG_OFFSET]) |= COMPRESSION_FLAG_BIT_MASK;
 }
 
+/**
+ * @brief Setup `compress descriptor` to keep the bits of the last partial output byte in the output accumulator
+ * of the written AECS, so the next descriptor of the stream continues from them.
+ *
+ * @param[out] descriptor_ptr @ref hw_descriptor previously inited with @ref hw_iaa_descriptor_init_compress_body
+ *
+ */
+static inline
+HW_PATH_IAA_API(void, descriptor_compress_keep_output_accumulator, (hw_descriptor *const descriptor_ptr)) {
+    const uint16_t COMPRESSION_FLAG_BIT_MASK = ADCF_FLUSH_OUTPUT;
+    const uint8_t  COMPRESSION_FLAG_OFFSET   = 38u;
+
+    *(uint16_t *) (&descriptor_ptr->data[COMPRESSION_FLAG_OFFSET]) &= (uint16_t) ~COMPRESSION_FLAG_BIT_MASK;
+}
+
 /**
 
  * @brief Setup AECS to `compress descriptor`
@@ -0,0 +1,502 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include "hw_device.hpp"
+#include "hw_configuration_driver.h"
+#include "algorithm"
+#include "hw_descriptors_api.h"
+
+#define OWN_CONGESTION_SHIFT     3u                                /**< Moving average weight of a new sample is 1/8 */
+#define OWN_CONGESTION_ROUNDING  ((1u << OWN_CONGESTION_SHIFT) - 1u) /**< Lets the average decay down to zero */
+#define OWN_FALLBACK_SHIFT       hw_traffic_class_count            /**< Fallback classes follow the band classes in a route */
+
+static const uint8_t  accelerator_name[]      = "iax";                         /**< Accelerator name */
+static const uint32_t accelerator_name_length = sizeof(accelerator_name) - 2u; /**< Last symbol index */
+
+static inline bool own_search_device_name(const uint8_t *src_ptr,
+                                          const uint32_t name,
+                                          const uint32_t name_size) noexcept {
+    const uint8_t null_terminator = '\0';
+
+    for (size_t symbol_idx = 0u; null_terminator != src_ptr[symbol_idx + name_size]; symbol_idx++) {
+        const auto *candidate_ptr = reinterpret_cast<const uint32_t *>(src_ptr + symbol_idx);
+
+        // Convert the first 3 bytes to lower case and make the 4th 0xff
+        if (name == (*candidate_ptr | CHAR_MSK)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+namespace qpl::ml::dispatcher {
+
+void hw_device::fill_hw_context(hw_accelerator_context *const hw_context_ptr) const noexcept {
+    // Restore device properties
+    hw_context_ptr->device_properties.max_set_size                  = hw_device::get_max_set_size();
+    hw_context_ptr->device_properties.max_decompressed_set_size     = hw_device::get_max_decompressed_set_size();
+    hw_context_ptr->device_properties.indexing_support_enabled      = hw_device::get_indexing_support_enabled();
+    hw_context_ptr->device_properties.decompression_support_enabled = hw_device::get_decompression_support_enabled();
+    hw_context_ptr->device_properties.max_transfer_size             = hw_device::get_max_transfer_size();
+    hw_context_ptr->device_properties.cache_flush_available         = hw_device::get_cache_flush_available();
+    hw_context_ptr->device_properties.cache_write_available         = hw_device::get_cache_write_available();
+    hw_context_ptr->device_properties.overlapping_available         = hw_device::get_overlapping_available();
+    hw_context_ptr->device_properties.block_on_fault_enabled        = hw_device::get_block_on_fault_available();
+}
+
+/**
+ * @brief Returns the amount of source data the descriptor moves, batches are treated as bulk transfers
+ *
+ * @param size_limit smallest transfer size limit of the queues, a batch is weighed within it so that the queue
+ *                   policy keeps every queue as a candidate
+ */
+static inline auto own_get_transfer_size(const void *desc_ptr, const uint64_t size_limit) noexcept -> uint64_t {
+    const auto *iaa_desc_ptr = reinterpret_cast<const hw_iaa_analytics_descriptor *>(desc_ptr);
+
+    if (QPL_OPCODE_BATCH != ADOF_GET_OPCODE(iaa_desc_ptr->op_code_op_flags)) {
+        return iaa_desc_ptr->src1_size;
+    }
+
+    // Batch keeps its descriptor list and count in `source-1`
+    const auto *list_ptr     = reinterpret_cast<const hw_iaa_analytics_descriptor *>(iaa_desc_ptr->src1_ptr);
+    uint64_t   transfer_size = 0u;
+
+    for (uint32_t desc_idx = 0u; desc_idx < iaa_desc_ptr->src1_size; desc_idx++) {
+        transfer_size += list_ptr[desc_idx].src1_size;
+    }
+
+    return std::min(std::max(transfer_size, hw_small_transfer_size + 1u), size_limit);
+}
+
+auto hw_device::enqueue_descriptor(void *desc_ptr,
+                                   const hw_queue **queue_pptr,
+                                   hw_traffic_class_t traffic_class) const noexcept -> bool {
+    // Cursors are kept per device, so submissions to one device don't skew the rotation on another
+    static thread_local std::array<uint32_t, MAX_NUM_DEV> wq_cursors = {};
+
+    std::array<uint32_t, max_working_queues> queue_order;
+    std::array<uint8_t, max_working_queues>  routes;
+    auto &cursor = wq_cursors[device_idx_];
+
+    // Tracked jobs of a thread owning a dedicated queue go there first, the credit comes back on completion
+    if (has_dedicated_queues_ && nullptr != queue_pptr) {
+        for (uint32_t queue_idx = 0u; queue_idx < queue_count_; ++queue_idx) {
+            const auto &queue = working_queues_[queue_idx];
+
+            if (!queue.is_owned_by_caller()) {
+                continue;
+            }
+
+            hw_iaa_descriptor_set_block_on_fault((hw_descriptor *) desc_ptr, queue.get_block_on_fault());
+
+            if (!queue.enqueue_descriptor(desc_ptr)) {
+                queue.increment_in_flight();
+                *queue_pptr = &queue;
+
+                hw_device::update_congestion(false);
+                return false;
+            }
+        }
+    }
+
+    const hw_queue_policy_t queue_policy = hw_device::load_routes(routes.data());
+
+    const uint32_t order_count = queue_policy(working_queues_.data(), queue_count_,
+                                              own_get_transfer_size(desc_ptr, transfer_size_limit_), cursor, queue_order.data());
+    cursor = (cursor + 1u) % queue_count_;
+
+    const uint32_t class_bit = hw_traffic_class_bit(traffic_class);
+
+    // The band of the class is tried in the policy order first, then the fallback bands in the same order
+    for (uint32_t order_idx = 0u; order_idx < 2u * order_count; ++order_idx) {
+        const uint32_t queue_idx  = queue_order[order_idx % order_count];
+        const uint32_t route_mask = (order_idx < order_count) ? class_bit : class_bit << OWN_FALLBACK_SHIFT;
+        const auto     &queue     = working_queues_[queue_idx];
+
+        if (0u == (routes[queue_idx] & route_mask)) {
+            continue;
+        }
+
+        if (queue.is_dedicated()) {
+            if (hw_device::enqueue_unowned(queue, desc_ptr, queue_pptr)) {
+                continue;
+            }
+
+            hw_device::update_congestion(false);
+            return false;
+        }
+
+        hw_iaa_descriptor_set_block_on_fault((hw_descriptor *) desc_ptr, queue.get_block_on_fault());
+
+        if (!queue.enqueue_descriptor(desc_ptr)) {
+            // Occupancy is tracked only for submissions whose completion will be reported back
+            if (nullptr != queue_pptr) {
+                queue.increment_in_flight();
+                *queue_pptr = &queue;
+            }
+
+            hw_device::update_congestion(false);
+            return false;
+        }
+    }
+
+    hw_device::update_congestion(true);
+    return true;
+}
+
+auto hw_device::enqueue_unowned(const hw_queue &queue, void *desc_ptr, const hw_queue **queue_pptr) const noexcept -> bool {
+    // An untracked job would never give its credit back, and the queue of the caller was tried already
+    if (nullptr == queue_pptr || queue.is_owned_by_caller()) {
+        return true;
+    }
+
+    // Ownership is held only while the credit is checked, the descriptor written and the credit taken,
+    // a queue that another thread owns or is submitting to at the moment is skipped
+    if (!queue.acquire()) {
+        return true;
+    }
+
+    hw_iaa_descriptor_set_block_on_fault((hw_descriptor *) desc_ptr, queue.get_block_on_fault());
+
+    const bool is_rejected = QPL_STS_OK != queue.enqueue_descriptor(desc_ptr);
+
+    if (!is_rejected) {
+        queue.increment_in_flight();
+        *queue_pptr = &queue;
+    }
+
+    queue.release();
+
+    return is_rejected;
+}
+
+void hw_device::update_congestion(bool is_rejected) const noexcept {
+    // Racing updates may lose a sample, which is acceptable for a moving average
+    const uint32_t congestion = congestion_.load(std::memory_order_relaxed);
+
+    if (is_rejected) {
+        congestion_.store(congestion + ((hw_queue::occupancy_full - congestion) >> OWN_CONGESTION_SHIFT),
+                          std::memory_order_relaxed);
+    } else if (0u != congestion) {
+        congestion_.store(congestion - ((congestion + OWN_CONGESTION_ROUNDING) >> OWN_CONGESTION_SHIFT),
+                          std::memory_order_relaxed);
+    }
+}
+
+auto hw_device::get_congestion() const noexcept -> uint32_t {
+    return congestion_.load(std::memory_order_relaxed);
+}
+
+void hw_device::get_stats(hw_queue_stats_t &stats) const noexcept {
+    hw_queue_stats_t queue_stats;
+
+    stats = {};
+
+    for (uint32_t queue_idx = 0u; queue_idx < queue_count_; queue_idx++) {
+        working_queues_[queue_idx].get_stats(queue_stats);
+        stats.merge(queue_stats);
+    }
+}
+
+void hw_device::set_traffic_config(const hw_traffic_config_t &config) noexcept {
+    std::array<uint8_t, max_working_queues> in_bands = {};
+    std::array<uint8_t, max_working_queues> reserved = {};
+    std::array<uint8_t, max_working_queues> routes   = {};
+
+    for (uint32_t queue_idx = 0u; queue_idx < queue_count_; queue_idx++) {
+        const int32_t priority = working_queues_[queue_idx].priority();
+
+        for (uint32_t class_idx = 0u; class_idx < hw_traffic_class_count; class_idx++) {
+            const auto &band = config.bands[class_idx];
+
+            if (band.min_priority <= priority && priority <= band.max_priority) {
+                in_bands[queue_idx] |= 1u << class_idx;
+                reserved[queue_idx] |= band.is_reserved ? 1u << class_idx : 0u;
+            }
+        }
+    }
+
+    for (uint32_t class_idx = 0u; class_idx < hw_traffic_class_count; class_idx++) {
+        const uint8_t class_bit  = 1u << class_idx;
+        bool          is_matched = false;
+
+        for (uint32_t queue_idx = 0u; queue_idx < queue_count_; queue_idx++) {
+            is_matched |= 0u != (in_bands[queue_idx] & class_bit);
+        }
+
+        for (uint32_t queue_idx = 0u; queue_idx < queue_count_; queue_idx++) {
+            const bool is_usable   = 0u == (reserved[queue_idx] & ~class_bit);
+            const bool is_in_band  = !is_matched || 0u != (in_bands[queue_idx] & class_bit);
+            const bool is_fallback = 0u != (in_bands[queue_idx] & config.bands[class_idx].fallback_mask);
+
+            routes[queue_idx] |= (is_usable && is_in_band) ? class_bit : 0u;
+            routes[queue_idx] |= (is_usable && !is_in_band && is_fallback) ? class_bit << OWN_FALLBACK_SHIFT : 0u;
+        }
+    }
+
+    hw_device::begin_routes_update();
+
+    for (uint32_t queue_idx = 0u; queue_idx < queue_count_; queue_idx++) {
+        routes_[queue_idx].store(routes[queue_idx], std::memory_order_relaxed);
+    }
+
+    hw_device::end_routes_update();
+}
+
+void hw_device::set_queue_policy(hw_queue_policy_t queue_policy) noexcept {
+    hw_device::begin_routes_update();
+
+    queue_policy_.store((nullptr != queue_policy) ? queue_policy : hw_adaptive_queue_policy, std::memory_order_relaxed);
+
+    hw_device::end_routes_update();
+}
+
+auto hw_device::load_routes(uint8_t *routes_ptr) const noexcept -> hw_queue_policy_t {
+    hw_queue_policy_t queue_policy = nullptr;
+    uint32_t          generation   = 0u;
+
+    // Copies taken while a writer holds an odd generation, or that it moved past, are taken again
+    do {
+        generation = routes_generation_.load(std::memory_order_acquire);
+
+        if (0u != (generation & 1u)) {
+            continue;
+        }
+
+        queue_policy = queue_policy_.load(std::memory_order_relaxed);
+
+        for (uint32_t queue_idx = 0u; queue_idx < queue_count_; queue_idx++) {
+            routes_ptr[queue_idx] = routes_[queue_idx].load(std::memory_order_relaxed);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (0u != (generation & 1u) || generation != routes_generation_.load(std::memory_order_relaxed));
+
+    return queue_policy;
+}
+
+void hw_device::begin_routes_update() noexcept {
+    uint32_t generation = routes_generation_.load(std::memory_order_relaxed);
+
+    // An odd generation belongs to another writer, the update waits until it is even again
+    while (0u != (generation & 1u)
+           || !routes_generation_.compare_exchange_weak(generation, generation + 1u, std::memory_order_relaxed)) {
+        generation = routes_generation_.load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void hw_device::end_routes_update() noexcept {
+    routes_generation_.fetch_add(1u, std::memory_order_release);
+}
+
+auto hw_device::get_max_set_size() const noexcept -> uint32_t {
+    return GC_MAX_SET_SIZE(gen_cap_register_);
+}
+
+auto hw_device::get_max_decompressed_set_size() const noexcept -> uint32_t {
+    return GC_MAX_DECOMP_SET_SIZE(gen_cap_register_);
+}
+
+auto hw_device::get_indexing_support_enabled() const noexcept -> uint32_t {
+    return GC_IDX_SUPPORT(gen_cap_register_);
+}
+
+auto hw_device::get_decompression_support_enabled() const noexcept -> bool {
+    return GC_DECOMP_SUPPORT(gen_cap_register_);
+}
+
+auto hw_device::get_max_transfer_size() const noexcept -> uint32_t {
+    return GC_MAX_TRANSFER_SIZE(gen_cap_register_);
+}
+
+auto hw_device::get_cache_flush_available() const noexcept -> bool {
+    return GC_CACHE_FLUSH(gen_cap_register_);
+}
+
+auto hw_device::get_cache_write_available() const noexcept -> bool {
+    return GC_CACHE_WRITE(gen_cap_register_);
+}
+
+auto hw_device::get_overlapping_available() const noexcept -> bool {
+    return GC_OVERLAPPING(gen_cap_register_);
+}
+
+auto hw_device::get_block_on_fault_available() const noexcept -> bool {
+    return GC_BLOCK_ON_FAULT(gen_cap_register_);
+}
+
+auto hw_device::get_max_batch_size() const noexcept -> uint32_t {
+    return max_batch_size_;
+}
+
+auto hw_device::initialize_new_device(descriptor_t *device_descriptor_ptr,
+                                      uint32_t device_idx) noexcept -> hw_accelerator_status {
+    // Device initialization stage
+    auto       *device_ptr          = reinterpret_cast<accfg_device *>(device_descriptor_ptr);
+    const auto *name_ptr            = reinterpret_cast<const uint8_t *>(hw_device_get_name(device_ptr));
+    const bool  is_iaa_device       = own_search_device_name(name_ptr, IAA_DEVICE, accelerator_name_length);
+
+    version_major_ = hw_device_get_version(device_ptr)>>8u;
+    version_minor_ = hw_device_get_version(device_ptr)&0xFF;
+
+    DIAG("%5s:", name_ptr);
+    if (!is_iaa_device) {
+        DIAGA(" UNSUPPORTED\n");
+        return HW_ACCELERATOR_WORK_QUEUES_NOT_AVAILABLE;
+    }
+    if (ACCFG_DEVICE_ENABLED != hw_device_get_state(device_ptr)) {
+        DIAGA(" DISABLED\n");
+        return HW_ACCELERATOR_WORK_QUEUES_NOT_AVAILABLE;
+    }
+    DIAGA("\n");
+
+    gen_cap_register_ = hw_device_get_gen_cap_register(device_ptr);
+    numa_node_id_     = hw_device_get_numa_node(device_ptr);
+    device_idx_       = device_idx;
+
+    DIAG("%5s: version: %u.%u numa: %lu\n", name_ptr, version_major_, version_minor_, numa_node_id_);
+    DIAG("%5s: GENCAP: block on fault support:                      %d\n", name_ptr, get_block_on_fault_available());
+    DIAG("%5s: GENCAP: overlapping copy support:                    %d\n", name_ptr, get_overlapping_available());
+    DIAG("%5s: GENCAP: cache control support (memory):              %d\n", name_ptr, get_cache_write_available());
+    DIAG("%5s: GENCAP: cache control support (cache flush):         %d\n", name_ptr, get_cache_flush_available());
+    DIAG("%5s: GENCAP: maximum supported transfer size:             %u\n", name_ptr, get_max_transfer_size());
+    DIAG("%5s: GENCAP: decompression support:                       %d\n", name_ptr, get_decompression_support_enabled());
+    DIAG("%5s: GENCAP: indexing support:                            %u\n", name_ptr, get_indexing_support_enabled());
+    DIAG("%5s: GENCAP: maximum decompression set size:              %u\n", name_ptr, get_max_decompressed_set_size());
+    DIAG("%5s: GENCAP: maximum set size:                            %u\n", name_ptr, get_max_set_size());
+
+    // Working queues initialization stage
+    auto *wq_ptr = hw_get_first_work_queue(device_ptr);
+    auto wq_it   = working_queues_.begin();
+
+    DIAG("%5s: getting device WQs\n", name_ptr);
+    while (nullptr != wq_ptr) {
+        if (HW_ACCELERATOR_STATUS_OK == wq_it->initialize_new_queue(wq_ptr)) {
+            wq_it++;
+
+            std::push_heap(working_queues_.begin(), wq_it,
+                           [](const hw_queue &a, const hw_queue &b) -> bool {
+                               return a.priority() < b.priority();
+                           });
+        }
+
+        wq_ptr = hw_work_queue_get_next(wq_ptr);
+    }
+
+    // Check number of working queues
+    queue_count_ = std::distance(working_queues_.begin(), wq_it);
+
+    if (queue_count_ > 1) {
+        auto begin = working_queues_.begin();
+        auto end   = begin + queue_count_;
+
+        std::sort_heap(begin, end, [](const hw_queue &a, const hw_queue &b) -> bool {
+            return a.priority() < b.priority();
+        });
+    }
+
+    if (queue_count_ == 0) {
+        return HW_ACCELERATOR_WORK_QUEUES_NOT_AVAILABLE;
+    }
+
+    has_dedicated_queues_ = std::any_of(begin(), end(), [](const hw_queue &queue) { return queue.is_dedicated(); });
+    has_shared_queues_    = std::any_of(begin(), end(), [](const hw_queue &queue) { return !queue.is_dedicated(); });
+    transfer_size_limit_  = hw_device::get_transfer_size_limit();
+    hw_device::set_traffic_config(hw_traffic_config_t());
+
+    // Batch descriptor may land on any of the working queues, so the smallest limit is used
+    max_batch_size_ = hw_device_get_max_batch_size(device_ptr);
+
+    for (auto queue_it = begin(); queue_it != end(); queue_it++) {
+        max_batch_size_ = std::min(max_batch_size_, queue_it->get_max_batch_size());
+    }
+
+    DIAG("%5s: max batch size: %u\n", name_ptr, max_batch_size_);
+
+    return HW_ACCELERATOR_STATUS_OK;
+}
+
+auto hw_device::initialize_from_record(const hw_device_record_t &record,
+                                       const hw_queue_record_t *queues_ptr,
+                                       uint32_t device_idx) noexcept -> hw_accelerator_status {
+    gen_cap_register_ = record.gen_cap_register;
+    numa_node_id_     = record.numa_node_id;
+    version_major_    = record.version_major;
+    version_minor_    = record.version_minor;
+    max_batch_size_   = record.max_batch_size;
+    device_idx_       = device_idx;
+
+    // Records were stored in the priority order, a queue that became inaccessible is skipped
+    auto wq_it = working_queues_.begin();
+
+    for (uint32_t record_idx = 0u; record_idx < record.queue_count && working_queues_.end() != wq_it; record_idx++) {
+        if (HW_ACCELERATOR_STATUS_OK == wq_it->initialize_from_record(queues_ptr[record_idx])) {
+            wq_it++;
+        }
+    }
+
+    queue_count_          = std::distance(working_queues_.begin(), wq_it);
+    has_dedicated_queues_ = std::any_of(begin(), end(), [](const hw_queue &queue) { return queue.is_dedicated(); });
+    has_shared_queues_    = std::any_of(begin(), end(), [](const hw_queue &queue) { return !queue.is_dedicated(); });
+    transfer_size_limit_  = hw_device::get_transfer_size_limit();
+    hw_device::set_traffic_config(hw_traffic_config_t());
+
+    return (0u != queue_count_) ? HW_ACCELERATOR_STATUS_OK : HW_ACCELERATOR_WORK_QUEUES_NOT_AVAILABLE;
+}
+
+void hw_device::fill_record(hw_device_record_t &record, hw_queue_record_t *queues_ptr) const noexcept {
+    record = {};
+
+    record.gen_cap_register = gen_cap_register_;
+    record.numa_node_id     = numa_node_id_;
+    record.version_major    = version_major_;
+    record.version_minor    = version_minor_;
+    record.max_batch_size   = max_batch_size_;
+    record.queue_count      = queue_count_;
+
+    for (uint32_t queue_idx = 0u; queue_idx < queue_count_; queue_idx++) {
+        working_queues_[queue_idx].fill_record(queues_ptr[queue_idx]);
+    }
+}
+
+auto hw_device::get_transfer_size_limit() const noexcept -> uint64_t {
+    uint64_t size_limit = UINT64_MAX;
+
+    // Queues reporting 0 have no limit of their own
+    for (uint32_t queue_idx = 0u; queue_idx < queue_count_; queue_idx++) {
+        const uint64_t max_transfer_size = working_queues_[queue_idx].get_max_transfer_size();
+
+        if (0u != max_transfer_size) {
+            size_limit = std::min(size_limit, max_transfer_size);
+        }
+    }
+
+    return size_limit;
+}
+
+auto hw_device::has_shared_queues() const noexcept -> bool {
+    return has_shared_queues_;
+}
+
+auto hw_device::size() const noexcept -> size_t {
+    return queue_count_;
+}
+
+auto hw_device::numa_id() const noexcept -> uint64_t {
+    return numa_node_id_;
+}
+
+auto hw_device::begin() const noexcept -> queues_container_t::const_iterator {
+    return working_queues_.cbegin();
+}
+
+auto hw_device::end() const noexcept -> queues_container_t::const_iterator {
+    return working_queues_.cbegin() + queue_count_;
+}
+
+}
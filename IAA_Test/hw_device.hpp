@@ -13,6 +13,8 @@
 
 #include "defs.h"
 #include "hw_queue.hpp"
+#include "hw_queue_policy.hpp"
+#include "hw_topology.hpp"
 #include "hw_devices.h"
 #include "hw_status.h"
 
@@ -20,6 +22,21 @@ namespace qpl::ml::dispatcher {
 
 #if defined( linux )
 
+/**
+ * @brief Accelerator device and its working queues.
+ *
+ * @details Shared and dedicated queues may be mixed. Queues are picked by the queue policy for every
+ * submission. A dedicated queue takes only tracked submissions, whose credit comes back on completion. Jobs of
+ * the thread that owns it, see hw_queue::acquire(), go there before any other queue is tried. A dedicated
+ * queue nobody owns takes tracked jobs of any thread, each one owning it just for the time of its submission.
+ * Untracked jobs go to the shared queues only.
+ *
+ * Every submission carries a traffic class. The queues a class may use are resolved from their priorities
+ * once, when the traffic configuration is set, and kept as a route per queue: the classes having the queue in
+ * their band and the classes using it as a fallback. The routes and the queue policy may change while other
+ * threads submit. A writer makes the routes generation odd for the time of the update, and a submission takes
+ * its copy again if the generation was odd or moved on meanwhile, so it always sees one configuration whole.
+ */
 class hw_device final {
 
     static constexpr uint32_t max_working_queues = MAX_NUM_WQ;
@@ -33,9 +50,38 @@ public:
 
     void fill_hw_context(hw_accelerator_context *hw_context_ptr) const noexcept;
 
-    [[nodiscard]] auto enqueue_descriptor(void *desc_ptr) const noexcept -> bool;
+    [[nodiscard]] auto enqueue_descriptor(void *desc_ptr,
+                                          const hw_queue **queue_pptr = nullptr,
+                                          hw_traffic_class_t traffic_class = hw_traffic_class_t::normal) const noexcept -> bool;
+
+    [[nodiscard]] auto initialize_new_device(descriptor_t *device_descriptor_ptr,
+                                             uint32_t device_idx) noexcept -> hw_accelerator_status;
+
+    [[nodiscard]] auto initialize_from_record(const hw_device_record_t &record,
+                                              const hw_queue_record_t *queues_ptr,
+                                              uint32_t device_idx) noexcept -> hw_accelerator_status;
 
-    [[nodiscard]] auto initialize_new_device(descriptor_t *device_descriptor_ptr) noexcept -> hw_accelerator_status;
+    /**
+     * @brief Fills the device record and one queue record per working queue, see @ref size
+     */
+    void fill_record(hw_device_record_t &record, hw_queue_record_t *queues_ptr) const noexcept;
+
+    /**
+     * @brief Sets the working queue selection policy, safe while other threads submit
+     */
+    void set_queue_policy(hw_queue_policy_t queue_policy) noexcept;
+
+    /**
+     * @brief Maps traffic classes onto the working queues by their priorities, see @ref hw_traffic_config_t
+     *
+     * @note Safe while other threads submit, their jobs follow either the former or the new mapping
+     */
+    void set_traffic_config(const hw_traffic_config_t &config) noexcept;
+
+    /**
+     * @brief Whether untracked submissions have a queue to go to, see @ref enqueue_descriptor
+     */
+    [[nodiscard]] auto has_shared_queues() const noexcept -> bool;
 
     [[nodiscard]] auto size() const noexcept -> size_t;
 
@@ -63,13 +109,61 @@ public:
 
     [[nodiscard]] auto get_block_on_fault_available() const noexcept -> bool;
 
+    [[nodiscard]] auto get_max_batch_size() const noexcept -> uint32_t;
+
+    /**
+     * @brief Share of recently rejected submissions, from 0 to hw_queue::occupancy_full when all were rejected
+     */
+    [[nodiscard]] auto get_congestion() const noexcept -> uint32_t;
+
+    /**
+     * @brief Merges the counters of all working queues of the device
+     */
+    void get_stats(hw_queue_stats_t &stats) const noexcept;
+
 private:
+    /**
+     * @brief Submits a tracked job to a dedicated queue that no thread owns
+     *
+     * @return true if the job is not taken, as @ref enqueue_descriptor
+     */
+    [[nodiscard]] auto enqueue_unowned(const hw_queue &queue,
+                                       void *desc_ptr,
+                                       const hw_queue **queue_pptr) const noexcept -> bool;
+
+    /**
+     * @brief Smallest transfer size limit of the working queues, UINT64_MAX if none has one
+     */
+    [[nodiscard]] auto get_transfer_size_limit() const noexcept -> uint64_t;
+
+    void update_congestion(bool is_rejected) const noexcept;
+
+    /**
+     * @brief Copies the route of every working queue
+     *
+     * @return queue policy of the same configuration
+     */
+    [[nodiscard]] auto load_routes(uint8_t *routes_ptr) const noexcept -> hw_queue_policy_t;
+
+    void begin_routes_update() noexcept;
+
+    void end_routes_update() noexcept;
+
     queues_container_t working_queues_   = {};    /**< Set of available HW working queues */
     uint32_t           queue_count_      = 0u;    /**< Number of working queues that are available */
     uint64_t           gen_cap_register_ = 0u;    /**< GENCAP register content */
     uint64_t           numa_node_id_     = 0u;    /**< NUMA node id of the device */
     uint32_t           version_major_    = 0u;    /**< Major version of discovered device */
     uint32_t           version_minor_    = 0u;    /**< Minor version of discovered device */
+    uint32_t           max_batch_size_   = 0u;    /**< Batch size accepted by every working queue of the device */
+    uint32_t           device_idx_       = 0u;    /**< Index of the device in the dispatcher */
+    bool               has_dedicated_queues_ = false;  /**< Some working queue is dedicated */
+    bool               has_shared_queues_    = false;  /**< Some working queue is shared */
+    uint64_t           transfer_size_limit_  = UINT64_MAX;  /**< See @ref get_transfer_size_limit */
+    std::array<std::atomic<uint8_t>, max_working_queues> routes_ = {};     /**< Band classes, then fallback classes of a queue */
+    std::atomic<hw_queue_policy_t> queue_policy_      = hw_adaptive_queue_policy;  /**< Working queue selection policy */
+    std::atomic<uint32_t>          routes_generation_ = 0u;  /**< Odd while the routes or the policy are updated */
+    mutable std::atomic<uint32_t> congestion_ = 0u; /**< Moving average of rejected submissions, see @ref get_congestion */
 };
 
 #endif
@@ -42,6 +42,7 @@ extern "C" {
                    ((uint32_t)('x') << 16u) | ((uint32_t)('a') << 8u) | (uint32_t)('i')))
 #define MAX_NUM_DEV 100u        /**< @todo */
 #define MAX_NUM_WQ  100u        /**< @todo */
+#define MAX_NUM_NUMA_NODES 64u  /**< Maximal number of NUMA nodes the dispatcher can group devices by */
 #define CHAR_MSK    0xFF202020  /**< @todo */
 
 #define OWN_PAGE_MASK             0x0FFFllu     /**< Defines page mask for portal incrementing */
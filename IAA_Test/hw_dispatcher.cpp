@@ -0,0 +1,417 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <sched.h>
+#include <stdio.h>
+#include <algorithm>
+
+#include "hw_dispatcher.hpp"
+
+#define OWN_LOCAL_NUMA_DISTANCE  10u  /**< ACPI SLIT distance of a node to itself */
+#define OWN_REMOTE_NUMA_DISTANCE 20u  /**< Assumed distance to other nodes if sysfs can't be read */
+
+static const char *numa_distance_path_format = "/sys/devices/system/node/node%u/distance";
+
+/**
+ * @brief Reads one row of the NUMA distance matrix, falls back to the local/remote defaults if it is unavailable
+ */
+static inline bool own_read_numa_distances(const uint32_t node_id,
+                                           uint32_t *const distances_ptr,
+                                           const uint32_t node_count) noexcept {
+    char path[64];
+
+    for (uint32_t node = 0u; node < node_count; node++) {
+        distances_ptr[node] = (node == node_id) ? OWN_LOCAL_NUMA_DISTANCE : OWN_REMOTE_NUMA_DISTANCE;
+    }
+
+    snprintf(path, sizeof(path), numa_distance_path_format, node_id);
+    FILE *file_ptr = fopen(path, "r");
+
+    if (nullptr == file_ptr) {
+        return false;
+    }
+
+    uint32_t distance = 0u;
+    for (uint32_t node = 0u; node < node_count && 1 == fscanf(file_ptr, "%u", &distance); node++) {
+        distances_ptr[node] = distance;
+    }
+
+    fclose(file_ptr);
+
+    return true;
+}
+
+static inline auto own_get_system_numa_node_count(const uint32_t max_numa_nodes) noexcept -> uint32_t {
+    char     path[64];
+    uint32_t node_count = 0u;
+
+    for (uint32_t node = 0u; node < max_numa_nodes; node++) {
+        snprintf(path, sizeof(path), numa_distance_path_format, node);
+        FILE *file_ptr = fopen(path, "r");
+
+        if (nullptr != file_ptr) {
+            fclose(file_ptr);
+            node_count = node + 1u;
+        }
+    }
+
+    return node_count;
+}
+
+namespace qpl::ml::dispatcher {
+
+hw_dispatcher::hw_dispatcher() noexcept {
+    hw_init_status_ = hw_dispatcher::initialize_hw();
+}
+
+hw_dispatcher::~hw_dispatcher() noexcept {
+    if (nullptr != hw_context_ptr_) {
+        hw_context_close(hw_context_ptr_);
+        hw_context_ptr_ = nullptr;
+    }
+
+    hw_finalize_accelerator_driver(&hw_driver_);
+}
+
+auto hw_dispatcher::get_instance() noexcept -> hw_dispatcher & {
+    static hw_dispatcher instance{};
+
+    return instance;
+}
+
+auto hw_dispatcher::initialize_hw() noexcept -> hw_accelerator_status {
+    // Emulated devices are not backed by sysfs, so the fingerprint can't validate their snapshot
+    const char     *cache_path_ptr = hw_emulator_is_enabled() ? nullptr : hw_topology_cache::get_path();
+    const uint64_t fingerprint     = (nullptr != cache_path_ptr) ? hw_topology_cache::get_fingerprint() : 0u;
+
+    // Valid snapshot spares loading the configuration driver and walking the devices
+    if (0u != fingerprint && hw_dispatcher::restore_topology(cache_path_ptr, fingerprint)) {
+        DIAG("topology restored from %s\n", cache_path_ptr);
+    } else {
+        auto status = hw_dispatcher::enumerate_devices();
+
+        if (HW_ACCELERATOR_STATUS_OK != status) {
+            return status;
+        }
+
+        if (0u != fingerprint && 0u != device_count_) {
+            hw_dispatcher::store_topology(cache_path_ptr, fingerprint);
+        }
+    }
+
+    if (device_count_ <= 0) {
+        return HW_ACCELERATOR_WORK_QUEUES_NOT_AVAILABLE;
+    }
+
+    max_batch_size_    = devices_[0].get_max_batch_size();
+    has_shared_queues_ = devices_[0].has_shared_queues();
+
+    for (uint32_t device_idx = 1u; device_idx < device_count_; device_idx++) {
+        max_batch_size_     = std::min(max_batch_size_, devices_[device_idx].get_max_batch_size());
+        has_shared_queues_ |= devices_[device_idx].has_shared_queues();
+    }
+
+    build_numa_groups();
+
+    return HW_ACCELERATOR_STATUS_OK;
+}
+
+auto hw_dispatcher::enumerate_devices() noexcept -> hw_accelerator_status {
+    auto status = hw_initialize_accelerator_driver(&hw_driver_);
+
+    if (HW_ACCELERATOR_STATUS_OK != status) {
+        return status;
+    }
+
+    if (0 != hw_driver_new_context(&hw_context_ptr_)) {
+        return HW_ACCELERATOR_LIBACCEL_ERROR;
+    }
+
+    // Retrieve first device in the system given the passed in context
+    auto *dev_tmp_ptr = hw_context_get_first_device(hw_context_ptr_);
+    auto device_it    = devices_.begin();
+
+    while (nullptr != dev_tmp_ptr && devices_.end() != device_it) {
+        const auto device_idx = static_cast<uint32_t>(std::distance(devices_.begin(), device_it));
+
+        if (HW_ACCELERATOR_STATUS_OK == device_it->initialize_new_device(dev_tmp_ptr, device_idx)) {
+            device_it++;
+        }
+
+        // Retrieve the "next" device in the system based on given device
+        dev_tmp_ptr = hw_device_get_next(dev_tmp_ptr);
+    }
+
+    device_count_ = std::distance(devices_.begin(), device_it);
+
+    return HW_ACCELERATOR_STATUS_OK;
+}
+
+auto hw_dispatcher::restore_topology(const char *path_ptr, uint64_t fingerprint) noexcept -> bool {
+    hw_topology_cache                         cache;
+    hw_device_record_t                        device_record = {};
+    std::array<hw_queue_record_t, MAX_NUM_WQ> queue_records;
+
+    if (!cache.open_read(path_ptr, fingerprint) || cache.device_count() > max_devices) {
+        return false;
+    }
+
+    device_count_ = 0u;
+
+    for (uint32_t record_idx = 0u; record_idx < cache.device_count(); record_idx++) {
+        if (!cache.read_device(device_record, queue_records.data(), queue_records.size())) {
+            device_count_ = 0u;
+            return false;
+        }
+
+        if (HW_ACCELERATOR_STATUS_OK == devices_[device_count_].initialize_from_record(device_record,
+                                                                                       queue_records.data(),
+                                                                                       device_count_)) {
+            device_count_++;
+        }
+    }
+
+    // A device of the snapshot that can't be opened any more means the snapshot is stale, the walk finds what is left
+    if (device_count_ < cache.device_count()) {
+        DIAG("topology snapshot %s: %u of %u device(s) available\n", path_ptr, device_count_, cache.device_count());
+        device_count_ = 0u;
+        return false;
+    }
+
+    return true;
+}
+
+void hw_dispatcher::store_topology(const char *path_ptr, uint64_t fingerprint) const noexcept {
+    hw_topology_cache                         cache;
+    hw_device_record_t                        device_record = {};
+    std::array<hw_queue_record_t, MAX_NUM_WQ> queue_records;
+
+    if (!cache.open_write(path_ptr, fingerprint)) {
+        DIAG("topology snapshot %s can't be created\n", path_ptr);
+        return;
+    }
+
+    for (uint32_t device_idx = 0u; device_idx < device_count_; device_idx++) {
+        devices_[device_idx].fill_record(device_record, queue_records.data());
+
+        if (!cache.write_device(device_record, queue_records.data())) {
+            return;
+        }
+    }
+
+    if (cache.commit()) {
+        DIAG("topology stored to %s\n", path_ptr);
+    }
+}
+
+void hw_dispatcher::build_numa_groups() noexcept {
+    uint32_t node_count = own_get_system_numa_node_count(max_numa_nodes);
+
+    for (uint32_t device_idx = 0u; device_idx < device_count_; device_idx++) {
+        const auto numa_id = devices_[device_idx].numa_id();
+
+        if (numa_id < max_numa_nodes) {
+            node_count = std::max(node_count, static_cast<uint32_t>(numa_id) + 1u);
+        }
+    }
+
+    numa_node_count_ = std::max(node_count, 1u);
+
+    std::array<uint32_t, max_numa_nodes> distances = {};
+    std::array<uint32_t, max_devices>    device_distances = {};
+
+    for (uint32_t node = 0u; node < numa_node_count_; node++) {
+        auto &group = numa_groups_[node];
+
+        own_read_numa_distances(node, distances.data(), numa_node_count_);
+
+        for (uint32_t device_idx = 0u; device_idx < device_count_; device_idx++) {
+            const auto numa_id = devices_[device_idx].numa_id();
+
+            // Devices with unknown affinity are treated as remote for every node
+            device_distances[device_idx] = (numa_id < numa_node_count_)
+                                           ? distances[numa_id]
+                                           : OWN_REMOTE_NUMA_DISTANCE;
+            group.device_order[device_idx] = device_idx;
+        }
+
+        auto begin = group.device_order.begin();
+        auto end   = begin + device_count_;
+
+        std::stable_sort(begin, end, [&device_distances](uint32_t a, uint32_t b) -> bool {
+            return device_distances[a] < device_distances[b];
+        });
+
+        // Devices at the minimal distance are the local set, even if the node itself has no devices
+        const uint32_t nearest_distance = device_distances[group.device_order[0]];
+
+        group.local_count = static_cast<uint32_t>(std::count_if(begin, end, [&](uint32_t device_idx) -> bool {
+            return device_distances[device_idx] == nearest_distance;
+        }));
+
+        DIAG("numa %u: %u local device(s) of %u\n", node, group.local_count, device_count_);
+    }
+}
+
+auto hw_dispatcher::get_current_numa_id() noexcept -> int32_t {
+    uint32_t cpu  = 0u;
+    uint32_t node = 0u;
+
+    if (0 != getcpu(&cpu, &node)) {
+        return 0;
+    }
+
+    return static_cast<int32_t>(node);
+}
+
+auto hw_dispatcher::resolve_numa_id(int32_t numa_id) const noexcept -> uint32_t {
+    if (0 > numa_id) {
+        numa_id = get_current_numa_id();
+    }
+
+    return (static_cast<uint32_t>(numa_id) < numa_node_count_) ? static_cast<uint32_t>(numa_id) : 0u;
+}
+
+auto hw_dispatcher::enqueue_descriptor(void *desc_ptr,
+                                       const hw_accelerator_submit_options &options) const noexcept -> qpl_status {
+    return hw_dispatcher::enqueue_descriptor(desc_ptr, options.numa_id);
+}
+
+auto hw_dispatcher::enqueue_descriptor(void *desc_ptr,
+                                       int32_t numa_id,
+                                       const hw_queue **queue_pptr,
+                                       hw_traffic_class_t traffic_class) const noexcept -> qpl_status {
+    static thread_local uint32_t device_idx = 0u;
+
+    // Dedicated queues take tracked jobs only, an untracked one would be refused forever
+    if (0u == device_count_ || (nullptr == queue_pptr && !has_shared_queues_)) {
+        return QPL_STS_INIT_WORK_QUEUES_NOT_AVAILABLE;
+    }
+
+    const auto &group = numa_groups_[resolve_numa_id(numa_id)];
+
+    // Round-robin over local devices, starting from this thread's cursor
+    for (uint32_t try_count = 0u; try_count < group.local_count; ++try_count) {
+        device_idx = (device_idx + 1u) % group.local_count;
+
+        if (!devices_[group.device_order[device_idx]].enqueue_descriptor(desc_ptr, queue_pptr, traffic_class)) {
+            return QPL_STS_OK;
+        }
+    }
+
+    // All local queues refused the descriptor, spill to remote nodes in order of increasing distance
+    for (uint32_t order_idx = group.local_count; order_idx < device_count_; ++order_idx) {
+        if (!devices_[group.device_order[order_idx]].enqueue_descriptor(desc_ptr, queue_pptr, traffic_class)) {
+            return QPL_STS_OK;
+        }
+    }
+
+    return QPL_STS_QUEUES_ARE_BUSY_ERR;
+}
+
+auto hw_dispatcher::enqueue_batch(hw_descriptor *batch_desc_ptr,
+                                  hw_completion_record *batch_completion_record_ptr,
+                                  hw_descriptor *desc_list_ptr,
+                                  uint32_t desc_count,
+                                  int32_t numa_id,
+                                  const hw_queue **queue_pptr,
+                                  hw_traffic_class_t traffic_class) const noexcept -> qpl_status {
+    // Devices without batch support report max batch size 1 (or 0), caller has to submit descriptors one by one
+    if (max_batch_size_ < 2u) {
+        return QPL_STS_NOT_SUPPORTED_MODE_ERR;
+    }
+
+    if (desc_count < 2u || desc_count > max_batch_size_) {
+        return QPL_STS_SIZE_ERR;
+    }
+
+    hw_iaa_descriptor_init_batch(batch_desc_ptr, desc_list_ptr, desc_count);
+    hw_iaa_descriptor_set_completion_record(batch_desc_ptr, batch_completion_record_ptr);
+    batch_completion_record_ptr->status = 0u;
+
+    return hw_dispatcher::enqueue_descriptor(batch_desc_ptr, numa_id, queue_pptr, traffic_class);
+}
+
+void hw_dispatcher::set_queue_policy(hw_queue_policy_t queue_policy) noexcept {
+    for (uint32_t device_idx = 0u; device_idx < device_count_; device_idx++) {
+        devices_[device_idx].set_queue_policy(queue_policy);
+    }
+}
+
+void hw_dispatcher::set_traffic_config(const hw_traffic_config_t &config) noexcept {
+    for (uint32_t device_idx = 0u; device_idx < device_count_; device_idx++) {
+        devices_[device_idx].set_traffic_config(config);
+    }
+}
+
+auto hw_dispatcher::get_max_batch_size() const noexcept -> uint32_t {
+    return max_batch_size_;
+}
+
+void hw_dispatcher::fill_hw_context(hw_accelerator_context *const hw_context_ptr) noexcept {
+    hw_context_ptr->ctx_ptr = hw_context_ptr_;
+
+    if (0u != device_count_) {
+        devices_[numa_groups_[resolve_numa_id(-1)].device_order[0]].fill_hw_context(hw_context_ptr);
+    }
+}
+
+auto hw_dispatcher::is_hw_support() const noexcept -> bool {
+    return HW_ACCELERATOR_STATUS_OK == hw_init_status_;
+}
+
+auto hw_dispatcher::get_hw_init_status() const noexcept -> hw_accelerator_status {
+    return hw_init_status_;
+}
+
+auto hw_dispatcher::device_count() const noexcept -> size_t {
+    return device_count_;
+}
+
+auto hw_dispatcher::numa_node_count() const noexcept -> size_t {
+    return numa_node_count_;
+}
+
+auto hw_dispatcher::local_device_count(int32_t numa_id) const noexcept -> size_t {
+    return (0u == device_count_) ? 0u : numa_groups_[resolve_numa_id(numa_id)].local_count;
+}
+
+auto hw_dispatcher::get_congestion(int32_t numa_id) const noexcept -> uint32_t {
+    if (0u == device_count_) {
+        return hw_queue::occupancy_full;
+    }
+
+    // The node is as congested as its least congested local device
+    const auto &group     = numa_groups_[resolve_numa_id(numa_id)];
+    uint32_t   congestion = hw_queue::occupancy_full;
+
+    for (uint32_t order_idx = 0u; order_idx < group.local_count; order_idx++) {
+        congestion = std::min(congestion, devices_[group.device_order[order_idx]].get_congestion());
+    }
+
+    return congestion;
+}
+
+void hw_dispatcher::get_stats(hw_queue_stats_t &stats) const noexcept {
+    hw_queue_stats_t device_stats;
+
+    stats = {};
+
+    for (uint32_t device_idx = 0u; device_idx < device_count_; device_idx++) {
+        devices_[device_idx].get_stats(device_stats);
+        stats.merge(device_stats);
+    }
+}
+
+auto hw_dispatcher::begin() const noexcept -> device_container_t::const_iterator {
+    return devices_.cbegin();
+}
+
+auto hw_dispatcher::end() const noexcept -> device_container_t::const_iterator {
+    return devices_.cbegin() + device_count_;
+}
+
+}
@@ -0,0 +1,147 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_DISPATCHER_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_DISPATCHER_HPP_
+
+#include <array>
+
+#include "hw_device.hpp"
+#include "hw_topology.hpp"
+#include "hw_devices.h"
+#include "hw_status.h"
+#include "hw_configuration_driver.h"
+#include "hw_descriptors_api.h"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief Owns the discovered accelerator devices and routes descriptors to them.
+ *
+ * @details Devices are grouped by the NUMA node reported by the configuration driver. A submission is offered to
+ * the devices of the caller's NUMA node first (round-robin per thread), and only when all of their work queues
+ * refuse the descriptor it is offered to the devices of the remaining nodes in the order of increasing NUMA distance.
+ * Inside a device the work queue is chosen by the device queue policy. Callers that pass queue_pptr receive
+ * the queue that accepted the descriptor and must call hw_queue::decrement_in_flight() once it completes.
+ * The traffic class of a submission limits the queues of every device it may land on, so bulk jobs can be
+ * kept off the queues that serve latency sensitive ones.
+ *
+ * The instance is created on the first @ref get_instance call. If a valid @ref hw_topology_cache snapshot exists,
+ * devices are restored from it without loading the configuration driver, otherwise they are enumerated through
+ * the driver and the snapshot is refreshed. In the former case the hardware context is not available.
+ */
+class hw_dispatcher final {
+
+    static constexpr uint32_t max_devices    = MAX_NUM_DEV;
+    static constexpr uint32_t max_numa_nodes = MAX_NUM_NUMA_NODES;
+
+    using device_container_t = std::array<hw_device, max_devices>;
+
+    /**
+     * @brief Device submission order for one NUMA node: nearest devices first, the rest by NUMA distance
+     */
+    struct numa_group_t {
+        uint32_t                          local_count = 0u;    /**< Number of devices with the minimal distance */
+        std::array<uint32_t, max_devices> device_order = {};   /**< Indexes into devices_ sorted by distance */
+    };
+
+public:
+    static auto get_instance() noexcept -> hw_dispatcher &;
+
+    [[nodiscard]] auto is_hw_support() const noexcept -> bool;
+
+    [[nodiscard]] auto get_hw_init_status() const noexcept -> hw_accelerator_status;
+
+    void fill_hw_context(hw_accelerator_context *hw_context_ptr) noexcept;
+
+    [[nodiscard]] auto enqueue_descriptor(void *desc_ptr,
+                                          const hw_accelerator_submit_options &options) const noexcept -> qpl_status;
+
+    [[nodiscard]] auto enqueue_descriptor(void *desc_ptr,
+                                          int32_t numa_id = -1,
+                                          const hw_queue **queue_pptr = nullptr,
+                                          hw_traffic_class_t traffic_class = hw_traffic_class_t::normal) const noexcept -> qpl_status;
+
+    [[nodiscard]] auto enqueue_batch(hw_descriptor *batch_desc_ptr,
+                                     hw_completion_record *batch_completion_record_ptr,
+                                     hw_descriptor *desc_list_ptr,
+                                     uint32_t desc_count,
+                                     int32_t numa_id = -1,
+                                     const hw_queue **queue_pptr = nullptr,
+                                     hw_traffic_class_t traffic_class = hw_traffic_class_t::normal) const noexcept -> qpl_status;
+
+    void set_queue_policy(hw_queue_policy_t queue_policy) noexcept;
+
+    /**
+     * @brief Applies the traffic class mapping to every device, see @ref hw_traffic_config_t
+     *
+     * @note Each device switches at once, while other threads submit, see hw_device::set_traffic_config()
+     */
+    void set_traffic_config(const hw_traffic_config_t &config) noexcept;
+
+    [[nodiscard]] auto get_max_batch_size() const noexcept -> uint32_t;
+
+    [[nodiscard]] auto device_count() const noexcept -> size_t;
+
+    [[nodiscard]] auto numa_node_count() const noexcept -> size_t;
+
+    [[nodiscard]] auto local_device_count(int32_t numa_id) const noexcept -> size_t;
+
+    [[nodiscard]] auto get_congestion(int32_t numa_id = -1) const noexcept -> uint32_t;
+
+    /**
+     * @brief Merges the counters of all devices, per device and per queue views are available through iteration
+     */
+    void get_stats(hw_queue_stats_t &stats) const noexcept;
+
+    [[nodiscard]] auto begin() const noexcept -> device_container_t::const_iterator;
+
+    [[nodiscard]] auto end() const noexcept -> device_container_t::const_iterator;
+
+    [[nodiscard]] static auto get_current_numa_id() noexcept -> int32_t;
+
+    hw_dispatcher(const hw_dispatcher &) = delete;
+
+    auto operator=(const hw_dispatcher &) -> hw_dispatcher & = delete;
+
+protected:
+    hw_dispatcher() noexcept;
+
+    ~hw_dispatcher() noexcept;
+
+    auto initialize_hw() noexcept -> hw_accelerator_status;
+
+    auto enumerate_devices() noexcept -> hw_accelerator_status;
+
+    /**
+     * @brief Initializes the devices from the snapshot, false if it is missing, stale or lists a device that fails
+     */
+    auto restore_topology(const char *path_ptr, uint64_t fingerprint) noexcept -> bool;
+
+    void store_topology(const char *path_ptr, uint64_t fingerprint) const noexcept;
+
+    void build_numa_groups() noexcept;
+
+private:
+    [[nodiscard]] auto resolve_numa_id(int32_t numa_id) const noexcept -> uint32_t;
+
+    device_container_t                        devices_         = {};      /**< Discovered IAA devices */
+    uint32_t                                  device_count_    = 0u;      /**< Number of initialized devices */
+    uint32_t                                  numa_node_count_ = 0u;      /**< Number of NUMA nodes with groups */
+    uint32_t                                  max_batch_size_  = 0u;      /**< Batch size accepted by every device */
+    bool                                      has_shared_queues_ = false; /**< Some device has a shared queue */
+    std::array<numa_group_t, max_numa_nodes>  numa_groups_     = {};      /**< Submission order per NUMA node */
+    hw_driver_t                               hw_driver_       = {};      /**< Loaded configuration driver */
+    accfg_ctx                                 *hw_context_ptr_ = nullptr; /**< Configuration driver context */
+    hw_accelerator_status                     hw_init_status_  = HW_ACCELERATOR_LIBACCEL_NOT_FOUND;
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_DISPATCHER_HPP_
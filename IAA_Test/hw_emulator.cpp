@@ -0,0 +1,545 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <chrono>
+#include <new>
+#include <system_error>
+
+#include "hw_emulator.hpp"
+#include "hw_util.hpp"
+#include "hw_cpu_executor.hpp"
+#include "hw_configuration_driver.h"
+#include "hw_iaa_flags.h"
+
+#define OWN_ENGINE_SPIN_LIMIT     1024u        /**< Empty ring checks with PAUSE before an engine starts to yield */
+#define OWN_ENGINE_YIELD_LIMIT    64u          /**< Yields before an idle engine starts to sleep */
+#define OWN_ENGINE_SLEEP_US       50u          /**< Sleep of an idle engine between ring checks */
+#define OWN_EMULATED_VERSION      0x100u       /**< Reported device version 1.0 */
+#define OWN_EMULATED_PRIORITY     10           /**< Priority of every emulated WQ */
+#define OWN_EMULATED_MAX_TRANSFER (1ull << 31u)
+
+/**
+ * @brief GENCAP of an emulated device: block on fault, overlapping copy, cache control, 2GB transfers,
+ * decompression, indexing and the largest set sizes
+ */
+#define OWN_EMULATED_GEN_CAP      (0xFull | (31ull << 16u) | (1ull << 40u) | (1ull << 41u) \
+                                   | (31ull << 42u) | (31ull << 47u))
+
+static const char *emulated_devices_env = "QPL_EMULATED_DEVICES";
+static const char *emulated_path_prefix = "emulated:";
+
+/**
+ * @brief Objects handed out to the dispatcher as accfg_dev and accfg_wq pointers
+ */
+struct own_emulated_device_t {
+    uint32_t device_idx;
+    char     name[16];
+};
+
+struct own_emulated_queue_t {
+    uint32_t device_idx;
+    uint32_t queue_idx;
+    char     name[16];
+    char     path[64];
+};
+
+static std::vector<own_emulated_device_t> emulated_devices;
+static std::vector<own_emulated_queue_t>  emulated_queues;
+
+static inline auto own_round_up_pow2(uint32_t value) noexcept -> uint32_t {
+    uint32_t result = 2u;
+
+    while (result < value && result < (1u << 30u)) {
+        result <<= 1u;
+    }
+
+    return result;
+}
+
+static inline void own_parse_config(const char *spec_ptr, qpl::ml::dispatcher::hw_emulator_config_t &config) noexcept {
+    char key[32];
+    unsigned long long value = 0u;
+    int consumed = 0;
+
+    while (2 == sscanf(spec_ptr, " %31[^=,]=%llu%n", key, &value, &consumed)) {
+        if (0 == strcmp(key, "devices")) {
+            config.device_count = (uint32_t) value;
+        } else if (0 == strcmp(key, "wqs")) {
+            config.queue_count = (uint32_t) value;
+        } else if (0 == strcmp(key, "dwqs")) {
+            config.dedicated_count = (uint32_t) value;
+        } else if (0 == strcmp(key, "engines")) {
+            config.engine_count = (uint32_t) value;
+        } else if (0 == strcmp(key, "wq_size")) {
+            config.queue_size = (uint32_t) value;
+        } else if (0 == strcmp(key, "numa")) {
+            config.numa_node_count = (uint32_t) value;
+        } else if (0 == strcmp(key, "batch")) {
+            config.max_batch_size = (uint32_t) value;
+        } else if (0 == strcmp(key, "latency_ns")) {
+            config.latency_ns = value;
+        } else if (0 == strcmp(key, "bandwidth_mbps")) {
+            config.bandwidth_mbps = value;
+        }
+
+        spec_ptr += consumed;
+        spec_ptr += (',' == *spec_ptr) ? 1 : 0;
+    }
+
+    config.device_count    = std::min(std::max(config.device_count, 1u), (uint32_t) MAX_NUM_DEV);
+    config.queue_count     = std::min(std::max(config.queue_count, 1u), (uint32_t) MAX_NUM_WQ);
+    config.dedicated_count = std::min(config.dedicated_count, config.queue_count);
+    config.engine_count    = std::max(config.engine_count, 1u);
+    config.queue_size      = own_round_up_pow2(config.queue_size);
+    config.numa_node_count = std::max(config.numa_node_count, 1u);
+}
+
+/**
+ * @brief Completes a descriptor the CPU executor refused the way the device reports an unknown operation
+ */
+static inline void own_complete_unsupported(const hw_iaa_analytics_descriptor *desc_ptr) noexcept {
+    if (0u == (desc_ptr->op_code_op_flags & ADOF_CR_ADDR_VALID) || nullptr == desc_ptr->completion_record_ptr) {
+        return;
+    }
+
+    auto *record_ptr = reinterpret_cast<hw_iaa_completion_record *>(desc_ptr->completion_record_ptr);
+
+    memset(reinterpret_cast<uint8_t *>(record_ptr) + 1u, 0, sizeof(hw_iaa_completion_record) - 1u);
+    __atomic_store_n(&record_ptr->status, AD_STATUS_UNSUPPORTED_OPCODE, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Time the emulated device needs for the descriptor, a batch costs as much as its descriptors
+ */
+static inline auto own_get_service_time_ns(const hw_iaa_analytics_descriptor *desc_ptr,
+                                           const qpl::ml::dispatcher::hw_emulator_config_t &config) noexcept
+                                           -> uint64_t {
+    uint64_t bytes            = desc_ptr->src1_size;
+    uint64_t descriptor_count = 1u;
+
+    if (QPL_OPCODE_BATCH == ADOF_GET_OPCODE(desc_ptr->op_code_op_flags)) {
+        const auto *list_ptr = reinterpret_cast<const hw_iaa_analytics_descriptor *>(desc_ptr->src1_ptr);
+
+        descriptor_count = desc_ptr->src1_size;
+        bytes            = 0u;
+
+        for (uint64_t desc_idx = 0u; desc_idx < descriptor_count; desc_idx++) {
+            bytes += list_ptr[desc_idx].src1_size;
+        }
+    }
+
+    const uint64_t transfer_ns = (0u != config.bandwidth_mbps) ? bytes * 1000u / config.bandwidth_mbps : 0u;
+
+    return config.latency_ns * descriptor_count + transfer_ns;
+}
+
+/**
+ * @brief Emulated configuration driver, signatures match the functions table of hw_configuration_driver.cpp
+ */
+static int own_accfg_new(accfg_ctx **ctx_pptr) {
+    const auto &config = qpl::ml::dispatcher::hw_emulator::get_instance().get_config();
+
+    emulated_devices.clear();
+    emulated_queues.clear();
+
+    for (uint32_t device_idx = 0u; device_idx < config.device_count; device_idx++) {
+        own_emulated_device_t device = {device_idx, {}};
+        snprintf(device.name, sizeof(device.name), "iax%u", 2u * device_idx + 1u);
+        emulated_devices.push_back(device);
+
+        for (uint32_t queue_idx = 0u; queue_idx < config.queue_count; queue_idx++) {
+            own_emulated_queue_t queue = {device_idx, queue_idx, {}, {}};
+            snprintf(queue.name, sizeof(queue.name), "wq%u.%u", 2u * device_idx + 1u, queue_idx);
+            snprintf(queue.path, sizeof(queue.path), "%s%u.%u", emulated_path_prefix, device_idx, queue_idx);
+            emulated_queues.push_back(queue);
+        }
+    }
+
+    *ctx_pptr = reinterpret_cast<accfg_ctx *>(&emulated_devices);
+
+    return 0;
+}
+
+static accfg_ctx *own_accfg_unref(accfg_ctx *) {
+    return nullptr;
+}
+
+static inline auto own_device(accfg_dev *device_ptr) noexcept -> own_emulated_device_t * {
+    return reinterpret_cast<own_emulated_device_t *>(device_ptr);
+}
+
+static inline auto own_queue(accfg_wq *wq_ptr) noexcept -> own_emulated_queue_t * {
+    return reinterpret_cast<own_emulated_queue_t *>(wq_ptr);
+}
+
+static accfg_dev *own_accfg_device_get_first(accfg_ctx *) {
+    return emulated_devices.empty() ? nullptr : reinterpret_cast<accfg_dev *>(&emulated_devices[0]);
+}
+
+static accfg_dev *own_accfg_device_get_next(accfg_dev *device_ptr) {
+    const uint32_t next_idx = own_device(device_ptr)->device_idx + 1u;
+
+    return (next_idx < emulated_devices.size()) ? reinterpret_cast<accfg_dev *>(&emulated_devices[next_idx]) : nullptr;
+}
+
+static const char *own_accfg_device_get_devname(accfg_dev *device_ptr) {
+    return own_device(device_ptr)->name;
+}
+
+static enum accfg_device_state own_accfg_device_get_state(accfg_dev *) {
+    return ACCFG_DEVICE_ENABLED;
+}
+
+static unsigned long own_accfg_device_get_gen_cap(accfg_dev *) {
+    return OWN_EMULATED_GEN_CAP;
+}
+
+static int own_accfg_device_get_numa_node(accfg_dev *device_ptr) {
+    const auto &config = qpl::ml::dispatcher::hw_emulator::get_instance().get_config();
+
+    return (int) (own_device(device_ptr)->device_idx % config.numa_node_count);
+}
+
+static unsigned int own_accfg_device_get_version(accfg_dev *) {
+    return OWN_EMULATED_VERSION;
+}
+
+static unsigned int own_accfg_device_get_max_batch_size(accfg_dev *) {
+    return qpl::ml::dispatcher::hw_emulator::get_instance().get_config().max_batch_size;
+}
+
+static accfg_wq *own_accfg_wq_get_first(accfg_dev *device_ptr) {
+    const auto &config = qpl::ml::dispatcher::hw_emulator::get_instance().get_config();
+
+    return reinterpret_cast<accfg_wq *>(&emulated_queues[own_device(device_ptr)->device_idx * config.queue_count]);
+}
+
+static accfg_wq *own_accfg_wq_get_next(accfg_wq *wq_ptr) {
+    const auto &config    = qpl::ml::dispatcher::hw_emulator::get_instance().get_config();
+    const auto *queue_ptr = own_queue(wq_ptr);
+
+    if (queue_ptr->queue_idx + 1u >= config.queue_count) {
+        return nullptr;
+    }
+
+    return reinterpret_cast<accfg_wq *>(&emulated_queues[queue_ptr->device_idx * config.queue_count
+                                                         + queue_ptr->queue_idx + 1u]);
+}
+
+static enum accfg_wq_state own_accfg_wq_get_state(accfg_wq *) {
+    return ACCFG_WQ_ENABLED;
+}
+
+static enum accfg_wq_mode own_accfg_wq_get_mode(accfg_wq *wq_ptr) {
+    const auto &config = qpl::ml::dispatcher::hw_emulator::get_instance().get_config();
+
+    return (own_queue(wq_ptr)->queue_idx + config.dedicated_count >= config.queue_count)
+           ? ACCFG_WQ_DEDICATED
+           : ACCFG_WQ_SHARED;
+}
+
+static int own_accfg_wq_get_id(accfg_wq *wq_ptr) {
+    return (int) own_queue(wq_ptr)->queue_idx;
+}
+
+static int own_accfg_wq_get_priority(accfg_wq *) {
+    return OWN_EMULATED_PRIORITY;
+}
+
+static int own_accfg_wq_get_user_dev_path(accfg_wq *wq_ptr, char *buffer_ptr, size_t size) {
+    const int length = snprintf(buffer_ptr, size, "%s", own_queue(wq_ptr)->path);
+
+    return (length < 0 || (size_t) length >= size) ? -1 : 0;
+}
+
+static const char *own_accfg_wq_get_devname(accfg_wq *wq_ptr) {
+    return own_queue(wq_ptr)->name;
+}
+
+static int own_accfg_wq_get_block_on_fault(accfg_wq *) {
+    return 0;
+}
+
+static unsigned int own_accfg_wq_get_max_batch_size(accfg_wq *) {
+    return qpl::ml::dispatcher::hw_emulator::get_instance().get_config().max_batch_size;
+}
+
+static uint64_t own_accfg_wq_get_size(accfg_wq *) {
+    return qpl::ml::dispatcher::hw_emulator::get_instance().get_config().queue_size;
+}
+
+static uint64_t own_accfg_wq_get_max_transfer_size(accfg_wq *) {
+    return OWN_EMULATED_MAX_TRANSFER;
+}
+
+static const qpl_desc_t emulated_functions_table[] = {
+        {(library_function) own_accfg_new,                       "accfg_new"},
+        {(library_function) own_accfg_device_get_first,          "accfg_device_get_first"},
+        {(library_function) own_accfg_device_get_devname,        "accfg_device_get_devname"},
+        {(library_function) own_accfg_device_get_next,           "accfg_device_get_next"},
+        {(library_function) own_accfg_wq_get_first,              "accfg_wq_get_first"},
+        {(library_function) own_accfg_wq_get_next,               "accfg_wq_get_next"},
+        {(library_function) own_accfg_wq_get_state,              "accfg_wq_get_state"},
+        {(library_function) own_accfg_wq_get_mode,               "accfg_wq_get_mode"},
+        {(library_function) own_accfg_wq_get_id,                 "accfg_wq_get_id"},
+        {(library_function) own_accfg_device_get_state,          "accfg_device_get_state"},
+        {(library_function) own_accfg_unref,                     "accfg_unref"},
+        {(library_function) own_accfg_device_get_gen_cap,        "accfg_device_get_gen_cap"},
+        {(library_function) own_accfg_device_get_numa_node,      "accfg_device_get_numa_node"},
+        {(library_function) own_accfg_wq_get_priority,           "accfg_wq_get_priority"},
+        {(library_function) own_accfg_wq_get_user_dev_path,      "accfg_wq_get_user_dev_path"},
+        {(library_function) own_accfg_wq_get_devname,            "accfg_wq_get_devname"},
+        {(library_function) own_accfg_device_get_version,        "accfg_device_get_version"},
+        {(library_function) own_accfg_wq_get_block_on_fault,     "accfg_wq_get_block_on_fault"},
+        {(library_function) own_accfg_device_get_max_batch_size, "accfg_device_get_max_batch_size"},
+        {(library_function) own_accfg_wq_get_max_batch_size,     "accfg_wq_get_max_batch_size"},
+        {(library_function) own_accfg_wq_get_size,               "accfg_wq_get_size"},
+        {(library_function) own_accfg_wq_get_max_transfer_size,  "accfg_wq_get_max_transfer_size"},
+        {NULL, NULL}
+};
+
+bool hw_emulator_is_enabled(void) {
+    return qpl::ml::dispatcher::hw_emulator::is_enabled();
+}
+
+library_function hw_emulator_get_function(const char *function_name) {
+    for (uint32_t function_idx = 0u; nullptr != emulated_functions_table[function_idx].function_name; function_idx++) {
+        if (0 == strcmp(function_name, emulated_functions_table[function_idx].function_name)) {
+            return emulated_functions_table[function_idx].function;
+        }
+    }
+
+    return NULL;
+}
+
+namespace qpl::ml::dispatcher {
+
+hw_emulated_portal::hw_emulated_portal(uint32_t capacity) noexcept
+        : cells_(new (std::nothrow) cell_t[capacity]),
+          mask_(capacity - 1u) {
+    if (nullptr == cells_) {
+        return;
+    }
+
+    for (uint64_t position = 0u; position <= mask_; position++) {
+        cells_[position].sequence.store(position, std::memory_order_relaxed);
+    }
+}
+
+auto hw_emulated_portal::enqueue(const void *desc_ptr) noexcept -> bool {
+    uint64_t position = enqueue_position_.load(std::memory_order_relaxed);
+
+    if (nullptr == cells_) {
+        return false;
+    }
+
+    // Bounded MPMC ring: a cell is free for the producer at `position` once its sequence equals the position
+    for (;;) {
+        auto           &cell      = cells_[position & mask_];
+        const uint64_t sequence   = cell.sequence.load(std::memory_order_acquire);
+        const auto     difference = static_cast<int64_t>(sequence - position);
+
+        if (0 == difference) {
+            if (enqueue_position_.compare_exchange_weak(position, position + 1u, std::memory_order_relaxed)) {
+                memcpy(cell.descriptor, desc_ptr, descriptor_size);
+                cell.sequence.store(position + 1u, std::memory_order_release);
+
+                return true;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = enqueue_position_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+auto hw_emulated_portal::dequeue(void *desc_ptr) noexcept -> bool {
+    uint64_t position = dequeue_position_.load(std::memory_order_relaxed);
+
+    if (nullptr == cells_) {
+        return false;
+    }
+
+    for (;;) {
+        auto           &cell      = cells_[position & mask_];
+        const uint64_t sequence   = cell.sequence.load(std::memory_order_acquire);
+        const auto     difference = static_cast<int64_t>(sequence - (position + 1u));
+
+        if (0 == difference) {
+            if (dequeue_position_.compare_exchange_weak(position, position + 1u, std::memory_order_relaxed)) {
+                memcpy(desc_ptr, cell.descriptor, descriptor_size);
+                cell.sequence.store(position + mask_ + 1u, std::memory_order_release);
+
+                return true;
+            }
+        } else if (difference < 0) {
+            return false;
+        } else {
+            position = dequeue_position_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+auto hw_emulated_portal::capacity() const noexcept -> uint32_t {
+    return static_cast<uint32_t>(mask_ + 1u);
+}
+
+hw_emulator::hw_emulator() noexcept {
+    const char *spec_ptr = getenv(emulated_devices_env);
+
+    if (nullptr == spec_ptr || '\0' == spec_ptr[0]) {
+        return;
+    }
+
+    own_parse_config(spec_ptr, config_);
+
+    const uint32_t portal_count = config_.device_count * config_.queue_count;
+
+    portals_.reserve(portal_count);
+    started_devices_.assign(config_.device_count, 0u);
+
+    for (uint32_t portal_idx = 0u; portal_idx < portal_count; portal_idx++) {
+        portals_.emplace_back(new (std::nothrow) hw_emulated_portal(config_.queue_size));
+    }
+
+    DIAG("emulating %u device(s) with %u WQ(s) of %u entries and %u engine(s)\n",
+         config_.device_count, config_.queue_count, config_.queue_size, config_.engine_count);
+}
+
+hw_emulator::~hw_emulator() noexcept {
+    stop_.store(true, std::memory_order_relaxed);
+
+    for (auto &engine : engines_) {
+        engine.join();
+    }
+}
+
+auto hw_emulator::get_instance() noexcept -> hw_emulator & {
+    static hw_emulator instance{};
+
+    return instance;
+}
+
+auto hw_emulator::is_enabled() noexcept -> bool {
+    const char *spec_ptr = getenv(emulated_devices_env);
+
+    return nullptr != spec_ptr && '\0' != spec_ptr[0];
+}
+
+auto hw_emulator::is_emulated_path(const char *path_ptr) noexcept -> bool {
+    return 0 == strncmp(path_ptr, emulated_path_prefix, strlen(emulated_path_prefix));
+}
+
+auto hw_emulator::get_config() const noexcept -> const hw_emulator_config_t & {
+    return config_;
+}
+
+auto hw_emulator::open_portal(const char *path_ptr) noexcept -> hw_emulated_portal * {
+    uint32_t device_idx = 0u;
+    uint32_t queue_idx  = 0u;
+
+    if (!is_emulated_path(path_ptr)
+        || 2 != sscanf(path_ptr + strlen(emulated_path_prefix), "%u.%u", &device_idx, &queue_idx)
+        || device_idx >= config_.device_count
+        || queue_idx >= config_.queue_count) {
+        return nullptr;
+    }
+
+    auto *portal_ptr = portals_[device_idx * config_.queue_count + queue_idx].get();
+
+    if (nullptr == portal_ptr || !hw_emulator::start_engines(device_idx)) {
+        return nullptr;
+    }
+
+    return portal_ptr;
+}
+
+auto hw_emulator::start_engines(uint32_t device_idx) noexcept -> bool {
+    std::lock_guard<std::mutex> lock(start_mutex_);
+
+    if (0u != started_devices_[device_idx]) {
+        return true;
+    }
+
+    uint32_t started_count = 0u;
+
+    // An engine that can't be started leaves the device slower, but still working
+    for (uint32_t engine_idx = 0u; engine_idx < config_.engine_count; engine_idx++) {
+        try {
+            engines_.emplace_back(&hw_emulator::run_engine, this, device_idx, engine_idx);
+            started_count++;
+        } catch (const std::system_error &) {
+            break;
+        }
+    }
+
+    DIAG("iax%u: %u emulated engine(s) started\n", 2u * device_idx + 1u, started_count);
+
+    started_devices_[device_idx] = (0u != started_count) ? 1u : 0u;
+
+    return 0u != started_count;
+}
+
+void hw_emulator::run_engine(uint32_t device_idx, uint32_t engine_idx) noexcept {
+    alignas(64) uint8_t descriptor[hw_emulated_portal::descriptor_size];
+
+    auto     *portals_ptr = &portals_[device_idx * config_.queue_count];
+    uint32_t cursor       = engine_idx % config_.queue_count;
+    uint32_t idle_checks  = 0u;
+
+    while (!stop_.load(std::memory_order_relaxed)) {
+        bool is_found = false;
+
+        for (uint32_t order_idx = 0u; order_idx < config_.queue_count && !is_found; order_idx++) {
+            const uint32_t queue_idx = (cursor + order_idx) % config_.queue_count;
+
+            if (nullptr != portals_ptr[queue_idx] && portals_ptr[queue_idx]->dequeue(descriptor)) {
+                cursor   = (queue_idx + 1u) % config_.queue_count;
+                is_found = true;
+            }
+        }
+
+        if (is_found) {
+            idle_checks = 0u;
+            hw_emulator::execute(reinterpret_cast<hw_descriptor *>(descriptor));
+        } else if (idle_checks < OWN_ENGINE_SPIN_LIMIT) {
+            idle_checks++;
+            _mm_pause();
+        } else if (idle_checks < OWN_ENGINE_SPIN_LIMIT + OWN_ENGINE_YIELD_LIMIT) {
+            idle_checks++;
+            sched_yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(OWN_ENGINE_SLEEP_US));
+        }
+    }
+}
+
+void hw_emulator::execute(hw_descriptor *desc_ptr) const noexcept {
+    const auto     *iaa_desc_ptr = reinterpret_cast<const hw_iaa_analytics_descriptor *>(desc_ptr);
+    const uint64_t service_ns    = own_get_service_time_ns(iaa_desc_ptr, config_);
+
+    // The device is busy for the modeled time before the completion record is written
+    if (0u != service_ns) {
+        const uint64_t deadline_ns = hw_now_ns() + service_ns;
+
+        while (hw_now_ns() < deadline_ns) {
+            _mm_pause();
+        }
+    }
+
+    if (!hw_cpu_execute_descriptor(desc_ptr)) {
+        own_complete_unsupported(iaa_desc_ptr);
+    }
+}
+
+}
@@ -0,0 +1,130 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_EMULATOR_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_EMULATOR_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hw_definitions.h"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief Emulated topology and timing, parsed from the `QPL_EMULATED_DEVICES` environment variable
+ *
+ * @details The variable holds comma separated `key=value` pairs, e.g. `devices=2,wqs=4,engines=2,wq_size=32`.
+ * Keys that are not set keep their defaults.
+ */
+struct hw_emulator_config_t {
+    uint32_t device_count    = 1u;       /**< `devices`: number of emulated IAA devices */
+    uint32_t queue_count     = 1u;       /**< `wqs`: WQs per device */
+    uint32_t dedicated_count = 0u;       /**< `dwqs`: last WQs of every device that are dedicated */
+    uint32_t engine_count    = 2u;       /**< `engines`: threads executing the descriptors of one device */
+    uint32_t queue_size      = 32u;      /**< `wq_size`: WQ entries, rounded up to a power of two */
+    uint32_t numa_node_count = 1u;       /**< `numa`: devices are spread round-robin over this many nodes */
+    uint32_t max_batch_size  = 64u;      /**< `batch`: max descriptors in a batch */
+    uint64_t latency_ns      = 0u;       /**< `latency_ns`: time an engine spends on every descriptor */
+    uint64_t bandwidth_mbps  = 0u;       /**< `bandwidth_mbps`: engine throughput limit in MB/s, 0 is unlimited */
+};
+
+/**
+ * @brief User-space stand-in for a WQ portal: a bounded ring of 64-byte descriptors.
+ *
+ * @details @ref enqueue copies the descriptor like ENQCMD does and fails instead of blocking when all entries
+ * are in use, which the caller sees as an ENQCMD retry. Any number of submitting threads and engines may use
+ * the ring concurrently.
+ */
+class hw_emulated_portal final {
+public:
+    static constexpr uint32_t descriptor_size = 64u;
+
+    explicit hw_emulated_portal(uint32_t capacity) noexcept;
+
+    hw_emulated_portal(const hw_emulated_portal &) = delete;
+
+    auto operator=(const hw_emulated_portal &) -> hw_emulated_portal & = delete;
+
+    [[nodiscard]] auto enqueue(const void *desc_ptr) noexcept -> bool;
+
+    [[nodiscard]] auto dequeue(void *desc_ptr) noexcept -> bool;
+
+    [[nodiscard]] auto capacity() const noexcept -> uint32_t;
+
+private:
+    struct alignas(64) cell_t {
+        std::atomic<uint64_t> sequence = 0u;                 /**< Ring position the cell is ready for */
+        uint8_t               descriptor[descriptor_size];   /**< Copy of the submitted descriptor */
+    };
+
+    std::unique_ptr<cell_t[]> cells_;                        /**< Ring storage, nullptr if allocation failed */
+    uint64_t                  mask_        = 0u;             /**< Capacity - 1 */
+    alignas(64) std::atomic<uint64_t> enqueue_position_ = 0u;   /**< Next position of the producers */
+    alignas(64) std::atomic<uint64_t> dequeue_position_ = 0u;   /**< Next position of the engines */
+};
+
+/**
+ * @brief Software IAA devices for profiling the dispatcher on hosts without accelerators.
+ *
+ * @details If `QPL_EMULATED_DEVICES` is set, the configuration driver resolves its functions table with
+ * hw_emulator_get_function() instead of loading `libaccel-config.so.1`, so the dispatcher discovers the emulated
+ * devices and WQs through the regular driver calls. WQ device paths start with `emulated:`, @ref hw_queue maps them with
+ * @ref open_portal and submits into the ring instead of issuing ENQCMD.
+ *
+ * Engine threads of a device start when the first of its portals is opened. They serve the WQs of the device
+ * round-robin, wait for the configured latency and bandwidth time, then execute the descriptor with
+ * @ref hw_cpu_execute_descriptor, which writes the completion record. Descriptors the CPU executor doesn't
+ * support complete with AD_STATUS_UNSUPPORTED_OPCODE, page faults are never reported.
+ */
+class hw_emulator final {
+public:
+    static auto get_instance() noexcept -> hw_emulator &;
+
+    [[nodiscard]] static auto is_enabled() noexcept -> bool;
+
+    [[nodiscard]] static auto is_emulated_path(const char *path_ptr) noexcept -> bool;
+
+    [[nodiscard]] auto get_config() const noexcept -> const hw_emulator_config_t &;
+
+    /**
+     * @brief Returns the portal named by an emulated WQ path, nullptr if there is none or its engines can't start
+     */
+    [[nodiscard]] auto open_portal(const char *path_ptr) noexcept -> hw_emulated_portal *;
+
+    hw_emulator(const hw_emulator &) = delete;
+
+    auto operator=(const hw_emulator &) -> hw_emulator & = delete;
+
+private:
+    hw_emulator() noexcept;
+
+    ~hw_emulator() noexcept;
+
+    void run_engine(uint32_t device_idx, uint32_t engine_idx) noexcept;
+
+    void execute(hw_descriptor *desc_ptr) const noexcept;
+
+    [[nodiscard]] auto start_engines(uint32_t device_idx) noexcept -> bool;
+
+    hw_emulator_config_t                             config_           = {};    /**< Parsed configuration */
+    std::vector<std::unique_ptr<hw_emulated_portal>> portals_;                  /**< Device-major portals */
+    std::vector<std::thread>                         engines_;                  /**< Started engine threads */
+    std::vector<uint8_t>                             started_devices_;          /**< Non-zero once engines run */
+    std::mutex                                       start_mutex_;              /**< Guards engine start */
+    std::atomic<bool>                                stop_             = false; /**< Asks the engines to exit */
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_EMULATOR_HPP_
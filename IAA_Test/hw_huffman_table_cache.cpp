@@ -0,0 +1,245 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <cstring>
+#include <new>
+
+#include "hw_huffman_table_cache.hpp"
+#include "hw_util.hpp"
+#include "qplc_compression_consts.h"
+
+#define OWN_MAX_CODE_LENGTH     15u                     /**< Longest deflate code */
+#define OWN_PERMILLE            1000u                   /**< Tolerance scale */
+
+/**
+ * @brief Ideal code length of a symbol seen `count` times out of `total`, 0 for an unused symbol
+ */
+static inline auto own_ideal_length(const uint32_t count, const uint64_t total) noexcept -> uint32_t {
+    if (0u == count) {
+        return 0u;
+    }
+
+    uint32_t length = 1u;
+
+    for (; length < OWN_MAX_CODE_LENGTH && (static_cast<uint64_t>(count) << length) < total; length++) {
+    }
+
+    return length;
+}
+
+/**
+ * @brief Hashes the ideal lengths of all symbols and sums the bits they would take
+ */
+static inline auto own_signature(const hw_iaa_histogram &histogram, uint64_t &ideal_bits) noexcept -> uint64_t {
+    uint64_t ll_total = 0u;
+    uint64_t d_total  = 0u;
+    uint64_t hash     = qpl::ml::dispatcher::hw_fnv_offset_basis;
+
+    for (uint32_t symbol = 0u; symbol < QPLC_DEFLATE_LL_TABLE_SIZE; symbol++) {
+        ll_total += histogram.ll_sym[symbol];
+    }
+
+    for (uint32_t symbol = 0u; symbol < QPLC_DEFLATE_D_TABLE_SIZE; symbol++) {
+        d_total += histogram.d_sym[symbol];
+    }
+
+    ideal_bits = 0u;
+
+    for (uint32_t symbol = 0u; symbol < QPLC_DEFLATE_LL_TABLE_SIZE + QPLC_DEFLATE_D_TABLE_SIZE; symbol++) {
+        const bool     is_ll  = symbol < QPLC_DEFLATE_LL_TABLE_SIZE;
+        const uint32_t count  = is_ll ? histogram.ll_sym[symbol] : histogram.d_sym[symbol - QPLC_DEFLATE_LL_TABLE_SIZE];
+        const uint32_t length = own_ideal_length(count, is_ll ? ll_total : d_total);
+
+        ideal_bits += static_cast<uint64_t>(count) * length;
+        hash        = (hash ^ length) * qpl::ml::dispatcher::hw_fnv_prime;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Bits the histogram takes when encoded with the codes of the AECS
+ */
+static inline auto own_encoded_bits(const hw_iaa_histogram &histogram, const hw_iaa_aecs_compress &aecs) noexcept -> uint64_t {
+    uint64_t bits = 0u;
+
+    for (uint32_t symbol = 0u; symbol < QPLC_DEFLATE_LL_TABLE_SIZE; symbol++) {
+        bits += static_cast<uint64_t>(histogram.ll_sym[symbol])
+                * (aecs.histogram.ll_sym[symbol] >> QPLC_HUFFMAN_CODE_LENGTH_OFFSET);
+    }
+
+    for (uint32_t symbol = 0u; symbol < QPLC_DEFLATE_D_TABLE_SIZE; symbol++) {
+        bits += static_cast<uint64_t>(histogram.d_sym[symbol])
+                * (aecs.histogram.d_sym[symbol] >> QPLC_HUFFMAN_CODE_LENGTH_OFFSET);
+    }
+
+    return bits;
+}
+
+namespace qpl::ml::dispatcher {
+
+hw_huffman_table_cache::hw_huffman_table_cache(const uint32_t capacity, const uint32_t tolerance_permille) noexcept
+        : entries_(new (std::nothrow) entry_t[(0u != capacity) ? capacity : 1u]),
+          capacity_((nullptr != entries_) ? ((0u != capacity) ? capacity : 1u) : 0u),
+          tolerance_permille_(tolerance_permille) {
+}
+
+auto hw_huffman_table_cache::find(const hw_iaa_histogram &histogram,
+                                  const uint64_t signature,
+                                  const uint64_t ideal_bits) noexcept -> entry_t * {
+    const uint64_t limit      = ideal_bits + ideal_bits * tolerance_permille_ / OWN_PERMILLE;
+    entry_t        *best_ptr  = nullptr;
+    uint64_t       best_bits  = UINT64_MAX;
+
+    // A table built for the same signature is almost always the best one, the scan is skipped if it fits
+    for (uint32_t idx = 0u; idx < capacity_; idx++) {
+        entry_t &entry = entries_[idx];
+
+        if (0u != entry.last_use && signature == entry.signature
+            && own_encoded_bits(histogram, entry.aecs) <= limit) {
+            return &entry;
+        }
+    }
+
+    for (uint32_t idx = 0u; idx < capacity_; idx++) {
+        entry_t &entry = entries_[idx];
+
+        if (0u == entry.last_use) {
+            continue;
+        }
+
+        const uint64_t bits = own_encoded_bits(histogram, entry.aecs);
+
+        if (bits < best_bits) {
+            best_bits = bits;
+            best_ptr  = &entry;
+        }
+    }
+
+    return (best_bits <= limit) ? best_ptr : nullptr;
+}
+
+auto hw_huffman_table_cache::build(const hw_iaa_histogram &histogram, const uint64_t signature) noexcept -> entry_t * {
+    entry_t *victim_ptr = &entries_[0];
+
+    for (uint32_t idx = 1u; idx < capacity_ && 0u != victim_ptr->last_use; idx++) {
+        victim_ptr = (entries_[idx].last_use < victim_ptr->last_use) ? &entries_[idx] : victim_ptr;
+    }
+
+    stats_.evictions += (0u != victim_ptr->last_use) ? 1u : 0u;
+
+    // Every symbol gets a code, so the table stays valid for data with symbols the histogram hasn't seen
+    hw_iaa_histogram smoothed = histogram;
+
+    for (uint32_t symbol = 0u; symbol < QPLC_DEFLATE_LL_TABLE_SIZE; symbol++) {
+        smoothed.ll_sym[symbol] = (histogram.ll_sym[symbol] < UINT32_MAX) ? histogram.ll_sym[symbol] + 1u : UINT32_MAX;
+    }
+
+    for (uint32_t symbol = 0u; symbol < QPLC_DEFLATE_D_TABLE_SIZE; symbol++) {
+        smoothed.d_sym[symbol] = (histogram.d_sym[symbol] < UINT32_MAX) ? histogram.d_sym[symbol] + 1u : UINT32_MAX;
+    }
+
+    memset(&victim_ptr->aecs, 0, sizeof(victim_ptr->aecs));
+    hw_iaa_aecs_compress_write_deflate_dynamic_header_from_histogram(&victim_ptr->aecs, &smoothed, 0u);
+
+    victim_ptr->signature = signature;
+    victim_ptr->key       = no_key;
+
+    return victim_ptr;
+}
+
+void hw_huffman_table_cache::use(entry_t &entry, hw_iaa_aecs_compress &aecs, const uint32_t b_final, const uint64_t key) noexcept {
+    entry.last_use = stats_.lookups;
+
+    if (no_key != key) {
+        for (uint32_t idx = 0u; idx < capacity_; idx++) {
+            entries_[idx].key = (key == entries_[idx].key) ? no_key : entries_[idx].key;
+        }
+
+        entry.key = key;
+    }
+
+    // The header doesn't fit behind the bits already in the accumulator, the block falls back to fixed codes
+    if (0u != hw_iaa_aecs_compress_write_deflate_dynamic_header(&aecs,
+                                                                entry.aecs.output_accum,
+                                                                entry.aecs.num_output_accum_bits,
+                                                                b_final)) {
+        (void) hw_iaa_aecs_compress_write_deflate_fixed_header(&aecs, b_final);
+        return;
+    }
+
+    hw_iaa_aecs_compress_set_deflate_huffman_table(&aecs, entry.aecs.histogram.ll_sym, entry.aecs.histogram.d_sym);
+}
+
+auto hw_huffman_table_cache::prepare(const hw_iaa_histogram &histogram,
+                                     hw_iaa_aecs_compress &aecs,
+                                     const uint32_t b_final,
+                                     const uint64_t key) noexcept -> bool {
+    if (0u == capacity_) {
+        hw_iaa_histogram copy = histogram;
+
+        hw_iaa_aecs_compress_write_deflate_dynamic_header_from_histogram(&aecs, &copy, b_final);
+        return false;
+    }
+
+    uint64_t       ideal_bits = 0u;
+    const uint64_t signature  = own_signature(histogram, ideal_bits);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    stats_.lookups++;
+
+    entry_t *entry_ptr = hw_huffman_table_cache::find(histogram, signature, ideal_bits);
+    const bool is_hit  = (nullptr != entry_ptr);
+
+    if (is_hit) {
+        stats_.hits++;
+    } else {
+        stats_.misses++;
+        entry_ptr = hw_huffman_table_cache::build(histogram, signature);
+    }
+
+    hw_huffman_table_cache::use(*entry_ptr, aecs, b_final, key);
+
+    return is_hit;
+}
+
+auto hw_huffman_table_cache::prepare(const uint64_t key, hw_iaa_aecs_compress &aecs, const uint32_t b_final) noexcept -> bool {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    stats_.lookups++;
+
+    for (uint32_t idx = 0u; no_key != key && idx < capacity_; idx++) {
+        if (key == entries_[idx].key && 0u != entries_[idx].last_use) {
+            stats_.hits++;
+            hw_huffman_table_cache::use(entries_[idx], aecs, b_final, no_key);
+
+            return true;
+        }
+    }
+
+    stats_.misses++;
+
+    return false;
+}
+
+auto hw_huffman_table_cache::get_stats() const noexcept -> hw_huffman_table_cache_stats_t {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return stats_;
+}
+
+void hw_huffman_table_cache::clear() noexcept {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (uint32_t idx = 0u; idx < capacity_; idx++) {
+        entries_[idx] = entry_t();
+    }
+
+    stats_ = hw_huffman_table_cache_stats_t();
+}
+
+}
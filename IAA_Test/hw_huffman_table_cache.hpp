@@ -0,0 +1,111 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_HUFFMAN_TABLE_CACHE_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_HUFFMAN_TABLE_CACHE_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "hw_aecs_api.h"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief Counters of @ref hw_huffman_table_cache
+ */
+struct hw_huffman_table_cache_stats_t {
+    uint64_t lookups   = 0u;    /**< Calls of any prepare() */
+    uint64_t hits      = 0u;    /**< Lookups served by a cached table */
+    uint64_t misses    = 0u;    /**< Lookups that built a table or found no table for the key */
+    uint64_t evictions = 0u;    /**< Tables replaced to make room for a new one */
+};
+
+/**
+ * @brief LRU cache of dynamic deflate tables keyed by a quantized histogram signature.
+ *
+ * @details A histogram is reduced to the ideal code length of every symbol, ceil(log2(total / count)) clamped
+ * to the deflate limit, which is stable across blocks of the same kind of data. A table whose signature is
+ * the same is tried first, then the cached table that encodes the histogram in the fewest bits. The table is
+ * reused if that is at most `tolerance_permille` worse than the ideal lengths, otherwise a new table is built
+ * and replaces the least recently used one.
+ *
+ * Tables are built from counts incremented by one, so every symbol has a code and a reused table can encode
+ * any data, only less tightly. A table may be bound to a caller key, e.g. a column, and reused by key with no
+ * statistics pass at all.
+ *
+ * The prepared AECS carries the block header in its output accumulator and the codes in its histogram area,
+ * ready for a compress descriptor with the read access policy.
+ */
+class hw_huffman_table_cache final {
+public:
+    static constexpr uint32_t default_capacity           = 32u;    /**< Cached tables */
+    static constexpr uint32_t default_tolerance_permille = 50u;    /**< Accepted size overhead of a reused table */
+    static constexpr uint64_t no_key                     = 0u;     /**< Table is not bound to a key */
+
+    explicit hw_huffman_table_cache(uint32_t capacity = default_capacity,
+                                    uint32_t tolerance_permille = default_tolerance_permille) noexcept;
+
+    hw_huffman_table_cache(const hw_huffman_table_cache &) = delete;
+
+    auto operator=(const hw_huffman_table_cache &) -> hw_huffman_table_cache & = delete;
+
+    /**
+     * @brief Writes the dynamic block header and codes fitting the histogram into the AECS
+     *
+     * @param histogram histogram collected with @ref hw_iaa_descriptor_init_statistic_collector
+     * @param aecs      AECS to prepare, the header is appended to the bits already in its accumulator
+     * @param key       binds the used table to the key, see the keyed overload
+     *
+     * @return true if a cached table was used
+     */
+    auto prepare(const hw_iaa_histogram &histogram,
+                 hw_iaa_aecs_compress &aecs,
+                 uint32_t b_final,
+                 uint64_t key = no_key) noexcept -> bool;
+
+    /**
+     * @brief Writes the table last bound to the key into the AECS, skipping the statistics pass
+     *
+     * @return false if no cached table is bound to the key, the AECS is not changed then
+     */
+    auto prepare(uint64_t key, hw_iaa_aecs_compress &aecs, uint32_t b_final) noexcept -> bool;
+
+    [[nodiscard]] auto get_stats() const noexcept -> hw_huffman_table_cache_stats_t;
+
+    void clear() noexcept;
+
+private:
+    /**
+     * @brief Cached table, the AECS holds the header with BFINAL cleared and nothing else in the accumulator
+     */
+    struct entry_t {
+        hw_iaa_aecs_compress aecs         = {};       /**< Header and codes of the table */
+        uint64_t             signature    = 0u;       /**< Hash of the ideal lengths the table was built for */
+        uint64_t             key          = no_key;   /**< Caller key the table is bound to */
+        uint64_t             last_use     = 0u;       /**< Lookup number of the last use, 0 if the entry is empty */
+    };
+
+    [[nodiscard]] auto find(const hw_iaa_histogram &histogram, uint64_t signature, uint64_t ideal_bits) noexcept -> entry_t *;
+
+    [[nodiscard]] auto build(const hw_iaa_histogram &histogram, uint64_t signature) noexcept -> entry_t *;
+
+    void use(entry_t &entry, hw_iaa_aecs_compress &aecs, uint32_t b_final, uint64_t key) noexcept;
+
+    std::unique_ptr<entry_t[]>     entries_;                     /**< Cached tables */
+    hw_huffman_table_cache_stats_t stats_;                       /**< Counters */
+    mutable std::mutex             mutex_;                       /**< Guards entries and counters */
+    uint32_t                       capacity_           = 0u;     /**< Number of entries */
+    uint32_t                       tolerance_permille_ = 0u;     /**< Accepted size overhead of a reused table */
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_HUFFMAN_TABLE_CACHE_HPP_
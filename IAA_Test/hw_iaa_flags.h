@@ -14,6 +14,25 @@ extern "C" {
 typedef uint64_t hw_operation_flags_t; /**< Represents operation's flags */
 
 /* ################# COMMON FLAGS ################# */
+/**
+ * @name Operation flags
+ * @anchor HW_OPERATION_FLAGS
+ * @brief Bits of the `op_code_op_flags` descriptor field: opcode in bits 31:24, flags in bits 23:0
+ * @{
+ */
+#define ADOF_OPCODE(x)          ((uint32_t)(x) << 24u)          /**< Places opcode into the descriptor field */
+#define ADOF_GET_OPCODE(x)      (((uint32_t)(x) >> 24u) & 0xFFu) /**< Extracts opcode from the descriptor field */
+#define ADOF_FENCE              0x000001u    /**< Wait for the previous descriptors of the batch */
+#define ADOF_BLOCK_ON_FAULT     0x000002u    /**< Block on page fault instead of partial completion */
+#define ADOF_CR_ADDR_VALID      0x000004u    /**< Completion record address is valid */
+#define ADOF_REQ_COMPL          0x000008u    /**< Request completion record write */
+#define ADOF_CACHE_CONTROL      0x000100u    /**< Hint to write destination into CPU cache */
+#define ADOF_READ_SRC2(x)       (((x) & 3u) << 16u) /**< Read source-2: 1 - AECS, 2 - secondary input */
+#define ADOF_WRITE_SRC2(x)      (((x) & 3u) << 18u) /**< Write source-2: 1 - always, 2 - on output overflow only */
+#define ADOF_AECS_SEL           0x100000u    /**< Select second AECS half for read (toggled R/W policy) */
+#define ADOF_CRC32C             0x200000u    /**< Use iSCSI CRC polynomial (RFC 3720) */
+/** @} */
+
 
 /* ################# COMPRESSION FLAGS ################# */
 /**
@@ -22,16 +41,90 @@ typedef uint64_t hw_operation_flags_t; /**< Represents operation's flags */
  * @todo Opcode values
  * @{
  */
+#define QPL_OPCODE_NOOP         0x00u    /**< No operation, can be used to fence a work queue */
+#define QPL_OPCODE_BATCH        0x01u    /**< Batch of descriptors submitted with a single descriptor */
+#define QPL_OPCODE_DRAIN        0x02u    /**< Wait for completion of previously submitted descriptors */
+#define QPL_OPCODE_MEMMOVE      0x03u    /**< Memory copy/move */
+
 #define QPL_OPCODE_DECOMPRESS   0x42u    /**< @todo */
 #define QPL_OPCODE_COMPRESS     0x43u    /**< @todo */
+#define QPL_OPCODE_CRC64        0x44u    /**< CRC64 with a polynomial given in the descriptor */
 
 #define QPL_OPCODE_Z_DECOMP32   0x48u    /**< @todo */
 #define QPL_OPCODE_Z_DECOMP16   0x49u    /**< @todo */
 #define QPL_OPCODE_Z_COMP32     0x4Cu    /**< @todo */
 #define QPL_OPCODE_Z_COMP16     0x4Du    /**< @todo */
+
+#define QPL_OPCODE_SCAN         0x50u    /**< Marks elements within [low, high] range */
+#define QPL_OPCODE_SET_MEMBERSHIP 0x51u  /**< Marks elements that belong to the `source-2` set */
+#define QPL_OPCODE_EXTRACT      0x52u    /**< Copies elements with indices within [low, high] range */
+#define QPL_OPCODE_SELECT       0x53u    /**< Copies elements marked in the `source-2` bit-vector */
+#define QPL_OPCODE_RLE_BURST    0x54u    /**< Replicates `source-2` elements by `source-1` counters */
+#define QPL_OPCODE_FIND_UNIQUE  0x55u    /**< Marks distinct element values */
+#define QPL_OPCODE_EXPAND       0x56u    /**< Places elements at positions marked in the `source-2` bit-vector */
 /** @} */
 
 /* ################# FILTER FLAGS ################# */
+/**
+ * @name Filter flags
+ * @anchor HW_FILTER_FLAGS
+ * @brief Bits of the `filter_flags` descriptor field of analytic operations
+ * @{
+ */
+#define ADFF_SRC1_PARSER(x)        ((uint32_t)(x) & 3u)                        /**< @ref hw_iaa_input_format of `source-1` */
+#define ADFF_SRC1_WIDTH(x)         ((((uint32_t)(x) - 1u) & 0x1Fu) << 2u)      /**< `source-1` element bit-width, 1..32 */
+#define ADFF_SRC2_WIDTH(x)         ((((uint32_t)(x) - 1u) & 0x1Fu) << 7u)      /**< `source-2` element bit-width, 1..32 */
+#define ADFF_SRC2_BE               0x1000u                                     /**< `source-2` is big-endian */
+#define ADFF_OUTPUT_WIDTH(x)       (((uint32_t)(x) & 3u) << 13u)               /**< @ref hw_iaa_output_format without modifiers */
+#define ADFF_OUTPUT_BE             0x8000u                                     /**< Output is big-endian */
+#define ADFF_INVERT_OUTPUT         0x10000u                                    /**< Output bit-vector is inverted */
+#define ADFF_DROP_LOW_BITS(x)      (((uint32_t)(x) & 0x1Fu) << 17u)            /**< Low bits dropped from elements */
+#define ADFF_DROP_HIGH_BITS(x)     (((uint32_t)(x) & 0x1Fu) << 22u)            /**< High bits dropped from elements */
+
+#define ADFF_GET_SRC1_PARSER(x)    ((uint32_t)(x) & 3u)                        /**< Extracts `source-1` parser */
+#define ADFF_GET_SRC1_WIDTH(x)     ((((uint32_t)(x) >> 2u) & 0x1Fu) + 1u)      /**< Extracts `source-1` bit-width */
+#define ADFF_GET_SRC2_WIDTH(x)     ((((uint32_t)(x) >> 7u) & 0x1Fu) + 1u)      /**< Extracts `source-2` bit-width */
+#define ADFF_GET_OUTPUT_WIDTH(x)   (((uint32_t)(x) >> 13u) & 3u)               /**< Extracts output format */
+#define ADFF_GET_DROP_LOW_BITS(x)  (((uint32_t)(x) >> 17u) & 0x1Fu)            /**< Extracts dropped low bits count */
+#define ADFF_GET_DROP_HIGH_BITS(x) (((uint32_t)(x) >> 22u) & 0x1Fu)            /**< Extracts dropped high bits count */
+
+/** @} */
+
+/**
+ * @name Decompression flags
+ * @anchor HW_DECOMPRESSION_FLAGS
+ * @brief Bits of the `decomp_flags` descriptor field of decompress and analytic operations
+ * @{
+ */
+#define ADDF_ENABLE_DECOMPRESS     0x0001u     /**< Decompress `source-1`, before filtering for analytic operations */
+#define ADDF_FLUSH_OUTPUT          0x0002u     /**< Write out the partially filled output accumulator */
+#define ADDF_STOP_ON_EOB           0x0004u     /**< Stop at the end-of-block symbol */
+#define ADDF_CHECK_FOR_EOB         0x0008u     /**< Report an error if the stream doesn't end with end-of-block */
+#define ADDF_SELECT_BFINAL_EOB     0x0010u     /**< Stop and check conditions apply to the final block only */
+#define ADDF_DECOMPRESS_BE         0x0020u     /**< Compressed `source-1` is a big-endian 16-bit stream */
+#define ADDF_IGNORE_END_BITS(x)    (((uint32_t)(x) & 7u) << 6u) /**< Bits of the last compressed byte to skip */
+#define ADDF_SUPPRESS_OUTPUT       0x0200u     /**< Decompress without writing the output */
+/** @} */
+
+/**
+ * @name Compression flags
+ * @anchor HW_COMPRESSION_FLAGS
+ * @brief Bits of the `decomp_flags` descriptor field of compress operations not covered by the inline setters
+ * @{
+ */
+#define ADCF_STATS_MODE            0x0001u     /**< Collect the histogram instead of compressing */
+#define ADCF_FLUSH_OUTPUT          0x0002u     /**< Write out the partially filled output accumulator */
+/** @} */
+
+/**
+ * @name CRC64 flags
+ * @anchor HW_CRC64_FLAGS
+ * @brief Bits of the `decomp_flags` descriptor field of the CRC64 operation
+ * @{
+ */
+#define ADC64F_MSB_FIRST           0x4000u     /**< Data bits are processed most significant bit first */
+#define ADC64F_INVERT_CRC          0x8000u     /**< CRC is inverted at the start and the end of the computation */
+/** @} */
 
 typedef enum {
     hw_iaa_input_format_le   = 0u,
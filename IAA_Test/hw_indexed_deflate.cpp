@@ -0,0 +1,269 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <sched.h>
+#include <cstring>
+
+#include "hw_indexed_deflate.hpp"
+#include "hw_aecs_api.h"
+#include "hw_descriptors_api.h"
+#include "qplc_compression_consts.h"
+
+#define OWN_MINI_BLOCK_BASE_SIZE   256u     /**< Mini-block size code 1 is 512 bytes, every next code doubles it */
+#define OWN_INDEX_EXTRA_ENTRIES    2u       /**< Block header and end-of-block entries */
+#define OWN_BOUND_EXTRA_BYTES      64u      /**< Block header, EOB and the flushed accumulator */
+
+/**
+ * @brief Source bytes and the ignored bits at both ends covering the bit range [begin, end) of a stream
+ */
+struct own_bit_range_t {
+    uint32_t byte_offset;           /**< First byte holding bits of the range */
+    uint32_t byte_count;            /**< Bytes up to the one holding the last bit */
+    uint8_t  ignore_start_bits;     /**< Bits of the first byte in front of the range */
+    uint8_t  ignore_end_bits;       /**< Bits of the last byte behind the range */
+};
+
+static inline auto own_bit_range(const uint32_t begin_bit, const uint32_t end_bit) noexcept -> own_bit_range_t {
+    own_bit_range_t range = {};
+
+    range.byte_offset       = begin_bit >> 3u;
+    range.byte_count        = ((end_bit + 7u) >> 3u) - range.byte_offset;
+    range.ignore_start_bits = static_cast<uint8_t>(begin_bit & 7u);
+    range.ignore_end_bits   = static_cast<uint8_t>((8u - (end_bit & 7u)) & 7u);
+
+    return range;
+}
+
+namespace qpl::ml::dispatcher {
+
+hw_indexed_deflate::hw_indexed_deflate(hw_iaa_mini_block_size_t mini_block_size) noexcept
+        : mini_block_size_((mini_block_size_none == mini_block_size) ? mini_block_size_4k : mini_block_size) {
+}
+
+hw_indexed_deflate::~hw_indexed_deflate() noexcept {
+    // Nothing is in flight between calls, a pass refused by every queue still looks submitted
+    if (nullptr != job_.descriptor_ptr) {
+        hw_iaa_descriptor_reset(job_.descriptor_ptr);
+    }
+
+    (void) hw_job_pool::get_instance().release_job(job_);
+}
+
+auto hw_indexed_deflate::get_mini_block_bytes() const noexcept -> uint32_t {
+    return OWN_MINI_BLOCK_BASE_SIZE << static_cast<uint32_t>(mini_block_size_);
+}
+
+auto hw_indexed_deflate::get_index_size(const uint32_t source_size,
+                                        const hw_iaa_mini_block_size_t mini_block_size) noexcept -> uint32_t {
+    const uint32_t mini_block_bytes = OWN_MINI_BLOCK_BASE_SIZE << static_cast<uint32_t>(mini_block_size);
+
+    return (source_size + mini_block_bytes - 1u) / mini_block_bytes + OWN_INDEX_EXTRA_ENTRIES;
+}
+
+auto hw_indexed_deflate::get_compressed_size_bound(const uint32_t source_size) noexcept -> uint32_t {
+    // Fixed codes take at most 9 bits per literal, matches are never longer than the literals they replace
+    return source_size + (source_size >> 3u) + OWN_BOUND_EXTRA_BYTES;
+}
+
+auto hw_indexed_deflate::execute() noexcept -> qpl_status {
+    auto status = engine_.submit(job_.descriptor_ptr, job_.completion_record_ptr);
+
+    // Every queue refused while the pass is the only job of the object, other submitters hold the devices
+    while (QPL_STS_QUEUES_ARE_BUSY_ERR == status) {
+        sched_yield();
+        status = engine_.submit(job_.descriptor_ptr, job_.completion_record_ptr);
+    }
+
+    if (QPL_STS_OK != status) {
+        return status;
+    }
+
+    hw_completion_engine::reaped_t reaped;
+
+    // Passes of one call depend on each other, so the only record in flight is the one just submitted
+    (void) engine_.wait_any(&reaped, 1u);
+
+    return reaped.status;
+}
+
+auto hw_indexed_deflate::compress(const uint8_t *src_ptr,
+                                  const uint32_t src_size,
+                                  uint8_t *dst_ptr,
+                                  const uint32_t dst_capacity,
+                                  uint32_t &dst_size,
+                                  hw_deflate_index_t *index_ptr,
+                                  const uint32_t index_capacity,
+                                  uint32_t &index_count) noexcept -> qpl_status {
+    if (nullptr == src_ptr || nullptr == dst_ptr || nullptr == index_ptr) {
+        return QPL_STS_NULL_PTR_ERR;
+    }
+
+    if (0u == src_size) {
+        return QPL_STS_SIZE_ERR;
+    }
+
+    if (index_capacity < hw_indexed_deflate::get_index_size(src_size, mini_block_size_)) {
+        return QPL_STS_MISSING_INDEX_TABLE_ERR;
+    }
+
+    if (nullptr == job_.descriptor_ptr && QPL_STS_OK != hw_job_pool::get_instance().acquire_job(job_, true)) {
+        return QPL_STS_NO_MEM_ERR;
+    }
+
+    auto *const desc_ptr   = job_.descriptor_ptr;
+    auto *const record_ptr = reinterpret_cast<hw_iaa_completion_record *>(job_.completion_record_ptr);
+
+    // Compression pass: one final fixed block whose header is emitted from the AECS accumulator
+    auto *const compress_aecs_ptr = static_cast<hw_iaa_aecs_compress *>(job_.aecs_ptr);
+
+    memset(compress_aecs_ptr, 0, sizeof(hw_iaa_aecs_compress));
+    (void) hw_iaa_aecs_compress_write_deflate_fixed_header(compress_aecs_ptr, BFINAL_BIT);
+
+    hw_iaa_descriptor_init_compress_body(desc_ptr);
+    hw_iaa_descriptor_init_deflate_body(desc_ptr, const_cast<uint8_t *>(src_ptr), src_size, dst_ptr, dst_capacity);
+    hw_iaa_descriptor_compress_set_aecs(desc_ptr, compress_aecs_ptr, hw_aecs_access_read);
+    hw_iaa_descriptor_compress_set_mini_block_size(desc_ptr, mini_block_size_);
+    hw_iaa_descriptor_compress_set_termination_rule(desc_ptr, final_end_of_block);
+
+    auto status = hw_indexed_deflate::execute();
+
+    if (QPL_STS_OK != status) {
+        return status;
+    }
+
+    dst_size = record_ptr->output_size;
+
+    // Indexing pass: the stream is decoded again with the output replaced by the index table
+    auto *const index_aecs_ptr = static_cast<hw_iaa_aecs_analytic *>(job_.aecs_ptr);
+
+    memset(index_aecs_ptr, 0, HW_AECS_ANALYTIC_RANDOM_ACCESS_SIZE);
+
+    hw_iaa_descriptor_init_compress_verification(desc_ptr);
+    hw_iaa_descriptor_set_input_buffer(desc_ptr, dst_ptr, dst_size);
+    hw_iaa_descriptor_compress_verification_set_index_table(desc_ptr,
+                                                            reinterpret_cast<uint64_t *>(index_ptr),
+                                                            0u,
+                                                            index_capacity);
+    hw_iaa_descriptor_decompress_set_mini_block_size(desc_ptr, mini_block_size_);
+    hw_iaa_descriptor_compress_verification_write_initial_index(desc_ptr, index_aecs_ptr, 0u, 0u);
+
+    status = hw_indexed_deflate::execute();
+
+    if (QPL_STS_OK != status) {
+        return (QPL_STS_DST_IS_SHORT_ERR == status) ? QPL_STS_INDEX_GENERATION_ERR : status;
+    }
+
+    index_count = record_ptr->output_size / static_cast<uint32_t>(sizeof(hw_deflate_index_t));
+
+    return QPL_STS_OK;
+}
+
+auto hw_indexed_deflate::read(const uint8_t *src_ptr,
+                              const uint32_t src_size,
+                              const hw_deflate_index_t *index_ptr,
+                              const uint32_t index_count,
+                              const uint32_t offset,
+                              const uint32_t length,
+                              uint8_t *dst_ptr) noexcept -> qpl_status {
+    if (nullptr == src_ptr || nullptr == index_ptr || nullptr == dst_ptr) {
+        return QPL_STS_NULL_PTR_ERR;
+    }
+
+    if (index_count <= OWN_INDEX_EXTRA_ENTRIES) {
+        return QPL_STS_MISSING_INDEX_TABLE_ERR;
+    }
+
+    const uint32_t mini_block_bytes = hw_indexed_deflate::get_mini_block_bytes();
+    const uint32_t mini_block_count = index_count - OWN_INDEX_EXTRA_ENTRIES;
+    const uint32_t first_block      = offset / mini_block_bytes;
+
+    if (0u == length || first_block >= mini_block_count || length > UINT32_MAX - offset) {
+        return QPL_STS_SIZE_ERR;
+    }
+
+    const uint32_t last_block = (offset + length - 1u) / mini_block_bytes;
+
+    if (last_block >= mini_block_count || index_ptr[index_count - 1u].bit_offset > src_size * 8ull) {
+        return QPL_STS_SIZE_ERR;
+    }
+
+    // The header pass starts without an input accumulator, so the block must start on a byte boundary
+    if (0u != (index_ptr[0].bit_offset & 7u)) {
+        return QPL_STS_NOT_SUPPORTED_MODE_ERR;
+    }
+
+    if (nullptr == job_.descriptor_ptr && QPL_STS_OK != hw_job_pool::get_instance().acquire_job(job_, true)) {
+        return QPL_STS_NO_MEM_ERR;
+    }
+
+    auto *const desc_ptr   = job_.descriptor_ptr;
+    auto *const record_ptr = reinterpret_cast<hw_iaa_completion_record *>(job_.completion_record_ptr);
+    auto *const aecs_ptr   = static_cast<hw_iaa_aecs_analytic *>(job_.aecs_ptr);
+
+    // Header pass: decode the block header alone and keep the parsed tables in the AECS
+    const auto header = own_bit_range(index_ptr[0].bit_offset, index_ptr[1].bit_offset);
+
+    memset(aecs_ptr, 0, HW_AECS_ANALYTIC_RANDOM_ACCESS_SIZE);
+
+    hw_iaa_descriptor_init_inflate_header(desc_ptr, aecs_ptr, header.ignore_end_bits, hw_aecs_access_write);
+    hw_iaa_descriptor_set_input_buffer(desc_ptr,
+                                       const_cast<uint8_t *>(src_ptr) + header.byte_offset,
+                                       header.byte_count);
+    hw_iaa_descriptor_set_output_buffer(desc_ptr, dst_ptr, length);
+
+    auto status = hw_indexed_deflate::execute();
+
+    if (QPL_STS_OK != status) {
+        return status;
+    }
+
+    // Body pass: decode the covering mini-blocks, the bits in front of the first one are skipped
+    // through the input accumulator and the bytes in front of the range are dropped by the device
+    const auto body     = own_bit_range(index_ptr[first_block + 1u].bit_offset,
+                                        index_ptr[last_block + 2u].bit_offset);
+    uint8_t    *next_ptr = const_cast<uint8_t *>(src_ptr) + body.byte_offset;
+    uint32_t   next_size = body.byte_count;
+    uint8_t    end_bits  = body.ignore_end_bits;
+
+    hw_iaa_aecs_decompress_clean_input_accumulator(&aecs_ptr->inflate_options);
+
+    if (0u != body.ignore_start_bits) {
+        if (0u != hw_iaa_aecs_decompress_set_input_accumulator(&aecs_ptr->inflate_options,
+                                                               next_ptr,
+                                                               next_size,
+                                                               body.ignore_start_bits,
+                                                               body.ignore_end_bits)) {
+            return QPL_STS_INVALID_DEFLATE_DATA_ERR;
+        }
+
+        // The accumulated byte is not read again, its end bits were applied if it was the last one
+        next_ptr++;
+        next_size--;
+        end_bits = (0u != next_size) ? end_bits : 0u;
+    }
+
+    hw_iaa_aecs_filter_set_drop_initial_decompressed_bytes(aecs_ptr,
+                                                           static_cast<uint16_t>(offset - first_block * mini_block_bytes));
+
+    hw_iaa_descriptor_init_inflate_body(desc_ptr, aecs_ptr, end_bits);
+    hw_iaa_descriptor_set_input_buffer(desc_ptr, next_ptr, next_size);
+    hw_iaa_descriptor_set_output_buffer(desc_ptr, dst_ptr, length);
+
+    status = hw_indexed_deflate::execute();
+
+    // The last mini-block usually reaches past the range, it overflows once the range is written
+    if (QPL_STS_DST_IS_SHORT_ERR == status && length == record_ptr->output_size) {
+        return QPL_STS_OK;
+    }
+
+    if (QPL_STS_OK != status) {
+        return status;
+    }
+
+    return (length == record_ptr->output_size) ? QPL_STS_OK : QPL_STS_SIZE_ERR;
+}
+
+}
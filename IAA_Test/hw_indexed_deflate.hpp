@@ -0,0 +1,105 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_INDEXED_DEFLATE_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_INDEXED_DEFLATE_HPP_
+
+#include <cstdint>
+
+#include "status.h"
+#include "hw_definitions.h"
+#include "hw_iaa_flags.h"
+#include "hw_completion_engine.hpp"
+#include "hw_job_pool.hpp"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief Entry of the mini-block index table, the layout of the 64-bit entries written by the indexing pass
+ */
+struct hw_deflate_index_t {
+    uint32_t bit_offset;    /**< Position in the compressed stream, in bits */
+    uint32_t crc;           /**< CRC32 of the data decompressed before this position */
+};
+
+static_assert(sizeof(hw_deflate_index_t) == sizeof(uint64_t), "index entries are written as 64-bit words");
+
+/**
+ * @brief Deflate compression with a mini-block index and decompression of byte ranges through that index.
+ *
+ * @details @ref compress writes one final fixed Huffman block with the mini-block flag set, so no match
+ * refers to data of another mini-block, then decodes the stream once with indexing enabled to fill the index
+ * table. A stream of N mini-blocks has N + 2 entries: the block header, the start of every mini-block and
+ * the end of the block.
+ *
+ * @ref read decodes only the mini-blocks covering the requested range. The header pass parses the block header
+ * into the AECS, the body pass starts at the first mini-block with the leading bits of its unaligned byte
+ * placed into the AECS input accumulator and drops the decompressed bytes in front of the range. History is
+ * never needed, since mini-blocks don't refer to each other.
+ *
+ * @note The object owns a completion engine and one job, each thread is expected to use its own one.
+ */
+class hw_indexed_deflate final {
+public:
+    explicit hw_indexed_deflate(hw_iaa_mini_block_size_t mini_block_size = mini_block_size_4k) noexcept;
+
+    ~hw_indexed_deflate() noexcept;
+
+    hw_indexed_deflate(const hw_indexed_deflate &) = delete;
+
+    auto operator=(const hw_indexed_deflate &) -> hw_indexed_deflate & = delete;
+
+    /**
+     * @brief Compresses the source and fills the index table
+     *
+     * @param[out] dst_size    compressed stream size
+     * @param[out] index_count number of written entries, see @ref get_index_size
+     */
+    [[nodiscard]] auto compress(const uint8_t *src_ptr,
+                                uint32_t src_size,
+                                uint8_t *dst_ptr,
+                                uint32_t dst_capacity,
+                                uint32_t &dst_size,
+                                hw_deflate_index_t *index_ptr,
+                                uint32_t index_capacity,
+                                uint32_t &index_count) noexcept -> qpl_status;
+
+    /**
+     * @brief Decompresses `length` bytes starting at `offset` of the original data into the destination
+     *
+     * @param src_ptr   stream written by @ref compress with the same mini-block size
+     * @param index_ptr index table written together with the stream
+     *
+     * @return QPL_STS_SIZE_ERR if the range is not within the original data
+     */
+    [[nodiscard]] auto read(const uint8_t *src_ptr,
+                            uint32_t src_size,
+                            const hw_deflate_index_t *index_ptr,
+                            uint32_t index_count,
+                            uint32_t offset,
+                            uint32_t length,
+                            uint8_t *dst_ptr) noexcept -> qpl_status;
+
+    [[nodiscard]] auto get_mini_block_bytes() const noexcept -> uint32_t;
+
+    [[nodiscard]] static auto get_index_size(uint32_t source_size, hw_iaa_mini_block_size_t mini_block_size) noexcept -> uint32_t;
+
+    [[nodiscard]] static auto get_compressed_size_bound(uint32_t source_size) noexcept -> uint32_t;
+
+private:
+    [[nodiscard]] auto execute() noexcept -> qpl_status;
+
+    hw_completion_engine     engine_;                                    /**< Runs the passes of one call */
+    hw_job_t                 job_             = {};                      /**< Descriptor, record and AECS of the passes */
+    hw_iaa_mini_block_size_t mini_block_size_ = mini_block_size_4k;      /**< Index granularity */
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_INDEXED_DEFLATE_HPP_
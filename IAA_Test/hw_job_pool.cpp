@@ -0,0 +1,309 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include <new>
+
+#include "hw_job_pool.hpp"
+#include "hw_dispatcher.hpp"
+#include "hw_descriptors_api.h"
+
+#define OWN_POOL_SLOT_ALIGN   64u                    /**< Alignment of every slot and of the chunk header */
+#define OWN_POOL_PAGE_SIZE    4096u                  /**< Stride used to prefault a fresh chunk */
+#define OWN_POOL_TAG_SHIFT    48u                    /**< User space pointers fit into the lower 48 bits */
+#define OWN_POOL_PTR_MASK     ((1ull << OWN_POOL_TAG_SHIFT) - 1u)
+
+static inline auto own_round_up(const size_t value, const size_t align) noexcept -> size_t {
+    return (value + align - 1u) & ~(align - 1u);
+}
+
+static inline auto own_untag(const uint64_t head) noexcept -> void * {
+    return reinterpret_cast<void *>(head & OWN_POOL_PTR_MASK);
+}
+
+static inline auto own_retag(const void *ptr, const uint64_t previous_head) noexcept -> uint64_t {
+    const uint64_t tag = (previous_head >> OWN_POOL_TAG_SHIFT) + 1u;
+
+    return reinterpret_cast<uint64_t>(ptr) | (tag << OWN_POOL_TAG_SHIFT);
+}
+
+/**
+ * @brief Free slots keep the pointer to the next free slot in their first bytes
+ */
+static inline auto own_get_next(void *slot_ptr) noexcept -> void * {
+    return __atomic_load_n(static_cast<void **>(slot_ptr), __ATOMIC_RELAXED);
+}
+
+static inline void own_set_next(void *slot_ptr, void *next_ptr) noexcept {
+    __atomic_store_n(static_cast<void **>(slot_ptr), next_ptr, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Prefers the given node for the chunk pages, failure leaves them to the first-touch policy
+ */
+static inline void own_bind_to_node(void *ptr, const size_t size, const uint32_t numa_id) noexcept {
+    unsigned long node_mask[(MAX_NUM_NUMA_NODES + 63u) / 64u] = {};
+
+    node_mask[numa_id / 64u] = 1ul << (numa_id % 64u);
+
+    syscall(SYS_mbind, ptr, size, MPOL_PREFERRED, node_mask, MAX_NUM_NUMA_NODES + 1u, 0u);
+}
+
+static inline void own_prefault(uint8_t *ptr, const size_t size) noexcept {
+    for (size_t offset = 0u; offset < size; offset += OWN_POOL_PAGE_SIZE) {
+        *reinterpret_cast<volatile uint8_t *>(ptr + offset) = 0u;
+    }
+}
+
+namespace qpl::ml::dispatcher {
+
+void hw_object_pool::init(uint32_t numa_id, uint32_t slot_size) noexcept {
+    numa_id_   = numa_id;
+    slot_size_ = static_cast<uint32_t>(own_round_up(slot_size, OWN_POOL_SLOT_ALIGN));
+}
+
+auto hw_object_pool::owner_of(const void *slot_ptr) noexcept -> hw_object_pool * {
+    const auto chunk_address = reinterpret_cast<uintptr_t>(slot_ptr) & ~(uintptr_t) (chunk_size - 1u);
+
+    return reinterpret_cast<const chunk_header_t *>(chunk_address)->owner_ptr;
+}
+
+auto hw_object_pool::grow() noexcept -> bool {
+    // Over-allocate to cut a chunk aligned to its size, so a slot finds its header by masking the address
+    const size_t map_size = 2u * chunk_size;
+    auto *raw_ptr = static_cast<uint8_t *>(mmap(nullptr, map_size, PROT_READ | PROT_WRITE,
+                                                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+
+    if (MAP_FAILED == raw_ptr) {
+        return false;
+    }
+
+    auto *chunk_ptr = reinterpret_cast<uint8_t *>(own_round_up(reinterpret_cast<uintptr_t>(raw_ptr), chunk_size));
+
+    if (chunk_ptr != raw_ptr) {
+        munmap(raw_ptr, chunk_ptr - raw_ptr);
+    }
+    munmap(chunk_ptr + chunk_size, (raw_ptr + map_size) - (chunk_ptr + chunk_size));
+
+    own_bind_to_node(chunk_ptr, chunk_size, numa_id_);
+    madvise(chunk_ptr, chunk_size, MADV_HUGEPAGE);
+    own_prefault(chunk_ptr, chunk_size);
+
+    auto *header_ptr = new(chunk_ptr) chunk_header_t{this, chunks_ptr_.load(std::memory_order_relaxed)};
+
+    while (!chunks_ptr_.compare_exchange_weak(header_ptr->next_ptr, header_ptr, std::memory_order_release)) {
+    }
+
+    uint8_t        *first_ptr  = chunk_ptr + OWN_POOL_SLOT_ALIGN;
+    const uint32_t slot_count  = static_cast<uint32_t>((chunk_size - OWN_POOL_SLOT_ALIGN) / slot_size_);
+    uint8_t        *last_ptr   = first_ptr + (size_t) (slot_count - 1u) * slot_size_;
+
+    for (uint8_t *slot_ptr = first_ptr; slot_ptr < last_ptr; slot_ptr += slot_size_) {
+        own_set_next(slot_ptr, slot_ptr + slot_size_);
+    }
+
+    hw_object_pool::push_chain(first_ptr, last_ptr);
+    chunk_count_.fetch_add(1u, std::memory_order_relaxed);
+
+    DIAG("pool numa %u: new chunk of %u slots by %u bytes\n", numa_id_, slot_count, slot_size_);
+
+    return true;
+}
+
+void hw_object_pool::push_chain(void *first_ptr, void *last_ptr) noexcept {
+    uint64_t head = free_head_.load(std::memory_order_relaxed);
+
+    do {
+        own_set_next(last_ptr, own_untag(head));
+    } while (!free_head_.compare_exchange_weak(head, own_retag(first_ptr, head),
+                                               std::memory_order_release, std::memory_order_relaxed));
+}
+
+auto hw_object_pool::pop() noexcept -> void * {
+    uint64_t head = free_head_.load(std::memory_order_acquire);
+
+    while (true) {
+        void *slot_ptr = own_untag(head);
+
+        if (nullptr == slot_ptr) {
+            // Concurrent growers may add a chunk each, which only costs memory
+            if (!hw_object_pool::grow()) {
+                return nullptr;
+            }
+
+            head = free_head_.load(std::memory_order_acquire);
+            continue;
+        }
+
+        // The slot may be popped and overwritten meanwhile, the tag makes the exchange fail in that case
+        if (free_head_.compare_exchange_weak(head, own_retag(own_get_next(slot_ptr), head),
+                                             std::memory_order_acquire, std::memory_order_acquire)) {
+            return slot_ptr;
+        }
+    }
+}
+
+void hw_object_pool::push(void *slot_ptr) noexcept {
+    hw_object_pool::push_chain(slot_ptr, slot_ptr);
+}
+
+void hw_object_pool::push(void **slots_ptr, uint32_t count) noexcept {
+    if (0u == count) {
+        return;
+    }
+
+    for (uint32_t slot_idx = 0u; slot_idx + 1u < count; slot_idx++) {
+        own_set_next(slots_ptr[slot_idx], slots_ptr[slot_idx + 1u]);
+    }
+
+    hw_object_pool::push_chain(slots_ptr[0], slots_ptr[count - 1u]);
+}
+
+auto hw_object_pool::get_reserved_bytes() const noexcept -> size_t {
+    return (size_t) chunk_count_.load(std::memory_order_relaxed) * chunk_size;
+}
+
+/**
+ * @brief Slots a thread holds for fast acquire/release, drained back to the owning pools on thread exit
+ */
+struct own_thread_cache_t {
+    static constexpr uint32_t kind_count = static_cast<uint32_t>(hw_pool_kind_t::count);
+
+    own_thread_cache_t() noexcept {
+        const auto numa_id = hw_dispatcher::get_current_numa_id();
+
+        numa_id_ = (static_cast<uint32_t>(numa_id) < MAX_NUM_NUMA_NODES) ? static_cast<uint32_t>(numa_id) : 0u;
+    }
+
+    ~own_thread_cache_t() noexcept {
+        for (uint32_t kind = 0u; kind < kind_count; kind++) {
+            for (uint32_t slot_idx = 0u; slot_idx < counts_[kind]; slot_idx++) {
+                hw_object_pool::owner_of(slots_[kind][slot_idx])->push(slots_[kind][slot_idx]);
+            }
+        }
+    }
+
+    uint32_t                                                                  numa_id_ = 0u;
+    std::array<uint32_t, kind_count>                                          counts_  = {};
+    std::array<std::array<void *, hw_job_pool::thread_cache_capacity>, kind_count> slots_ = {};
+};
+
+static thread_local own_thread_cache_t thread_cache;
+
+hw_job_pool::hw_job_pool() noexcept {
+    for (uint32_t numa_id = 0u; numa_id < max_numa_nodes; numa_id++) {
+        pools_[numa_id][static_cast<uint32_t>(hw_pool_kind_t::descriptor)].init(numa_id, sizeof(hw_descriptor));
+        pools_[numa_id][static_cast<uint32_t>(hw_pool_kind_t::completion_record)].init(numa_id,
+                                                                                       sizeof(hw_completion_record));
+        pools_[numa_id][static_cast<uint32_t>(hw_pool_kind_t::aecs)].init(numa_id, HW_AECS_ANALYTICS_SIZE);
+    }
+}
+
+auto hw_job_pool::get_instance() noexcept -> hw_job_pool & {
+    static hw_job_pool instance{};
+
+    return instance;
+}
+
+auto hw_job_pool::acquire(hw_pool_kind_t kind) noexcept -> void * {
+    const auto kind_idx = static_cast<uint32_t>(kind);
+    auto       &count   = thread_cache.counts_[kind_idx];
+    auto       &slots   = thread_cache.slots_[kind_idx];
+
+    if (0u == count) {
+        auto &pool = pools_[thread_cache.numa_id_][kind_idx];
+
+        for (void *slot_ptr = nullptr; count < thread_cache_batch && nullptr != (slot_ptr = pool.pop());) {
+            slots[count++] = slot_ptr;
+        }
+
+        if (0u == count) {
+            return nullptr;
+        }
+    }
+
+    return slots[--count];
+}
+
+void hw_job_pool::release(hw_pool_kind_t kind, void *slot_ptr) noexcept {
+    if (nullptr == slot_ptr) {
+        return;
+    }
+
+    const auto kind_idx  = static_cast<uint32_t>(kind);
+    auto       &count    = thread_cache.counts_[kind_idx];
+    auto       &slots    = thread_cache.slots_[kind_idx];
+    auto       *pool_ptr = hw_object_pool::owner_of(slot_ptr);
+
+    if (pool_ptr != &pools_[thread_cache.numa_id_][kind_idx]) {
+        pool_ptr->push(slot_ptr);
+        return;
+    }
+
+    if (thread_cache_capacity == count) {
+        count -= thread_cache_batch;
+        pool_ptr->push(&slots[count], thread_cache_batch);
+    }
+
+    slots[count++] = slot_ptr;
+}
+
+auto hw_job_pool::acquire_job(hw_job_t &job, bool with_aecs) noexcept -> qpl_status {
+    job.descriptor_ptr        = static_cast<hw_descriptor *>(hw_job_pool::acquire(hw_pool_kind_t::descriptor));
+    job.completion_record_ptr = static_cast<hw_completion_record *>(
+            hw_job_pool::acquire(hw_pool_kind_t::completion_record));
+    job.aecs_ptr              = with_aecs ? hw_job_pool::acquire(hw_pool_kind_t::aecs) : nullptr;
+
+    if (nullptr == job.descriptor_ptr || nullptr == job.completion_record_ptr || (with_aecs && nullptr == job.aecs_ptr)) {
+        hw_job_pool::release(hw_pool_kind_t::descriptor, job.descriptor_ptr);
+        hw_job_pool::release(hw_pool_kind_t::completion_record, job.completion_record_ptr);
+        hw_job_pool::release(hw_pool_kind_t::aecs, job.aecs_ptr);
+        job = {};
+
+        return QPL_STS_NO_MEM_ERR;
+    }
+
+    // Recycled slots carry the state of the previous job
+    hw_iaa_descriptor_reset(job.descriptor_ptr);
+    job.completion_record_ptr->status = AD_STATUS_INPROG;
+
+    return QPL_STS_OK;
+}
+
+auto hw_job_pool::release_job(hw_job_t &job) noexcept -> qpl_status {
+    const auto *desc_ptr = reinterpret_cast<const hw_iaa_analytics_descriptor *>(job.descriptor_ptr);
+
+    // The device still owns a submitted job until it writes the completion record
+    if (nullptr != desc_ptr
+        && desc_ptr->completion_record_ptr == reinterpret_cast<uint8_t *>(job.completion_record_ptr)
+        && AD_STATUS_INPROG == reinterpret_cast<volatile hw_completion_record *>(job.completion_record_ptr)->status) {
+        return QPL_STS_BEING_PROCESSED;
+    }
+
+    hw_job_pool::release(hw_pool_kind_t::descriptor, job.descriptor_ptr);
+    hw_job_pool::release(hw_pool_kind_t::completion_record, job.completion_record_ptr);
+    hw_job_pool::release(hw_pool_kind_t::aecs, job.aecs_ptr);
+    job = {};
+
+    return QPL_STS_OK;
+}
+
+auto hw_job_pool::get_reserved_bytes() const noexcept -> size_t {
+    size_t reserved_bytes = 0u;
+
+    for (const auto &node_pools : pools_) {
+        for (const auto &pool : node_pools) {
+            reserved_bytes += pool.get_reserved_bytes();
+        }
+    }
+
+    return reserved_bytes;
+}
+
+}
@@ -0,0 +1,134 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_JOB_POOL_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_JOB_POOL_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "status.h"
+#include "hw_devices.h"
+#include "hw_definitions.h"
+#include "hw_aecs_api.h"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief Kinds of hardware structures served by @ref hw_job_pool
+ */
+enum class hw_pool_kind_t : uint32_t {
+    descriptor = 0u,      /**< 64-byte aligned @ref hw_descriptor */
+    completion_record,    /**< 64-byte aligned @ref hw_completion_record */
+    aecs,                 /**< AECS buffer of HW_AECS_ANALYTICS_SIZE bytes */
+    count                 /**< Number of kinds */
+};
+
+/**
+ * @brief Set of structures needed to submit one job
+ */
+struct hw_job_t {
+    hw_descriptor        *descriptor_ptr        = nullptr;  /**< Job descriptor */
+    hw_completion_record *completion_record_ptr = nullptr;  /**< Record written by the device on completion */
+    hw_iaa_aecs          *aecs_ptr              = nullptr;  /**< Optional AECS, nullptr if not requested */
+};
+
+/**
+ * @brief Lock-free pool of fixed-size slots of one kind placed on one NUMA node.
+ *
+ * @details Slots are carved from 2MB-aligned chunks which are bound to the node, backed with huge pages when
+ * possible and touched at creation, so a slot never page faults on the submission path. Free slots form
+ * a Treiber stack whose head carries an ABA tag in the upper pointer bits. Chunks are never returned to the system,
+ * which keeps a racing pop that reads a stale next pointer safe.
+ */
+class hw_object_pool final {
+public:
+    static constexpr size_t chunk_size = 2u * 1024u * 1024u;  /**< Size and alignment of one backing chunk */
+
+    hw_object_pool() noexcept = default;
+
+    void init(uint32_t numa_id, uint32_t slot_size) noexcept;
+
+    [[nodiscard]] auto pop() noexcept -> void *;
+
+    void push(void *slot_ptr) noexcept;
+
+    void push(void **slots_ptr, uint32_t count) noexcept;
+
+    [[nodiscard]] auto get_reserved_bytes() const noexcept -> size_t;
+
+    [[nodiscard]] static auto owner_of(const void *slot_ptr) noexcept -> hw_object_pool *;
+
+    hw_object_pool(const hw_object_pool &) = delete;
+
+    auto operator=(const hw_object_pool &) -> hw_object_pool & = delete;
+
+private:
+    /**
+     * @brief Header placed into the first 64 bytes of each chunk
+     */
+    struct chunk_header_t {
+        hw_object_pool *owner_ptr = nullptr;  /**< Pool the chunk slots belong to */
+        chunk_header_t *next_ptr  = nullptr;  /**< Next chunk of the same pool */
+    };
+
+    [[nodiscard]] auto grow() noexcept -> bool;
+
+    void push_chain(void *first_ptr, void *last_ptr) noexcept;
+
+    std::atomic<uint64_t>        free_head_   = 0u;       /**< Tagged top of the free slot stack */
+    std::atomic<chunk_header_t*> chunks_ptr_  = nullptr;  /**< List of allocated chunks */
+    std::atomic<uint32_t>        chunk_count_ = 0u;       /**< Number of allocated chunks */
+    uint32_t                     numa_id_     = 0u;       /**< Node the chunks are bound to */
+    uint32_t                     slot_size_   = 0u;       /**< Slot size rounded to 64 bytes */
+};
+
+/**
+ * @brief Thread-caching pool of descriptors, completion records and AECS buffers.
+ *
+ * @details Each thread keeps a small cache of slots taken from the pools of its NUMA node and refills or drains it
+ * in batches, so the shared stacks are touched once per batch. Slots released by a thread of another node go
+ * straight back to the owning pool to keep their memory local to the node that allocated them.
+ */
+class hw_job_pool final {
+    static constexpr uint32_t max_numa_nodes = MAX_NUM_NUMA_NODES;
+    static constexpr uint32_t kind_count     = static_cast<uint32_t>(hw_pool_kind_t::count);
+
+public:
+    static constexpr uint32_t thread_cache_capacity = 64u;   /**< Slots of one kind a thread may keep */
+    static constexpr uint32_t thread_cache_batch    = 32u;   /**< Slots moved between a cache and a pool at once */
+
+    static auto get_instance() noexcept -> hw_job_pool &;
+
+    [[nodiscard]] auto acquire(hw_pool_kind_t kind) noexcept -> void *;
+
+    void release(hw_pool_kind_t kind, void *slot_ptr) noexcept;
+
+    [[nodiscard]] auto acquire_job(hw_job_t &job, bool with_aecs = false) noexcept -> qpl_status;
+
+    [[nodiscard]] auto release_job(hw_job_t &job) noexcept -> qpl_status;
+
+    [[nodiscard]] auto get_reserved_bytes() const noexcept -> size_t;
+
+    hw_job_pool(const hw_job_pool &) = delete;
+
+    auto operator=(const hw_job_pool &) -> hw_job_pool & = delete;
+
+protected:
+    hw_job_pool() noexcept;
+
+private:
+    std::array<std::array<hw_object_pool, kind_count>, max_numa_nodes> pools_ = {};  /**< Pools per node and kind */
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_JOB_POOL_HPP_
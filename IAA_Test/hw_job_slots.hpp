@@ -0,0 +1,139 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_JOB_SLOTS_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_JOB_SLOTS_HPP_
+
+#include <sched.h>
+#include <cstdint>
+#include <vector>
+
+#include "status.h"
+#include "hw_completion_engine.hpp"
+#include "hw_job_pool.hpp"
+#include "hw_descriptors_api.h"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief Jobs of a service that keeps several single-descriptor jobs of its own in flight.
+ *
+ * @details Every slot holds a @ref hw_job_t with an AECS from @ref hw_job_pool, next to the fields the owner
+ * tracks the job with. The jobs are acquired on the first @ref prepare and kept until the slots are destroyed.
+ * A job refused by every queue keeps its completion record in progress, so descriptors are reset before their
+ * jobs go back to the pool.
+ *
+ * @tparam slot_t slot of the owner, a `job` member of type @ref hw_job_t and defaults for the rest
+ *
+ * @note Not thread-safe, it belongs to a service that owns its completion engine.
+ */
+template <typename slot_t>
+class hw_job_slots final {
+public:
+    hw_job_slots() noexcept = default;
+
+    /**
+     * @note The owner waits for its jobs first, nothing may be in flight
+     */
+    ~hw_job_slots() noexcept {
+        hw_job_slots::release();
+    }
+
+    hw_job_slots(const hw_job_slots &) = delete;
+
+    auto operator=(const hw_job_slots &) -> hw_job_slots & = delete;
+
+    /**
+     * @brief Acquires the jobs of all slots once, later calls keep the slots as they are
+     */
+    [[nodiscard]] auto prepare(const uint32_t slot_count) noexcept -> qpl_status {
+        if (!slots_.empty()) {
+            return QPL_STS_OK;
+        }
+
+        auto &pool = hw_job_pool::get_instance();
+
+        slots_.resize(slot_count);
+
+        for (auto &slot : slots_) {
+            if (QPL_STS_OK != pool.acquire_job(slot.job, true)) {
+                hw_job_slots::release();
+
+                return QPL_STS_NO_MEM_ERR;
+            }
+        }
+
+        return QPL_STS_OK;
+    }
+
+    [[nodiscard]] auto empty() const noexcept -> bool {
+        return slots_.empty();
+    }
+
+    [[nodiscard]] auto size() const noexcept -> uint32_t {
+        return static_cast<uint32_t>(slots_.size());
+    }
+
+    [[nodiscard]] auto operator[](const size_t slot_idx) noexcept -> slot_t & {
+        return slots_[slot_idx];
+    }
+
+    [[nodiscard]] auto operator[](const size_t slot_idx) const noexcept -> const slot_t & {
+        return slots_[slot_idx];
+    }
+
+    [[nodiscard]] auto begin() noexcept -> typename std::vector<slot_t>::iterator {
+        return slots_.begin();
+    }
+
+    [[nodiscard]] auto end() noexcept -> typename std::vector<slot_t>::iterator {
+        return slots_.end();
+    }
+
+    /**
+     * @brief Waits for a job of the owner with `reap`, or gives the CPU away if none is in flight
+     *
+     * @details Nothing in flight after a submission loop means every queue refused while none of the jobs of
+     * the owner runs, so other submitters hold the devices and the owner only submits again after a yield.
+     *
+     * @return false if the thread yielded instead of reaping
+     */
+    template <typename reap_t>
+    static auto wait(const hw_completion_engine &engine, reap_t &&reap) noexcept -> bool {
+        if (0u == engine.in_flight()) {
+            sched_yield();
+            return false;
+        }
+
+        reap();
+
+        return true;
+    }
+
+private:
+    void release() noexcept {
+        auto &pool = hw_job_pool::get_instance();
+
+        for (auto &slot : slots_) {
+            if (nullptr != slot.job.descriptor_ptr) {
+                hw_iaa_descriptor_reset(slot.job.descriptor_ptr);
+            }
+
+            (void) pool.release_job(slot.job);
+        }
+
+        slots_.clear();
+    }
+
+    std::vector<slot_t> slots_;    /**< Jobs of the owner, in flight or not */
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_JOB_SLOTS_HPP_
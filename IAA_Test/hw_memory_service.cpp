@@ -0,0 +1,356 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cstring>
+
+#include "hw_memory_service.hpp"
+#include "hw_autotuner.hpp"
+#include "hw_descriptors_api.h"
+#include "hw_iaa_flags.h"
+#include "hw_status.h"
+#include "qplc_zero.h"
+
+static inline auto own_get_zero_opcode(qpl::ml::dispatcher::hw_memory_op_t operation) noexcept -> uint32_t {
+    using qpl::ml::dispatcher::hw_memory_op_t;
+
+    switch (operation) {
+        case hw_memory_op_t::zero_compress_16:
+            return QPL_OPCODE_Z_COMP16;
+        case hw_memory_op_t::zero_compress_32:
+            return QPL_OPCODE_Z_COMP32;
+        case hw_memory_op_t::zero_decompress_16:
+            return QPL_OPCODE_Z_DECOMP16;
+        default:
+            return QPL_OPCODE_Z_DECOMP32;
+    }
+}
+
+static inline auto own_get_element_width(qpl::ml::dispatcher::hw_memory_op_t operation) noexcept -> uint32_t {
+    using qpl::ml::dispatcher::hw_memory_op_t;
+
+    return (hw_memory_op_t::zero_compress_16 == operation || hw_memory_op_t::zero_decompress_16 == operation)
+           ? 16u
+           : 32u;
+}
+
+static inline auto own_is_overlapped(const qpl::ml::dispatcher::hw_memory_request_t &request) noexcept -> bool {
+    const auto src = reinterpret_cast<uintptr_t>(request.src_ptr);
+    const auto dst = reinterpret_cast<uintptr_t>(request.dst_ptr);
+
+    return src < dst + request.dst_size && dst < src + request.src_size;
+}
+
+namespace qpl::ml::dispatcher {
+
+hw_memory_service::hw_memory_service(const uint32_t max_in_flight) noexcept
+        : batches_(max_in_flight) {
+    crossover_sizes_.fill(never_offload);
+
+    // The crossovers alone decide what runs on the CPU
+    engine_.set_cpu_path(nullptr, 0u);
+}
+
+hw_memory_service::~hw_memory_service() noexcept {
+    // The batches must end before their slots are released
+    (void) hw_memory_service::wait_all();
+}
+
+void hw_memory_service::set_crossover_size(const hw_memory_op_t operation, const uint32_t size) noexcept {
+    const auto op_idx = static_cast<uint32_t>(operation);
+
+    if (op_idx < operation_count) {
+        crossover_sizes_[op_idx]  = size;
+        is_crossover_set_[op_idx] = true;
+    }
+}
+
+auto hw_memory_service::get_crossover_size(const hw_memory_op_t operation) const noexcept -> uint32_t {
+    const auto op_idx = static_cast<uint32_t>(operation);
+
+    if (op_idx >= operation_count) {
+        return never_offload;
+    }
+
+    return is_crossover_set_[op_idx] ? crossover_sizes_[op_idx] : get_measured_crossover_size(operation);
+}
+
+auto hw_memory_service::get_max_in_flight() const noexcept -> uint32_t {
+    return batches_.get_max_in_flight();
+}
+
+auto hw_memory_service::get_outstanding() const noexcept -> uint32_t {
+    return in_flight_requests_ + static_cast<uint32_t>(queued_.size());
+}
+
+auto hw_memory_service::get_output_size_bound(const hw_memory_op_t operation, const uint32_t src_size) noexcept -> uint32_t {
+    switch (operation) {
+        case hw_memory_op_t::copy:
+            return src_size;
+        case hw_memory_op_t::zero_compress_16:
+        case hw_memory_op_t::zero_compress_32:
+            return qplc_zero_compress_bound(own_get_element_width(operation), src_size);
+        default:
+            // Every element of a block may be zero, the tag alone expands to a whole block
+            return (src_size / 4u) * QPLC_ZERO_BLOCK_ELEMENTS * (own_get_element_width(operation) / 8u);
+    }
+}
+
+auto hw_memory_service::get_measured_crossover_size(const hw_memory_op_t operation) noexcept -> uint32_t {
+    // Zero compression and decompression cost the device about the same, copies are tuned apart
+    const auto tuning_op = (hw_memory_op_t::copy == operation) ? hw_tuning_op_t::copy : hw_tuning_op_t::zero_compress;
+
+    return hw_autotuner::get_instance().get_crossover_size(tuning_op);
+}
+
+auto hw_memory_service::execute_on_cpu(const hw_memory_request_t &request, uint32_t &output_size) noexcept -> qpl_status {
+    output_size = 0u;
+
+    if ((nullptr == request.src_ptr && 0u != request.src_size) || (nullptr == request.dst_ptr && 0u != request.dst_size)) {
+        return QPL_STS_NULL_PTR_ERR;
+    }
+
+    if (static_cast<uint32_t>(request.operation) >= operation_count) {
+        return QPL_STS_OPERATION_ERR;
+    }
+
+    if (hw_memory_op_t::copy == request.operation) {
+        if (request.dst_size < request.src_size) {
+            return QPL_STS_DST_IS_SHORT_ERR;
+        }
+
+        if (0u != request.src_size) {
+            memmove(request.dst_ptr, request.src_ptr, request.src_size);
+        }
+
+        output_size = request.src_size;
+
+        return QPL_STS_OK;
+    }
+
+    if (own_is_overlapped(request)) {
+        return QPL_STS_BUFFER_OVERLAP_ERR;
+    }
+
+    const uint32_t element_width = own_get_element_width(request.operation);
+    const bool     is_compress   = hw_memory_op_t::zero_compress_16 == request.operation
+                                   || hw_memory_op_t::zero_compress_32 == request.operation;
+
+    const uint32_t status = is_compress
+                            ? qplc_zero_compress(element_width, request.src_ptr, request.src_size,
+                                                 request.dst_ptr, request.dst_size, &output_size)
+                            : qplc_zero_decompress(element_width, request.src_ptr, request.src_size,
+                                                   request.dst_ptr, request.dst_size, &output_size);
+
+    switch (status) {
+        case AD_STATUS_SUCCESS:
+            return QPL_STS_OK;
+        case AD_STATUS_OUTPUT_OVERFLOW:
+            output_size = 0u;
+            return QPL_STS_DST_IS_SHORT_ERR;
+        default:
+            output_size = 0u;
+            return QPL_STS_SIZE_ERR;
+    }
+}
+
+void hw_memory_service::complete(const hw_memory_request_t &request,
+                                 const qpl_status status,
+                                 const uint32_t output_size) noexcept {
+    if (nullptr != request.callback) {
+        request.callback(request, status, output_size);
+    }
+}
+
+void hw_memory_service::complete_on_cpu(const hw_memory_request_t &request) noexcept {
+    uint32_t output_size = 0u;
+
+    const auto status = execute_on_cpu(request, output_size);
+
+    complete(request, status, output_size);
+}
+
+auto hw_memory_service::is_offloaded(const hw_memory_request_t &request) const noexcept -> bool {
+    if (0u == request.src_size || static_cast<uint32_t>(request.operation) >= operation_count) {
+        return false;
+    }
+
+    if (nullptr == request.src_ptr || nullptr == request.dst_ptr) {
+        return false;
+    }
+
+    // A move descriptor has no destination size, the device would write past a short one, the CPU path refuses it
+    if (hw_memory_op_t::copy == request.operation && request.dst_size < request.src_size) {
+        return false;
+    }
+
+    // A device move stopped half way over overlapping buffers has already changed its own source
+    if (own_is_overlapped(request)) {
+        return false;
+    }
+
+    return request.src_size >= hw_memory_service::get_crossover_size(request.operation);
+}
+
+auto hw_memory_service::submit(batch_slots_t::slot_t &slot) noexcept -> qpl_status {
+    for (uint32_t desc_idx = 0u; desc_idx < slot.count; desc_idx++) {
+        const auto &request = slot.items_ptr[desc_idx];
+
+        if (hw_memory_op_t::copy == request.operation) {
+            hw_iaa_descriptor_init_mem_copy(&slot.descs_ptr[desc_idx], request.src_ptr, request.dst_ptr, request.src_size);
+        } else {
+            hw_iaa_descriptor_init_zero_compress(&slot.descs_ptr[desc_idx],
+                                                 own_get_zero_opcode(request.operation),
+                                                 request.src_ptr,
+                                                 request.dst_ptr,
+                                                 request.src_size,
+                                                 request.dst_size);
+        }
+    }
+
+    return batches_.submit(slot, engine_);
+}
+
+auto hw_memory_service::dispatch() noexcept -> uint32_t {
+    uint32_t completed = 0u;
+
+    for (auto *slot_ptr = batches_.get_free(); !queued_.empty() && nullptr != slot_ptr; slot_ptr = batches_.get_free()) {
+        slot_ptr->count = std::min(batches_.get_batch_size(), static_cast<uint32_t>(queued_.size()));
+        std::copy(queued_.begin(), queued_.begin() + slot_ptr->count, slot_ptr->items_ptr);
+
+        const auto status = hw_memory_service::submit(*slot_ptr);
+
+        if (QPL_STS_QUEUES_ARE_BUSY_ERR == status) {
+            break;
+        }
+
+        queued_.erase(queued_.begin(), queued_.begin() + slot_ptr->count);
+
+        if (QPL_STS_OK != status) {
+            for (uint32_t desc_idx = 0u; desc_idx < slot_ptr->count; desc_idx++) {
+                complete_on_cpu(slot_ptr->items_ptr[desc_idx]);
+            }
+
+            completed += slot_ptr->count;
+        } else {
+            in_flight_requests_ += slot_ptr->count;
+        }
+    }
+
+    return completed;
+}
+
+auto hw_memory_service::reap(const bool is_blocking) noexcept -> uint32_t {
+    hw_completion_engine::reaped_t reaped[hw_completion_engine::max_in_flight];
+
+    const uint32_t reaped_count = is_blocking
+                                  ? engine_.wait_any(reaped, hw_completion_engine::max_in_flight)
+                                  : engine_.poll(reaped, hw_completion_engine::max_in_flight);
+    uint32_t       completed    = 0u;
+
+    for (uint32_t reaped_idx = 0u; reaped_idx < reaped_count; reaped_idx++) {
+        auto &slot = batch_slots_t::get_slot(reaped[reaped_idx]);
+
+        for (uint32_t desc_idx = 0u; desc_idx < slot.count; desc_idx++) {
+            const auto &request = slot.items_ptr[desc_idx];
+
+            // A descriptor the batch did not run to success is redone on the CPU, which tells the final status
+            if (QPL_STS_OK != batch_slots_t::get_status(slot, desc_idx)) {
+                complete_on_cpu(request);
+                continue;
+            }
+
+            complete(request,
+                     QPL_STS_OK,
+                     (hw_memory_op_t::copy == request.operation)
+                     ? request.src_size
+                     : batch_slots_t::get_record(slot, desc_idx).output_size);
+        }
+
+        completed           += slot.count;
+        in_flight_requests_ -= slot.count;
+        batches_.release(slot);
+    }
+
+    return completed;
+}
+
+auto hw_memory_service::submit(const hw_memory_request_t *requests_ptr,
+                               const uint32_t request_count) noexcept -> qpl_status {
+    if (nullptr == requests_ptr && 0u != request_count) {
+        return QPL_STS_NULL_PTR_ERR;
+    }
+
+    on_cpu_.clear();
+
+    for (uint32_t request_idx = 0u; request_idx < request_count; request_idx++) {
+        const auto &request = requests_ptr[request_idx];
+
+        if (hw_memory_service::is_offloaded(request)) {
+            queued_.push_back(request);
+        } else {
+            on_cpu_.push_back(request);
+        }
+    }
+
+    if (!queued_.empty() && QPL_STS_OK != batches_.prepare()) {
+        on_cpu_.insert(on_cpu_.end(), queued_.begin(), queued_.end());
+        queued_.clear();
+    }
+
+    (void) hw_memory_service::dispatch();
+
+    // Small requests are run while the batches are in flight
+    for (const auto &request : on_cpu_) {
+        complete_on_cpu(request);
+
+        if (0u != engine_.in_flight()) {
+            (void) hw_memory_service::reap(false);
+            (void) hw_memory_service::dispatch();
+        }
+    }
+
+    on_cpu_.clear();
+
+    return QPL_STS_OK;
+}
+
+auto hw_memory_service::poll() noexcept -> uint32_t {
+    uint32_t completed = 0u;
+
+    if (0u != engine_.in_flight()) {
+        completed += hw_memory_service::reap(false);
+    }
+
+    return completed + hw_memory_service::dispatch();
+}
+
+auto hw_memory_service::wait_all() noexcept -> uint32_t {
+    uint32_t completed = 0u;
+
+    while (!queued_.empty() || 0u != engine_.in_flight()) {
+        completed += hw_memory_service::dispatch();
+
+        if (0u != engine_.in_flight()) {
+            completed += hw_memory_service::reap(true);
+            continue;
+        }
+
+        // Every queue refused while none of our batches is in flight, the CPU takes the next batch
+        const auto count = std::min(static_cast<size_t>(batches_.get_batch_size()), queued_.size());
+
+        for (size_t idx = 0u; idx < count; idx++) {
+            complete_on_cpu(queued_.front());
+            queued_.pop_front();
+        }
+
+        completed += static_cast<uint32_t>(count);
+    }
+
+    return completed;
+}
+
+}
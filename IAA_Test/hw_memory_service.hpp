@@ -0,0 +1,177 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_MEMORY_SERVICE_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_MEMORY_SERVICE_HPP_
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "status.h"
+#include "hw_definitions.h"
+#include "hw_completion_engine.hpp"
+#include "hw_batch_slots.hpp"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief Operation of a memory request
+ */
+enum class hw_memory_op_t : uint32_t {
+    copy,                   /**< Moves `src_size` bytes, the destination holds at least as many */
+    zero_compress_16,       /**< Zero compression of 16-bit elements, see @ref qplc_zero_compress */
+    zero_compress_32,       /**< Zero compression of 32-bit elements */
+    zero_decompress_16,     /**< Zero decompression into 16-bit elements */
+    zero_decompress_32,     /**< Zero decompression into 32-bit elements */
+    count                   /**< Number of operations, not an operation */
+};
+
+struct hw_memory_request_t;
+
+/**
+ * @brief Called once per request when it ends, the output size is valid on success only
+ */
+using hw_memory_callback_t = void (*)(const hw_memory_request_t &request, qpl_status status, uint32_t output_size);
+
+/**
+ * @brief Memory operation on one buffer
+ */
+struct hw_memory_request_t {
+    hw_memory_op_t       operation = hw_memory_op_t::copy;   /**< Operation to run */
+    const uint8_t        *src_ptr  = nullptr;                /**< Source */
+    uint8_t              *dst_ptr  = nullptr;                /**< Destination */
+    uint32_t             src_size  = 0u;                     /**< Source size in bytes */
+    uint32_t             dst_size  = 0u;                     /**< Destination capacity in bytes */
+    hw_memory_callback_t callback  = nullptr;                /**< Completion callback, may be null */
+    void                 *user_ptr = nullptr;                /**< Passed back to the callback untouched */
+};
+
+/**
+ * @brief Asynchronous memory moves and zero compression of sparse data, on the devices or on the CPU.
+ *
+ * @details Requests are copied into the service on submission, so the caller's array may be reused right away,
+ * the buffers must stay valid until the request's callback. Requests at least as large as the crossover size of
+ * their operation are packed into batch descriptors of up to the device batch size and kept in flight, the others
+ * are run on the CPU inside @ref submit, after the batches are on their way. Requests that don't fit the free
+ * batches wait in a queue that @ref poll and @ref wait_all feed to the devices as batches complete.
+ *
+ * Unless set, the crossovers are the ones @ref hw_autotuner measured on the node of the calling thread, one for
+ * copies and one for zero compression and decompression. Without devices every request runs on the CPU.
+ *
+ * A request the device fails on, for instance with a page fault inside a batch, is redone on the CPU, which
+ * reports the final status. Copies of overlapping buffers always run on the CPU since a partly done device move
+ * can't be redone.
+ *
+ * Callbacks run on the thread calling @ref submit, @ref poll or @ref wait_all and must not call back into the
+ * service.
+ *
+ * @note The object owns a completion engine and its batches, each thread is expected to use its own one.
+ * The destructor waits for every request.
+ */
+class hw_memory_service final {
+public:
+    static constexpr uint32_t never_offload = UINT32_MAX;    /**< Crossover keeping every request on the CPU */
+
+    /**
+     * @param max_in_flight batches in progress at once, 0 picks 4 per device
+     */
+    explicit hw_memory_service(uint32_t max_in_flight = 0u) noexcept;
+
+    ~hw_memory_service() noexcept;
+
+    hw_memory_service(const hw_memory_service &) = delete;
+
+    auto operator=(const hw_memory_service &) -> hw_memory_service & = delete;
+
+    /**
+     * @brief Starts all requests, every one of them gets its callback
+     *
+     * @return QPL_STS_NULL_PTR_ERR for a null array, QPL_STS_OK otherwise, the status of each request goes to its
+     * callback
+     */
+    [[nodiscard]] auto submit(const hw_memory_request_t *requests_ptr, uint32_t request_count) noexcept -> qpl_status;
+
+    /**
+     * @brief Completes the finished requests and submits the queued ones without waiting
+     *
+     * @return Number of callbacks made
+     */
+    auto poll() noexcept -> uint32_t;
+
+    /**
+     * @brief Waits until every request is completed
+     *
+     * @return Number of callbacks made
+     */
+    auto wait_all() noexcept -> uint32_t;
+
+    /**
+     * @brief Requests submitted and not completed yet
+     */
+    [[nodiscard]] auto get_outstanding() const noexcept -> uint32_t;
+
+    /**
+     * @brief Replaces the measured crossover of the operation, @ref never_offload keeps it on the CPU
+     */
+    void set_crossover_size(hw_memory_op_t operation, uint32_t size) noexcept;
+
+    /**
+     * @brief Smallest source sent to the devices for the operation
+     */
+    [[nodiscard]] auto get_crossover_size(hw_memory_op_t operation) const noexcept -> uint32_t;
+
+    [[nodiscard]] auto get_max_in_flight() const noexcept -> uint32_t;
+
+    /**
+     * @brief Crossover @ref hw_autotuner measured for copies or for zero (de)compression on the calling node
+     */
+    [[nodiscard]] static auto get_measured_crossover_size(hw_memory_op_t operation) noexcept -> uint32_t;
+
+    /**
+     * @brief Destination size that always holds the result of the operation on the given source size
+     */
+    [[nodiscard]] static auto get_output_size_bound(hw_memory_op_t operation, uint32_t src_size) noexcept -> uint32_t;
+
+    /**
+     * @brief Runs the request on the calling thread, without the callback
+     */
+    static auto execute_on_cpu(const hw_memory_request_t &request, uint32_t &output_size) noexcept -> qpl_status;
+
+private:
+    static constexpr auto operation_count = static_cast<uint32_t>(hw_memory_op_t::count);
+
+    using batch_slots_t = hw_batch_slots<hw_memory_request_t>;    /**< Work item of a descriptor is its request */
+
+    [[nodiscard]] auto submit(batch_slots_t::slot_t &slot) noexcept -> qpl_status;
+
+    [[nodiscard]] auto is_offloaded(const hw_memory_request_t &request) const noexcept -> bool;
+
+    static void complete(const hw_memory_request_t &request, qpl_status status, uint32_t output_size) noexcept;
+
+    static void complete_on_cpu(const hw_memory_request_t &request) noexcept;
+
+    auto dispatch() noexcept -> uint32_t;
+
+    auto reap(bool is_blocking) noexcept -> uint32_t;
+
+    hw_completion_engine                   engine_;                  /**< Tracks the batches of this object */
+    batch_slots_t                          batches_;                 /**< Batches, in flight or not */
+    std::deque<hw_memory_request_t>        queued_;                  /**< Offloaded requests waiting for a slot */
+    std::vector<hw_memory_request_t>       on_cpu_;                  /**< Requests of the current submission for the CPU */
+    uint32_t                               in_flight_requests_ = 0u; /**< Requests in the batches in flight */
+    std::array<uint32_t, operation_count>  crossover_sizes_    = {}; /**< Smallest source sent to the devices per operation */
+    std::array<bool, operation_count>      is_crossover_set_   = {}; /**< Crossover was set, the measured one is not used */
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_MEMORY_SERVICE_HPP_
@@ -0,0 +1,272 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <cstring>
+#include <new>
+
+#include "hw_parallel_deflate.hpp"
+#include "hw_deflate_blocks.hpp"
+#include "hw_dispatcher.hpp"
+#include "hw_iaa_flags.h"
+#include "hw_aecs_api.h"
+#include "hw_descriptors_api.h"
+
+#define OWN_CHUNKS_PER_DEVICE       16u      /**< Default chunks in flight per device */
+
+namespace qpl::ml::dispatcher {
+
+hw_parallel_deflate::hw_parallel_deflate(uint32_t chunk_size, uint32_t max_in_flight) noexcept {
+    const auto &dispatcher = hw_dispatcher::get_instance();
+
+    is_hw_        = dispatcher.is_hw_support();
+    device_count_ = static_cast<uint32_t>(dispatcher.device_count());
+
+    // A chunk is one descriptor, so it must fit the smallest transfer any device accepts
+    for (const auto &device : dispatcher) {
+        if (chunk_size > device.get_max_transfer_size()) {
+            chunk_size = device.get_max_transfer_size();
+        }
+    }
+
+    chunk_size_     = (chunk_size < min_chunk_size) ? min_chunk_size : chunk_size;
+    chunk_capacity_ = static_cast<uint32_t>(hw_deflate_stored_size(chunk_size_));
+
+    if (0u == max_in_flight) {
+        max_in_flight = OWN_CHUNKS_PER_DEVICE * ((0u != device_count_) ? device_count_ : 1u);
+    }
+
+    // Two slots are the least that overlap a commit with the next chunk
+    max_in_flight_ = (max_in_flight < 2u) ? 2u : max_in_flight;
+    max_in_flight_ = (max_in_flight_ > hw_completion_engine::max_in_flight)
+                     ? hw_completion_engine::max_in_flight
+                     : max_in_flight_;
+
+    engine_.set_traffic_class(hw_traffic_class_t::bulk);
+}
+
+hw_parallel_deflate::~hw_parallel_deflate() noexcept {
+    // Jobs go back to the pool with the slots, once nothing is in flight
+    hw_parallel_deflate::drain();
+}
+
+void hw_parallel_deflate::set_cpu_path(hw_cpu_executor_t executor) noexcept {
+    // Chunks go to the CPU path only if the host has no devices, so the threshold doesn't matter
+    engine_.set_cpu_path(executor, UINT32_MAX);
+}
+
+auto hw_parallel_deflate::get_chunk_size() const noexcept -> uint32_t {
+    return chunk_size_;
+}
+
+auto hw_parallel_deflate::get_max_in_flight() const noexcept -> uint32_t {
+    return max_in_flight_;
+}
+
+auto hw_parallel_deflate::get_compressed_size_bound(const uint64_t source_size,
+                                                    const uint32_t chunk_size) noexcept -> uint64_t {
+    const uint64_t full_chunks = source_size / chunk_size;
+    const uint64_t tail_size   = source_size % chunk_size;
+
+    return full_chunks * hw_deflate_stored_size(chunk_size)
+           + ((0u != tail_size) ? hw_deflate_stored_size(tail_size) : 0u)
+           + hw_deflate_trailer_size;
+}
+
+auto hw_parallel_deflate::prepare() noexcept -> qpl_status {
+    if (!slots_.empty()) {
+        return QPL_STS_OK;
+    }
+
+    // Scratch and jobs are kept between calls, the pool memory is already bound and touched
+    scratch_.reset(new (std::nothrow) uint8_t[static_cast<size_t>(chunk_capacity_) * max_in_flight_]);
+
+    if (nullptr == scratch_) {
+        return QPL_STS_NO_MEM_ERR;
+    }
+
+    const auto status = slots_.prepare(max_in_flight_);
+
+    if (QPL_STS_OK != status) {
+        scratch_.reset();
+
+        return status;
+    }
+
+    for (uint32_t slot_idx = 0u; slot_idx < max_in_flight_; slot_idx++) {
+        slots_[slot_idx].scratch_ptr = scratch_.get() + static_cast<size_t>(chunk_capacity_) * slot_idx;
+    }
+
+    return QPL_STS_OK;
+}
+
+auto hw_parallel_deflate::submit(slot_t &slot, const uint8_t *src_ptr, const uint32_t src_size) noexcept -> qpl_status {
+    auto *const desc_ptr   = slot.job.descriptor_ptr;
+    auto *const record_ptr = slot.job.completion_record_ptr;
+    auto *const aecs_ptr   = static_cast<hw_iaa_aecs_compress *>(slot.job.aecs_ptr);
+
+    // Every chunk opens its own fixed block, the device appends its output to the header bits
+    memset(aecs_ptr, 0, sizeof(hw_iaa_aecs_compress));
+    (void) hw_iaa_aecs_compress_write_deflate_fixed_header(aecs_ptr, 0u);
+
+    // Output that wouldn't beat stored blocks overflows, so a tail chunk can't exceed its share of the bound
+    hw_iaa_descriptor_init_compress_body(desc_ptr);
+    hw_iaa_descriptor_init_deflate_body(desc_ptr,
+                                        const_cast<uint8_t *>(src_ptr),
+                                        src_size,
+                                        slot.scratch_ptr,
+                                        static_cast<uint32_t>(hw_deflate_stored_size(src_size)));
+    hw_iaa_descriptor_compress_set_aecs(desc_ptr, aecs_ptr, hw_aecs_access_read);
+
+    // EOB and an empty stored block end the chunk on a byte boundary, so chunks are concatenated as is
+    hw_iaa_descriptor_compress_set_termination_rule(desc_ptr, stored_end_of_block);
+
+    if (!is_hw_) {
+        return engine_.submit(desc_ptr, record_ptr, &slot);
+    }
+
+    hw_iaa_descriptor_set_completion_record(desc_ptr, record_ptr);
+    record_ptr->status = AD_STATUS_INPROG;
+
+    // Neighbouring chunks start on neighbouring devices, a device that refuses passes the chunk on
+    const auto     &dispatcher  = hw_dispatcher::get_instance();
+    const uint32_t first_device = static_cast<uint32_t>(slot.chunk_idx % device_count_);
+
+    for (uint32_t attempt = 0u; attempt < device_count_; attempt++) {
+        const auto     &device   = *(dispatcher.begin() + (first_device + attempt) % device_count_);
+        const hw_queue *queue_ptr = nullptr;
+
+        if (!device.enqueue_descriptor(desc_ptr, &queue_ptr, hw_traffic_class_t::bulk)) {
+            return engine_.track(record_ptr, &slot, queue_ptr, desc_ptr);
+        }
+    }
+
+    return QPL_STS_QUEUES_ARE_BUSY_ERR;
+}
+
+void hw_parallel_deflate::reap() noexcept {
+    hw_completion_engine::reaped_t reaped[hw_completion_engine::max_in_flight];
+
+    const uint32_t reaped_count = engine_.wait_any(reaped, hw_completion_engine::max_in_flight);
+
+    for (uint32_t reaped_idx = 0u; reaped_idx < reaped_count; reaped_idx++) {
+        auto *const slot_ptr = static_cast<slot_t *>(reaped[reaped_idx].user_ptr);
+
+        slot_ptr->status       = reaped[reaped_idx].status;
+        slot_ptr->is_completed = true;
+    }
+}
+
+void hw_parallel_deflate::drain() noexcept {
+    // Devices must stop writing into the scratch buffers before they are reused or freed
+    while (0u != engine_.in_flight()) {
+        hw_parallel_deflate::reap();
+    }
+}
+
+auto hw_parallel_deflate::compress(const uint8_t *src_ptr,
+                                   const uint64_t src_size,
+                                   uint8_t *dst_ptr,
+                                   const uint64_t dst_capacity,
+                                   uint64_t &dst_size) noexcept -> qpl_status {
+    if ((nullptr == src_ptr && 0u != src_size) || nullptr == dst_ptr) {
+        return QPL_STS_NULL_PTR_ERR;
+    }
+
+    auto status = hw_parallel_deflate::prepare();
+
+    if (QPL_STS_OK != status) {
+        return status;
+    }
+
+    const uint64_t chunk_count = (src_size + chunk_size_ - 1u) / chunk_size_;
+    uint8_t        *out_ptr    = dst_ptr;
+    uint8_t *const end_ptr     = dst_ptr + dst_capacity;
+    uint64_t       next_submit = 0u;
+    uint64_t       next_commit = 0u;
+
+    while (next_commit < chunk_count) {
+        // Slots are taken in chunk order, a slot is free again once its chunk is committed
+        while (next_submit < chunk_count && next_submit - next_commit < max_in_flight_) {
+            auto           &slot      = slots_[next_submit % max_in_flight_];
+            const uint64_t offset     = next_submit * chunk_size_;
+            const auto     chunk_size = static_cast<uint32_t>((src_size - offset < chunk_size_)
+                                                              ? src_size - offset
+                                                              : chunk_size_);
+
+            slot.chunk_idx    = next_submit;
+            slot.is_completed = false;
+
+            status = hw_parallel_deflate::submit(slot, src_ptr + offset, chunk_size);
+
+            if (QPL_STS_QUEUES_ARE_BUSY_ERR == status) {
+                break;
+            }
+
+            if (QPL_STS_OK != status) {
+                hw_parallel_deflate::drain();
+                return status;
+            }
+
+            next_submit++;
+        }
+
+        while (next_commit < next_submit && slots_[next_commit % max_in_flight_].is_completed) {
+            const auto     &slot      = slots_[next_commit % max_in_flight_];
+            const uint64_t offset     = next_commit * chunk_size_;
+            const auto     chunk_size = static_cast<uint32_t>((src_size - offset < chunk_size_)
+                                                              ? src_size - offset
+                                                              : chunk_size_);
+
+            if (QPL_STS_OK == slot.status) {
+                const auto *record_ptr = reinterpret_cast<const hw_iaa_completion_record *>(
+                        slot.job.completion_record_ptr);
+
+                if (record_ptr->output_size > static_cast<uint64_t>(end_ptr - out_ptr)) {
+                    hw_parallel_deflate::drain();
+                    return QPL_STS_DST_IS_SHORT_ERR;
+                }
+
+                memcpy(out_ptr, slot.scratch_ptr, record_ptr->output_size);
+                out_ptr += record_ptr->output_size;
+            } else if (QPL_STS_DST_IS_SHORT_ERR == slot.status) {
+                // Incompressible chunk, stored blocks take no more than the device was allowed to
+                if (hw_deflate_stored_size(chunk_size) > static_cast<uint64_t>(end_ptr - out_ptr)) {
+                    hw_parallel_deflate::drain();
+                    return QPL_STS_DST_IS_SHORT_ERR;
+                }
+
+                out_ptr = hw_deflate_write_stored_blocks(out_ptr, src_ptr + offset, chunk_size);
+            } else {
+                hw_parallel_deflate::drain();
+                return slot.status;
+            }
+
+            next_commit++;
+        }
+
+        if (next_commit == chunk_count) {
+            break;
+        }
+
+        (void) hw_job_slots<slot_t>::wait(engine_, [this] { hw_parallel_deflate::reap(); });
+    }
+
+    if (hw_deflate_trailer_size > static_cast<uint64_t>(end_ptr - out_ptr)) {
+        return QPL_STS_DST_IS_SHORT_ERR;
+    }
+
+    // Empty final fixed block closes the stream, also the whole stream of an empty source
+    hw_iaa_aecs_compress trailer_aecs;
+
+    memset(&trailer_aecs, 0, sizeof(trailer_aecs));
+    out_ptr = hw_deflate_write_trailer(trailer_aecs, out_ptr);
+
+    dst_size = static_cast<uint64_t>(out_ptr - dst_ptr);
+
+    return QPL_STS_OK;
+}
+
+}
@@ -0,0 +1,115 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_PARALLEL_DEFLATE_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_PARALLEL_DEFLATE_HPP_
+
+#include <cstdint>
+#include <memory>
+
+#include "status.h"
+#include "hw_definitions.h"
+#include "hw_completion_engine.hpp"
+#include "hw_job_slots.hpp"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief Compresses one large buffer into a single raw deflate stream using every device and WQ at once.
+ *
+ * @details The source is cut into chunks that are compressed independently, each one with its own descriptor
+ * and AECS. A chunk starts with a fixed Huffman block header written into the AECS output accumulator and is
+ * terminated with @ref hw_iaa_terminator_t::stored_end_of_block, so its output ends on a byte boundary and chunk
+ * outputs are stitched by plain concatenation. Chunks are spread round-robin over the devices and copied to the
+ * destination strictly in chunk order as they complete. The stream is closed by an empty final block built on
+ * the host and flushed from an AECS accumulator.
+ *
+ * A chunk the device can't fit into its stored size is written as stored blocks instead, so the result never
+ * exceeds @ref get_compressed_size_bound. Matches never cross a chunk boundary, which costs some ratio
+ * on small chunks.
+ *
+ * @note The object owns a completion engine and scratch buffers, each thread is expected to use its own one.
+ */
+class hw_parallel_deflate final {
+public:
+    static constexpr uint32_t default_chunk_size = 1024u * 1024u;    /**< Source bytes per descriptor */
+    static constexpr uint32_t min_chunk_size     = 4096u;            /**< Smaller chunks cost more ratio than they pay */
+
+    /**
+     * @param chunk_size    source bytes per descriptor, clamped to the device max transfer size
+     * @param max_in_flight chunks in progress at once, 0 picks 16 per device
+     */
+    explicit hw_parallel_deflate(uint32_t chunk_size = default_chunk_size, uint32_t max_in_flight = 0u) noexcept;
+
+    ~hw_parallel_deflate() noexcept;
+
+    hw_parallel_deflate(const hw_parallel_deflate &) = delete;
+
+    auto operator=(const hw_parallel_deflate &) -> hw_parallel_deflate & = delete;
+
+    /**
+     * @brief Compresses the whole source into a complete raw deflate stream, no zlib or gzip wrapper is added
+     *
+     * @param[out] dst_size number of bytes written to the destination, valid on success only
+     *
+     * @return QPL_STS_DST_IS_SHORT_ERR if the destination is smaller than needed, the first chunk error otherwise
+     */
+    [[nodiscard]] auto compress(const uint8_t *src_ptr,
+                                uint64_t src_size,
+                                uint8_t *dst_ptr,
+                                uint64_t dst_capacity,
+                                uint64_t &dst_size) noexcept -> qpl_status;
+
+    /**
+     * @brief Replaces the CPU path of the internal engine, see hw_completion_engine::set_cpu_path()
+     */
+    void set_cpu_path(hw_cpu_executor_t executor) noexcept;
+
+    [[nodiscard]] auto get_chunk_size() const noexcept -> uint32_t;
+
+    [[nodiscard]] auto get_max_in_flight() const noexcept -> uint32_t;
+
+    /**
+     * @brief Destination size that is always enough to compress a source of the given size
+     */
+    [[nodiscard]] static auto get_compressed_size_bound(uint64_t source_size, uint32_t chunk_size) noexcept -> uint64_t;
+
+private:
+    /**
+     * @brief Chunk in progress, slots are reused in chunk order once their output is committed
+     */
+    struct slot_t {
+        hw_job_t  job            = {};            /**< Descriptor, completion record and AECS of the chunk */
+        uint8_t   *scratch_ptr   = nullptr;       /**< Device output of the chunk */
+        uint64_t  chunk_idx      = 0u;            /**< Chunk the slot is used by */
+        bool      is_completed   = false;         /**< Completion record was reaped */
+        qpl_status status        = QPL_STS_OK;    /**< Reaped status */
+    };
+
+    [[nodiscard]] auto prepare() noexcept -> qpl_status;
+
+    [[nodiscard]] auto submit(slot_t &slot, const uint8_t *src_ptr, uint32_t src_size) noexcept -> qpl_status;
+
+    void reap() noexcept;
+
+    void drain() noexcept;
+
+    hw_completion_engine       engine_;                               /**< Tracks the chunks of this object */
+    hw_job_slots<slot_t>       slots_;                                /**< Ring of in-flight chunks */
+    std::unique_ptr<uint8_t[]> scratch_;                              /**< Device output buffers of all slots */
+    uint32_t                   chunk_size_           = 0u;            /**< Source bytes per descriptor */
+    uint32_t                   chunk_capacity_       = 0u;            /**< Output bytes of one slot */
+    uint32_t                   max_in_flight_        = 0u;            /**< Number of slots */
+    uint32_t                   device_count_         = 0u;            /**< Devices chunks are spread over */
+    bool                       is_hw_                = false;         /**< Submit to the devices directly */
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_PARALLEL_DEFLATE_HPP_
@@ -0,0 +1,399 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string.h>
+#include <algorithm>
+#include <new>
+#include <utility>
+
+#include "hw_queue.hpp"
+#include "hw_configuration_driver.h"
+#include "hw_emulator.hpp"
+#include "hw_arbiter.hpp"
+
+#define QPL_HWSTS_RET(expr, err_code) { if( expr ) { return( err_code ); }}
+
+/**
+ * @brief Portal slot cursor of the calling thread, threads start 1/8 of the portal page apart
+ */
+static inline auto own_portal_cursor() noexcept -> uint64_t & {
+    static std::atomic<uint64_t> next_seed = 0u;
+    static thread_local uint64_t cursor    = next_seed.fetch_add(1u, std::memory_order_relaxed) * 8u;
+
+    return cursor;
+}
+
+/**
+ * @brief Identifies the calling thread while it is alive
+ */
+static inline auto own_thread_token() noexcept -> uintptr_t {
+    static thread_local char token = 0;
+
+    return reinterpret_cast<uintptr_t>(&token);
+}
+
+namespace qpl::ml::dispatcher {
+
+hw_queue::hw_queue(hw_queue &&other) noexcept {
+    *this = std::move(other);
+}
+
+auto hw_queue::operator=(hw_queue &&other) noexcept -> hw_queue & {
+    block_on_fault_    = other.block_on_fault_;
+    max_batch_size_    = other.max_batch_size_;
+    size_              = other.size_;
+    max_transfer_size_ = other.max_transfer_size_;
+    in_flight_         = 0u;
+    priority_          = other.priority_;
+    portal_offset_     = other.portal_offset_;
+    portal_ptr_        = other.portal_ptr_.exchange(nullptr, std::memory_order_acq_rel);
+    is_emulated_       = other.is_emulated_;
+    is_dedicated_      = other.is_dedicated_;
+    owner_             = 0u;
+    arbiter_tag_       = 0u;
+
+    std::swap(counters_ptr_, other.counters_ptr_);
+
+    memcpy(portal_path_, other.portal_path_, sizeof(portal_path_));
+
+    return *this;
+}
+
+hw_queue::~hw_queue() noexcept {
+    // Freeing resources
+    void *portal_ptr = portal_ptr_.exchange(nullptr, std::memory_order_acq_rel);
+
+    if (nullptr != portal_ptr && MAP_FAILED != portal_ptr && !is_emulated_) {
+        munmap(portal_ptr, 0x1000u);
+    }
+
+    delete counters_ptr_;
+}
+
+void hw_queue::allocate_counters() noexcept {
+    // Queues that are never initialized don't carry the counter shards
+    if (nullptr == counters_ptr_) {
+        counters_ptr_ = new (std::nothrow) hw_queue_counters();
+    }
+}
+
+void hw_queue::record_completion(hw_operation_status status, uint64_t submit_ticks) const noexcept {
+    if (nullptr != counters_ptr_) {
+        status &= STATUS_MASK;
+        counters_ptr_->record_completion(AD_STATUS_SUCCESS == status, AD_STATUS_PAGE_FAULT == status, submit_ticks);
+    }
+}
+
+auto hw_queue::get_arbiter_tag() const noexcept -> uint32_t {
+    return arbiter_tag_.load(std::memory_order_relaxed);
+}
+
+void hw_queue::set_arbiter_tag(const uint32_t tag) const noexcept {
+    arbiter_tag_.store(tag, std::memory_order_relaxed);
+}
+
+void hw_queue::get_stats(hw_queue_stats_t &stats) const noexcept {
+    if (nullptr != counters_ptr_) {
+        counters_ptr_->collect(stats);
+    } else {
+        stats = {};
+    }
+}
+
+void hw_queue::set_portal_ptr(void *value_ptr) noexcept {
+    portal_offset_ = reinterpret_cast<uint64_t>(value_ptr) & OWN_PAGE_MASK;
+    portal_ptr_.store(value_ptr, std::memory_order_release);
+}
+
+auto hw_queue::get_portal_ptr() const noexcept -> void * {
+    const auto portal_mask = reinterpret_cast<uint64_t>(portal_ptr_.load(std::memory_order_acquire)) & (~OWN_PAGE_MASK);
+
+    // The slot only spreads the writes over the portal page, so a thread-local cursor does as well as a shared one
+    uint64_t offset = portal_offset_ + own_portal_cursor()++;
+    offset = (offset << 6) & OWN_PAGE_MASK;
+    return reinterpret_cast<void *>(offset | portal_mask);
+}
+
+auto hw_queue::get_portal_path() const noexcept -> const char * {
+    return portal_path_;
+}
+
+auto hw_queue::map_portal() const noexcept -> void * {
+    void *region_ptr = MAP_FAILED;
+
+    if (is_emulated_) {
+        void *ring_ptr = hw_emulator::get_instance().open_portal(portal_path_);
+        region_ptr = (nullptr != ring_ptr) ? ring_ptr : MAP_FAILED;
+    } else {
+        auto fd = open(portal_path_, O_RDWR);
+
+        if (0 <= fd) {
+            region_ptr = mmap(nullptr, 0x1000u, PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, 0);
+            close(fd);
+        }
+    }
+
+    DIAG("%s: portal %s\n", portal_path_, (MAP_FAILED != region_ptr) ? "mapped" : "mapping failed");
+
+    // Threads racing for the first submission keep the mapping that was published first
+    void *expected_ptr = nullptr;
+
+    if (!portal_ptr_.compare_exchange_strong(expected_ptr, region_ptr, std::memory_order_acq_rel)) {
+        if (MAP_FAILED != region_ptr) {
+            munmap(region_ptr, 0x1000u);
+        }
+
+        return expected_ptr;
+    }
+
+    return region_ptr;
+}
+
+auto hw_queue::enqueue_descriptor(void *desc_ptr) const noexcept -> qpl_status {
+    uint8_t retry = 0u;
+
+    void *portal_ptr = portal_ptr_.load(std::memory_order_acquire);
+
+    // Only the owner may submit to a dedicated queue, and only while it holds a credit
+    if (is_dedicated_) {
+        if (!hw_queue::is_owned_by_caller()) {
+            return QPL_STS_QUEUES_ARE_BUSY_ERR;
+        }
+
+        if (hw_queue::get_in_flight() >= size_) {
+            if (nullptr != counters_ptr_) {
+                counters_ptr_->record_submission(false);
+            }
+
+            return QPL_STS_QUEUES_ARE_BUSY_ERR;
+        }
+    } else if (!hw_arbiter::get_instance().is_admitted(*this)) {
+        // Process is over its share of a busy queue, the other processes get the free entries
+        return QPL_STS_QUEUES_ARE_BUSY_ERR;
+    }
+
+    if (nullptr == portal_ptr) {
+        portal_ptr = hw_queue::map_portal();
+    }
+
+    // Queue whose portal can't be mapped refuses every descriptor
+    if (MAP_FAILED == portal_ptr) {
+        return QPL_STS_INIT_WORK_QUEUES_NOT_AVAILABLE;
+    }
+
+    if (is_emulated_) {
+        retry = static_cast<hw_emulated_portal *>(portal_ptr)->enqueue(desc_ptr) ? 0u : 1u;
+    } else if (is_dedicated_) {
+        void *current_place_ptr = get_portal_ptr();
+        asm volatile("sfence\t\n"
+                     ".byte 0x66, 0x0f, 0x38, 0xf8, 0x02\t\n"
+        : : "a" (current_place_ptr), "d" (desc_ptr) : "memory");
+    } else {
+        void *current_place_ptr = get_portal_ptr();
+        asm volatile("sfence\t\n"
+                     ".byte 0xf2, 0x0f, 0x38, 0xf8, 0x02\t\n"
+                     "setz %0\t\n"
+        : "=r"(retry) : "a" (current_place_ptr), "d" (desc_ptr) : "memory");
+    }
+
+    if (nullptr != counters_ptr_) {
+        counters_ptr_->record_submission(0u == retry);
+    }
+
+    return static_cast<qpl_status>(retry);
+}
+
+auto hw_queue::initialize_new_queue(void *wq_descriptor_ptr) noexcept -> hw_accelerator_status {
+
+    auto *work_queue_ptr        = reinterpret_cast<accfg_wq *>(wq_descriptor_ptr);
+#ifdef LOG_HW_INIT
+    auto work_queue_dev_name    = hw_work_queue_get_device_name(work_queue_ptr);
+#endif
+
+    if (ACCFG_WQ_ENABLED != hw_work_queue_get_state(work_queue_ptr)) {
+        DIAG("     %7s: DISABLED\n", work_queue_dev_name);
+        return HW_ACCELERATOR_WORK_QUEUES_NOT_AVAILABLE;
+    }
+
+    const auto mode = hw_work_queue_get_mode(work_queue_ptr);
+
+    if (ACCFG_WQ_SHARED != mode && ACCFG_WQ_DEDICATED != mode) {
+        DIAG("     %7s: UNSUPPOTED\n", work_queue_dev_name);
+        return HW_ACCELERATOR_WORK_QUEUES_NOT_AVAILABLE;
+    }
+
+    DIAG("     %7s:\n", work_queue_dev_name);
+    auto status = hw_work_queue_get_device_path(work_queue_ptr, portal_path_, sizeof(portal_path_) - 1u);
+    QPL_HWSTS_RET((0 > status), HW_ACCELERATOR_LIBACCEL_ERROR);
+
+    // The portal itself is mapped on the first submission, here only the access is checked
+    is_emulated_ = hw_emulator::is_emulated_path(portal_path_);
+
+    DIAG("     %7s: checking descriptor %s", work_queue_dev_name, portal_path_);
+    if (!is_emulated_ && 0 != access(portal_path_, R_OK | W_OK))
+    {
+        DIAGA(", access denied\n");
+        return HW_ACCELERATOR_LIBACCEL_ERROR;
+    }
+    DIAGA("\n");
+
+    is_dedicated_      = ACCFG_WQ_DEDICATED == mode;
+    priority_          = hw_work_queue_get_priority(work_queue_ptr);
+    block_on_fault_    = hw_work_queue_get_block_on_fault(work_queue_ptr);
+    max_batch_size_    = hw_work_queue_get_max_batch_size(work_queue_ptr);
+    size_              = static_cast<uint32_t>(hw_work_queue_get_size(work_queue_ptr));
+    max_transfer_size_ = hw_work_queue_get_max_transfer_size(work_queue_ptr);
+
+#if 0
+    DIAG("     %7s: size:        %d\n", work_queue_dev_name, accfg_wq_get_size(work_queue_ptr));
+    DIAG("     %7s: threshold:   %d\n", work_queue_dev_name, accfg_wq_get_threshold(work_queue_ptr));
+    DIAG("     %7s: priority:    %d\n", work_queue_dev_name, priority_);
+    DIAG("     %7s: group:       %d\n", work_queue_dev_name, group_id);
+
+    for(struct accfg_engine *engine = accfg_engine_get_first(device_ptr);
+            engine != NULL; engine = accfg_engine_get_next(engine))
+    {
+        if(accfg_engine_get_group_id(engine) == group_id)
+            DIAG("            %s\n", accfg_engine_get_devname(engine));
+    }
+#else
+    DIAG("     %7s: priority:    %d\n", work_queue_dev_name, priority_);
+    DIAG("     %7s: bof:         %d\n", work_queue_dev_name, block_on_fault_);
+    DIAG("     %7s: mode:        %s\n", work_queue_dev_name, is_dedicated_ ? "dedicated" : "shared");
+    DIAG("     %7s: batch size:  %u\n", work_queue_dev_name, max_batch_size_);
+    DIAG("     %7s: size:        %u\n", work_queue_dev_name, size_);
+    DIAG("     %7s: transfer:    %lu\n", work_queue_dev_name, max_transfer_size_);
+#endif
+
+    hw_queue::allocate_counters();
+
+    return HW_ACCELERATOR_STATUS_OK;
+}
+
+auto hw_queue::initialize_from_record(const hw_queue_record_t &record) noexcept -> hw_accelerator_status {
+    // Permissions of the process that wrote the snapshot may differ
+    if (0 != access(record.portal_path, R_OK | W_OK)) {
+        DIAG("%s: access denied\n", record.portal_path);
+        return HW_ACCELERATOR_WORK_QUEUES_NOT_AVAILABLE;
+    }
+
+    memcpy(portal_path_, record.portal_path, sizeof(portal_path_));
+    portal_path_[sizeof(portal_path_) - 1u] = '\0';
+
+    priority_          = record.priority;
+    block_on_fault_    = 0u != record.block_on_fault;
+    is_dedicated_      = 0u != record.is_dedicated;
+    max_batch_size_    = record.max_batch_size;
+    size_              = record.size;
+    max_transfer_size_ = record.max_transfer_size;
+
+    hw_queue::allocate_counters();
+
+    return HW_ACCELERATOR_STATUS_OK;
+}
+
+void hw_queue::fill_record(hw_queue_record_t &record) const noexcept {
+    record = {};
+
+    memcpy(record.portal_path, portal_path_, sizeof(record.portal_path));
+
+    record.priority          = priority_;
+    record.block_on_fault    = block_on_fault_ ? 1u : 0u;
+    record.is_dedicated      = is_dedicated_ ? 1u : 0u;
+    record.max_batch_size    = max_batch_size_;
+    record.size              = size_;
+    record.max_transfer_size = max_transfer_size_;
+}
+
+auto hw_queue::priority() const noexcept -> int32_t {
+    return priority_;
+}
+
+auto hw_queue::get_block_on_fault() const noexcept -> bool {
+    return block_on_fault_;
+}
+
+auto hw_queue::is_dedicated() const noexcept -> bool {
+    return is_dedicated_;
+}
+
+auto hw_queue::acquire() const noexcept -> bool {
+    if (!is_dedicated_) {
+        return false;
+    }
+
+    const uintptr_t token    = own_thread_token();
+    uintptr_t       expected = 0u;
+
+    return owner_.compare_exchange_strong(expected, token, std::memory_order_acquire) || token == expected;
+}
+
+void hw_queue::release() const noexcept {
+    uintptr_t expected = own_thread_token();
+
+    (void) owner_.compare_exchange_strong(expected, 0u, std::memory_order_release);
+}
+
+auto hw_queue::is_owned_by_caller() const noexcept -> bool {
+    return own_thread_token() == owner_.load(std::memory_order_relaxed);
+}
+
+auto hw_queue::get_max_batch_size() const noexcept -> uint32_t {
+    return max_batch_size_;
+}
+
+auto hw_queue::get_size() const noexcept -> uint32_t {
+    return size_;
+}
+
+auto hw_queue::get_max_transfer_size() const noexcept -> uint64_t {
+    return max_transfer_size_;
+}
+
+auto hw_queue::get_in_flight() const noexcept -> uint32_t {
+    return in_flight_.load(std::memory_order_relaxed);
+}
+
+auto hw_queue::get_occupancy() const noexcept -> uint32_t {
+    uint32_t in_flight = hw_queue::get_in_flight();
+
+    // Jobs of the other processes fill a shared queue as well
+    if (!is_dedicated_) {
+        (void) hw_arbiter::get_instance().get_global_in_flight(*this, in_flight);
+    }
+
+    // Fixed point fraction of the WQ entries in use
+    const uint32_t size = (0u != size_) ? size_ : 1u;
+    in_flight = std::min(in_flight, size);
+
+    return in_flight * occupancy_full / size;
+}
+
+void hw_queue::increment_in_flight() const noexcept {
+    in_flight_.fetch_add(1u, std::memory_order_relaxed);
+
+    if (!is_dedicated_) {
+        hw_arbiter::get_instance().on_submit(*this);
+    }
+}
+
+void hw_queue::decrement_in_flight() const noexcept {
+    uint32_t in_flight = in_flight_.load(std::memory_order_relaxed);
+
+    while (0u != in_flight
+           && !in_flight_.compare_exchange_weak(in_flight, in_flight - 1u, std::memory_order_relaxed)) {
+    }
+
+    if (0u != in_flight && !is_dedicated_) {
+        hw_arbiter::get_instance().on_complete(*this);
+    }
+}
+
+}
@@ -11,13 +11,41 @@
 
 #include "status.h"
 #include "hw_status.h"
+#include "hw_topology.hpp"
+#include "hw_queue_stats.hpp"
 
 namespace qpl::ml::dispatcher {
 
-class hw_queue {
+/**
+ * @brief Shared or dedicated work queue of a device.
+ *
+ * @details The portal is mapped on the first submission to the queue rather than on initialization, so processes
+ * that never submit to a queue don't pay for opening and mapping its character device.
+ * Queues of @ref hw_emulator devices have an `emulated:` path, their portal is a ring the emulated engines
+ * serve and submission copies the descriptor into it instead of issuing ENQCMD.
+ * Every initialized queue owns @ref hw_queue_counters: ENQCMD results are counted on submission, completions
+ * are counted by the completion engine that tracked them through @ref record_completion.
+ *
+ * Queues are cache-line aligned and keep nothing that every submission writes: the portal slot comes from a
+ * per-thread cursor and the in-flight counter has a line of its own, so threads submitting to different
+ * queues never share a line and threads sharing a queue only read the line with its configuration.
+ *
+ * A dedicated queue takes descriptors through MOVDIR64B, which never reports a refusal: a descriptor written
+ * into a full queue is dropped. The queue is therefore submitted to by one thread only, the one that took it
+ * with @ref acquire, and that thread counts the free entries itself. The in-flight counter is the credit
+ * count, so every descriptor accepted by a dedicated queue must be followed by @ref increment_in_flight and
+ * its completion reported through @ref decrement_in_flight, as the completion engine does for tracked jobs.
+ *
+ * While the process is attached to @ref hw_arbiter, a shared queue takes a descriptor only if the arbiter admits
+ * it, the in-flight changes are published to the other processes, and @ref get_occupancy reports the occupancy
+ * of the queue across all of them.
+ */
+class alignas(64) hw_queue {
 public:
     using descriptor_t = void;
 
+    static constexpr uint32_t occupancy_full = 1024u;   /**< @ref get_occupancy value of a queue with all entries in use */
+
     hw_queue() noexcept = default;
 
     hw_queue(const hw_queue &) noexcept = delete;
@@ -30,24 +58,88 @@ public:
 
     auto initialize_new_queue(descriptor_t *wq_descriptor_ptr) noexcept -> hw_accelerator_status;
 
+    auto initialize_from_record(const hw_queue_record_t &record) noexcept -> hw_accelerator_status;
+
+    void fill_record(hw_queue_record_t &record) const noexcept;
+
     [[nodiscard]] auto get_portal_ptr() const noexcept -> void *;
 
+    [[nodiscard]] auto get_portal_path() const noexcept -> const char *;
+
     [[nodiscard]] auto enqueue_descriptor(void *desc_ptr) const noexcept -> qpl_status;
 
     [[nodiscard]] auto priority() const noexcept -> int32_t;
 
     [[nodiscard]] auto get_block_on_fault() const noexcept -> bool;
 
+    [[nodiscard]] auto is_dedicated() const noexcept -> bool;
+
+    /**
+     * @brief Makes the calling thread the only submitter of a dedicated queue
+     *
+     * @return false if the queue is shared or another thread owns it, true if the caller owns it already
+     */
+    [[nodiscard]] auto acquire() const noexcept -> bool;
+
+    /**
+     * @brief Gives up the ownership taken by @ref acquire, jobs in flight keep their credits until completed
+     */
+    void release() const noexcept;
+
+    [[nodiscard]] auto is_owned_by_caller() const noexcept -> bool;
+
+    [[nodiscard]] auto get_max_batch_size() const noexcept -> uint32_t;
+
+    [[nodiscard]] auto get_size() const noexcept -> uint32_t;
+
+    [[nodiscard]] auto get_max_transfer_size() const noexcept -> uint64_t;
+
+    [[nodiscard]] auto get_in_flight() const noexcept -> uint32_t;
+
+    [[nodiscard]] auto get_occupancy() const noexcept -> uint32_t;
+
+    void increment_in_flight() const noexcept;
+
+    void decrement_in_flight() const noexcept;
+
     void set_portal_ptr(void *portal_ptr) noexcept;
 
+    void record_completion(hw_operation_status status, uint64_t submit_ticks) const noexcept;
+
+    /**
+     * @brief Slot of the queue in the @ref hw_arbiter segment as the arbiter caches it, 0 if not resolved
+     */
+    [[nodiscard]] auto get_arbiter_tag() const noexcept -> uint32_t;
+
+    void set_arbiter_tag(uint32_t tag) const noexcept;
+
+    /**
+     * @brief Merges the counter shards of the queue, a queue that was not initialized reports zeros
+     */
+    void get_stats(hw_queue_stats_t &stats) const noexcept;
+
     virtual ~hw_queue() noexcept;
 
 private:
-    bool                          block_on_fault_ = false;
-    int32_t                       priority_       = 0u;
-    uint64_t                      portal_mask_    = 0u;      /**< Mask for incrementing portals */
-    mutable void                  *portal_ptr_    = nullptr;
-    mutable std::atomic<uint64_t> portal_offset_  = 0u;      /**< Portal for enqcmd (mod page size)*/
+    [[nodiscard]] auto map_portal() const noexcept -> void *;
+
+    void allocate_counters() noexcept;
+
+    bool                           block_on_fault_    = false;
+    int32_t                        priority_          = 0u;
+    uint32_t                       max_batch_size_    = 0u;      /**< Max descriptors in a batch, less than 2 if not supported */
+    uint32_t                       size_              = 0u;      /**< Number of WQ entries */
+    uint64_t                       max_transfer_size_ = 0u;      /**< Largest transfer size the WQ accepts */
+    mutable std::atomic<void *>    portal_ptr_        = nullptr; /**< Mapped portal, MAP_FAILED if mapping failed */
+    uint64_t                       portal_offset_     = 0u;      /**< First portal slot for enqcmd (mod page size) */
+    char                           portal_path_[64]   = {};      /**< Character device the portal is mapped from */
+    hw_queue_counters              *counters_ptr_     = nullptr; /**< Owned counters, nullptr if not initialized */
+    bool                           is_emulated_       = false;   /**< Portal is a @ref hw_emulator ring */
+    bool                           is_dedicated_      = false;   /**< Dedicated WQ, submitted to with MOVDIR64B */
+    mutable std::atomic<uintptr_t> owner_             = 0u;      /**< Token of the thread owning a dedicated WQ, 0 if none */
+    mutable std::atomic<uint32_t>  arbiter_tag_       = 0u;      /**< See @ref get_arbiter_tag */
+
+    alignas(64) mutable std::atomic<uint32_t> in_flight_ = 0u;  /**< Tracked descriptors that are not completed yet */
 };
 
 }
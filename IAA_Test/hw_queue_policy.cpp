@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <array>
+#include <algorithm>
+
+#include "hw_queue_policy.hpp"
+#include "hw_devices.h"
+
+#define OWN_WQ_MAX_PRIORITY     15u   /**< Highest priority a WQ can be configured with */
+#define OWN_WQ_PRIORITY_WEIGHT  32u   /**< Cost of one priority level, in hw_queue::occupancy_full units */
+
+namespace qpl::ml::dispatcher {
+
+auto hw_round_robin_queue_policy(const hw_queue *,
+                                 uint32_t queue_count,
+                                 uint64_t,
+                                 uint32_t cursor,
+                                 uint32_t *order_ptr) noexcept -> uint32_t {
+    for (uint32_t try_idx = 0u; try_idx < queue_count; try_idx++) {
+        order_ptr[try_idx] = (cursor + try_idx) % queue_count;
+    }
+
+    return queue_count;
+}
+
+auto hw_adaptive_queue_policy(const hw_queue *queues_ptr,
+                              uint32_t queue_count,
+                              uint64_t transfer_size,
+                              uint32_t cursor,
+                              uint32_t *order_ptr) noexcept -> uint32_t {
+    std::array<uint32_t, MAX_NUM_WQ> costs = {};
+    const bool                       is_small_job = transfer_size <= hw_small_transfer_size;
+    uint32_t                         order_count  = 0u;
+
+    // Candidates are collected from the cursor position, so the stable sort rotates between equal costs
+    for (uint32_t try_idx = 0u; try_idx < queue_count; try_idx++) {
+        const uint32_t queue_idx         = (cursor + try_idx) % queue_count;
+        const auto     &queue            = queues_ptr[queue_idx];
+        const uint64_t max_transfer_size = queue.get_max_transfer_size();
+
+        if (0u != max_transfer_size && transfer_size > max_transfer_size) {
+            continue;
+        }
+
+        const auto priority = static_cast<uint32_t>(std::clamp<int32_t>(queue.priority(), 0, OWN_WQ_MAX_PRIORITY));
+        const auto priority_cost = is_small_job ? OWN_WQ_MAX_PRIORITY - priority : priority;
+
+        costs[queue_idx]         = queue.get_occupancy() + priority_cost * OWN_WQ_PRIORITY_WEIGHT;
+        order_ptr[order_count++] = queue_idx;
+    }
+
+    // No queue takes a job this large, let the device report the error in the completion record
+    if (0u == order_count) {
+        return hw_round_robin_queue_policy(queues_ptr, queue_count, transfer_size, cursor, order_ptr);
+    }
+
+    std::stable_sort(order_ptr, order_ptr + order_count, [&costs](uint32_t a, uint32_t b) -> bool {
+        return costs[a] < costs[b];
+    });
+
+    return order_count;
+}
+
+}
@@ -0,0 +1,99 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_QUEUE_POLICY_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_QUEUE_POLICY_HPP_
+
+#include <array>
+#include <cstdint>
+
+#include "hw_queue.hpp"
+
+namespace qpl::ml::dispatcher {
+
+/**
+ * @brief Work queue selection policy of a device.
+ *
+ * @details Policy fills order_ptr with indexes into queues_ptr in the order the submission should try them and
+ * returns the number of written indexes. Cursor is a per-thread per-device counter advanced on every submission,
+ * policies use it to spread equally ranked queues between submissions.
+ */
+using hw_queue_policy_t = auto (*)(const hw_queue *queues_ptr,
+                                   uint32_t queue_count,
+                                   uint64_t transfer_size,
+                                   uint32_t cursor,
+                                   uint32_t *order_ptr) noexcept -> uint32_t;
+
+/**
+ * @brief Kind of traffic a job belongs to, selects the priority band of work queues it is submitted to
+ */
+enum class hw_traffic_class_t : uint32_t {
+    latency = 0u,    /**< Interactive jobs, e.g. scans of a query waiting for the result */
+    normal  = 1u,    /**< Jobs without a stated preference */
+    bulk    = 2u     /**< Background throughput jobs, e.g. compression of cold data */
+};
+
+constexpr uint32_t hw_traffic_class_count = 3u;
+
+/**
+ * @brief Bit of the class in @ref hw_traffic_band_t::fallback_mask
+ */
+constexpr auto hw_traffic_class_bit(hw_traffic_class_t traffic_class) noexcept -> uint32_t {
+    return 1u << static_cast<uint32_t>(traffic_class);
+}
+
+/**
+ * @brief Work queues of one traffic class
+ */
+struct hw_traffic_band_t {
+    int32_t  min_priority  = 0;         /**< Lowest WQ priority of the band */
+    int32_t  max_priority  = INT32_MAX; /**< Highest WQ priority of the band */
+    bool     is_reserved   = false;     /**< Other classes never use the queues of the band */
+    uint32_t fallback_mask = 0u;        /**< Classes whose bands are tried once every queue of this band refused */
+};
+
+/**
+ * @brief Mapping of traffic classes onto the work queues of every device.
+ *
+ * @details A job is offered to the queues of its band first, in the order of the device queue policy, then to
+ * the queues of the fallback bands. A queue in the band of a reserved class is skipped by every other class,
+ * in its own band and as a fallback. A class whose band holds no queue of a device, e.g. because all queues
+ * share one priority, uses every queue of that device that isn't reserved by another class.
+ * The default maps every class onto every queue.
+ */
+struct hw_traffic_config_t {
+    std::array<hw_traffic_band_t, hw_traffic_class_count> bands = {};    /**< Indexed by hw_traffic_class_t */
+};
+
+/**
+ * @brief Jobs up to this size are latency sensitive for @ref hw_adaptive_queue_policy
+ */
+constexpr uint64_t hw_small_transfer_size = 16u * 1024u;
+
+/**
+ * @brief Tries every queue once starting from the cursor
+ */
+auto hw_round_robin_queue_policy(const hw_queue *queues_ptr,
+                                 uint32_t queue_count,
+                                 uint64_t transfer_size,
+                                 uint32_t cursor,
+                                 uint32_t *order_ptr) noexcept -> uint32_t;
+
+/**
+ * @brief Orders queues by estimated occupancy weighted by priority.
+ *
+ * @details Queues whose max transfer size is below the job size are skipped. Small jobs favour high priority
+ * (low-latency) queues, large jobs favour low priority (bulk) queues, and a busier queue loses to a less busy one
+ * once the occupancy difference outweighs the priority preference.
+ */
+auto hw_adaptive_queue_policy(const hw_queue *queues_ptr,
+                              uint32_t queue_count,
+                              uint64_t transfer_size,
+                              uint32_t cursor,
+                              uint32_t *order_ptr) noexcept -> uint32_t;
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_QUEUE_POLICY_HPP_
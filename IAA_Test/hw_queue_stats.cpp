@@ -0,0 +1,156 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <chrono>
+#include <thread>
+
+#include "hw_queue_stats.hpp"
+#include "hw_util.hpp"
+
+#define OWN_CALIBRATION_MIN_NS    10000000u    /**< Shortest interval the tick rate is measured over */
+
+/**
+ * @brief Reference point of the tick rate calibration, taken when the library is loaded
+ */
+static const uint64_t calibration_start_ns    = qpl::ml::dispatcher::hw_now_ns();
+static const uint64_t calibration_start_ticks = qpl::ml::dispatcher::hw_stats_ticks();
+
+namespace qpl::ml::dispatcher {
+
+void hw_queue_stats_t::merge(const hw_queue_stats_t &other) noexcept {
+    submissions += other.submissions;
+    retries     += other.retries;
+    completions += other.completions;
+    page_faults += other.page_faults;
+    errors      += other.errors;
+
+    for (uint32_t bucket_idx = 0u; bucket_idx < hw_latency_bucket_count; bucket_idx++) {
+        latency[bucket_idx] += other.latency[bucket_idx];
+    }
+}
+
+void hw_queue_stats_t::subtract(const hw_queue_stats_t &older) noexcept {
+    submissions -= older.submissions;
+    retries     -= older.retries;
+    completions -= older.completions;
+    page_faults -= older.page_faults;
+    errors      -= older.errors;
+
+    for (uint32_t bucket_idx = 0u; bucket_idx < hw_latency_bucket_count; bucket_idx++) {
+        latency[bucket_idx] -= older.latency[bucket_idx];
+    }
+}
+
+auto hw_queue_stats_t::get_latency_count() const noexcept -> uint64_t {
+    uint64_t count = 0u;
+
+    for (const auto bucket : latency) {
+        count += bucket;
+    }
+
+    return count;
+}
+
+auto hw_queue_stats_t::get_latency_percentile_ns(double fraction) const noexcept -> uint64_t {
+    const uint64_t count = hw_queue_stats_t::get_latency_count();
+
+    if (0u == count) {
+        return 0u;
+    }
+
+    fraction = (fraction < 0.0) ? 0.0 : (fraction > 1.0) ? 1.0 : fraction;
+
+    // Rank of the sample, counting from one
+    auto rank = static_cast<uint64_t>(fraction * static_cast<double>(count) + 0.5);
+    rank = (0u == rank) ? 1u : rank;
+
+    uint64_t seen = 0u;
+
+    for (uint32_t bucket_idx = 0u; bucket_idx < hw_latency_bucket_count; bucket_idx++) {
+        seen += latency[bucket_idx];
+
+        if (seen >= rank) {
+            const auto ticks = static_cast<double>(get_bucket_upper_ticks(bucket_idx));
+
+            return static_cast<uint64_t>(ticks / get_ticks_per_ns());
+        }
+    }
+
+    return UINT64_MAX;
+}
+
+auto hw_queue_stats_t::get_bucket_upper_ticks(uint32_t bucket_idx) noexcept -> uint64_t {
+    if (bucket_idx < hw_latency_sub_bucket_count) {
+        return bucket_idx;
+    }
+
+    if (bucket_idx >= hw_latency_bucket_count - 1u) {
+        return UINT64_MAX;
+    }
+
+    const uint32_t exponent   = bucket_idx / hw_latency_sub_bucket_count + hw_latency_sub_bucket_bits - 1u;
+    const uint32_t sub_bucket = bucket_idx % hw_latency_sub_bucket_count;
+    const uint32_t shift      = exponent - hw_latency_sub_bucket_bits;
+
+    return ((static_cast<uint64_t>(hw_latency_sub_bucket_count + sub_bucket + 1u)) << shift) - 1u;
+}
+
+auto hw_queue_stats_t::get_ticks_per_ns() noexcept -> double {
+    static const double ticks_per_ns = []() -> double {
+        uint64_t elapsed_ns = hw_now_ns() - calibration_start_ns;
+
+        // Snapshot read right after the start waits until the interval is long enough to be accurate
+        if (elapsed_ns < OWN_CALIBRATION_MIN_NS) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(OWN_CALIBRATION_MIN_NS - elapsed_ns));
+        }
+
+        const uint64_t ticks = hw_stats_ticks() - calibration_start_ticks;
+        elapsed_ns = hw_now_ns() - calibration_start_ns;
+
+        return (0u != ticks && 0u != elapsed_ns) ? static_cast<double>(ticks) / static_cast<double>(elapsed_ns) : 1.0;
+    }();
+
+    return ticks_per_ns;
+}
+
+hw_queue_counters::shard_lease_t::shard_lease_t() noexcept {
+    uint32_t free_mask = free_shards_mask_.load(std::memory_order_relaxed);
+
+    while (0u != free_mask) {
+        const auto candidate_idx = static_cast<uint32_t>(__builtin_ctz(free_mask));
+
+        if (free_shards_mask_.compare_exchange_weak(free_mask, free_mask & ~(1u << candidate_idx),
+                                                    std::memory_order_acquire)) {
+            shard_idx = candidate_idx;
+            return;
+        }
+    }
+}
+
+hw_queue_counters::shard_lease_t::~shard_lease_t() noexcept {
+    // Counts stay in the shard, the next owner continues from them
+    if (shared_shard_idx != shard_idx) {
+        free_shards_mask_.fetch_or(1u << shard_idx, std::memory_order_release);
+    }
+}
+
+void hw_queue_counters::collect(hw_queue_stats_t &stats) const noexcept {
+    stats = {};
+
+    for (const auto &shard : shards_) {
+        stats.submissions += shard.submissions.load(std::memory_order_relaxed);
+        stats.retries     += shard.retries.load(std::memory_order_relaxed);
+        stats.completions += shard.completions.load(std::memory_order_relaxed);
+        stats.page_faults += shard.page_faults.load(std::memory_order_relaxed);
+        stats.errors      += shard.errors.load(std::memory_order_relaxed);
+
+        for (uint32_t bucket_idx = 0u; bucket_idx < hw_latency_bucket_count; bucket_idx++) {
+            stats.latency[bucket_idx] += shard.latency[bucket_idx].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+}
@@ -0,0 +1,172 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_QUEUE_STATS_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_QUEUE_STATS_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <x86intrin.h>
+
+namespace qpl::ml::dispatcher {
+
+/**
+ * @brief Latency histogram layout: values below 2^(sub bits) have a bucket each, every further power of two
+ * is split into 2^(sub bits) equal buckets, so the relative bucket width stays under 12.5%
+ */
+constexpr uint32_t hw_latency_sub_bucket_bits  = 3u;
+constexpr uint32_t hw_latency_sub_bucket_count = 1u << hw_latency_sub_bucket_bits;
+constexpr uint32_t hw_latency_max_exponent     = 39u;   /**< Longer latencies land in the last bucket */
+constexpr uint32_t hw_latency_bucket_count     = (hw_latency_max_exponent - hw_latency_sub_bucket_bits + 2u)
+                                                 * hw_latency_sub_bucket_count;
+
+/**
+ * @brief Time stamp used for latency samples, converted to nanoseconds only when a snapshot is read
+ */
+static inline auto hw_stats_ticks() noexcept -> uint64_t {
+    return __rdtsc();
+}
+
+/**
+ * @brief Merged view of the counters of one work queue, a device or all devices
+ */
+struct hw_queue_stats_t {
+    uint64_t submissions = 0u;                                  /**< Descriptors accepted by ENQCMD */
+    uint64_t retries     = 0u;                                  /**< Descriptors rejected by ENQCMD */
+    uint64_t completions = 0u;                                  /**< Tracked records reaped, whatever the status */
+    uint64_t page_faults = 0u;                                  /**< Reaped records with a page fault status */
+    uint64_t errors      = 0u;                                  /**< Reaped records with any other non-success status */
+    std::array<uint64_t, hw_latency_bucket_count> latency = {}; /**< Submission to reap latency, in ticks */
+
+    void merge(const hw_queue_stats_t &other) noexcept;
+
+    /**
+     * @brief Counts since the older snapshot, both snapshots must be taken from the same object
+     */
+    void subtract(const hw_queue_stats_t &older) noexcept;
+
+    [[nodiscard]] auto get_latency_count() const noexcept -> uint64_t;
+
+    /**
+     * @brief Upper bound in nanoseconds of the bucket holding the given fraction (0..1) of latency samples
+     */
+    [[nodiscard]] auto get_latency_percentile_ns(double fraction) const noexcept -> uint64_t;
+
+    [[nodiscard]] static auto get_bucket_upper_ticks(uint32_t bucket_idx) noexcept -> uint64_t;
+
+    /**
+     * @brief Rate of @ref hw_stats_ticks, calibrated on the first call against the steady clock
+     */
+    [[nodiscard]] static auto get_ticks_per_ns() noexcept -> double;
+};
+
+/**
+ * @brief Live counters of one work queue, updated on the submission and completion paths.
+ *
+ * @details Counters are sharded per thread and merged only by @ref collect. On its first update a thread leases
+ * one of the exclusive shards for its lifetime, the same shard index in every queue, and increments it with
+ * a plain load and store. Threads that find no free exclusive shard share the last one and pay for a locked
+ * increment. A snapshot taken while updates are in progress is not atomic across counters, but every counter
+ * in it is exact up to the moment it was read.
+ */
+class hw_queue_counters final {
+public:
+    static constexpr uint32_t shard_count      = 16u;               /**< At most 32 */
+    static constexpr uint32_t shared_shard_idx = shard_count - 1u;  /**< Shard of threads without an exclusive one */
+
+    static_assert(shard_count <= 32u, "exclusive shards are leased from a 32-bit mask");
+
+    hw_queue_counters() noexcept = default;
+
+    hw_queue_counters(const hw_queue_counters &) = delete;
+
+    auto operator=(const hw_queue_counters &) -> hw_queue_counters & = delete;
+
+    inline void record_submission(bool is_accepted) noexcept {
+        const uint32_t shard_idx = get_thread_shard_idx();
+        auto           &shard    = shards_[shard_idx];
+
+        increment(is_accepted ? shard.submissions : shard.retries, shard_idx);
+    }
+
+    inline void record_completion(bool is_success, bool is_page_fault, uint64_t submit_ticks) noexcept {
+        const uint32_t shard_idx = get_thread_shard_idx();
+        auto           &shard    = shards_[shard_idx];
+
+        increment(shard.completions, shard_idx);
+
+        if (is_page_fault) {
+            increment(shard.page_faults, shard_idx);
+        } else if (!is_success) {
+            increment(shard.errors, shard_idx);
+        }
+
+        increment(shard.latency[get_bucket_idx(hw_stats_ticks() - submit_ticks)], shard_idx);
+    }
+
+    void collect(hw_queue_stats_t &stats) const noexcept;
+
+    [[nodiscard]] static inline auto get_bucket_idx(uint64_t ticks) noexcept -> uint32_t {
+        if (ticks < hw_latency_sub_bucket_count) {
+            return static_cast<uint32_t>(ticks);
+        }
+
+        const uint32_t exponent = 63u - static_cast<uint32_t>(__builtin_clzll(ticks));
+
+        if (exponent > hw_latency_max_exponent) {
+            return hw_latency_bucket_count - 1u;
+        }
+
+        const auto sub_bucket = static_cast<uint32_t>(ticks >> (exponent - hw_latency_sub_bucket_bits))
+                                & (hw_latency_sub_bucket_count - 1u);
+
+        return (exponent - hw_latency_sub_bucket_bits + 1u) * hw_latency_sub_bucket_count + sub_bucket;
+    }
+
+private:
+    struct alignas(64) shard_t {
+        std::atomic<uint64_t> submissions = 0u;
+        std::atomic<uint64_t> retries     = 0u;
+        std::atomic<uint64_t> completions = 0u;
+        std::atomic<uint64_t> page_faults = 0u;
+        std::atomic<uint64_t> errors      = 0u;
+        alignas(64) std::array<std::atomic<uint64_t>, hw_latency_bucket_count> latency = {};
+    };
+
+    /**
+     * @brief Exclusive shard index held by a thread until it exits, @ref shared_shard_idx if none was free
+     */
+    struct shard_lease_t {
+        uint32_t shard_idx = shared_shard_idx;
+
+        shard_lease_t() noexcept;
+
+        ~shard_lease_t() noexcept;
+    };
+
+    static inline void increment(std::atomic<uint64_t> &counter, uint32_t shard_idx) noexcept {
+        if (shared_shard_idx != shard_idx) {
+            // Single writer, no locked instruction is needed
+            counter.store(counter.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+        } else {
+            counter.fetch_add(1u, std::memory_order_relaxed);
+        }
+    }
+
+    [[nodiscard]] static inline auto get_thread_shard_idx() noexcept -> uint32_t {
+        static thread_local const shard_lease_t lease;
+
+        return lease.shard_idx;
+    }
+
+    static inline std::atomic<uint32_t> free_shards_mask_ = (1u << shared_shard_idx) - 1u;  /**< Unleased shards */
+
+    std::array<shard_t, shard_count> shards_ = {};    /**< Per-thread counter shards */
+};
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_QUEUE_STATS_HPP_
@@ -43,6 +43,8 @@ typedef uint8_t hw_operation_status; /**< Accelerator status type */
 
 #define AD_STATUS_INPROG                   0x00    /**< Operation is in progress */
 #define AD_STATUS_SUCCESS                  0x01    /**< Success */
+#define AD_STATUS_PAGE_FAULT               0x03    /**< Partial completion due to a page fault, see @ref FAULT_TYPE_IS_WRITE */
+#define AD_STATUS_BATCH_FAILED             0x05    /**< One or more descriptors of the batch completed with non-success status */
 #define AD_STATUS_ANALYTICS_ERROR          0x0A    /**< Operation execution error. See at @ref HW_ERROR_CODES */
 #define AD_STATUS_OUTPUT_OVERFLOW          0x0B    /**< Output buffer overflow. */
 #define AD_STATUS_UNSUPPORTED_OPCODE       0x10    /**< Unsupported operation code */
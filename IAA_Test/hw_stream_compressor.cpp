@@ -0,0 +1,420 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <cstring>
+
+#include "hw_stream_compressor.hpp"
+#include "hw_deflate_blocks.hpp"
+#include "hw_iaa_flags.h"
+#include "hw_aecs_api.h"
+#include "hw_descriptors_api.h"
+
+#define OWN_CRC32_POLYNOMIAL        0xEDB88320u   /**< Reflected IEEE 802.3 polynomial the device uses */
+#define OWN_TABLES_PER_STREAM       4u            /**< Dynamic tables kept for the following streams */
+
+static_assert(2u * sizeof(hw_iaa_aecs_compress) <= HW_AECS_ANALYTICS_SIZE, "AECS pair must fit one pool AECS");
+
+/**
+ * @brief Continues the CRC32 of the stream on the host for a chunk the device didn't finish, a rare path kept simple
+ */
+static inline auto own_crc32(const uint32_t crc, const uint8_t *src_ptr, const uint32_t size) noexcept -> uint32_t {
+    uint32_t state = ~crc;
+
+    for (uint32_t idx = 0u; idx < size; idx++) {
+        state ^= src_ptr[idx];
+
+        for (uint32_t bit = 0u; bit < 8u; bit++) {
+            state = (0u != (state & 1u)) ? (state >> 1u) ^ OWN_CRC32_POLYNOMIAL : state >> 1u;
+        }
+    }
+
+    return ~state;
+}
+
+namespace qpl::ml::dispatcher {
+
+hw_stream_compressor::hw_stream_compressor(const uint32_t max_in_flight, const hw_stream_huffman_t huffman) noexcept
+        : table_cache_(OWN_TABLES_PER_STREAM),
+          huffman_(huffman),
+          max_in_flight_((0u == max_in_flight)
+                         ? 1u
+                         : ((max_in_flight > hw_completion_engine::max_in_flight)
+                            ? hw_completion_engine::max_in_flight
+                            : max_in_flight)) {
+    engine_.set_traffic_class(hw_traffic_class_t::bulk);
+}
+
+hw_stream_compressor::~hw_stream_compressor() noexcept {
+    // Jobs go back to the pool with the slots, once nothing is in flight
+    hw_stream_compressor::reset();
+
+    hw_job_pool::get_instance().release(hw_pool_kind_t::aecs, aecs_pair_ptr_);
+}
+
+void hw_stream_compressor::set_cpu_path(hw_cpu_executor_t executor) noexcept {
+    // Chunks are the size a device is worth starting for, so they go to the CPU path only without devices
+    engine_.set_cpu_path(executor, 0u);
+}
+
+auto hw_stream_compressor::get_crc() const noexcept -> uint32_t {
+    return crc_;
+}
+
+auto hw_stream_compressor::get_total_in() const noexcept -> uint64_t {
+    return total_in_;
+}
+
+auto hw_stream_compressor::get_total_out() const noexcept -> uint64_t {
+    return total_out_;
+}
+
+auto hw_stream_compressor::in_flight() const noexcept -> uint32_t {
+    return static_cast<uint32_t>(next_submit_ - next_retire_);
+}
+
+auto hw_stream_compressor::get_max_in_flight() const noexcept -> uint32_t {
+    return max_in_flight_;
+}
+
+auto hw_stream_compressor::get_chunk_output_bound(const uint32_t chunk_size) noexcept -> uint32_t {
+    // Stored blocks after the pending bits of the stream and the EOB of the block they end
+    return static_cast<uint32_t>(hw_deflate_stored_size(chunk_size)) + sizeof(hw_iaa_aecs_compress::output_accum) + 3u;
+}
+
+auto hw_stream_compressor::prepare() noexcept -> qpl_status {
+    if (!slots_.empty()) {
+        return QPL_STS_OK;
+    }
+
+    auto &pool = hw_job_pool::get_instance();
+
+    aecs_pair_ptr_ = static_cast<hw_iaa_aecs_compress *>(pool.acquire(hw_pool_kind_t::aecs));
+
+    if (nullptr == aecs_pair_ptr_) {
+        return QPL_STS_NO_MEM_ERR;
+    }
+
+    const auto status = slots_.prepare(max_in_flight_);
+
+    if (QPL_STS_OK != status) {
+        pool.release(hw_pool_kind_t::aecs, aecs_pair_ptr_);
+        aecs_pair_ptr_ = nullptr;
+    }
+
+    return status;
+}
+
+auto hw_stream_compressor::get_state() noexcept -> hw_iaa_aecs_compress & {
+    return aecs_pair_ptr_[read_half_];
+}
+
+void hw_stream_compressor::open_block(const hw_iaa_histogram *histogram_ptr) noexcept {
+    auto &state = hw_stream_compressor::get_state();
+
+    // New stream, the checksums start from zero
+    memset(&state, 0, sizeof(state));
+
+    if (nullptr != histogram_ptr) {
+        (void) table_cache_.prepare(*histogram_ptr, state, 0u);
+    } else {
+        (void) hw_iaa_aecs_compress_write_deflate_fixed_header(&state, 0u);
+    }
+
+    block_start_   = state;
+    is_block_open_ = true;
+}
+
+auto hw_stream_compressor::submit_statistics(slot_t &slot) noexcept -> qpl_status {
+    auto *const desc_ptr = slot.job.descriptor_ptr;
+
+    // The histogram lands in the AECS of the slot, the state pair isn't written before the block is open
+    hw_iaa_descriptor_init_statistic_collector(desc_ptr,
+                                               slot.src_ptr,
+                                               slot.src_size,
+                                               static_cast<hw_iaa_aecs_compress *>(slot.job.aecs_ptr));
+
+    slot.is_collecting = true;
+
+    const auto status = engine_.submit(desc_ptr, slot.job.completion_record_ptr, &slot);
+
+    if (QPL_STS_OK != status) {
+        slot.is_collecting = false;
+    }
+
+    return status;
+}
+
+auto hw_stream_compressor::submit_chunk(slot_t &slot) noexcept -> qpl_status {
+    auto *const desc_ptr = slot.job.descriptor_ptr;
+    const auto  &state   = hw_stream_compressor::get_state();
+
+    // The chunk reads the state from one half and writes it to the other, toggling swaps the halves
+    const uint32_t access_policy = static_cast<uint32_t>(hw_aecs_access_read)
+                                   | static_cast<uint32_t>(hw_aecs_access_write)
+                                   | ((0u != read_half_) ? static_cast<uint32_t>(hw_aecs_toggle_rw) : 0u);
+
+    // Output that wouldn't beat stored blocks overflows and is replaced with them on completion
+    const uint32_t max_output_size = (state.num_output_accum_bits >> 3u)
+                                     + static_cast<uint32_t>(hw_deflate_stored_size(slot.src_size));
+
+    hw_iaa_descriptor_init_compress_body(desc_ptr);
+    hw_iaa_descriptor_init_deflate_body(desc_ptr, const_cast<uint8_t *>(slot.src_ptr), slot.src_size, slot.dst_ptr, max_output_size);
+    hw_iaa_descriptor_compress_set_aecs(desc_ptr, aecs_pair_ptr_, static_cast<hw_iaa_aecs_access_policy>(access_policy));
+
+    // The partial last byte stays in the written half, the next chunk continues the bit stream from it
+    hw_iaa_descriptor_compress_keep_output_accumulator(desc_ptr);
+
+    return engine_.submit(desc_ptr, slot.job.completion_record_ptr, &slot);
+}
+
+void hw_stream_compressor::start_next() noexcept {
+    // One chunk of the stream runs at a time, it can't start before the previous one has written its state
+    while (0u == engine_.in_flight() && next_start_ < next_submit_) {
+        auto &slot = slots_[next_start_ % max_in_flight_];
+
+        if (QPL_STS_OK != stream_status_) {
+            slot.status       = stream_status_;
+            slot.is_completed = true;
+            next_start_++;
+            continue;
+        }
+
+        if (!is_block_open_ && hw_stream_huffman_t::fixed == huffman_) {
+            hw_stream_compressor::open_block(nullptr);
+        }
+
+        if (!is_block_open_) {
+            const auto status = hw_stream_compressor::submit_statistics(slot);
+
+            // The stream still goes on with fixed codes if the histogram can't be collected
+            if (QPL_STS_OK != status && QPL_STS_QUEUES_ARE_BUSY_ERR != status) {
+                hw_stream_compressor::open_block(nullptr);
+                continue;
+            }
+
+            return;
+        }
+
+        const auto status = hw_stream_compressor::submit_chunk(slot);
+
+        if (QPL_STS_QUEUES_ARE_BUSY_ERR == status) {
+            return;
+        }
+
+        if (QPL_STS_OK != status) {
+            // Refused chunk is not in flight, the descriptor can't keep the slot from being released
+            hw_iaa_descriptor_reset(slot.job.descriptor_ptr);
+            stream_status_ = status;
+            continue;
+        }
+
+        next_start_++;
+    }
+}
+
+void hw_stream_compressor::write_stored(slot_t &slot) noexcept {
+    auto &state = hw_stream_compressor::get_state();
+
+    // The chunk read the state from this half and the device wrote nothing back, the open block ends here
+    uint8_t *out_ptr = hw_deflate_drain_accumulator(state, slot.dst_ptr);
+
+    hw_deflate_end_block(state);
+
+    const uint32_t bit_offset = state.num_output_accum_bits & 7u;
+
+    hw_iaa_aecs_compress_accumulator_flush(&state, &out_ptr, state.num_output_accum_bits);
+    out_ptr = hw_deflate_write_stored_blocks(out_ptr, slot.src_ptr, slot.src_size, bit_offset);
+
+    // The next chunk opens a block with the same codes
+    const uint32_t crc = own_crc32(state.crc, slot.src_ptr, slot.src_size);
+
+    state     = block_start_;
+    state.crc = crc;
+
+    slot.output_size = static_cast<uint32_t>(out_ptr - slot.dst_ptr);
+    slot.crc         = crc;
+    slot.status      = QPL_STS_OK;
+}
+
+void hw_stream_compressor::complete(slot_t &slot, const qpl_status status) noexcept {
+    if (slot.is_collecting) {
+        slot.is_collecting = false;
+
+        // Codes of the whole stream come from the histogram of its first chunk
+        hw_stream_compressor::open_block((QPL_STS_OK == status)
+                                         ? &static_cast<const hw_iaa_aecs_compress *>(slot.job.aecs_ptr)->histogram
+                                         : nullptr);
+        return;
+    }
+
+    const auto *record_ptr = reinterpret_cast<const hw_iaa_completion_record *>(slot.job.completion_record_ptr);
+
+    slot.is_completed = true;
+    slot.status       = status;
+
+    if (QPL_STS_OK == status) {
+        // The written half holds the state now, the codes are written back along with the bits and checksums
+        read_half_ ^= 1u;
+
+        slot.output_size = record_ptr->output_size;
+        slot.crc         = record_ptr->crc;
+    } else if (QPL_STS_DST_IS_SHORT_ERR == status) {
+        hw_stream_compressor::write_stored(slot);
+    } else {
+        stream_status_ = status;
+    }
+}
+
+void hw_stream_compressor::reap(const bool is_blocking) noexcept {
+    hw_completion_engine::reaped_t reaped;
+
+    const uint32_t reaped_count = is_blocking ? engine_.wait_any(&reaped, 1u) : engine_.poll(&reaped, 1u);
+
+    if (0u != reaped_count) {
+        hw_stream_compressor::complete(*static_cast<slot_t *>(reaped.user_ptr), reaped.status);
+    }
+
+    // The state is written, the next chunk can start
+    hw_stream_compressor::start_next();
+}
+
+auto hw_stream_compressor::submit(const uint8_t *src_ptr,
+                                  const uint32_t src_size,
+                                  uint8_t *dst_ptr,
+                                  const uint32_t dst_capacity) noexcept -> qpl_status {
+    if (nullptr == src_ptr || nullptr == dst_ptr) {
+        return QPL_STS_NULL_PTR_ERR;
+    }
+
+    if (0u == src_size) {
+        return QPL_STS_SIZE_ERR;
+    }
+
+    if (dst_capacity < hw_stream_compressor::get_chunk_output_bound(src_size)) {
+        return QPL_STS_DST_IS_SHORT_ERR;
+    }
+
+    if (hw_stream_compressor::in_flight() >= max_in_flight_) {
+        return QPL_STS_QUEUES_ARE_BUSY_ERR;
+    }
+
+    const auto status = hw_stream_compressor::prepare();
+
+    if (QPL_STS_OK != status) {
+        return status;
+    }
+
+    auto &slot = slots_[next_submit_ % max_in_flight_];
+
+    slot.src_ptr       = src_ptr;
+    slot.src_size      = src_size;
+    slot.dst_ptr       = dst_ptr;
+    slot.output_size   = 0u;
+    slot.is_collecting = false;
+    slot.is_completed  = false;
+    slot.status        = QPL_STS_OK;
+
+    next_submit_++;
+
+    // Starts the chunk at once if the previous one is done, a refused chunk is started again by later calls
+    hw_stream_compressor::reap(false);
+
+    return QPL_STS_OK;
+}
+
+auto hw_stream_compressor::retire(hw_stream_chunk_t &chunk) noexcept -> qpl_status {
+    if (0u == hw_stream_compressor::in_flight()) {
+        return QPL_STS_BEING_PROCESSED;
+    }
+
+    auto &slot = slots_[next_retire_ % max_in_flight_];
+
+    while (!slot.is_completed) {
+        if (!hw_job_slots<slot_t>::wait(engine_, [this] { hw_stream_compressor::reap(true); })) {
+            hw_stream_compressor::start_next();
+        }
+    }
+
+    chunk.dst_ptr     = slot.dst_ptr;
+    chunk.status      = slot.status;
+    chunk.output_size = (QPL_STS_OK == slot.status) ? slot.output_size : 0u;
+
+    next_retire_++;
+
+    if (QPL_STS_OK == chunk.status) {
+        crc_        = slot.crc;
+        total_in_  += slot.src_size;
+        total_out_ += chunk.output_size;
+    }
+
+    return chunk.status;
+}
+
+auto hw_stream_compressor::finish(uint8_t *dst_ptr, const uint32_t dst_capacity, uint32_t &dst_size) noexcept -> qpl_status {
+    if (nullptr == dst_ptr) {
+        return QPL_STS_NULL_PTR_ERR;
+    }
+
+    if (0u != hw_stream_compressor::in_flight()) {
+        return QPL_STS_BEING_PROCESSED;
+    }
+
+    if (QPL_STS_OK != stream_status_) {
+        return stream_status_;
+    }
+
+    // Empty final fixed block closes the stream, also the whole stream if no chunk was written
+    hw_iaa_aecs_compress trailer_aecs;
+    auto                 &state   = is_block_open_ ? hw_stream_compressor::get_state() : trailer_aecs;
+    uint8_t              *out_ptr = dst_ptr;
+
+    if (!is_block_open_) {
+        memset(&trailer_aecs, 0, sizeof(trailer_aecs));
+    }
+
+    // Whole pending bytes, then the partial byte, the EOB of the open block and the final block in 4 bytes at most
+    if (dst_capacity < (state.num_output_accum_bits >> 3u) + (is_block_open_ ? 4u : hw_deflate_trailer_size)) {
+        return QPL_STS_DST_IS_SHORT_ERR;
+    }
+
+    if (is_block_open_) {
+        out_ptr = hw_deflate_drain_accumulator(state, out_ptr);
+        hw_deflate_end_block(state);
+        is_block_open_ = false;
+    }
+
+    out_ptr = hw_deflate_write_trailer(state, out_ptr);
+
+    dst_size    = static_cast<uint32_t>(out_ptr - dst_ptr);
+    total_out_ += dst_size;
+
+    return QPL_STS_OK;
+}
+
+void hw_stream_compressor::reset() noexcept {
+    // Devices must stop reading and writing the buffers of the dropped chunks
+    while (0u != engine_.in_flight()) {
+        hw_completion_engine::reaped_t reaped;
+
+        (void) engine_.wait_any(&reaped, 1u);
+    }
+
+    for (auto &slot : slots_) {
+        slot.is_collecting = false;
+    }
+
+    read_half_     = 0u;
+    is_block_open_ = false;
+    stream_status_ = QPL_STS_OK;
+    next_submit_   = 0u;
+    next_start_    = 0u;
+    next_retire_   = 0u;
+    total_in_      = 0u;
+    total_out_     = 0u;
+    crc_           = 0u;
+}
+
+}
@@ -0,0 +1,184 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_STREAM_COMPRESSOR_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_STREAM_COMPRESSOR_HPP_
+
+#include <cstdint>
+
+#include "status.h"
+#include "hw_definitions.h"
+#include "hw_completion_engine.hpp"
+#include "hw_job_slots.hpp"
+#include "hw_huffman_table_cache.hpp"
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief Huffman codes of a @ref hw_stream_compressor stream
+ */
+enum class hw_stream_huffman_t : uint32_t {
+    fixed   = 0u,    /**< Fixed codes, the first chunk starts at once */
+    dynamic = 1u     /**< Codes built from the histogram of the first chunk, collected before it is compressed */
+};
+
+/**
+ * @brief Compressed chunk handed back by @ref hw_stream_compressor::retire
+ */
+struct hw_stream_chunk_t {
+    uint8_t    *dst_ptr     = nullptr;      /**< Destination given on submission */
+    uint32_t   output_size  = 0u;           /**< Bytes of the stream written there */
+    qpl_status status       = QPL_STS_OK;   /**< Chunk status, the output is valid on success only */
+};
+
+/**
+ * @brief Compresses a continuous stream chunk by chunk, chaining the stream state from one chunk to the next
+ * through a pair of AECS.
+ *
+ * @details A chunk reads the state of the stream from one half of the pair and writes it to the other one,
+ * selected with @ref hw_aecs_toggle_rw, so no state is copied on the host between chunks. The state is one
+ * deflate block open across the stream: its Huffman codes, the output bits short of a whole byte and the
+ * checksums. Chunk outputs therefore carry no per-chunk header or padding, and the codes of
+ * @ref hw_stream_huffman_t::dynamic are built once per stream. The compress AECS has no history window, so
+ * matches don't reach back into earlier chunks.
+ *
+ * A chunk can only start once the previous one has written the state it reads. Up to @ref get_max_in_flight
+ * chunks are accepted at once, the next one is handed to the device as soon as the completion of the previous
+ * one is reaped, by any call of the object. Chunks retire strictly in submission order. Outputs written one
+ * after another, followed by the bytes of @ref finish, form one raw deflate stream.
+ *
+ * A chunk that doesn't beat its stored size ends the open block and is written as stored blocks on the host,
+ * the next chunk opens a new block with the same codes. @ref get_chunk_output_bound always holds.
+ *
+ * @note Source and destination of a chunk must stay valid until it is retired. The object owns a completion
+ * engine, each thread is expected to use its own one.
+ */
+class hw_stream_compressor final {
+public:
+    static constexpr uint32_t default_max_in_flight = 4u;      /**< Chunks accepted at once */
+    static constexpr uint32_t max_trailer_size      = 260u;    /**< Pending bits, EOB and the final block of @ref finish */
+
+    explicit hw_stream_compressor(uint32_t max_in_flight = default_max_in_flight,
+                                  hw_stream_huffman_t huffman = hw_stream_huffman_t::dynamic) noexcept;
+
+    ~hw_stream_compressor() noexcept;
+
+    hw_stream_compressor(const hw_stream_compressor &) = delete;
+
+    auto operator=(const hw_stream_compressor &) -> hw_stream_compressor & = delete;
+
+    /**
+     * @brief Appends the next chunk to the stream, it starts as soon as the previous chunk completes
+     *
+     * @param dst_capacity at least @ref get_chunk_output_bound of the chunk size
+     *
+     * @return QPL_STS_QUEUES_ARE_BUSY_ERR if @ref get_max_in_flight chunks are not retired yet, nothing is
+     * submitted then. Failures of the chunk itself are reported by @ref retire
+     */
+    [[nodiscard]] auto submit(const uint8_t *src_ptr,
+                              uint32_t src_size,
+                              uint8_t *dst_ptr,
+                              uint32_t dst_capacity) noexcept -> qpl_status;
+
+    /**
+     * @brief Waits for the oldest chunk in flight and hands it back
+     *
+     * @details A failed chunk breaks the chain, the chunks after it fail with the same status until @ref reset.
+     *
+     * @return QPL_STS_BEING_PROCESSED if no chunk is in flight, the chunk status otherwise
+     */
+    [[nodiscard]] auto retire(hw_stream_chunk_t &chunk) noexcept -> qpl_status;
+
+    /**
+     * @brief Ends the open block and writes the end of the stream once every chunk is retired
+     *
+     * @param[out] dst_size bytes written, at most @ref max_trailer_size
+     *
+     * @return QPL_STS_BEING_PROCESSED if a chunk is still in flight, the status of a failed chunk if the
+     * stream is broken. Start the next stream with @ref reset
+     */
+    [[nodiscard]] auto finish(uint8_t *dst_ptr, uint32_t dst_capacity, uint32_t &dst_size) noexcept -> qpl_status;
+
+    /**
+     * @brief Drops the chunks in flight and starts a new stream
+     */
+    void reset() noexcept;
+
+    /**
+     * @brief Replaces the CPU path of the internal engine, see hw_completion_engine::set_cpu_path()
+     */
+    void set_cpu_path(hw_cpu_executor_t executor) noexcept;
+
+    [[nodiscard]] auto get_crc() const noexcept -> uint32_t;
+
+    [[nodiscard]] auto get_total_in() const noexcept -> uint64_t;
+
+    [[nodiscard]] auto get_total_out() const noexcept -> uint64_t;
+
+    [[nodiscard]] auto in_flight() const noexcept -> uint32_t;
+
+    [[nodiscard]] auto get_max_in_flight() const noexcept -> uint32_t;
+
+    [[nodiscard]] static auto get_chunk_output_bound(uint32_t chunk_size) noexcept -> uint32_t;
+
+private:
+    /**
+     * @brief Accepted chunk, slots are reused in submission order
+     */
+    struct slot_t {
+        hw_job_t       job           = {};            /**< Descriptor, completion record and statistics AECS */
+        const uint8_t  *src_ptr      = nullptr;       /**< Chunk source, kept for the stored fallback */
+        uint32_t       src_size      = 0u;            /**< Chunk size */
+        uint8_t        *dst_ptr      = nullptr;       /**< Chunk destination */
+        uint32_t       output_size   = 0u;            /**< Bytes written to the destination */
+        uint32_t       crc           = 0u;            /**< CRC32 of the stream up to the end of the chunk */
+        bool           is_collecting = false;         /**< Descriptor in flight collects the histogram */
+        bool           is_completed  = false;         /**< Chunk is done, its state is written */
+        qpl_status     status        = QPL_STS_OK;    /**< Chunk status */
+    };
+
+    [[nodiscard]] auto prepare() noexcept -> qpl_status;
+
+    [[nodiscard]] auto get_state() noexcept -> hw_iaa_aecs_compress &;
+
+    void open_block(const hw_iaa_histogram *histogram_ptr) noexcept;
+
+    [[nodiscard]] auto submit_statistics(slot_t &slot) noexcept -> qpl_status;
+
+    [[nodiscard]] auto submit_chunk(slot_t &slot) noexcept -> qpl_status;
+
+    void start_next() noexcept;
+
+    void complete(slot_t &slot, qpl_status status) noexcept;
+
+    void write_stored(slot_t &slot) noexcept;
+
+    void reap(bool is_blocking) noexcept;
+
+    hw_completion_engine   engine_;                        /**< Tracks the chunks of this stream */
+    hw_huffman_table_cache table_cache_;                   /**< Dynamic tables, kept between streams */
+    hw_job_slots<slot_t>   slots_;                         /**< Ring of accepted chunks */
+    hw_iaa_aecs_compress   *aecs_pair_ptr_ = nullptr;      /**< Two halves the chunks toggle between */
+    hw_iaa_aecs_compress   block_start_    = {};           /**< Header and codes of the open block, to reopen it */
+    hw_stream_huffman_t    huffman_        = hw_stream_huffman_t::dynamic;  /**< Codes of the stream */
+    uint32_t               read_half_      = 0u;           /**< Half holding the state the next chunk reads */
+    bool                   is_block_open_  = false;        /**< State holds the header of an open block */
+    qpl_status             stream_status_  = QPL_STS_OK;   /**< Status of the chunk that broke the chain */
+    uint64_t               next_submit_    = 0u;           /**< Chunks accepted into the stream */
+    uint64_t               next_start_     = 0u;           /**< Chunks handed to the device or failed */
+    uint64_t               next_retire_    = 0u;           /**< Chunks retired from the stream */
+    uint64_t               total_in_       = 0u;           /**< Source bytes of the retired chunks */
+    uint64_t               total_out_      = 0u;           /**< Stream bytes of the retired chunks and the trailer */
+    uint32_t               crc_            = 0u;           /**< CRC32 of the retired chunks */
+    uint32_t               max_in_flight_  = 0u;           /**< Number of slots */
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_STREAM_COMPRESSOR_HPP_
@@ -0,0 +1,255 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "hw_topology.hpp"
+#include "hw_util.hpp"
+
+#define OWN_TOPOLOGY_MAGIC     0x504f5451u              /**< "QTOP" */
+#define OWN_TOPOLOGY_VERSION   2u                       /**< Bumped on any record layout change */
+#define OWN_STATE_MAX_LENGTH   32u                      /**< Longest sysfs `state` value that is hashed */
+
+static const char *topology_cache_env = "QPL_TOPOLOGY_CACHE";
+static const char *sysfs_devices_path = "/sys/bus/dsa/devices";
+static const char *portals_path       = "/dev/iax";
+static const char *boot_id_path       = "/proc/sys/kernel/random/boot_id";
+
+/**
+ * @brief Snapshot file header, device records with their queue records follow it
+ */
+struct own_topology_header_t {
+    uint32_t magic;                 /**< Must be OWN_TOPOLOGY_MAGIC */
+    uint32_t version;               /**< Must be OWN_TOPOLOGY_VERSION */
+    uint32_t device_record_size;    /**< sizeof(hw_device_record_t) of the writer */
+    uint32_t queue_record_size;     /**< sizeof(hw_queue_record_t) of the writer */
+    uint64_t fingerprint;           /**< Sysfs fingerprint at the time of enumeration */
+    uint32_t device_count;          /**< Number of device records */
+    uint32_t reserved;              /**< Zero */
+};
+
+/**
+ * @brief Mixes the modification time of a path into the hash, a missing path is mixed in as zero time
+ */
+static inline auto own_hash_mtime(const uint64_t hash, const char *path_ptr) noexcept -> uint64_t {
+    struct stat path_stat = {};
+    int64_t     mtime[2]  = {0, 0};
+
+    if (0 == stat(path_ptr, &path_stat)) {
+        mtime[0] = path_stat.st_mtim.tv_sec;
+        mtime[1] = path_stat.st_mtim.tv_nsec;
+    }
+
+    return qpl::ml::dispatcher::hw_fnv_hash(hash, mtime, sizeof(mtime));
+}
+
+static inline auto own_hash_file(const uint64_t hash, const char *path_ptr) noexcept -> uint64_t {
+    char content[OWN_STATE_MAX_LENGTH] = {};
+    FILE *file_ptr = fopen(path_ptr, "r");
+
+    if (nullptr == file_ptr) {
+        return qpl::ml::dispatcher::hw_fnv_hash(hash, content, 1u);
+    }
+
+    const size_t length = fread(content, 1u, sizeof(content), file_ptr);
+    fclose(file_ptr);
+
+    return qpl::ml::dispatcher::hw_fnv_hash(hash, content, length);
+}
+
+namespace qpl::ml::dispatcher {
+
+hw_topology_cache::~hw_topology_cache() noexcept {
+    hw_topology_cache::close();
+}
+
+void hw_topology_cache::close() noexcept {
+    if (nullptr != file_ptr_) {
+        fclose(file_ptr_);
+        file_ptr_ = nullptr;
+    }
+
+    // Snapshot that was not committed is dropped
+    if ('\0' != temp_path_[0]) {
+        unlink(temp_path_);
+        temp_path_[0] = '\0';
+    }
+}
+
+auto hw_topology_cache::get_path() noexcept -> const char * {
+    const char *path_ptr = getenv(topology_cache_env);
+
+    return (nullptr != path_ptr && '\0' != path_ptr[0]) ? path_ptr : nullptr;
+}
+
+auto hw_topology_cache::get_fingerprint() noexcept -> uint64_t {
+    DIR *dir_ptr = opendir(sysfs_devices_path);
+
+    if (nullptr == dir_ptr) {
+        return 0u;
+    }
+
+    char     path[PATH_MAX];
+    uint64_t entries_hash = 0u;
+
+    // Per-entry hashes are summed, so the result doesn't depend on the directory listing order
+    for (const dirent *entry_ptr = readdir(dir_ptr); nullptr != entry_ptr; entry_ptr = readdir(dir_ptr)) {
+        if ('.' == entry_ptr->d_name[0]) {
+            continue;
+        }
+
+        uint64_t entry_hash = hw_fnv_hash(hw_fnv_offset_basis, entry_ptr->d_name, strlen(entry_ptr->d_name));
+
+        snprintf(path, sizeof(path), "%s/%s", sysfs_devices_path, entry_ptr->d_name);
+        entry_hash = own_hash_mtime(entry_hash, path);
+
+        snprintf(path, sizeof(path), "%s/%s/state", sysfs_devices_path, entry_ptr->d_name);
+        entry_hash = own_hash_file(entry_hash, path);
+
+        entries_hash += entry_hash;
+    }
+
+    closedir(dir_ptr);
+
+    uint64_t hash = own_hash_file(hw_fnv_offset_basis, boot_id_path);
+    hash = own_hash_mtime(hash, sysfs_devices_path);
+    hash = own_hash_mtime(hash, portals_path);
+    hash = hw_fnv_hash(hash, &entries_hash, sizeof(entries_hash));
+
+    // Zero is reserved for "can't be validated"
+    return hash | 1u;
+}
+
+auto hw_topology_cache::open_read(const char *path_ptr, const uint64_t fingerprint) noexcept -> bool {
+    hw_topology_cache::close();
+
+    if (0u == fingerprint) {
+        return false;
+    }
+
+    file_ptr_ = fopen(path_ptr, "rb");
+
+    if (nullptr == file_ptr_) {
+        return false;
+    }
+
+    own_topology_header_t header = {};
+
+    if (1u != fread(&header, sizeof(header), 1u, file_ptr_)
+        || OWN_TOPOLOGY_MAGIC != header.magic
+        || OWN_TOPOLOGY_VERSION != header.version
+        || sizeof(hw_device_record_t) != header.device_record_size
+        || sizeof(hw_queue_record_t) != header.queue_record_size
+        || fingerprint != header.fingerprint) {
+        hw_topology_cache::close();
+        return false;
+    }
+
+    device_count_ = header.device_count;
+
+    return true;
+}
+
+auto hw_topology_cache::read_device(hw_device_record_t &device,
+                                    hw_queue_record_t *queues_ptr,
+                                    const uint32_t queues_capacity) noexcept -> bool {
+    if (nullptr == file_ptr_ || 1u != fread(&device, sizeof(device), 1u, file_ptr_)) {
+        return false;
+    }
+
+    if (device.queue_count > queues_capacity) {
+        return false;
+    }
+
+    return device.queue_count == fread(queues_ptr, sizeof(hw_queue_record_t), device.queue_count, file_ptr_);
+}
+
+auto hw_topology_cache::open_write(const char *path_ptr, const uint64_t fingerprint) noexcept -> bool {
+    hw_topology_cache::close();
+
+    if (0u == fingerprint) {
+        return false;
+    }
+
+    const int path_length = snprintf(path_, sizeof(path_), "%s", path_ptr);
+    const int temp_length = snprintf(temp_path_, sizeof(temp_path_), "%s.%d.tmp", path_ptr, getpid());
+
+    if (path_length < 0 || temp_length < 0 || static_cast<size_t>(temp_length) >= sizeof(temp_path_)) {
+        temp_path_[0] = '\0';
+        return false;
+    }
+
+    file_ptr_ = fopen(temp_path_, "wb");
+
+    if (nullptr == file_ptr_) {
+        temp_path_[0] = '\0';
+        return false;
+    }
+
+    // Header is rewritten on commit when the device count is known
+    const own_topology_header_t header = {};
+
+    fingerprint_  = fingerprint;
+    device_count_ = 0u;
+
+    return 1u == fwrite(&header, sizeof(header), 1u, file_ptr_);
+}
+
+auto hw_topology_cache::write_device(const hw_device_record_t &device,
+                                     const hw_queue_record_t *queues_ptr) noexcept -> bool {
+    if (nullptr == file_ptr_ || '\0' == temp_path_[0]) {
+        return false;
+    }
+
+    if (1u != fwrite(&device, sizeof(device), 1u, file_ptr_)
+        || device.queue_count != fwrite(queues_ptr, sizeof(hw_queue_record_t), device.queue_count, file_ptr_)) {
+        return false;
+    }
+
+    device_count_++;
+
+    return true;
+}
+
+auto hw_topology_cache::commit() noexcept -> bool {
+    if (nullptr == file_ptr_ || '\0' == temp_path_[0]) {
+        return false;
+    }
+
+    own_topology_header_t header = {};
+    header.magic              = OWN_TOPOLOGY_MAGIC;
+    header.version            = OWN_TOPOLOGY_VERSION;
+    header.device_record_size = sizeof(hw_device_record_t);
+    header.queue_record_size  = sizeof(hw_queue_record_t);
+    header.fingerprint        = fingerprint_;
+    header.device_count       = device_count_;
+
+    const bool is_written = 0 == fseek(file_ptr_, 0, SEEK_SET)
+                            && 1u == fwrite(&header, sizeof(header), 1u, file_ptr_)
+                            && 0 == fflush(file_ptr_);
+
+    fclose(file_ptr_);
+    file_ptr_ = nullptr;
+
+    if (!is_written || 0 != rename(temp_path_, path_)) {
+        hw_topology_cache::close();
+        return false;
+    }
+
+    temp_path_[0] = '\0';
+
+    return true;
+}
+
+auto hw_topology_cache::device_count() const noexcept -> uint32_t {
+    return device_count_;
+}
+
+}
@@ -0,0 +1,94 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_TOPOLOGY_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_TOPOLOGY_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <climits>
+
+namespace qpl::ml::dispatcher {
+
+#if defined( linux )
+
+/**
+ * @brief Attributes of an accepted work queue as stored in the topology snapshot
+ */
+struct hw_queue_record_t {
+    char     portal_path[64];      /**< Character device the portal is mapped from */
+    int32_t  priority;             /**< WQ priority */
+    uint32_t block_on_fault;       /**< Non-zero if the WQ blocks on page faults */
+    uint32_t is_dedicated;         /**< Non-zero for a dedicated WQ */
+    uint32_t max_batch_size;       /**< Max descriptors in a batch */
+    uint32_t size;                 /**< Number of WQ entries */
+    uint64_t max_transfer_size;    /**< Largest transfer size the WQ accepts */
+};
+
+/**
+ * @brief Attributes of an accepted device as stored in the topology snapshot, followed by its queue records
+ */
+struct hw_device_record_t {
+    uint64_t gen_cap_register;     /**< GENCAP register content */
+    uint64_t numa_node_id;         /**< NUMA node id of the device */
+    uint32_t version_major;        /**< Major version of the device */
+    uint32_t version_minor;        /**< Minor version of the device */
+    uint32_t max_batch_size;       /**< Batch size accepted by every WQ of the device */
+    uint32_t queue_count;          /**< Number of queue records that follow */
+};
+
+/**
+ * @brief On-disk snapshot of the devices and work queues accepted by the dispatcher.
+ *
+ * @details The snapshot is opt-in: it is used only if the `QPL_TOPOLOGY_CACHE` environment variable names its file.
+ * A snapshot is trusted if it was written during the same boot and the fingerprint of the accelerator sysfs tree
+ * still matches: modification times of `/sys/bus/dsa/devices` entries and `/dev/iax`, and the device and WQ states.
+ * A snapshot is written to a temporary file and renamed over the old one, so processes racing to refresh it
+ * never observe a partial file.
+ */
+class hw_topology_cache final {
+public:
+    hw_topology_cache() noexcept = default;
+
+    ~hw_topology_cache() noexcept;
+
+    [[nodiscard]] static auto get_path() noexcept -> const char *;
+
+    [[nodiscard]] static auto get_fingerprint() noexcept -> uint64_t;
+
+    [[nodiscard]] auto open_read(const char *path_ptr, uint64_t fingerprint) noexcept -> bool;
+
+    [[nodiscard]] auto read_device(hw_device_record_t &device,
+                                   hw_queue_record_t *queues_ptr,
+                                   uint32_t queues_capacity) noexcept -> bool;
+
+    [[nodiscard]] auto open_write(const char *path_ptr, uint64_t fingerprint) noexcept -> bool;
+
+    [[nodiscard]] auto write_device(const hw_device_record_t &device,
+                                    const hw_queue_record_t *queues_ptr) noexcept -> bool;
+
+    [[nodiscard]] auto commit() noexcept -> bool;
+
+    [[nodiscard]] auto device_count() const noexcept -> uint32_t;
+
+    hw_topology_cache(const hw_topology_cache &) = delete;
+
+    auto operator=(const hw_topology_cache &) -> hw_topology_cache & = delete;
+
+private:
+    void close() noexcept;
+
+    FILE     *file_ptr_           = nullptr;  /**< Snapshot being read or temporary file being written */
+    uint32_t device_count_        = 0u;       /**< Devices in the snapshot, or written so far */
+    uint64_t fingerprint_         = 0u;       /**< Fingerprint written into the header on commit */
+    char     path_[PATH_MAX]      = {};       /**< Snapshot path */
+    char     temp_path_[PATH_MAX] = {};       /**< Temporary file path, empty unless writing */
+};
+
+#endif
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_TOPOLOGY_HPP_
@@ -0,0 +1,41 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#ifndef QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_UTIL_HPP_
+#define QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_UTIL_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace qpl::ml::dispatcher {
+
+constexpr uint64_t hw_fnv_offset_basis = 0xcbf29ce484222325llu;   /**< FNV-1a 64-bit offset basis */
+constexpr uint64_t hw_fnv_prime        = 0x00000100000001b3llu;   /**< FNV-1a 64-bit prime */
+
+/**
+ * @brief Steady clock in nanoseconds, for timeouts and measurements rather than per-job latency samples
+ */
+inline auto hw_now_ns() noexcept -> uint64_t {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Mixes the bytes into an FNV-1a hash, a new hash starts from @ref hw_fnv_offset_basis
+ */
+inline auto hw_fnv_hash(uint64_t hash, const void *data_ptr, const size_t size) noexcept -> uint64_t {
+    const auto *byte_ptr = reinterpret_cast<const uint8_t *>(data_ptr);
+
+    for (size_t byte_idx = 0u; byte_idx < size; byte_idx++) {
+        hash = (hash ^ byte_ptr[byte_idx]) * hw_fnv_prime;
+    }
+
+    return hash;
+}
+
+}
+#endif //QPL_SOURCES_MIDDLE_LAYER_DISPATCHER_HW_UTIL_HPP_
@@ -0,0 +1,278 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+#include "hw_dispatcher.hpp"
+#include "hw_util.hpp"
+#include "hw_memory_service.hpp"
+
+using namespace std;
+using qpl::ml::dispatcher::hw_dispatcher;
+using qpl::ml::dispatcher::hw_memory_service;
+using qpl::ml::dispatcher::hw_memory_request_t;
+using qpl::ml::dispatcher::hw_memory_op_t;
+
+static constexpr uint32_t page_sizes[]         = {4096u, 16384u, 65536u};
+static constexpr uint32_t default_pages        = 1024u;
+static constexpr uint32_t default_repeats      = 10u;
+static constexpr uint32_t default_zero_percent = 50u;
+
+struct run_result_t {
+    uint64_t time_ns     = 0u;      /**< Time from the first submission to the last completion */
+    uint64_t output_size = 0u;      /**< Bytes written for all pages */
+    bool     ok          = true;    /**< All requests succeeded */
+};
+
+/**
+ * @brief Progress of the service requests of one run, the callbacks update it
+ */
+struct run_state_t {
+    uint32_t completed = 0u;
+    uint32_t failed    = 0u;
+    uint64_t output    = 0u;
+};
+
+template <class value_t>
+static inline auto aligned_array(size_t count) -> value_t * {
+    const size_t size = (count * sizeof(value_t) + HW_PATH_STRUCTURES_REQUIRED_ALIGN - 1u)
+                        & ~(size_t) (HW_PATH_STRUCTURES_REQUIRED_ALIGN - 1u);
+
+    auto *ptr = static_cast<value_t *>(aligned_alloc(HW_PATH_STRUCTURES_REQUIRED_ALIGN, size));
+    memset(ptr, 0, size);
+
+    return ptr;
+}
+
+static void on_complete(const hw_memory_request_t &request, qpl_status status, uint32_t output_size) {
+    auto *state_ptr = static_cast<run_state_t *>(request.user_ptr);
+
+    state_ptr->completed++;
+    state_ptr->failed += (QPL_STS_OK != status) ? 1u : 0u;
+    state_ptr->output += output_size;
+}
+
+/**
+ * @brief Fills the arena with pages of which the given share is all zero, the rest hold a quarter of zero dwords
+ */
+static void fill_sparse(uint8_t *arena_ptr, uint32_t pages, uint32_t page_size, uint32_t zero_percent) {
+    uint32_t seed = 0x2545F491u;
+
+    for (uint32_t page = 0u; page < pages; page++) {
+        auto *page_ptr = reinterpret_cast<uint32_t *>(arena_ptr + (size_t) page * page_size);
+
+        seed = seed * 1664525u + 1013904223u;
+
+        const bool is_zero_page = (seed >> 8u) % 100u < zero_percent;
+
+        for (uint32_t idx = 0u; idx < page_size / 4u; idx++) {
+            seed = seed * 1664525u + 1013904223u;
+            page_ptr[idx] = (is_zero_page || 0u == (seed >> 30u)) ? 0u : (seed | 1u);
+        }
+    }
+}
+
+static auto run_memcpy(const uint8_t *src_ptr, uint8_t *dst_ptr, uint32_t pages, uint32_t page_size) -> run_result_t {
+    run_result_t   result{};
+    const uint64_t start = qpl::ml::dispatcher::hw_now_ns();
+
+    for (uint32_t page = 0u; page < pages; page++) {
+        memcpy(dst_ptr + (size_t) page * page_size, src_ptr + (size_t) page * page_size, page_size);
+    }
+
+    result.time_ns     = qpl::ml::dispatcher::hw_now_ns() - start;
+    result.output_size = (uint64_t) pages * page_size;
+
+    return result;
+}
+
+/**
+ * @brief Zero-page detection as a swap or dedup path does it: zero pages are only marked, the others are copied
+ */
+static auto run_zero_detect(const uint8_t *src_ptr,
+                            uint8_t *dst_ptr,
+                            uint8_t *zero_map_ptr,
+                            uint32_t pages,
+                            uint32_t page_size) -> run_result_t {
+    run_result_t   result{};
+    const uint64_t start = qpl::ml::dispatcher::hw_now_ns();
+
+    for (uint32_t page = 0u; page < pages; page++) {
+        const auto *words_ptr = reinterpret_cast<const uint64_t *>(src_ptr + (size_t) page * page_size);
+        uint64_t   any_bits   = 0u;
+
+        for (uint32_t idx = 0u; idx < page_size / 8u && 0u == any_bits; idx += 8u) {
+            any_bits = words_ptr[idx] | words_ptr[idx + 1u] | words_ptr[idx + 2u] | words_ptr[idx + 3u]
+                       | words_ptr[idx + 4u] | words_ptr[idx + 5u] | words_ptr[idx + 6u] | words_ptr[idx + 7u];
+        }
+
+        zero_map_ptr[page] = (0u == any_bits) ? 1u : 0u;
+
+        if (0u != any_bits) {
+            memcpy(dst_ptr + (size_t) page * page_size, words_ptr, page_size);
+            result.output_size += page_size;
+        }
+    }
+
+    result.time_ns = qpl::ml::dispatcher::hw_now_ns() - start;
+
+    return result;
+}
+
+static auto run_service(hw_memory_service &service,
+                        hw_memory_op_t operation,
+                        const uint8_t *src_ptr,
+                        uint8_t *dst_ptr,
+                        uint32_t dst_stride,
+                        uint32_t pages,
+                        uint32_t page_size) -> run_result_t {
+    run_result_t                result{};
+    run_state_t                 state{};
+    vector<hw_memory_request_t> requests(pages);
+
+    for (uint32_t page = 0u; page < pages; page++) {
+        requests[page] = {operation,
+                          src_ptr + (size_t) page * page_size,
+                          dst_ptr + (size_t) page * dst_stride,
+                          page_size,
+                          dst_stride,
+                          on_complete,
+                          &state};
+    }
+
+    const uint64_t start = qpl::ml::dispatcher::hw_now_ns();
+
+    if (QPL_STS_OK != service.submit(requests.data(), pages)) {
+        result.ok = false;
+        return result;
+    }
+
+    (void) service.wait_all();
+
+    result.time_ns     = qpl::ml::dispatcher::hw_now_ns() - start;
+    result.output_size = state.output;
+    result.ok          = pages == state.completed && 0u == state.failed;
+
+    return result;
+}
+
+static void print_result(const char *mode, uint32_t page_size, uint32_t pages, const run_result_t &result) {
+    const double bytes = (double) page_size * pages;
+
+    cout << setw(8) << page_size
+         << setw(10) << mode
+         << setw(12) << fixed << setprecision(1) << result.time_ns / 1000.0
+         << setw(10) << setprecision(2) << bytes / result.time_ns
+         << setw(12) << setprecision(0) << pages * 1e9 / result.time_ns
+         << setw(10) << setprecision(3) << result.output_size / bytes
+         << (result.ok ? "" : "  FAILED") << endl;
+}
+
+template <class runner_t>
+static auto best_of(uint32_t repeats, runner_t runner) -> run_result_t {
+    run_result_t best{};
+    bool         ok = true;
+
+    best.time_ns = UINT64_MAX;
+
+    // Best of the repeats is reported, failure of any repeat marks the row as failed
+    for (uint32_t repeat = 0u; repeat < repeats; repeat++) {
+        const auto result = runner();
+
+        ok = ok && result.ok;
+
+        if (result.time_ns < best.time_ns) {
+            best = result;
+        }
+    }
+
+    best.ok = ok;
+
+    return best;
+}
+
+int main(int argc, char **argv) {
+    const uint32_t pages        = (argc > 1) ? (uint32_t) atoi(argv[1]) : default_pages;
+    const uint32_t repeats      = (argc > 2) ? (uint32_t) atoi(argv[2]) : default_repeats;
+    const uint32_t zero_percent = (argc > 3) ? (uint32_t) atoi(argv[3]) : default_zero_percent;
+
+    auto &dispatcher = hw_dispatcher::get_instance();
+
+    if (0u == pages || 0u == repeats || zero_percent > 100u) {
+        cout << "usage: memory_benchmark [pages] [repeats] [zero pages, %]" << endl;
+        return 1;
+    }
+
+    const uint32_t max_page_size = page_sizes[std::size(page_sizes) - 1u];
+    const uint32_t max_stride    = hw_memory_service::get_output_size_bound(hw_memory_op_t::zero_compress_32,
+                                                                            max_page_size);
+
+    cout << "pages per group: " << pages << ", repeats: " << repeats << ", zero pages: " << zero_percent << "%"
+         << ", devices: " << (dispatcher.is_hw_support() ? dispatcher.device_count() : 0u) << endl;
+    cout << "measured crossover, copy: "
+         << hw_memory_service::get_measured_crossover_size(hw_memory_op_t::copy)
+         << ", zero compress: "
+         << hw_memory_service::get_measured_crossover_size(hw_memory_op_t::zero_compress_32) << endl;
+
+    auto *src_ptr      = aligned_array<uint8_t>((size_t) pages * max_page_size);
+    auto *dst_ptr      = aligned_array<uint8_t>((size_t) pages * max_stride);
+    auto *zero_map_ptr = aligned_array<uint8_t>(pages);
+
+    // The service as applications get it, and one that offloads everything to show the device side alone
+    hw_memory_service service;
+    hw_memory_service offload;
+
+    offload.set_crossover_size(hw_memory_op_t::copy, 0u);
+    offload.set_crossover_size(hw_memory_op_t::zero_compress_32, 0u);
+
+    cout << setw(8) << "page" << setw(10) << "mode" << setw(12) << "time, us" << setw(10) << "GB/s"
+         << setw(12) << "pages/s" << setw(10) << "out/in" << endl;
+
+    for (const uint32_t page_size : page_sizes) {
+        const uint32_t zero_stride = hw_memory_service::get_output_size_bound(hw_memory_op_t::zero_compress_32,
+                                                                              page_size);
+
+        fill_sparse(src_ptr, pages, page_size, zero_percent);
+
+        print_result("memcpy", page_size, pages, best_of(repeats, [&]() {
+            return run_memcpy(src_ptr, dst_ptr, pages, page_size);
+        }));
+        print_result("copy", page_size, pages, best_of(repeats, [&]() {
+            return run_service(service, hw_memory_op_t::copy, src_ptr, dst_ptr, page_size, pages, page_size);
+        }));
+
+        if (dispatcher.is_hw_support()) {
+            print_result("copy-hw", page_size, pages, best_of(repeats, [&]() {
+                return run_service(offload, hw_memory_op_t::copy, src_ptr, dst_ptr, page_size, pages, page_size);
+            }));
+        }
+
+        print_result("zdetect", page_size, pages, best_of(repeats, [&]() {
+            return run_zero_detect(src_ptr, dst_ptr, zero_map_ptr, pages, page_size);
+        }));
+        print_result("zcomp", page_size, pages, best_of(repeats, [&]() {
+            return run_service(service, hw_memory_op_t::zero_compress_32, src_ptr, dst_ptr, zero_stride, pages,
+                               page_size);
+        }));
+
+        if (dispatcher.is_hw_support()) {
+            print_result("zcomp-hw", page_size, pages, best_of(repeats, [&]() {
+                return run_service(offload, hw_memory_op_t::zero_compress_32, src_ptr, dst_ptr, zero_stride, pages,
+                                   page_size);
+            }));
+        }
+    }
+
+    free(zero_map_ptr);
+    free(dst_ptr);
+    free(src_ptr);
+
+    return 0;
+}
@@ -0,0 +1,1470 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+/*
+ *  Intel® Query Processing Library (Intel® QPL)
+ *  Core API (private C API)
+ */
+
+#include <immintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "qplc_analytics.h"
+#include "hw_status.h"
+
+#define OWN_BLOCK_SIZE          1024u      /**< Elements processed per pass, keeps the block bit-vector byte aligned */
+#define OWN_BLOCK_BYTES         (OWN_BLOCK_SIZE / 8u)
+#define OWN_BLOCK_SLACK         16u        /**< Elements a vector kernel may write past the result */
+#define OWN_MAX_SET_BIT_WIDTH   15u        /**< Widest element of set membership and find unique */
+#define OWN_MAX_SET_BYTES       ((1u << OWN_MAX_SET_BIT_WIDTH) / 8u)
+
+#define OWN_FORMAT_LE           0u         /**< hw_iaa_input_format_le */
+#define OWN_FORMAT_BE           1u         /**< hw_iaa_input_format_be */
+#define OWN_FORMAT_PRLE         2u         /**< hw_iaa_input_format_prle */
+#define OWN_OUTPUT_WIDTH_MASK   3u         /**< hw_iaa_output_format without modifiers */
+#define OWN_OUTPUT_BE           (1u << 15u)
+#define OWN_OUTPUT_INVERT       (1u << 16u)
+
+/* ################# KERNELS ################# */
+
+/**
+ * @brief Set of vector kernels one instruction set provides.
+ *
+ * @details Bit-vectors are passed in little-endian bit order, the unused bits of the last byte are zero.
+ * `select` and `expand` may write up to @ref OWN_BLOCK_SLACK elements past the result, `expand` may also read
+ * as much past the consumed source elements.
+ */
+struct own_kernels_t {
+    void     (*unpack_1u)(const uint8_t *src_ptr, uint32_t count, uint32_t *dst_ptr);
+    void     (*unpack_8u)(const uint8_t *src_ptr, uint32_t count, uint32_t *dst_ptr);
+    void     (*unpack_16u)(const uint8_t *src_ptr, uint32_t count, uint32_t *dst_ptr);
+    void     (*scan)(const uint32_t *src_ptr, uint32_t count, uint32_t low, uint32_t high, uint8_t *bits_ptr);
+    void     (*membership)(const uint32_t *src_ptr, uint32_t count, uint32_t shift, uint32_t mask,
+                           const uint8_t *set_ptr, uint8_t *bits_ptr);
+    uint32_t (*select)(const uint32_t *src_ptr, const uint8_t *mask_ptr, uint32_t count, uint32_t *dst_ptr);
+    uint32_t (*expand)(const uint32_t *src_ptr, const uint8_t *mask_ptr, uint32_t count, uint32_t *dst_ptr);
+    void     (*aggregate)(const uint32_t *src_ptr, uint32_t count, uint32_t *min_ptr, uint32_t *max_ptr,
+                          uint32_t *sum_ptr);
+    void     (*pack_8u)(const uint32_t *src_ptr, uint32_t count, uint8_t *dst_ptr);
+    void     (*pack_16u)(const uint32_t *src_ptr, uint32_t count, uint8_t *dst_ptr);
+};
+
+struct own_lut_t {
+    uint8_t compress[256][8];    /**< Source lanes gathered to the front for a mask byte */
+    uint8_t expand[256][8];      /**< Source lane each set mask bit takes */
+    uint8_t reverse[256];        /**< Byte with the bit order reversed */
+};
+
+static constexpr auto own_build_lut() -> own_lut_t {
+    own_lut_t lut{};
+
+    for (uint32_t mask = 0u; mask < 256u; mask++) {
+        uint32_t count    = 0u;
+        uint32_t reversed = 0u;
+
+        for (uint32_t bit = 0u; bit < 8u; bit++) {
+            if (mask & (1u << bit)) {
+                lut.compress[mask][count] = (uint8_t) bit;
+                lut.expand[mask][bit]     = (uint8_t) count;
+                count++;
+                reversed |= 1u << (7u - bit);
+            }
+        }
+
+        lut.reverse[mask] = (uint8_t) reversed;
+    }
+
+    return lut;
+}
+
+static constexpr own_lut_t own_lut = own_build_lut();
+
+static inline auto own_get_bit(const uint8_t *bits_ptr, uint32_t idx) noexcept -> uint32_t {
+    return (bits_ptr[idx >> 3u] >> (idx & 7u)) & 1u;
+}
+
+/* ################# SCALAR KERNELS ################# */
+
+static void own_unpack_1u_scalar(const uint8_t *src_ptr, uint32_t count, uint32_t *dst_ptr) {
+    for (uint32_t idx = 0u; idx < count; idx++) {
+        dst_ptr[idx] = own_get_bit(src_ptr, idx);
+    }
+}
+
+static void own_unpack_8u_scalar(const uint8_t *src_ptr, uint32_t count, uint32_t *dst_ptr) {
+    for (uint32_t idx = 0u; idx < count; idx++) {
+        dst_ptr[idx] = src_ptr[idx];
+    }
+}
+
+static void own_unpack_16u_scalar(const uint8_t *src_ptr, uint32_t count, uint32_t *dst_ptr) {
+    for (uint32_t idx = 0u; idx < count; idx++) {
+        uint16_t value;
+        memcpy(&value, src_ptr + idx * 2u, sizeof(value));
+        dst_ptr[idx] = value;
+    }
+}
+
+static void own_scan_scalar(const uint32_t *src_ptr, uint32_t count, uint32_t low, uint32_t high, uint8_t *bits_ptr) {
+    memset(bits_ptr, 0, (count + 7u) / 8u);
+
+    for (uint32_t idx = 0u; idx < count; idx++) {
+        // One unsigned compare covers both limits, a range with low > high matches nothing
+        const uint32_t match = (src_ptr[idx] - low <= high - low && low <= high) ? 1u : 0u;
+        bits_ptr[idx >> 3u] |= (uint8_t) (match << (idx & 7u));
+    }
+}
+
+static void own_membership_scalar(const uint32_t *src_ptr, uint32_t count, uint32_t shift, uint32_t mask,
+                                  const uint8_t *set_ptr, uint8_t *bits_ptr) {
+    memset(bits_ptr, 0, (count + 7u) / 8u);
+
+    for (uint32_t idx = 0u; idx < count; idx++) {
+        bits_ptr[idx >> 3u] |= (uint8_t) (own_get_bit(set_ptr, (src_ptr[idx] >> shift) & mask) << (idx & 7u));
+    }
+}
+
+static uint32_t own_select_scalar(const uint32_t *src_ptr, const uint8_t *mask_ptr, uint32_t count, uint32_t *dst_ptr) {
+    uint32_t selected = 0u;
+
+    for (uint32_t idx = 0u; idx < count; idx++) {
+        dst_ptr[selected] = src_ptr[idx];
+        selected += own_get_bit(mask_ptr, idx);
+    }
+
+    return selected;
+}
+
+static uint32_t own_expand_scalar(const uint32_t *src_ptr, const uint8_t *mask_ptr, uint32_t count, uint32_t *dst_ptr) {
+    uint32_t consumed = 0u;
+
+    for (uint32_t idx = 0u; idx < count; idx++) {
+        if (own_get_bit(mask_ptr, idx)) {
+            dst_ptr[idx] = src_ptr[consumed++];
+        } else {
+            dst_ptr[idx] = 0u;
+        }
+    }
+
+    return consumed;
+}
+
+static void own_aggregate_scalar(const uint32_t *src_ptr, uint32_t count, uint32_t *min_ptr, uint32_t *max_ptr,
+                                 uint32_t *sum_ptr) {
+    uint32_t min_value = UINT32_MAX;
+    uint32_t max_value = 0u;
+    uint32_t sum       = 0u;
+
+    for (uint32_t idx = 0u; idx < count; idx++) {
+        min_value = std::min(min_value, src_ptr[idx]);
+        max_value = std::max(max_value, src_ptr[idx]);
+        sum      += src_ptr[idx];
+    }
+
+    *min_ptr = min_value;
+    *max_ptr = max_value;
+    *sum_ptr = sum;
+}
+
+static void own_pack_8u_scalar(const uint32_t *src_ptr, uint32_t count, uint8_t *dst_ptr) {
+    for (uint32_t idx = 0u; idx < count; idx++) {
+        dst_ptr[idx] = (uint8_t) src_ptr[idx];
+    }
+}
+
+static void own_pack_16u_scalar(const uint32_t *src_ptr, uint32_t count, uint8_t *dst_ptr) {
+    for (uint32_t idx = 0u; idx < count; idx++) {
+        const auto value = (uint16_t) src_ptr[idx];
+        memcpy(dst_ptr + idx * 2u, &value, sizeof(value));
+    }
+}
+
+/* ################# AVX2 KERNELS ################# */
+
+#define OWN_AVX2 __attribute__((target("avx2,popcnt")))
+
+OWN_AVX2 static inline auto own_mask_lanes_avx2(uint32_t mask) -> __m256i {
+    const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+
+    return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32((int) mask), lane_bits), lane_bits);
+}
+
+OWN_AVX2 static void own_unpack_1u_avx2(const uint8_t *src_ptr, uint32_t count, uint32_t *dst_ptr) {
+    uint32_t idx = 0u;
+
+    for (; idx + 8u <= count; idx += 8u) {
+        const __m256i lanes = own_mask_lanes_avx2(src_ptr[idx >> 3u]);
+        _mm256_storeu_si256((__m256i *) (dst_ptr + idx), _mm256_srli_epi32(lanes, 31));
+    }
+
+    own_unpack_1u_scalar(src_ptr + idx / 8u, count - idx, dst_ptr + idx);
+}
+
+OWN_AVX2 static void own_unpack_8u_avx2(const uint8_t *src_ptr, uint32_t count, uint32_t *dst_ptr) {
+    uint32_t idx = 0u;
+
+    for (; idx + 8u <= count; idx += 8u) {
+        const __m128i bytes = _mm_loadl_epi64((const __m128i *) (src_ptr + idx));
+        _mm256_storeu_si256((__m256i *) (dst_ptr + idx), _mm256_cvtepu8_epi32(bytes));
+    }
+
+    own_unpack_8u_scalar(src_ptr + idx, count - idx, dst_ptr + idx);
+}
+
+OWN_AVX2 static void own_unpack_16u_avx2(const uint8_t *src_ptr, uint32_t count, uint32_t *dst_ptr) {
+    uint32_t idx = 0u;
+
+    for (; idx + 8u <= count; idx += 8u) {
+        const __m128i words = _mm_loadu_si128((const __m128i *) (src_ptr + idx * 2u));
+        _mm256_storeu_si256((__m256i *) (dst_ptr + idx), _mm256_cvtepu16_epi32(words));
+    }
+
+    own_unpack_16u_scalar(src_ptr + idx * 2u, count - idx, dst_ptr + idx);
+}
+
+OWN_AVX2 static void own_scan_avx2(const uint32_t *src_ptr, uint32_t count, uint32_t low, uint32_t high,
+                                   uint8_t *bits_ptr) {
+    // AVX2 has signed compares only, flipping the sign bit turns them into unsigned ones
+    const __m256i sign      = _mm256_set1_epi32(INT32_MIN);
+    const __m256i low_vec   = _mm256_xor_si256(_mm256_set1_epi32((int) low), sign);
+    const __m256i high_vec  = _mm256_xor_si256(_mm256_set1_epi32((int) high), sign);
+    uint32_t      idx       = 0u;
+
+    for (; idx + 8u <= count; idx += 8u) {
+        const __m256i values  = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (src_ptr + idx)), sign);
+        const __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(low_vec, values),
+                                                _mm256_cmpgt_epi32(values, high_vec));
+        bits_ptr[idx >> 3u] = (uint8_t) ~_mm256_movemask_ps(_mm256_castsi256_ps(outside));
+    }
+
+    own_scan_scalar(src_ptr + idx, count - idx, low, high, bits_ptr + idx / 8u);
+}
+
+OWN_AVX2 static void own_membership_avx2(const uint32_t *src_ptr, uint32_t count, uint32_t shift, uint32_t mask,
+                                         const uint8_t *set_ptr, uint8_t *bits_ptr) {
+    const __m256i mask_vec  = _mm256_set1_epi32((int) mask);
+    const __m128i shift_vec = _mm_cvtsi32_si128((int) shift);
+    const __m256i seven     = _mm256_set1_epi32(7);
+    const __m256i one       = _mm256_set1_epi32(1);
+    uint32_t      idx       = 0u;
+
+    for (; idx + 8u <= count; idx += 8u) {
+        const __m256i values = _mm256_loadu_si256((const __m256i *) (src_ptr + idx));
+        const __m256i keys   = _mm256_and_si256(_mm256_srl_epi32(values, shift_vec), mask_vec);
+        // Set is padded by the caller, so a 4-byte gather at the byte of the key stays inside
+        const __m256i words  = _mm256_i32gather_epi32((const int *) set_ptr, _mm256_srli_epi32(keys, 3), 1);
+        const __m256i hits   = _mm256_and_si256(_mm256_srlv_epi32(words, _mm256_and_si256(keys, seven)), one);
+        bits_ptr[idx >> 3u] = (uint8_t) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(hits, one)));
+    }
+
+    own_membership_scalar(src_ptr + idx, count - idx, shift, mask, set_ptr, bits_ptr + idx / 8u);
+}
+
+OWN_AVX2 static uint32_t own_select_avx2(const uint32_t *src_ptr, const uint8_t *mask_ptr, uint32_t count,
+                                         uint32_t *dst_ptr) {
+    uint32_t selected = 0u;
+    uint32_t idx      = 0u;
+
+    for (; idx + 8u <= count; idx += 8u) {
+        const uint32_t mask    = mask_ptr[idx >> 3u];
+        const __m256i  values  = _mm256_loadu_si256((const __m256i *) (src_ptr + idx));
+        const __m256i  indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) own_lut.compress[mask]));
+
+        _mm256_storeu_si256((__m256i *) (dst_ptr + selected), _mm256_permutevar8x32_epi32(values, indices));
+        selected += (uint32_t) _mm_popcnt_u32(mask);
+    }
+
+    return selected + own_select_scalar(src_ptr + idx, mask_ptr + idx / 8u, count - idx, dst_ptr + selected);
+}
+
+OWN_AVX2 static uint32_t own_expand_avx2(const uint32_t *src_ptr, const uint8_t *mask_ptr, uint32_t count,
+                                         uint32_t *dst_ptr) {
+    uint32_t consumed = 0u;
+    uint32_t idx      = 0u;
+
+    for (; idx + 8u <= count; idx += 8u) {
+        const uint32_t mask    = mask_ptr[idx >> 3u];
+        const __m256i  values  = _mm256_loadu_si256((const __m256i *) (src_ptr + consumed));
+        const __m256i  indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *) own_lut.expand[mask]));
+        const __m256i  result  = _mm256_and_si256(_mm256_permutevar8x32_epi32(values, indices),
+                                                  own_mask_lanes_avx2(mask));
+
+        _mm256_storeu_si256((__m256i *) (dst_ptr + idx), result);
+        consumed += (uint32_t) _mm_popcnt_u32(mask);
+    }
+
+    return consumed + own_expand_scalar(src_ptr + consumed, mask_ptr + idx / 8u, count - idx, dst_ptr + idx);
+}
+
+OWN_AVX2 static void own_aggregate_avx2(const uint32_t *src_ptr, uint32_t count, uint32_t *min_ptr,
+                                        uint32_t *max_ptr, uint32_t *sum_ptr) {
+    __m256i  min_vec = _mm256_set1_epi32(-1);
+    __m256i  max_vec = _mm256_setzero_si256();
+    __m256i  sum_vec = _mm256_setzero_si256();
+    uint32_t idx     = 0u;
+
+    for (; idx + 8u <= count; idx += 8u) {
+        const __m256i values = _mm256_loadu_si256((const __m256i *) (src_ptr + idx));
+        min_vec = _mm256_min_epu32(min_vec, values);
+        max_vec = _mm256_max_epu32(max_vec, values);
+        sum_vec = _mm256_add_epi32(sum_vec, values);
+    }
+
+    alignas(32) uint32_t lanes[3][8];
+    _mm256_store_si256((__m256i *) lanes[0], min_vec);
+    _mm256_store_si256((__m256i *) lanes[1], max_vec);
+    _mm256_store_si256((__m256i *) lanes[2], sum_vec);
+
+    own_aggregate_scalar(src_ptr + idx, count - idx, min_ptr, max_ptr, sum_ptr);
+
+    for (uint32_t lane = 0u; lane < 8u; lane++) {
+        *min_ptr  = std::min(*min_ptr, lanes[0][lane]);
+        *max_ptr  = std::max(*max_ptr, lanes[1][lane]);
+        *sum_ptr += lanes[2][lane];
+    }
+}
+
+OWN_AVX2 static void own_pack_8u_avx2(const uint32_t *src_ptr, uint32_t count, uint8_t *dst_ptr) {
+    uint32_t idx = 0u;
+
+    // Values are checked to fit the output width, so saturating packs don't change them
+    for (; idx + 8u <= count; idx += 8u) {
+        const __m256i values = _mm256_loadu_si256((const __m256i *) (src_ptr + idx));
+        const __m128i words  = _mm_packus_epi32(_mm256_castsi256_si128(values), _mm256_extracti128_si256(values, 1));
+        _mm_storel_epi64((__m128i *) (dst_ptr + idx), _mm_packus_epi16(words, words));
+    }
+
+    own_pack_8u_scalar(src_ptr + idx, count - idx, dst_ptr + idx);
+}
+
+OWN_AVX2 static void own_pack_16u_avx2(const uint32_t *src_ptr, uint32_t count, uint8_t *dst_ptr) {
+    uint32_t idx = 0u;
+
+    for (; idx + 8u <= count; idx += 8u) {
+        const __m256i values = _mm256_loadu_si256((const __m256i *) (src_ptr + idx));
+        const __m128i words  = _mm_packus_epi32(_mm256_castsi256_si128(values), _mm256_extracti128_si256(values, 1));
+        _mm_storeu_si128((__m128i *) (dst_ptr + idx * 2u), words);
+    }
+
+    own_pack_16u_scalar(src_ptr + idx, count - idx, dst_ptr + idx * 2u);
+}
+
+/* ################# AVX-512 KERNELS ################# */
+
+#define OWN_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,popcnt")))
+
+OWN_AVX512 static inline auto own_tail_mask(uint32_t count) -> __mmask16 {
+    return (__mmask16) ((count >= 16u) ? 0xFFFFu : ((1u << count) - 1u));
+}
+
+OWN_AVX512 static inline auto own_load_mask16(const uint8_t *bits_ptr, uint32_t idx, uint32_t count) -> __mmask16 {
+    // Reads only the bytes holding the remaining bits
+    uint16_t mask = bits_ptr[idx >> 3u];
+    if (count > 8u) {
+        mask |= (uint16_t) (bits_ptr[(idx >> 3u) + 1u] << 8u);
+    }
+
+    return (__mmask16) (mask & own_tail_mask(count));
+}
+
+OWN_AVX512 static inline void own_store_mask16(uint8_t *bits_ptr, uint32_t idx, uint32_t count, __mmask16 mask) {
+    bits_ptr[idx >> 3u] = (uint8_t) mask;
+    if (count > 8u) {
+        bits_ptr[(idx >> 3u) + 1u] = (uint8_t) (mask >> 8u);
+    }
+}
+
+OWN_AVX512 static void own_unpack_1u_avx512(const uint8_t *src_ptr, uint32_t count, uint32_t *dst_ptr) {
+    const __m512i one = _mm512_set1_epi32(1);
+
+    for (uint32_t idx = 0u; idx < count; idx += 16u) {
+        const uint32_t  left = count - idx;
+        const __mmask16 bits = own_load_mask16(src_ptr, idx, left);
+        _mm512_mask_storeu_epi32(dst_ptr + idx, own_tail_mask(left), _mm512_maskz_mov_epi32(bits, one));
+    }
+}
+
+OWN_AVX512 static void own_unpack_8u_avx512(const uint8_t *src_ptr, uint32_t count, uint32_t *dst_ptr) {
+    for (uint32_t idx = 0u; idx < count; idx += 16u) {
+        const __mmask16 tail  = own_tail_mask(count - idx);
+        const __m128i   bytes = _mm_maskz_loadu_epi8(tail, src_ptr + idx);
+        _mm512_mask_storeu_epi32(dst_ptr + idx, tail, _mm512_maskz_cvtepu8_epi32(tail, bytes));
+    }
+}
+
+OWN_AVX512 static void own_unpack_16u_avx512(const uint8_t *src_ptr, uint32_t count, uint32_t *dst_ptr) {
+    for (uint32_t idx = 0u; idx < count; idx += 16u) {
+        const __mmask16 tail  = own_tail_mask(count - idx);
+        const __m256i   words = _mm256_maskz_loadu_epi16(tail, src_ptr + idx * 2u);
+        _mm512_mask_storeu_epi32(dst_ptr + idx, tail, _mm512_maskz_cvtepu16_epi32(tail, words));
+    }
+}
+
+OWN_AVX512 static void own_scan_avx512(const uint32_t *src_ptr, uint32_t count, uint32_t low, uint32_t high,
+                                       uint8_t *bits_ptr) {
+    const __m512i low_vec  = _mm512_set1_epi32((int) low);
+    const __m512i high_vec = _mm512_set1_epi32((int) high);
+
+    for (uint32_t idx = 0u; idx < count; idx += 16u) {
+        const __mmask16 tail   = own_tail_mask(count - idx);
+        const __m512i   values = _mm512_maskz_loadu_epi32(tail, src_ptr + idx);
+        const __mmask16 match  = _mm512_mask_cmp_epu32_mask(_mm512_cmp_epu32_mask(values, low_vec, _MM_CMPINT_NLT),
+                                                            values, high_vec, _MM_CMPINT_LE);
+        own_store_mask16(bits_ptr, idx, count - idx, match & tail);
+    }
+}
+
+OWN_AVX512 static void own_membership_avx512(const uint32_t *src_ptr, uint32_t count, uint32_t shift,
+                                             uint32_t mask, const uint8_t *set_ptr, uint8_t *bits_ptr) {
+    const __m512i mask_vec  = _mm512_set1_epi32((int) mask);
+    const __m128i shift_vec = _mm_cvtsi32_si128((int) shift);
+    const __m512i seven     = _mm512_set1_epi32(7);
+    const __m512i one       = _mm512_set1_epi32(1);
+
+    for (uint32_t idx = 0u; idx < count; idx += 16u) {
+        const __mmask16 tail   = own_tail_mask(count - idx);
+        const __m512i   values = _mm512_maskz_loadu_epi32(tail, src_ptr + idx);
+        const __m512i   keys   = _mm512_and_si512(_mm512_maskz_srl_epi32(tail, values, shift_vec), mask_vec);
+        const __m512i   words  = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), tail,
+                                                             _mm512_maskz_srli_epi32(tail, keys, 3), set_ptr, 1);
+        const __m512i   hits   = _mm512_maskz_srlv_epi32(tail, words, _mm512_and_si512(keys, seven));
+        own_store_mask16(bits_ptr, idx, count - idx, _mm512_mask_test_epi32_mask(tail, hits, one));
+    }
+}
+
+OWN_AVX512 static uint32_t own_select_avx512(const uint32_t *src_ptr, const uint8_t *mask_ptr, uint32_t count,
+                                             uint32_t *dst_ptr) {
+    uint32_t selected = 0u;
+
+    for (uint32_t idx = 0u; idx < count; idx += 16u) {
+        const __mmask16 mask   = own_load_mask16(mask_ptr, idx, count - idx);
+        const __m512i   values = _mm512_maskz_loadu_epi32(mask, src_ptr + idx);
+
+        _mm512_mask_compressstoreu_epi32(dst_ptr + selected, mask, values);
+        selected += (uint32_t) _mm_popcnt_u32(mask);
+    }
+
+    return selected;
+}
+
+OWN_AVX512 static uint32_t own_expand_avx512(const uint32_t *src_ptr, const uint8_t *mask_ptr, uint32_t count,
+                                             uint32_t *dst_ptr) {
+    uint32_t consumed = 0u;
+
+    for (uint32_t idx = 0u; idx < count; idx += 16u) {
+        const __mmask16 mask = own_load_mask16(mask_ptr, idx, count - idx);
+
+        _mm512_mask_storeu_epi32(dst_ptr + idx, own_tail_mask(count - idx),
+                                 _mm512_maskz_expandloadu_epi32(mask, src_ptr + consumed));
+        consumed += (uint32_t) _mm_popcnt_u32(mask);
+    }
+
+    return consumed;
+}
+
+OWN_AVX512 static void own_aggregate_avx512(const uint32_t *src_ptr, uint32_t count, uint32_t *min_ptr,
+                                            uint32_t *max_ptr, uint32_t *sum_ptr) {
+    __m512i min_vec = _mm512_set1_epi32(-1);
+    __m512i max_vec = _mm512_setzero_si512();
+    __m512i sum_vec = _mm512_setzero_si512();
+
+    for (uint32_t idx = 0u; idx < count; idx += 16u) {
+        const __mmask16 tail   = own_tail_mask(count - idx);
+        const __m512i   values = _mm512_maskz_loadu_epi32(tail, src_ptr + idx);
+        min_vec = _mm512_mask_min_epu32(min_vec, tail, min_vec, values);
+        max_vec = _mm512_mask_max_epu32(max_vec, tail, max_vec, values);
+        sum_vec = _mm512_add_epi32(sum_vec, values);
+    }
+
+    alignas(64) uint32_t lanes[3][16];
+    _mm512_store_si512(lanes[0], min_vec);
+    _mm512_store_si512(lanes[1], max_vec);
+    _mm512_store_si512(lanes[2], sum_vec);
+
+    own_aggregate_scalar(nullptr, 0u, min_ptr, max_ptr, sum_ptr);
+
+    for (uint32_t lane = 0u; lane < 16u; lane++) {
+        *min_ptr  = std::min(*min_ptr, lanes[0][lane]);
+        *max_ptr  = std::max(*max_ptr, lanes[1][lane]);
+        *sum_ptr += lanes[2][lane];
+    }
+}
+
+OWN_AVX512 static void own_pack_8u_avx512(const uint32_t *src_ptr, uint32_t count, uint8_t *dst_ptr) {
+    for (uint32_t idx = 0u; idx < count; idx += 16u) {
+        const __mmask16 tail = own_tail_mask(count - idx);
+        _mm512_mask_cvtepi32_storeu_epi8(dst_ptr + idx, tail, _mm512_maskz_loadu_epi32(tail, src_ptr + idx));
+    }
+}
+
+OWN_AVX512 static void own_pack_16u_avx512(const uint32_t *src_ptr, uint32_t count, uint8_t *dst_ptr) {
+    for (uint32_t idx = 0u; idx < count; idx += 16u) {
+        const __mmask16 tail = own_tail_mask(count - idx);
+        _mm512_mask_cvtepi32_storeu_epi16(dst_ptr + idx * 2u, tail, _mm512_maskz_loadu_epi32(tail, src_ptr + idx));
+    }
+}
+
+/* ################# DISPATCHING ################# */
+
+static constexpr own_kernels_t own_kernels_table[] = {
+        {own_unpack_1u_scalar, own_unpack_8u_scalar, own_unpack_16u_scalar, own_scan_scalar, own_membership_scalar,
+         own_select_scalar, own_expand_scalar, own_aggregate_scalar, own_pack_8u_scalar, own_pack_16u_scalar},
+        {own_unpack_1u_avx2, own_unpack_8u_avx2, own_unpack_16u_avx2, own_scan_avx2, own_membership_avx2,
+         own_select_avx2, own_expand_avx2, own_aggregate_avx2, own_pack_8u_avx2, own_pack_16u_avx2},
+        {own_unpack_1u_avx512, own_unpack_8u_avx512, own_unpack_16u_avx512, own_scan_avx512, own_membership_avx512,
+         own_select_avx512, own_expand_avx512, own_aggregate_avx512, own_pack_8u_avx512, own_pack_16u_avx512},
+};
+
+static inline auto own_detect_isa() noexcept -> qplc_analytic_isa {
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+        && __builtin_cpu_supports("avx512vl")) {
+        return qplc_analytic_isa_avx512;
+    }
+
+    return __builtin_cpu_supports("avx2") ? qplc_analytic_isa_avx2 : qplc_analytic_isa_scalar;
+}
+
+static inline auto own_get_isa_state() noexcept -> std::atomic<uint32_t> & {
+    static std::atomic<uint32_t> isa = static_cast<uint32_t>(own_detect_isa());
+
+    return isa;
+}
+
+static inline auto own_get_kernels() noexcept -> const own_kernels_t & {
+    return own_kernels_table[own_get_isa_state().load(std::memory_order_relaxed)];
+}
+
+/* ################# CHECKSUMS ################# */
+
+/**
+ * @brief Tables of slice-by-8 CRC32 with the reflected IEEE 802.3 polynomial
+ */
+static inline auto own_get_crc_tables() noexcept -> const uint32_t (&)[8][256] {
+    static const auto tables = []() {
+        struct {
+            uint32_t data[8][256];
+        } result{};
+
+        for (uint32_t byte = 0u; byte < 256u; byte++) {
+            uint32_t crc = byte;
+            for (uint32_t bit = 0u; bit < 8u; bit++) {
+                crc = (crc >> 1u) ^ (0xEDB88320u & (0u - (crc & 1u)));
+            }
+            result.data[0][byte] = crc;
+        }
+
+        for (uint32_t slice = 1u; slice < 8u; slice++) {
+            for (uint32_t byte = 0u; byte < 256u; byte++) {
+                const uint32_t prev = result.data[slice - 1u][byte];
+                result.data[slice][byte] = (prev >> 8u) ^ result.data[0][prev & 0xFFu];
+            }
+        }
+
+        return result;
+    }();
+
+    return tables.data;
+}
+
+static inline auto own_crc32(uint32_t seed, const uint8_t *src_ptr, uint32_t size) noexcept -> uint32_t {
+    const auto &tables = own_get_crc_tables();
+    uint32_t   crc     = ~seed;
+    uint32_t   idx     = 0u;
+
+    for (; idx + 8u <= size; idx += 8u) {
+        uint32_t low;
+        uint32_t high;
+        memcpy(&low, src_ptr + idx, sizeof(low));
+        memcpy(&high, src_ptr + idx + 4u, sizeof(high));
+        low ^= crc;
+
+        crc = tables[7][low & 0xFFu] ^ tables[6][(low >> 8u) & 0xFFu]
+              ^ tables[5][(low >> 16u) & 0xFFu] ^ tables[4][low >> 24u]
+              ^ tables[3][high & 0xFFu] ^ tables[2][(high >> 8u) & 0xFFu]
+              ^ tables[1][(high >> 16u) & 0xFFu] ^ tables[0][high >> 24u];
+    }
+
+    for (; idx < size; idx++) {
+        crc = (crc >> 8u) ^ tables[0][(crc ^ src_ptr[idx]) & 0xFFu];
+    }
+
+    return ~crc;
+}
+
+static inline auto own_xor_checksum(uint32_t seed, const uint8_t *src_ptr, uint32_t size) noexcept -> uint32_t {
+    uint64_t wide = 0u;
+    uint32_t idx  = 0u;
+
+    for (; idx + 8u <= size; idx += 8u) {
+        uint64_t value;
+        memcpy(&value, src_ptr + idx, sizeof(value));
+        wide ^= value;
+    }
+
+    uint32_t checksum = seed ^ (uint32_t) (wide ^ (wide >> 16u) ^ (wide >> 32u) ^ (wide >> 48u));
+
+    // An odd trailing byte is the low half of the last word
+    for (; idx < size; idx++) {
+        checksum ^= (uint32_t) src_ptr[idx] << (8u * (idx & 1u));
+    }
+
+    return checksum & 0xFFFFu;
+}
+
+/* ################# INPUT STREAMS ################# */
+
+/**
+ * @brief Sequential reader of packed elements
+ */
+struct own_reader_t {
+    const uint8_t *ptr          = nullptr;
+    uint32_t      size          = 0u;
+    uint32_t      format        = OWN_FORMAT_LE;
+    uint32_t      bit_width     = 0u;
+    uint32_t      short_error   = AD_ERROR_CODE_SRC1_TOO_SMALL;   /**< Reported if the stream ends too early */
+    uint64_t      bit_pos       = 0u;                             /**< Next fixed-width or bit-packed element */
+    uint32_t      byte_pos      = 0u;                             /**< PRLE: next run header */
+    uint32_t      run_left      = 0u;                             /**< PRLE: repetitions left in the run */
+    uint32_t      run_value     = 0u;                             /**< PRLE: repeated value */
+    uint32_t      packed_left   = 0u;                             /**< PRLE: values left in the bit-packed run */
+};
+
+static inline auto own_load_64(const uint8_t *ptr, uint32_t size, uint64_t byte_idx) noexcept -> uint64_t {
+    uint64_t value = 0u;
+
+    memcpy(&value, ptr + byte_idx, (byte_idx + sizeof(value) <= size) ? sizeof(value) : size - byte_idx);
+
+    return value;
+}
+
+/**
+ * @brief Unpacks `count` elements starting at `bit_pos`, the caller checks the stream holds them
+ */
+static void own_unpack(const own_kernels_t &kernels, const uint8_t *ptr, uint32_t size, uint64_t bit_pos,
+                       uint32_t count, uint32_t bit_width, bool is_big_endian, uint32_t *dst_ptr) {
+    const uint8_t *src_ptr = ptr + (bit_pos >> 3u);
+
+    if (0u == (bit_pos & 7u)) {
+        if (8u == bit_width) {
+            kernels.unpack_8u(src_ptr, count, dst_ptr);
+            return;
+        }
+
+        if (!is_big_endian) {
+            switch (bit_width) {
+                case 1u:
+                    kernels.unpack_1u(src_ptr, count, dst_ptr);
+                    return;
+                case 16u:
+                    kernels.unpack_16u(src_ptr, count, dst_ptr);
+                    return;
+                case 32u:
+                    memcpy(dst_ptr, src_ptr, count * sizeof(uint32_t));
+                    return;
+                default:
+                    break;
+            }
+        }
+    }
+
+    const uint64_t mask = (1ull << bit_width) - 1u;
+
+    // An element with the bit offset fits into 39 bits, so one 64-bit load is always enough
+    for (uint32_t idx = 0u; idx < count; idx++, bit_pos += bit_width) {
+        const uint64_t value = own_load_64(ptr, size, bit_pos >> 3u);
+
+        if (is_big_endian) {
+            dst_ptr[idx] = (uint32_t) ((__builtin_bswap64(value) >> (64u - (bit_pos & 7u) - bit_width)) & mask);
+        } else {
+            dst_ptr[idx] = (uint32_t) ((value >> (bit_pos & 7u)) & mask);
+        }
+    }
+}
+
+static inline auto own_reader_init(own_reader_t &reader,
+                                   const uint8_t *ptr,
+                                   uint32_t size,
+                                   uint32_t format,
+                                   uint32_t bit_width,
+                                   uint32_t short_error) noexcept -> uint32_t {
+    reader             = own_reader_t{};
+    reader.ptr         = ptr;
+    reader.size        = size;
+    reader.format      = format;
+    reader.bit_width   = bit_width;
+    reader.short_error = short_error;
+
+    if (OWN_FORMAT_PRLE == format) {
+        if (0u == size) {
+            return AD_ERROR_CODE_PRLE_FORMAT_INCORRECT;
+        }
+
+        // PRLE stream starts with the bit-width of its elements
+        reader.bit_width = ptr[0];
+        reader.byte_pos  = 1u;
+
+        if (reader.bit_width > 32u) {
+            return AD_ERROR_CODE_PRLE_BITWIDTH_TOO_LARGE;
+        }
+    } else if (format > OWN_FORMAT_PRLE) {
+        return QPLC_ANALYTIC_INVALID_FLAGS;
+    }
+
+    return (0u == reader.bit_width || reader.bit_width > 32u) ? QPLC_ANALYTIC_INVALID_FLAGS : AD_ERROR_CODE_OK;
+}
+
+/**
+ * @brief Parses the next run header of the Parquet RLE/bit-packed hybrid encoding
+ */
+static inline auto own_prle_next_run(own_reader_t &reader) noexcept -> uint32_t {
+    if (reader.byte_pos >= reader.size) {
+        return AD_ERROR_CODE_TOO_FEW_ELEMENTS_PROCESSED;
+    }
+
+    uint32_t header = 0u;
+
+    for (uint32_t shift = 0u;; shift += 7u) {
+        if (reader.byte_pos >= reader.size || shift > 28u) {
+            return AD_ERROR_CODE_PRLE_FORMAT_INCORRECT;
+        }
+
+        const uint32_t byte = reader.ptr[reader.byte_pos++];
+        header |= (byte & 0x7Fu) << shift;
+
+        if (0u == (byte & 0x80u)) {
+            break;
+        }
+    }
+
+    if (header & 1u) {
+        // Groups of 8 values packed little-endian
+        const uint64_t group_count = header >> 1u;
+        const uint64_t byte_count  = group_count * reader.bit_width;
+
+        if (reader.byte_pos + byte_count > reader.size) {
+            return AD_ERROR_CODE_PRLE_FORMAT_INCORRECT;
+        }
+
+        reader.packed_left = (uint32_t) (group_count * 8u);
+        reader.bit_pos     = (uint64_t) reader.byte_pos * 8u;
+        reader.byte_pos   += (uint32_t) byte_count;
+    } else {
+        const uint32_t value_bytes = (reader.bit_width + 7u) / 8u;
+
+        if (reader.byte_pos + value_bytes > reader.size) {
+            return AD_ERROR_CODE_PRLE_FORMAT_INCORRECT;
+        }
+
+        reader.run_value = 0u;
+        memcpy(&reader.run_value, reader.ptr + reader.byte_pos, value_bytes);
+        reader.run_left  = header >> 1u;
+        reader.byte_pos += value_bytes;
+    }
+
+    return AD_ERROR_CODE_OK;
+}
+
+static auto own_read(const own_kernels_t &kernels, own_reader_t &reader, uint32_t *dst_ptr, uint32_t count)
+    -> uint32_t {
+    if (OWN_FORMAT_PRLE != reader.format) {
+        if (reader.bit_pos + (uint64_t) count * reader.bit_width > (uint64_t) reader.size * 8u) {
+            return reader.short_error;
+        }
+
+        own_unpack(kernels, reader.ptr, reader.size, reader.bit_pos, count, reader.bit_width,
+                   OWN_FORMAT_BE == reader.format, dst_ptr);
+        reader.bit_pos += (uint64_t) count * reader.bit_width;
+
+        return AD_ERROR_CODE_OK;
+    }
+
+    while (0u != count) {
+        if (0u != reader.run_left) {
+            const uint32_t run_count = std::min(count, reader.run_left);
+
+            std::fill_n(dst_ptr, run_count, reader.run_value);
+            reader.run_left -= run_count;
+            dst_ptr         += run_count;
+            count           -= run_count;
+        } else if (0u != reader.packed_left) {
+            const uint32_t run_count = std::min(count, reader.packed_left);
+
+            own_unpack(kernels, reader.ptr, reader.size, reader.bit_pos, run_count, reader.bit_width, false, dst_ptr);
+            reader.bit_pos     += (uint64_t) run_count * reader.bit_width;
+            reader.packed_left -= run_count;
+            dst_ptr            += run_count;
+            count              -= run_count;
+        } else {
+            const uint32_t status = own_prle_next_run(reader);
+
+            if (AD_ERROR_CODE_OK != status) {
+                return status;
+            }
+        }
+    }
+
+    return AD_ERROR_CODE_OK;
+}
+
+static auto own_skip(const own_kernels_t &kernels, own_reader_t &reader, uint32_t count) -> uint32_t {
+    if (OWN_FORMAT_PRLE != reader.format) {
+        if (reader.bit_pos + (uint64_t) count * reader.bit_width > (uint64_t) reader.size * 8u) {
+            return reader.short_error;
+        }
+
+        reader.bit_pos += (uint64_t) count * reader.bit_width;
+
+        return AD_ERROR_CODE_OK;
+    }
+
+    uint32_t scratch[OWN_BLOCK_SIZE];
+
+    while (0u != count) {
+        const uint32_t chunk  = std::min(count, OWN_BLOCK_SIZE);
+        const uint32_t status = own_read(kernels, reader, scratch, chunk);
+
+        if (AD_ERROR_CODE_OK != status) {
+            return status;
+        }
+
+        count -= chunk;
+    }
+
+    return AD_ERROR_CODE_OK;
+}
+
+/**
+ * @brief Copies `count` bits of a bit-vector starting from a byte boundary, converting them to little-endian order
+ */
+static inline void own_load_bits(const uint8_t *src_ptr, uint32_t bit_offset, uint32_t count, bool is_big_endian,
+                                 uint8_t *dst_ptr) {
+    const uint32_t byte_count = (count + 7u) / 8u;
+
+    memcpy(dst_ptr, src_ptr + bit_offset / 8u, byte_count);
+
+    if (is_big_endian) {
+        for (uint32_t idx = 0u; idx < byte_count; idx++) {
+            dst_ptr[idx] = own_lut.reverse[dst_ptr[idx]];
+        }
+    }
+
+    if (count & 7u) {
+        dst_ptr[byte_count - 1u] &= (uint8_t) ((1u << (count & 7u)) - 1u);
+    }
+}
+
+/* ################# OUTPUT STREAM ################# */
+
+/**
+ * @brief Writer of the output stream that keeps the aggregates of what it wrote
+ */
+struct own_writer_t {
+    uint8_t  *ptr          = nullptr;
+    uint32_t capacity      = 0u;
+    uint64_t bit_pos       = 0u;
+    uint32_t output_width  = 0u;            /**< 0 for nominal, otherwise 8, 16 or 32 */
+    uint32_t nominal_width = 1u;            /**< Element bit-width of nominal array output */
+    bool     is_big_endian = false;
+    bool     is_inverted   = false;
+    uint64_t initial_index = 0u;
+    uint32_t min_value     = UINT32_MAX;
+    uint32_t max_value     = 0u;
+    uint32_t sum           = 0u;
+};
+
+static inline void own_writer_init(own_writer_t &writer, const qplc_analytic_request *request_ptr,
+                                   uint32_t nominal_width) noexcept {
+    const uint32_t format = request_ptr->output_format & OWN_OUTPUT_WIDTH_MASK;
+
+    writer               = own_writer_t{};
+    writer.ptr           = request_ptr->dst_ptr;
+    writer.capacity      = request_ptr->dst_size;
+    writer.output_width  = (0u == format) ? 0u : (4u << format);
+    writer.nominal_width = nominal_width;
+    writer.is_big_endian = 0u != (request_ptr->output_format & OWN_OUTPUT_BE);
+    writer.is_inverted   = 0u != (request_ptr->output_format & OWN_OUTPUT_INVERT);
+    writer.initial_index = request_ptr->initial_output_index;
+}
+
+static inline void own_write_index(own_writer_t &writer, uint32_t value) noexcept {
+    uint8_t *dst_ptr = writer.ptr + (writer.bit_pos >> 3u);
+
+    switch (writer.output_width) {
+        case 8u:
+            *dst_ptr = (uint8_t) value;
+            break;
+        case 16u: {
+            const auto word = (uint16_t) (writer.is_big_endian ? __builtin_bswap16((uint16_t) value) : value);
+            memcpy(dst_ptr, &word, sizeof(word));
+            break;
+        }
+        default: {
+            const uint32_t dword = writer.is_big_endian ? __builtin_bswap32(value) : value;
+            memcpy(dst_ptr, &dword, sizeof(dword));
+            break;
+        }
+    }
+
+    writer.bit_pos += writer.output_width;
+}
+
+/**
+ * @brief Writes a bit-vector, or indices of its set bits for 8u/16u/32u outputs
+ *
+ * @note The aggregates are taken from the bit-vector whatever the output format is
+ */
+static auto own_emit_bits(own_writer_t &writer, uint8_t *bits_ptr, uint32_t count, uint32_t base_index)
+    -> uint32_t {
+    const uint32_t byte_count = (count + 7u) / 8u;
+
+    if (writer.is_inverted) {
+        for (uint32_t idx = 0u; idx < byte_count; idx++) {
+            bits_ptr[idx] = (uint8_t) ~bits_ptr[idx];
+        }
+
+        if (count & 7u) {
+            bits_ptr[byte_count - 1u] &= (uint8_t) ((1u << (count & 7u)) - 1u);
+        }
+    }
+
+    for (uint32_t idx = 0u; idx < byte_count; idx++) {
+        const uint32_t byte = bits_ptr[idx];
+
+        if (0u != byte) {
+            const uint32_t first = base_index + idx * 8u + (uint32_t) __builtin_ctz(byte);
+
+            writer.min_value  = std::min(writer.min_value, first);
+            writer.max_value  = base_index + idx * 8u + 31u - (uint32_t) __builtin_clz(byte);
+            writer.sum       += (uint32_t) __builtin_popcount(byte);
+        }
+    }
+
+    if (0u == writer.output_width) {
+        // Every block but the last one ends on a byte boundary, so whole bytes are copied
+        const uint64_t byte_pos = writer.bit_pos >> 3u;
+
+        if (byte_pos + byte_count > writer.capacity) {
+            return AD_ERROR_CODE_UNRECOVERABLE_OUTPUT_OVERFLOW;
+        }
+
+        for (uint32_t idx = 0u; idx < byte_count; idx++) {
+            writer.ptr[byte_pos + idx] = writer.is_big_endian ? own_lut.reverse[bits_ptr[idx]] : bits_ptr[idx];
+        }
+
+        writer.bit_pos += count;
+
+        return AD_ERROR_CODE_OK;
+    }
+
+    const uint64_t max_index = (32u == writer.output_width) ? UINT32_MAX : (1ull << writer.output_width) - 1u;
+
+    for (uint32_t idx = 0u; idx < byte_count; idx++) {
+        for (uint32_t byte = bits_ptr[idx]; 0u != byte; byte &= byte - 1u) {
+            const uint64_t index = writer.initial_index + base_index + idx * 8u + (uint32_t) __builtin_ctz(byte);
+
+            if (index > max_index) {
+                return AD_ERROR_CODE_OUTPUT_WIDTH_TOO_SMALL;
+            }
+
+            if ((writer.bit_pos + writer.output_width) / 8u > writer.capacity) {
+                return AD_ERROR_CODE_UNRECOVERABLE_OUTPUT_OVERFLOW;
+            }
+
+            own_write_index(writer, (uint32_t) index);
+        }
+    }
+
+    return AD_ERROR_CODE_OK;
+}
+
+static void own_pack_nominal(own_writer_t &writer, const uint32_t *src_ptr, uint32_t count) {
+    const uint32_t bit_width = writer.nominal_width;
+    uint64_t       byte_pos  = writer.bit_pos >> 3u;
+    uint32_t       acc_bits  = (uint32_t) (writer.bit_pos & 7u);
+    uint64_t       acc;
+
+    // The partial byte left by the previous call is taken back into the accumulator
+    if (writer.is_big_endian) {
+        acc = acc_bits ? (writer.ptr[byte_pos] >> (8u - acc_bits)) : 0u;
+
+        for (uint32_t idx = 0u; idx < count; idx++) {
+            acc       = (acc << bit_width) | src_ptr[idx];
+            acc_bits += bit_width;
+
+            while (acc_bits >= 8u) {
+                acc_bits -= 8u;
+                writer.ptr[byte_pos++] = (uint8_t) (acc >> acc_bits);
+            }
+
+            acc &= (1ull << acc_bits) - 1u;
+        }
+
+        if (acc_bits) {
+            writer.ptr[byte_pos] = (uint8_t) (acc << (8u - acc_bits));
+        }
+    } else {
+        acc = acc_bits ? (writer.ptr[byte_pos] & ((1u << acc_bits) - 1u)) : 0u;
+
+        for (uint32_t idx = 0u; idx < count; idx++) {
+            acc      |= (uint64_t) src_ptr[idx] << acc_bits;
+            acc_bits += bit_width;
+
+            while (acc_bits >= 8u) {
+                writer.ptr[byte_pos++] = (uint8_t) acc;
+                acc      >>= 8u;
+                acc_bits  -= 8u;
+            }
+        }
+
+        if (acc_bits) {
+            writer.ptr[byte_pos] = (uint8_t) acc;
+        }
+    }
+
+    writer.bit_pos += (uint64_t) count * bit_width;
+}
+
+/**
+ * @brief Writes an array of elements with the output width or the nominal one
+ */
+static auto own_emit_values(const own_kernels_t &kernels, own_writer_t &writer, const uint32_t *src_ptr,
+                            uint32_t count) -> uint32_t {
+    if (0u == count) {
+        return AD_ERROR_CODE_OK;
+    }
+
+    uint32_t min_value;
+    uint32_t max_value;
+    uint32_t sum;
+
+    kernels.aggregate(src_ptr, count, &min_value, &max_value, &sum);
+    writer.min_value  = std::min(writer.min_value, min_value);
+    writer.max_value  = std::max(writer.max_value, max_value);
+    writer.sum       += sum;
+
+    uint32_t bit_width = writer.output_width;
+
+    if (0u == bit_width) {
+        bit_width = writer.nominal_width;
+
+        if (0u != (writer.bit_pos & 7u) || (8u != bit_width && 16u != bit_width && 32u != bit_width)) {
+            if ((writer.bit_pos + (uint64_t) count * bit_width + 7u) / 8u > writer.capacity) {
+                return AD_ERROR_CODE_UNRECOVERABLE_OUTPUT_OVERFLOW;
+            }
+
+            own_pack_nominal(writer, src_ptr, count);
+
+            return AD_ERROR_CODE_OK;
+        }
+    } else if (bit_width < 32u && 0u != (max_value >> bit_width)) {
+        return AD_ERROR_CODE_OUTPUT_WIDTH_TOO_SMALL;
+    }
+
+    const uint64_t byte_pos = writer.bit_pos >> 3u;
+    uint8_t        *dst_ptr = writer.ptr + byte_pos;
+
+    if (byte_pos + (uint64_t) count * (bit_width / 8u) > writer.capacity) {
+        return AD_ERROR_CODE_UNRECOVERABLE_OUTPUT_OVERFLOW;
+    }
+
+    switch (bit_width) {
+        case 8u:
+            kernels.pack_8u(src_ptr, count, dst_ptr);
+            break;
+        case 16u:
+            kernels.pack_16u(src_ptr, count, dst_ptr);
+            if (writer.is_big_endian) {
+                for (uint32_t idx = 0u; idx < count; idx++) {
+                    std::swap(dst_ptr[idx * 2u], dst_ptr[idx * 2u + 1u]);
+                }
+            }
+            break;
+        default:
+            memcpy(dst_ptr, src_ptr, count * sizeof(uint32_t));
+            if (writer.is_big_endian) {
+                for (uint32_t idx = 0u; idx < count; idx++) {
+                    const uint32_t value = __builtin_bswap32(src_ptr[idx]);
+                    memcpy(dst_ptr + idx * 4u, &value, sizeof(value));
+                }
+            }
+            break;
+    }
+
+    writer.bit_pos += (uint64_t) count * bit_width;
+
+    return AD_ERROR_CODE_OK;
+}
+
+static inline void own_finalize(const qplc_analytic_request *request_ptr,
+                                const own_writer_t &writer,
+                                qplc_analytic_result *result_ptr) noexcept {
+    result_ptr->output_size   = (uint32_t) ((writer.bit_pos + 7u) / 8u);
+    result_ptr->output_bits   = (uint32_t) (writer.bit_pos & 7u);
+    result_ptr->min_first_agg = writer.min_value;
+    result_ptr->max_last_agg  = writer.max_value;
+    result_ptr->sum_agg       = writer.sum;
+    result_ptr->crc           = own_crc32(request_ptr->crc_seed, request_ptr->src1_ptr, request_ptr->src1_size);
+    result_ptr->xor_checksum  = own_xor_checksum(request_ptr->xor_seed, request_ptr->src1_ptr, request_ptr->src1_size);
+}
+
+static inline auto own_init_source1(own_reader_t &reader, const qplc_analytic_request *request_ptr) noexcept
+    -> uint32_t {
+    return own_reader_init(reader, request_ptr->src1_ptr, request_ptr->src1_size, request_ptr->src1_format,
+                           request_ptr->src1_bit_width, AD_ERROR_CODE_SRC1_TOO_SMALL);
+}
+
+/**
+ * @brief Checks dropped bits leave a key narrow enough to index a set
+ */
+static inline auto own_get_key_width(const own_reader_t &reader, const qplc_analytic_request *request_ptr) noexcept
+    -> uint32_t {
+    const uint32_t dropped = request_ptr->drop_low_bits + request_ptr->drop_high_bits;
+
+    if (dropped >= reader.bit_width || reader.bit_width - dropped > OWN_MAX_SET_BIT_WIDTH) {
+        return 0u;
+    }
+
+    return reader.bit_width - dropped;
+}
+
+/* ################# OPERATIONS ################# */
+
+extern "C" {
+
+uint32_t qplc_analytic_scan(const qplc_analytic_request *request_ptr, qplc_analytic_result *result_ptr) {
+    const auto   &kernels = own_get_kernels();
+    own_reader_t reader;
+    own_writer_t writer;
+    uint32_t     values[OWN_BLOCK_SIZE];
+    uint8_t      bits[OWN_BLOCK_BYTES];
+
+    uint32_t status = own_init_source1(reader, request_ptr);
+    own_writer_init(writer, request_ptr, 1u);
+
+    for (uint32_t base = 0u; AD_ERROR_CODE_OK == status && base < request_ptr->elements_count; base += OWN_BLOCK_SIZE) {
+        const uint32_t count = std::min(OWN_BLOCK_SIZE, request_ptr->elements_count - base);
+
+        status = own_read(kernels, reader, values, count);
+        if (AD_ERROR_CODE_OK == status) {
+            kernels.scan(values, count, request_ptr->param_low, request_ptr->param_high, bits);
+            status = own_emit_bits(writer, bits, count, base);
+        }
+    }
+
+    if (AD_ERROR_CODE_OK == status) {
+        own_finalize(request_ptr, writer, result_ptr);
+    }
+
+    return status;
+}
+
+uint32_t qplc_analytic_set_membership(const qplc_analytic_request *request_ptr, qplc_analytic_result *result_ptr) {
+    const auto   &kernels = own_get_kernels();
+    own_reader_t reader;
+    own_writer_t writer;
+    uint32_t     values[OWN_BLOCK_SIZE];
+    uint8_t      bits[OWN_BLOCK_BYTES];
+
+    // Little-endian copy of the set with room for a 4-byte gather at its last byte
+    alignas(64) uint8_t set[OWN_MAX_SET_BYTES + sizeof(uint32_t)] = {};
+
+    uint32_t status = own_init_source1(reader, request_ptr);
+    own_writer_init(writer, request_ptr, 1u);
+
+    const uint32_t key_width = own_get_key_width(reader, request_ptr);
+
+    if (AD_ERROR_CODE_OK == status && 0u == key_width) {
+        status = QPLC_ANALYTIC_INVALID_FLAGS;
+    }
+
+    if (AD_ERROR_CODE_OK == status) {
+        const uint32_t set_bits = 1u << key_width;
+
+        if ((uint64_t) request_ptr->src2_size * 8u < set_bits) {
+            status = AD_ERROR_CODE_SRC2_TOO_SMALL;
+        } else {
+            own_load_bits(request_ptr->src2_ptr, 0u, set_bits, 0u != request_ptr->src2_big_endian, set);
+        }
+    }
+
+    for (uint32_t base = 0u; AD_ERROR_CODE_OK == status && base < request_ptr->elements_count; base += OWN_BLOCK_SIZE) {
+        const uint32_t count = std::min(OWN_BLOCK_SIZE, request_ptr->elements_count - base);
+
+        status = own_read(kernels, reader, values, count);
+        if (AD_ERROR_CODE_OK == status) {
+            kernels.membership(values, count, request_ptr->drop_low_bits, (1u << key_width) - 1u, set, bits);
+            status = own_emit_bits(writer, bits, count, base);
+        }
+    }
+
+    if (AD_ERROR_CODE_OK == status) {
+        own_finalize(request_ptr, writer, result_ptr);
+    }
+
+    return status;
+}
+
+uint32_t qplc_analytic_extract(const qplc_analytic_request *request_ptr, qplc_analytic_result *result_ptr) {
+    const auto   &kernels = own_get_kernels();
+    own_reader_t reader;
+    own_writer_t writer;
+    uint32_t     values[OWN_BLOCK_SIZE];
+
+    uint32_t status = own_init_source1(reader, request_ptr);
+    own_writer_init(writer, request_ptr, reader.bit_width);
+
+    if (writer.is_inverted) {
+        status = QPLC_ANALYTIC_INVALID_FLAGS;
+    }
+
+    const uint32_t first = request_ptr->param_low;
+    const auto     end   = (uint32_t) std::min<uint64_t>(request_ptr->elements_count,
+                                                         (uint64_t) request_ptr->param_high + 1u);
+
+    // An empty range (first > last or first out of input) produces an empty output
+    if (AD_ERROR_CODE_OK == status && first < end) {
+        status = own_skip(kernels, reader, first);
+    }
+
+    for (uint32_t base = first; AD_ERROR_CODE_OK == status && base < end; base += OWN_BLOCK_SIZE) {
+        const uint32_t count = std::min(OWN_BLOCK_SIZE, end - base);
+
+        status = own_read(kernels, reader, values, count);
+        if (AD_ERROR_CODE_OK == status) {
+            status = own_emit_values(kernels, writer, values, count);
+        }
+    }
+
+    if (AD_ERROR_CODE_OK == status) {
+        own_finalize(request_ptr, writer, result_ptr);
+    }
+
+    return status;
+}
+
+uint32_t qplc_analytic_select(const qplc_analytic_request *request_ptr, qplc_analytic_result *result_ptr) {
+    const auto   &kernels = own_get_kernels();
+    own_reader_t reader;
+    own_writer_t writer;
+    uint32_t     values[OWN_BLOCK_SIZE];
+    uint32_t     selected[OWN_BLOCK_SIZE + OWN_BLOCK_SLACK];
+    uint8_t      mask[OWN_BLOCK_BYTES];
+
+    uint32_t status = own_init_source1(reader, request_ptr);
+    own_writer_init(writer, request_ptr, reader.bit_width);
+
+    if (writer.is_inverted) {
+        status = QPLC_ANALYTIC_INVALID_FLAGS;
+    } else if ((uint64_t) request_ptr->src2_size * 8u < request_ptr->elements_count) {
+        status = AD_ERROR_CODE_SRC2_TOO_SMALL;
+    }
+
+    for (uint32_t base = 0u; AD_ERROR_CODE_OK == status && base < request_ptr->elements_count; base += OWN_BLOCK_SIZE) {
+        const uint32_t count = std::min(OWN_BLOCK_SIZE, request_ptr->elements_count - base);
+
+        status = own_read(kernels, reader, values, count);
+        if (AD_ERROR_CODE_OK == status) {
+            own_load_bits(request_ptr->src2_ptr, base, count, 0u != request_ptr->src2_big_endian, mask);
+            status = own_emit_values(kernels, writer, selected, kernels.select(values, mask, count, selected));
+        }
+    }
+
+    if (AD_ERROR_CODE_OK == status) {
+        own_finalize(request_ptr, writer, result_ptr);
+    }
+
+    return status;
+}
+
+uint32_t qplc_analytic_rle_burst(const qplc_analytic_request *request_ptr, qplc_analytic_result *result_ptr) {
+    const auto   &kernels = own_get_kernels();
+    own_reader_t counters_reader;
+    own_reader_t elements_reader;
+    own_writer_t writer;
+    uint32_t     counters[OWN_BLOCK_SIZE];
+    uint32_t     elements[OWN_BLOCK_SIZE];
+    uint32_t     output[OWN_BLOCK_SIZE];
+
+    uint32_t status = own_init_source1(counters_reader, request_ptr);
+
+    if (AD_ERROR_CODE_OK == status) {
+        status = own_reader_init(elements_reader, request_ptr->src2_ptr, request_ptr->src2_size,
+                                 request_ptr->src2_big_endian ? OWN_FORMAT_BE : OWN_FORMAT_LE,
+                                 request_ptr->src2_bit_width, AD_ERROR_CODE_SRC2_TOO_SMALL);
+    }
+
+    own_writer_init(writer, request_ptr, elements_reader.bit_width);
+
+    const uint32_t counter_width = counters_reader.bit_width;
+
+    if (writer.is_inverted || (8u != counter_width && 16u != counter_width && 32u != counter_width)) {
+        status = (AD_ERROR_CODE_OK == status) ? QPLC_ANALYTIC_INVALID_FLAGS : status;
+    }
+
+    // 32-bit counters are cumulative output lengths, one more than elements
+    const bool     is_cumulative  = 32u == counter_width;
+    const uint32_t elements_total = request_ptr->elements_count - (is_cumulative ? 1u : 0u);
+    uint32_t       elements_read  = 0u;
+    uint32_t       element_idx    = 0u;
+    uint32_t       elements_ready = 0u;
+    uint32_t       output_count   = 0u;
+    uint32_t       previous       = 0u;
+
+    for (uint32_t base = 0u; AD_ERROR_CODE_OK == status && base < request_ptr->elements_count; base += OWN_BLOCK_SIZE) {
+        const uint32_t count = std::min(OWN_BLOCK_SIZE, request_ptr->elements_count - base);
+
+        status = own_read(kernels, counters_reader, counters, count);
+
+        for (uint32_t idx = 0u; AD_ERROR_CODE_OK == status && idx < count; idx++) {
+            uint32_t repeats = counters[idx];
+
+            if (is_cumulative) {
+                if (0u == base + idx) {
+                    previous = repeats;
+                    continue;
+                }
+
+                if (repeats < previous) {
+                    status = AD_ERROR_CODE_INVALID_RLE_COUNT;
+                    break;
+                }
+
+                repeats  = counters[idx] - previous;
+                previous = counters[idx];
+            }
+
+            if (element_idx == elements_ready) {
+                elements_ready = std::min(OWN_BLOCK_SIZE, elements_total - elements_read);
+                element_idx    = 0u;
+                elements_read += elements_ready;
+                status         = own_read(kernels, elements_reader, elements, elements_ready);
+            }
+
+            const uint32_t value = elements[element_idx++];
+
+            while (AD_ERROR_CODE_OK == status && 0u != repeats) {
+                const uint32_t chunk = std::min(repeats, OWN_BLOCK_SIZE - output_count);
+
+                std::fill_n(output + output_count, chunk, value);
+                output_count += chunk;
+                repeats      -= chunk;
+
+                if (OWN_BLOCK_SIZE == output_count) {
+                    status       = own_emit_values(kernels, writer, output, output_count);
+                    output_count = 0u;
+                }
+            }
+        }
+    }
+
+    if (AD_ERROR_CODE_OK == status) {
+        status = own_emit_values(kernels, writer, output, output_count);
+    }
+
+    if (AD_ERROR_CODE_OK == status) {
+        own_finalize(request_ptr, writer, result_ptr);
+    }
+
+    return status;
+}
+
+uint32_t qplc_analytic_find_unique(const qplc_analytic_request *request_ptr, qplc_analytic_result *result_ptr) {
+    const auto   &kernels = own_get_kernels();
+    own_reader_t reader;
+    own_writer_t writer;
+    uint32_t     values[OWN_BLOCK_SIZE];
+    uint8_t      set[OWN_MAX_SET_BYTES] = {};
+
+    uint32_t status = own_init_source1(reader, request_ptr);
+    own_writer_init(writer, request_ptr, 1u);
+
+    const uint32_t key_width = own_get_key_width(reader, request_ptr);
+    const uint32_t key_mask  = (1u << key_width) - 1u;
+    const uint32_t shift     = request_ptr->drop_low_bits;
+
+    if (AD_ERROR_CODE_OK == status && 0u == key_width) {
+        status = QPLC_ANALYTIC_INVALID_FLAGS;
+    }
+
+    for (uint32_t base = 0u; AD_ERROR_CODE_OK == status && base < request_ptr->elements_count; base += OWN_BLOCK_SIZE) {
+        const uint32_t count = std::min(OWN_BLOCK_SIZE, request_ptr->elements_count - base);
+
+        status = own_read(kernels, reader, values, count);
+
+        for (uint32_t idx = 0u; AD_ERROR_CODE_OK == status && idx < count; idx++) {
+            const uint32_t key = (values[idx] >> shift) & key_mask;
+            set[key >> 3u] |= (uint8_t) (1u << (key & 7u));
+        }
+    }
+
+    if (AD_ERROR_CODE_OK == status) {
+        status = own_emit_bits(writer, set, 1u << key_width, 0u);
+    }
+
+    if (AD_ERROR_CODE_OK == status) {
+        own_finalize(request_ptr, writer, result_ptr);
+    }
+
+    return status;
+}
+
+uint32_t qplc_analytic_expand(const qplc_analytic_request *request_ptr, qplc_analytic_result *result_ptr) {
+    const auto   &kernels = own_get_kernels();
+    own_reader_t reader;
+    own_writer_t writer;
+    uint32_t     values[OWN_BLOCK_SIZE + OWN_BLOCK_SLACK];
+    uint32_t     expanded[OWN_BLOCK_SIZE + OWN_BLOCK_SLACK];
+    uint8_t      mask[OWN_BLOCK_BYTES];
+
+    uint32_t status = own_init_source1(reader, request_ptr);
+    own_writer_init(writer, request_ptr, reader.bit_width);
+
+    // Number of elements counts mask bits, `source-1` holds one element per set bit
+    if (writer.is_inverted) {
+        status = QPLC_ANALYTIC_INVALID_FLAGS;
+    } else if ((uint64_t) request_ptr->src2_size * 8u < request_ptr->elements_count) {
+        status = AD_ERROR_CODE_SRC2_TOO_SMALL;
+    }
+
+    for (uint32_t base = 0u; AD_ERROR_CODE_OK == status && base < request_ptr->elements_count; base += OWN_BLOCK_SIZE) {
+        const uint32_t count      = std::min(OWN_BLOCK_SIZE, request_ptr->elements_count - base);
+        uint32_t       population = 0u;
+
+        own_load_bits(request_ptr->src2_ptr, base, count, 0u != request_ptr->src2_big_endian, mask);
+
+        for (uint32_t idx = 0u; idx < (count + 7u) / 8u; idx++) {
+            population += (uint32_t) __builtin_popcount(mask[idx]);
+        }
+
+        status = own_read(kernels, reader, values, population);
+        if (AD_ERROR_CODE_OK == status) {
+            kernels.expand(values, mask, count, expanded);
+            status = own_emit_values(kernels, writer, expanded, count);
+        }
+    }
+
+    if (AD_ERROR_CODE_OK == status) {
+        own_finalize(request_ptr, writer, result_ptr);
+    }
+
+    return status;
+}
+
+qplc_analytic_isa qplc_analytic_get_isa(void) {
+    return static_cast<qplc_analytic_isa>(own_get_isa_state().load(std::memory_order_relaxed));
+}
+
+void qplc_analytic_set_isa(qplc_analytic_isa isa) {
+    if (static_cast<uint32_t>(isa) <= static_cast<uint32_t>(own_detect_isa())) {
+        own_get_isa_state().store(static_cast<uint32_t>(isa), std::memory_order_relaxed);
+    }
+}
+
+}
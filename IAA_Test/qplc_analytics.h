@@ -0,0 +1,115 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+/*
+ *  Intel® Query Processing Library (Intel® QPL)
+ *  Core API (private C API)
+ */
+
+#ifndef QPL_QPLC_ANALYTICS_H_
+#define QPL_QPLC_ANALYTICS_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define QPLC_ANALYTIC_INVALID_FLAGS 0x100u  /**< Parameters the device rejects with AD_STATUS_INVALID_FILTER_FLAG */
+
+/**
+ * @brief Instruction set the analytic kernels were dispatched to
+ */
+typedef enum {
+    qplc_analytic_isa_scalar  = 0u,    /**< Portable C++ */
+    qplc_analytic_isa_avx2    = 1u,    /**< Intel® AVX2 */
+    qplc_analytic_isa_avx512  = 2u     /**< Intel® AVX-512 (F, BW, VL) */
+} qplc_analytic_isa;
+
+/**
+ * @brief Streams and parameters of one analytic operation.
+ *
+ * @details Encodings follow the hardware descriptor: `src1_format` holds a `hw_iaa_input_format` value and
+ * `output_format` holds a `hw_iaa_output_format` value with its big-endian and inverse modifiers.
+ * For a PRLE `source-1` the bit-width is taken from the stream and `src1_bit_width` is ignored.
+ */
+typedef struct {
+    const uint8_t *src1_ptr;               /**< `source-1` stream */
+    uint32_t      src1_size;               /**< `source-1` size in bytes */
+    uint32_t      elements_count;          /**< Number of input elements */
+    uint32_t      src1_format;             /**< `source-1` format: LE, BE or PRLE */
+    uint32_t      src1_bit_width;          /**< `source-1` element bit-width, 1..32 */
+    const uint8_t *src2_ptr;               /**< Mask, set or element array depending on the operation */
+    uint32_t      src2_size;               /**< `source-2` size in bytes */
+    uint32_t      src2_bit_width;          /**< `source-2` element bit-width, 1..32 */
+    uint32_t      src2_big_endian;         /**< Non-zero if `source-2` is big-endian */
+    uint8_t       *dst_ptr;                /**< Output stream */
+    uint32_t      dst_size;                /**< Output capacity in bytes */
+    uint32_t      output_format;           /**< Output format with modifiers */
+    uint32_t      drop_low_bits;           /**< Low bits dropped by set membership and find unique */
+    uint32_t      drop_high_bits;          /**< High bits dropped by set membership and find unique */
+    uint32_t      param_low;               /**< Scan low limit or extract first index */
+    uint32_t      param_high;              /**< Scan high limit or extract last index */
+    uint32_t      initial_output_index;    /**< Added to indices written by index outputs */
+    uint32_t      crc_seed;                /**< CRC32 of the preceding data */
+    uint32_t      xor_seed;                /**< XOR checksum of the preceding data */
+} qplc_analytic_request;
+
+/**
+ * @brief Values reported by an analytic operation, mirror completion record fields
+ */
+typedef struct {
+    uint32_t output_size;      /**< Bytes written to the output */
+    uint32_t output_bits;      /**< Valid bits in the last output byte, 0 if the output ends on a byte boundary */
+    uint32_t min_first_agg;    /**< Minimal value or index of the first set bit */
+    uint32_t max_last_agg;     /**< Maximal value or index of the last set bit */
+    uint32_t sum_agg;          /**< Sum of values or number of set bits */
+    uint32_t crc;              /**< CRC32 of `source-1` */
+    uint32_t xor_checksum;     /**< XOR checksum of `source-1` 16-bit words */
+} qplc_analytic_result;
+
+/**
+ * @name Analytic kernels
+ *
+ * @brief CPU implementations of the accelerator filter operations.
+ *
+ * @details Each function returns 0 on success, one of `AD_ERROR_CODE_*` values the device would report for
+ * the same request, or @ref QPLC_ANALYTIC_INVALID_FLAGS. Zero number of elements is the caller's check.
+ * Output written before an error is left in place, the result is filled on success only.
+ *
+ * @{
+ */
+uint32_t qplc_analytic_scan(const qplc_analytic_request *request_ptr, qplc_analytic_result *result_ptr);
+
+uint32_t qplc_analytic_set_membership(const qplc_analytic_request *request_ptr, qplc_analytic_result *result_ptr);
+
+uint32_t qplc_analytic_extract(const qplc_analytic_request *request_ptr, qplc_analytic_result *result_ptr);
+
+uint32_t qplc_analytic_select(const qplc_analytic_request *request_ptr, qplc_analytic_result *result_ptr);
+
+uint32_t qplc_analytic_rle_burst(const qplc_analytic_request *request_ptr, qplc_analytic_result *result_ptr);
+
+uint32_t qplc_analytic_find_unique(const qplc_analytic_request *request_ptr, qplc_analytic_result *result_ptr);
+
+uint32_t qplc_analytic_expand(const qplc_analytic_request *request_ptr, qplc_analytic_result *result_ptr);
+
+/**
+ * @brief Returns instruction set selected for the running CPU
+ */
+qplc_analytic_isa qplc_analytic_get_isa(void);
+
+/**
+ * @brief Forces a narrower instruction set, a request wider than the CPU supports is ignored
+ */
+void qplc_analytic_set_isa(qplc_analytic_isa isa);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //QPL_QPLC_ANALYTICS_H_
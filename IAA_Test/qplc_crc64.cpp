@@ -0,0 +1,375 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+/*
+ *  Intel® Query Processing Library (Intel® QPL)
+ *  Core API (private C API)
+ */
+
+#include <immintrin.h>
+#include <atomic>
+
+#include "qplc_crc64.h"
+
+#define OWN_FOLD_MIN_SIZE       16u        /**< Smallest input folded with carry-less multiplication */
+#define OWN_VPCLMUL_MIN_SIZE    256u       /**< Smallest input the 512-bit kernel folds with four accumulators */
+
+/* ################# CONSTANTS ################# */
+
+static inline auto own_reflect(uint64_t value) noexcept -> uint64_t {
+    uint64_t result = 0u;
+
+    for (uint32_t bit = 0u; bit < 64u; bit++) {
+        result = (result << 1u) | ((value >> bit) & 1u);
+    }
+
+    return result;
+}
+
+/**
+ * @brief x^power modulo the polynomial in the normal form
+ */
+static inline auto own_x_pow_mod(uint64_t polynomial, uint32_t power) noexcept -> uint64_t {
+    uint64_t remainder = 1u;
+
+    for (uint32_t step = 0u; step < power; step++) {
+        remainder = (remainder << 1u) ^ (polynomial & (0u - (remainder >> 63u)));
+    }
+
+    return remainder;
+}
+
+/**
+ * @brief Constants folding a 128-bit lane forward by `distance` bits, see @ref qplc_crc64_context
+ *
+ * @details In the reflected order the low half of a lane holds the high degree coefficients, and the product
+ * of two reflected 64-bit values lands one bit short of the reflected 128-bit product, which x^(d-1) instead
+ * of x^d makes up for.
+ */
+static inline void own_init_fold(uint64_t (&fold)[2], uint64_t polynomial, bool is_be_bit_order, uint32_t distance)
+noexcept {
+    if (is_be_bit_order) {
+        fold[0] = own_x_pow_mod(polynomial, distance);
+        fold[1] = own_x_pow_mod(polynomial, distance + 64u);
+    } else {
+        fold[0] = own_reflect(own_x_pow_mod(polynomial, distance + 63u));
+        fold[1] = own_reflect(own_x_pow_mod(polynomial, distance - 1u));
+    }
+}
+
+/**
+ * @brief Low 64 bits of floor(x^128 / polynomial), the x^64 term of the quotient is implied
+ */
+static inline auto own_barrett_quotient(uint64_t polynomial) noexcept -> uint64_t {
+    unsigned __int128 remainder = static_cast<unsigned __int128>(polynomial) << 64u;
+    uint64_t          quotient  = 0u;
+
+    for (uint32_t degree = 64u; degree-- > 0u;) {
+        if (0u != ((uint64_t) (remainder >> (64u + degree)) & 1u)) {
+            quotient |= 1ull << degree;
+            remainder ^= static_cast<unsigned __int128>(polynomial) << degree;
+        }
+    }
+
+    return quotient;
+}
+
+/* ################# KERNELS ################# */
+
+static inline auto own_crc64_table(const qplc_crc64_context *context_ptr,
+                                   uint64_t crc,
+                                   const uint8_t *src_ptr,
+                                   uint32_t size) noexcept -> uint64_t {
+    const uint64_t *table = context_ptr->table;
+
+    if (0u != context_ptr->is_be_bit_order) {
+        for (uint32_t idx = 0u; idx < size; idx++) {
+            crc = (crc << 8u) ^ table[(crc >> 56u) ^ src_ptr[idx]];
+        }
+    } else {
+        for (uint32_t idx = 0u; idx < size; idx++) {
+            crc = (crc >> 8u) ^ table[(crc ^ src_ptr[idx]) & 0xFFu];
+        }
+    }
+
+    return crc;
+}
+
+#define OWN_PCLMUL __attribute__((target("pclmul,ssse3,sse4.1")))
+
+/**
+ * @brief Lane holding 16 data bytes as a polynomial, the first byte carries the highest degree coefficients
+ */
+OWN_PCLMUL static inline auto own_load_lane(const uint8_t *src_ptr, bool is_be_bit_order) noexcept -> __m128i {
+    const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src_ptr));
+
+    return is_be_bit_order
+           ? _mm_shuffle_epi8(data, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15))
+           : data;
+}
+
+OWN_PCLMUL static inline auto own_fold_lane(__m128i lane, __m128i fold, __m128i data) noexcept -> __m128i {
+    return _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(lane, fold, 0x00), _mm_clmulepi64_si128(lane, fold, 0x11)),
+                         data);
+}
+
+/**
+ * @brief Adds the CRC register to the first 64 data bits of a lane
+ */
+OWN_PCLMUL static inline auto own_seed_lane(__m128i lane, uint64_t crc, bool is_be_bit_order) noexcept -> __m128i {
+    return _mm_xor_si128(lane, is_be_bit_order
+                               ? _mm_set_epi64x((long long) crc, 0)
+                               : _mm_set_epi64x(0, (long long) crc));
+}
+
+/**
+ * @brief Reduces the folded lane to the CRC register of the data folded into it
+ *
+ * @details The lane L is moved forward by 64 bits as L_hi * x^128 + L_lo * x^64, which is 128 bits T again,
+ * and T modulo the polynomial is taken with a Barrett quotient. In the reflected order every product comes one
+ * bit short of its reflected value and is shifted back.
+ */
+OWN_PCLMUL static inline auto own_reduce_lane(const qplc_crc64_context *context_ptr, __m128i lane, bool is_be_bit_order)
+noexcept -> uint64_t {
+    const __m128i fold_128 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(context_ptr->fold_128));
+    const __m128i barrett  = _mm_loadu_si128(reinterpret_cast<const __m128i *>(context_ptr->barrett));
+
+    if (is_be_bit_order) {
+        const __m128i  moved    = _mm_clmulepi64_si128(lane, fold_128, 0x01);
+        const uint64_t moved_hi = (uint64_t) _mm_extract_epi64(moved, 1) ^ (uint64_t) _mm_cvtsi128_si64(lane);
+        const uint64_t moved_lo = (uint64_t) _mm_cvtsi128_si64(moved);
+        const __m128i  high     = _mm_cvtsi64_si128((long long) moved_hi);
+        const uint64_t quotient = (uint64_t) _mm_extract_epi64(_mm_clmulepi64_si128(high, barrett, 0x00), 1) ^ moved_hi;
+
+        return moved_lo ^ (uint64_t) _mm_cvtsi128_si64(
+                _mm_clmulepi64_si128(_mm_cvtsi64_si128((long long) quotient), barrett, 0x10));
+    }
+
+    const __m128i  moved    = _mm_clmulepi64_si128(lane, fold_128, 0x10);
+    const uint64_t moved_hi = (uint64_t) _mm_cvtsi128_si64(moved) ^ (uint64_t) _mm_extract_epi64(lane, 1);
+    const uint64_t moved_lo = (uint64_t) _mm_extract_epi64(moved, 1);
+    const __m128i  high     = _mm_cvtsi64_si128((long long) moved_hi);
+    const uint64_t quotient = ((uint64_t) _mm_cvtsi128_si64(_mm_clmulepi64_si128(high, barrett, 0x00)) << 1u)
+                              ^ moved_hi;
+    const __m128i  product  = _mm_clmulepi64_si128(_mm_cvtsi64_si128((long long) quotient), barrett, 0x10);
+
+    return moved_lo ^ ((uint64_t) _mm_extract_epi64(product, 1) << 1u)
+           ^ ((uint64_t) _mm_cvtsi128_si64(product) >> 63u);
+}
+
+/**
+ * @brief Folds 16-byte blocks past `offset` into the lane and reduces it with the tail
+ */
+OWN_PCLMUL static inline auto own_finish_lane(const qplc_crc64_context *context_ptr,
+                                              __m128i lane,
+                                              const uint8_t *src_ptr,
+                                              uint32_t offset,
+                                              uint32_t size) noexcept -> uint64_t {
+    const bool    is_be_bit_order = 0u != context_ptr->is_be_bit_order;
+    const __m128i fold_128        = _mm_loadu_si128(reinterpret_cast<const __m128i *>(context_ptr->fold_128));
+
+    for (; offset + 16u <= size; offset += 16u) {
+        lane = own_fold_lane(lane, fold_128, own_load_lane(src_ptr + offset, is_be_bit_order));
+    }
+
+    const uint64_t crc = own_reduce_lane(context_ptr, lane, is_be_bit_order);
+
+    return own_crc64_table(context_ptr, crc, src_ptr + offset, size - offset);
+}
+
+OWN_PCLMUL static auto own_crc64_pclmul(const qplc_crc64_context *context_ptr,
+                                        uint64_t crc,
+                                        const uint8_t *src_ptr,
+                                        uint32_t size) noexcept -> uint64_t {
+    const bool is_be_bit_order = 0u != context_ptr->is_be_bit_order;
+    __m128i    lane            = own_seed_lane(own_load_lane(src_ptr, is_be_bit_order), crc, is_be_bit_order);
+    uint32_t   offset          = 16u;
+
+    if (size >= 64u) {
+        const __m128i fold_512 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(context_ptr->fold_512));
+        const __m128i fold_128 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(context_ptr->fold_128));
+        __m128i       lane_1   = own_load_lane(src_ptr + 16u, is_be_bit_order);
+        __m128i       lane_2   = own_load_lane(src_ptr + 32u, is_be_bit_order);
+        __m128i       lane_3   = own_load_lane(src_ptr + 48u, is_be_bit_order);
+
+        // Four independent chains hide the multiplication latency
+        for (offset = 64u; offset + 64u <= size; offset += 64u) {
+            lane   = own_fold_lane(lane, fold_512, own_load_lane(src_ptr + offset, is_be_bit_order));
+            lane_1 = own_fold_lane(lane_1, fold_512, own_load_lane(src_ptr + offset + 16u, is_be_bit_order));
+            lane_2 = own_fold_lane(lane_2, fold_512, own_load_lane(src_ptr + offset + 32u, is_be_bit_order));
+            lane_3 = own_fold_lane(lane_3, fold_512, own_load_lane(src_ptr + offset + 48u, is_be_bit_order));
+        }
+
+        lane = own_fold_lane(lane, fold_128, lane_1);
+        lane = own_fold_lane(lane, fold_128, lane_2);
+        lane = own_fold_lane(lane, fold_128, lane_3);
+    }
+
+    return own_finish_lane(context_ptr, lane, src_ptr, offset, size);
+}
+
+#define OWN_VPCLMUL __attribute__((target("avx512f,avx512bw,vpclmulqdq,pclmul,ssse3,sse4.1")))
+
+/**
+ * @brief Masked forms of the lane broadcast and extract, the unmasked ones trip -Wuninitialized in GCC headers
+ */
+OWN_VPCLMUL static inline auto own_broadcast_lane(__m128i lane) noexcept -> __m512i {
+    return _mm512_maskz_broadcast_i32x4(0xFFFF, lane);
+}
+
+OWN_VPCLMUL static inline auto own_extract_lane(__m512i vector, const int lane_idx) noexcept -> __m128i {
+    switch (lane_idx) {
+        case 0:
+            return _mm512_maskz_extracti32x4_epi32(0xF, vector, 0);
+        case 1:
+            return _mm512_maskz_extracti32x4_epi32(0xF, vector, 1);
+        case 2:
+            return _mm512_maskz_extracti32x4_epi32(0xF, vector, 2);
+        default:
+            return _mm512_maskz_extracti32x4_epi32(0xF, vector, 3);
+    }
+}
+
+OWN_VPCLMUL static inline auto own_load_vector(const uint8_t *src_ptr, bool is_be_bit_order) noexcept -> __m512i {
+    const __m512i data = _mm512_loadu_si512(src_ptr);
+
+    return is_be_bit_order
+           ? _mm512_shuffle_epi8(data, own_broadcast_lane(_mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13,
+                                                                       14, 15)))
+           : data;
+}
+
+OWN_VPCLMUL static inline auto own_fold_vector(__m512i vector, __m512i fold, __m512i data) noexcept -> __m512i {
+    return _mm512_ternarylogic_epi64(_mm512_clmulepi64_epi128(vector, fold, 0x00),
+                                     _mm512_clmulepi64_epi128(vector, fold, 0x11),
+                                     data,
+                                     0x96);
+}
+
+OWN_VPCLMUL static auto own_crc64_vpclmul(const qplc_crc64_context *context_ptr,
+                                          uint64_t crc,
+                                          const uint8_t *src_ptr,
+                                          uint32_t size) noexcept -> uint64_t {
+    const bool    is_be_bit_order = 0u != context_ptr->is_be_bit_order;
+    const __m512i fold_2048       = own_broadcast_lane(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(context_ptr->fold_2048)));
+    const __m512i fold_512        = own_broadcast_lane(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(context_ptr->fold_512)));
+    const __m128i fold_128        = _mm_loadu_si128(reinterpret_cast<const __m128i *>(context_ptr->fold_128));
+
+    __m512i vector   = own_load_vector(src_ptr, is_be_bit_order);
+    __m512i vector_1 = own_load_vector(src_ptr + 64u, is_be_bit_order);
+    __m512i vector_2 = own_load_vector(src_ptr + 128u, is_be_bit_order);
+    __m512i vector_3 = own_load_vector(src_ptr + 192u, is_be_bit_order);
+    uint32_t offset  = 256u;
+
+    vector = _mm512_xor_si512(vector, _mm512_zextsi128_si512(own_seed_lane(_mm_setzero_si128(), crc, is_be_bit_order)));
+
+    for (; offset + 256u <= size; offset += 256u) {
+        vector   = own_fold_vector(vector, fold_2048, own_load_vector(src_ptr + offset, is_be_bit_order));
+        vector_1 = own_fold_vector(vector_1, fold_2048, own_load_vector(src_ptr + offset + 64u, is_be_bit_order));
+        vector_2 = own_fold_vector(vector_2, fold_2048, own_load_vector(src_ptr + offset + 128u, is_be_bit_order));
+        vector_3 = own_fold_vector(vector_3, fold_2048, own_load_vector(src_ptr + offset + 192u, is_be_bit_order));
+    }
+
+    vector = own_fold_vector(vector, fold_512, vector_1);
+    vector = own_fold_vector(vector, fold_512, vector_2);
+    vector = own_fold_vector(vector, fold_512, vector_3);
+
+    for (; offset + 64u <= size; offset += 64u) {
+        vector = own_fold_vector(vector, fold_512, own_load_vector(src_ptr + offset, is_be_bit_order));
+    }
+
+    // The first lane holds the earliest data
+    __m128i lane = own_extract_lane(vector, 0);
+
+    lane = own_fold_lane(lane, fold_128, own_extract_lane(vector, 1));
+    lane = own_fold_lane(lane, fold_128, own_extract_lane(vector, 2));
+    lane = own_fold_lane(lane, fold_128, own_extract_lane(vector, 3));
+
+    return own_finish_lane(context_ptr, lane, src_ptr, offset, size);
+}
+
+/* ################# DISPATCHING ################# */
+
+static inline auto own_detect_isa() noexcept -> qplc_crc64_isa {
+    __builtin_cpu_init();
+
+    if (!__builtin_cpu_supports("pclmul") || !__builtin_cpu_supports("sse4.1")) {
+        return qplc_crc64_isa_scalar;
+    }
+
+    if (__builtin_cpu_supports("vpclmulqdq") && __builtin_cpu_supports("avx512f")
+        && __builtin_cpu_supports("avx512bw")) {
+        return qplc_crc64_isa_vpclmul;
+    }
+
+    return qplc_crc64_isa_pclmul;
+}
+
+static inline auto own_get_isa_state() noexcept -> std::atomic<uint32_t> & {
+    static std::atomic<uint32_t> isa = static_cast<uint32_t>(own_detect_isa());
+
+    return isa;
+}
+
+extern "C" {
+
+void qplc_crc64_init(qplc_crc64_context *context_ptr, uint64_t polynomial, uint32_t is_be_bit_order, uint32_t is_inverse) {
+    const uint64_t reflected = own_reflect(polynomial);
+
+    context_ptr->polynomial      = polynomial;
+    context_ptr->is_be_bit_order = (0u != is_be_bit_order) ? 1u : 0u;
+    context_ptr->is_inverse      = (0u != is_inverse) ? 1u : 0u;
+
+    for (uint32_t byte = 0u; byte < 256u; byte++) {
+        uint64_t crc = (0u != is_be_bit_order) ? (uint64_t) byte << 56u : byte;
+
+        for (uint32_t bit = 0u; bit < 8u; bit++) {
+            crc = (0u != is_be_bit_order)
+                  ? (crc << 1u) ^ (polynomial & (0u - (crc >> 63u)))
+                  : (crc >> 1u) ^ (reflected & (0u - (crc & 1u)));
+        }
+
+        context_ptr->table[byte] = crc;
+    }
+
+    own_init_fold(context_ptr->fold_2048, polynomial, 0u != is_be_bit_order, 2048u);
+    own_init_fold(context_ptr->fold_512, polynomial, 0u != is_be_bit_order, 512u);
+    own_init_fold(context_ptr->fold_128, polynomial, 0u != is_be_bit_order, 128u);
+
+    context_ptr->barrett[0] = (0u != is_be_bit_order) ? own_barrett_quotient(polynomial)
+                                                      : own_reflect(own_barrett_quotient(polynomial));
+    context_ptr->barrett[1] = (0u != is_be_bit_order) ? polynomial : reflected;
+}
+
+uint64_t qplc_crc64(const qplc_crc64_context *context_ptr, uint64_t seed, const uint8_t *src_ptr, uint32_t size) {
+    const uint64_t inversion = (0u != context_ptr->is_inverse) ? ~0ull : 0u;
+    const uint32_t isa       = own_get_isa_state().load(std::memory_order_relaxed);
+    uint64_t       crc       = seed ^ inversion;
+
+    if (size < OWN_FOLD_MIN_SIZE || qplc_crc64_isa_scalar == isa) {
+        crc = own_crc64_table(context_ptr, crc, src_ptr, size);
+    } else if (qplc_crc64_isa_vpclmul == isa && size >= OWN_VPCLMUL_MIN_SIZE) {
+        crc = own_crc64_vpclmul(context_ptr, crc, src_ptr, size);
+    } else {
+        crc = own_crc64_pclmul(context_ptr, crc, src_ptr, size);
+    }
+
+    return crc ^ inversion;
+}
+
+qplc_crc64_isa qplc_crc64_get_isa(void) {
+    return static_cast<qplc_crc64_isa>(own_get_isa_state().load(std::memory_order_relaxed));
+}
+
+void qplc_crc64_set_isa(qplc_crc64_isa isa) {
+    if (static_cast<uint32_t>(isa) <= static_cast<uint32_t>(own_detect_isa())) {
+        own_get_isa_state().store(static_cast<uint32_t>(isa), std::memory_order_relaxed);
+    }
+}
+
+}
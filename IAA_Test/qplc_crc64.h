@@ -0,0 +1,77 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+/*
+ *  Intel® Query Processing Library (Intel® QPL)
+ *  Core API (private C API)
+ */
+
+#ifndef QPL_QPLC_CRC64_H_
+#define QPL_QPLC_CRC64_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Instruction set the CRC64 kernel was dispatched to
+ */
+typedef enum {
+    qplc_crc64_isa_scalar   = 0u,    /**< Byte-wise table */
+    qplc_crc64_isa_pclmul   = 1u,    /**< PCLMULQDQ folding of 128-bit lanes */
+    qplc_crc64_isa_vpclmul  = 2u     /**< VPCLMULQDQ folding of 512-bit vectors, Intel® AVX-512 (F, BW) */
+} qplc_crc64_isa;
+
+/**
+ * @brief Tables and folding constants of one polynomial and bit order.
+ *
+ * @details The polynomial is given in the normal form without the x^64 term, as in the CRC64 descriptor.
+ * With the most significant bit first the CRC register holds the remainder as is, otherwise the register and
+ * the result are bit-reflected, the way the device reports them. A folding constant pair moves a 128-bit lane
+ * forward by the given distance: the low and high halves of the lane are multiplied by x^d and x^(d+64) modulo
+ * the polynomial, kept bit-reflected and shifted by one for the reflected order. The Barrett pair is kept
+ * bit-reflected for the reflected order as well.
+ */
+typedef struct {
+    uint64_t polynomial;          /**< Polynomial without the x^64 term */
+    uint32_t is_be_bit_order;     /**< Non-zero if data bits are processed most significant bit first */
+    uint32_t is_inverse;          /**< Non-zero if the CRC is inverted at the start and the end */
+    uint64_t fold_2048[2];        /**< Constants folding a lane by 2048 bits */
+    uint64_t fold_512[2];         /**< Constants folding a lane by 512 bits */
+    uint64_t fold_128[2];         /**< Constants folding a lane by 128 bits */
+    uint64_t barrett[2];          /**< Low 64 bits of floor(x^128 / polynomial) and the polynomial, reduce a lane */
+    uint64_t table[256];          /**< Byte-wise remainders in the register bit order */
+} qplc_crc64_context;
+
+/**
+ * @brief Prepares the context of a polynomial, takes a few microseconds and is meant to be done once
+ */
+void qplc_crc64_init(qplc_crc64_context *context_ptr, uint64_t polynomial, uint32_t is_be_bit_order, uint32_t is_inverse);
+
+/**
+ * @brief Computes CRC64 the way the device does
+ *
+ * @param seed CRC of the data preceding `src_ptr`, 0 to start a new computation
+ */
+uint64_t qplc_crc64(const qplc_crc64_context *context_ptr, uint64_t seed, const uint8_t *src_ptr, uint32_t size);
+
+/**
+ * @brief Returns instruction set selected for the running CPU
+ */
+qplc_crc64_isa qplc_crc64_get_isa(void);
+
+/**
+ * @brief Forces a narrower instruction set, a request wider than the CPU supports is ignored
+ */
+void qplc_crc64_set_isa(qplc_crc64_isa isa);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //QPL_QPLC_CRC64_H_
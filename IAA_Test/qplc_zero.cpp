@@ -0,0 +1,381 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+/*
+ *  Intel® Query Processing Library (Intel® QPL)
+ *  Core API (private C API)
+ */
+
+#include <immintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#include "qplc_zero.h"
+#include "hw_status.h"
+
+#define OWN_TAG_SIZE    4u          /**< Bytes of a block tag */
+
+using own_zero_kernel_t = uint32_t (*)(const uint8_t *, uint32_t, uint8_t *, uint32_t, uint32_t *);
+
+/* ################# SCALAR KERNELS ################# */
+
+template <class element_t>
+static auto own_compress_scalar(const uint8_t *src_ptr,
+                                uint32_t src_size,
+                                uint8_t *dst_ptr,
+                                uint32_t dst_size,
+                                uint32_t *output_size_ptr) -> uint32_t {
+    const uint32_t count   = src_size / sizeof(element_t);
+    uint32_t       out_pos = 0u;
+
+    for (uint32_t first = 0u; first < count; first += QPLC_ZERO_BLOCK_ELEMENTS) {
+        const uint32_t block_count = std::min(QPLC_ZERO_BLOCK_ELEMENTS, count - first);
+        const uint32_t tag_pos     = out_pos;
+        uint32_t       tag         = 0u;
+
+        if (out_pos + OWN_TAG_SIZE > dst_size) {
+            return AD_STATUS_OUTPUT_OVERFLOW;
+        }
+
+        out_pos += OWN_TAG_SIZE;
+
+        for (uint32_t idx = 0u; idx < block_count; idx++) {
+            element_t value;
+            memcpy(&value, src_ptr + (size_t) (first + idx) * sizeof(element_t), sizeof(value));
+
+            if (0u == value) {
+                continue;
+            }
+
+            if (out_pos + sizeof(element_t) > dst_size) {
+                return AD_STATUS_OUTPUT_OVERFLOW;
+            }
+
+            memcpy(dst_ptr + out_pos, &value, sizeof(value));
+            out_pos += sizeof(element_t);
+            tag |= 1u << idx;
+        }
+
+        memcpy(dst_ptr + tag_pos, &tag, sizeof(tag));
+    }
+
+    *output_size_ptr = out_pos;
+
+    return AD_STATUS_SUCCESS;
+}
+
+/**
+ * @brief Checks the next block of a compressed stream and returns the number of its elements that fit the output
+ *
+ * @return 0 with the status set if the block is invalid or doesn't fit
+ */
+template <class element_t>
+static inline auto own_next_block(const uint8_t *src_ptr,
+                                  uint32_t src_size,
+                                  uint32_t in_pos,
+                                  uint32_t dst_size,
+                                  uint32_t out_pos,
+                                  uint32_t &tag,
+                                  uint32_t &status) -> uint32_t {
+    if (in_pos + OWN_TAG_SIZE > src_size) {
+        status = AD_STATUS_INVALID_INPUT_SIZE;
+        return 0u;
+    }
+
+    memcpy(&tag, src_ptr + in_pos, sizeof(tag));
+
+    const uint32_t room        = (dst_size - out_pos) / sizeof(element_t);
+    const uint32_t block_count = std::min(QPLC_ZERO_BLOCK_ELEMENTS, room);
+
+    // The last block may be cut at the end of the output only where its elements are zero
+    if (0u == block_count || (block_count < QPLC_ZERO_BLOCK_ELEMENTS && 0u != (tag >> block_count))) {
+        status = AD_STATUS_OUTPUT_OVERFLOW;
+        return 0u;
+    }
+
+    if (in_pos + OWN_TAG_SIZE + (uint32_t) __builtin_popcount(tag) * sizeof(element_t) > src_size) {
+        status = AD_STATUS_INVALID_INPUT_SIZE;
+        return 0u;
+    }
+
+    return block_count;
+}
+
+template <class element_t>
+static auto own_decompress_scalar(const uint8_t *src_ptr,
+                                  uint32_t src_size,
+                                  uint8_t *dst_ptr,
+                                  uint32_t dst_size,
+                                  uint32_t *output_size_ptr) -> uint32_t {
+    uint32_t in_pos  = 0u;
+    uint32_t out_pos = 0u;
+
+    while (in_pos < src_size) {
+        uint32_t       tag         = 0u;
+        uint32_t       status      = AD_STATUS_SUCCESS;
+        const uint32_t block_count = own_next_block<element_t>(src_ptr, src_size, in_pos, dst_size, out_pos, tag, status);
+
+        if (0u == block_count) {
+            return status;
+        }
+
+        in_pos += OWN_TAG_SIZE;
+
+        for (uint32_t idx = 0u; idx < block_count; idx++) {
+            element_t value = 0u;
+
+            if (0u != ((tag >> idx) & 1u)) {
+                memcpy(&value, src_ptr + in_pos, sizeof(value));
+                in_pos += sizeof(element_t);
+            }
+
+            memcpy(dst_ptr + out_pos, &value, sizeof(value));
+            out_pos += sizeof(element_t);
+        }
+    }
+
+    *output_size_ptr = out_pos;
+
+    return AD_STATUS_SUCCESS;
+}
+
+/* ################# AVX-512 KERNELS ################# */
+
+#define OWN_AVX512 __attribute__((target("avx512f,avx512bw,avx512vbmi2,popcnt,bmi2")))
+
+OWN_AVX512 static inline auto own_mask(uint32_t count) -> uint32_t {
+    return _bzhi_u32(UINT32_MAX, count);
+}
+
+OWN_AVX512 static auto own_compress_32u_avx512(const uint8_t *src_ptr,
+                                               uint32_t src_size,
+                                               uint8_t *dst_ptr,
+                                               uint32_t dst_size,
+                                               uint32_t *output_size_ptr) -> uint32_t {
+    const uint32_t count   = src_size / sizeof(uint32_t);
+    uint32_t       out_pos = 0u;
+
+    for (uint32_t first = 0u; first < count; first += QPLC_ZERO_BLOCK_ELEMENTS) {
+        const uint32_t block_count = std::min(QPLC_ZERO_BLOCK_ELEMENTS, count - first);
+        const uint32_t load_mask   = own_mask(block_count);
+        const __m512i  low         = _mm512_maskz_loadu_epi32((__mmask16) load_mask, src_ptr + first * 4u);
+        const __m512i  high        = _mm512_maskz_loadu_epi32((__mmask16) (load_mask >> 16u), src_ptr + first * 4u + 64u);
+        const uint32_t low_tag     = _mm512_test_epi32_mask(low, low);
+        const uint32_t high_tag    = _mm512_test_epi32_mask(high, high);
+        const uint32_t low_count   = (uint32_t) _mm_popcnt_u32(low_tag);
+        const uint32_t high_count  = (uint32_t) _mm_popcnt_u32(high_tag);
+        const uint32_t tag         = low_tag | (high_tag << 16u);
+
+        if (out_pos + OWN_TAG_SIZE + (low_count + high_count) * 4u > dst_size) {
+            return AD_STATUS_OUTPUT_OVERFLOW;
+        }
+
+        memcpy(dst_ptr + out_pos, &tag, sizeof(tag));
+        out_pos += OWN_TAG_SIZE;
+
+        _mm512_mask_storeu_epi32(dst_ptr + out_pos,
+                                 (__mmask16) own_mask(low_count),
+                                 _mm512_maskz_compress_epi32((__mmask16) low_tag, low));
+        out_pos += low_count * 4u;
+
+        _mm512_mask_storeu_epi32(dst_ptr + out_pos,
+                                 (__mmask16) own_mask(high_count),
+                                 _mm512_maskz_compress_epi32((__mmask16) high_tag, high));
+        out_pos += high_count * 4u;
+    }
+
+    *output_size_ptr = out_pos;
+
+    return AD_STATUS_SUCCESS;
+}
+
+OWN_AVX512 static auto own_compress_16u_avx512(const uint8_t *src_ptr,
+                                               uint32_t src_size,
+                                               uint8_t *dst_ptr,
+                                               uint32_t dst_size,
+                                               uint32_t *output_size_ptr) -> uint32_t {
+    const uint32_t count   = src_size / sizeof(uint16_t);
+    uint32_t       out_pos = 0u;
+
+    for (uint32_t first = 0u; first < count; first += QPLC_ZERO_BLOCK_ELEMENTS) {
+        const uint32_t block_count = std::min(QPLC_ZERO_BLOCK_ELEMENTS, count - first);
+        const __m512i  values      = _mm512_maskz_loadu_epi16(own_mask(block_count), src_ptr + first * 2u);
+        const uint32_t tag         = _mm512_test_epi16_mask(values, values);
+        const uint32_t tag_count   = (uint32_t) _mm_popcnt_u32(tag);
+
+        if (out_pos + OWN_TAG_SIZE + tag_count * 2u > dst_size) {
+            return AD_STATUS_OUTPUT_OVERFLOW;
+        }
+
+        memcpy(dst_ptr + out_pos, &tag, sizeof(tag));
+        out_pos += OWN_TAG_SIZE;
+
+        _mm512_mask_storeu_epi16(dst_ptr + out_pos, own_mask(tag_count), _mm512_maskz_compress_epi16(tag, values));
+        out_pos += tag_count * 2u;
+    }
+
+    *output_size_ptr = out_pos;
+
+    return AD_STATUS_SUCCESS;
+}
+
+OWN_AVX512 static auto own_decompress_32u_avx512(const uint8_t *src_ptr,
+                                                 uint32_t src_size,
+                                                 uint8_t *dst_ptr,
+                                                 uint32_t dst_size,
+                                                 uint32_t *output_size_ptr) -> uint32_t {
+    uint32_t in_pos  = 0u;
+    uint32_t out_pos = 0u;
+
+    while (in_pos < src_size) {
+        uint32_t       tag         = 0u;
+        uint32_t       status      = AD_STATUS_SUCCESS;
+        const uint32_t block_count = own_next_block<uint32_t>(src_ptr, src_size, in_pos, dst_size, out_pos, tag, status);
+
+        if (0u == block_count) {
+            return status;
+        }
+
+        const uint32_t store_mask = own_mask(block_count);
+        const uint32_t low_count  = (uint32_t) _mm_popcnt_u32(tag & 0xFFFFu);
+        const uint32_t high_count = (uint32_t) _mm_popcnt_u32(tag >> 16u);
+        const uint8_t  *data_ptr  = src_ptr + in_pos + OWN_TAG_SIZE;
+        const __m512i  low        = _mm512_maskz_expand_epi32(
+                (__mmask16) tag, _mm512_maskz_loadu_epi32((__mmask16) own_mask(low_count), data_ptr));
+        const __m512i  high       = _mm512_maskz_expand_epi32(
+                (__mmask16) (tag >> 16u),
+                _mm512_maskz_loadu_epi32((__mmask16) own_mask(high_count), data_ptr + low_count * 4u));
+
+        _mm512_mask_storeu_epi32(dst_ptr + out_pos, (__mmask16) store_mask, low);
+        _mm512_mask_storeu_epi32(dst_ptr + out_pos + 64u, (__mmask16) (store_mask >> 16u), high);
+
+        in_pos  += OWN_TAG_SIZE + (low_count + high_count) * 4u;
+        out_pos += block_count * 4u;
+    }
+
+    *output_size_ptr = out_pos;
+
+    return AD_STATUS_SUCCESS;
+}
+
+OWN_AVX512 static auto own_decompress_16u_avx512(const uint8_t *src_ptr,
+                                                 uint32_t src_size,
+                                                 uint8_t *dst_ptr,
+                                                 uint32_t dst_size,
+                                                 uint32_t *output_size_ptr) -> uint32_t {
+    uint32_t in_pos  = 0u;
+    uint32_t out_pos = 0u;
+
+    while (in_pos < src_size) {
+        uint32_t       tag         = 0u;
+        uint32_t       status      = AD_STATUS_SUCCESS;
+        const uint32_t block_count = own_next_block<uint16_t>(src_ptr, src_size, in_pos, dst_size, out_pos, tag, status);
+
+        if (0u == block_count) {
+            return status;
+        }
+
+        const uint32_t tag_count = (uint32_t) _mm_popcnt_u32(tag);
+        const __m512i  values    = _mm512_maskz_expand_epi16(
+                tag, _mm512_maskz_loadu_epi16(own_mask(tag_count), src_ptr + in_pos + OWN_TAG_SIZE));
+
+        _mm512_mask_storeu_epi16(dst_ptr + out_pos, own_mask(block_count), values);
+
+        in_pos  += OWN_TAG_SIZE + tag_count * 2u;
+        out_pos += block_count * 2u;
+    }
+
+    *output_size_ptr = out_pos;
+
+    return AD_STATUS_SUCCESS;
+}
+
+/* ################# DISPATCHING ################# */
+
+/**
+ * @brief Kernels of one instruction set: compress 16u, compress 32u, decompress 16u, decompress 32u
+ */
+static constexpr own_zero_kernel_t own_kernels_table[][4] = {
+        {own_compress_scalar<uint16_t>, own_compress_scalar<uint32_t>,
+         own_decompress_scalar<uint16_t>, own_decompress_scalar<uint32_t>},
+        {own_compress_16u_avx512, own_compress_32u_avx512, own_decompress_16u_avx512, own_decompress_32u_avx512},
+};
+
+static inline auto own_detect_isa() noexcept -> qplc_zero_isa {
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+        && __builtin_cpu_supports("avx512vbmi2") && __builtin_cpu_supports("bmi2")) {
+        return qplc_zero_isa_avx512;
+    }
+
+    return qplc_zero_isa_scalar;
+}
+
+static inline auto own_get_isa_state() noexcept -> std::atomic<uint32_t> & {
+    static std::atomic<uint32_t> isa = static_cast<uint32_t>(own_detect_isa());
+
+    return isa;
+}
+
+static inline auto own_run(uint32_t kernel_idx,
+                           uint32_t element_width,
+                           const uint8_t *src_ptr,
+                           uint32_t src_size,
+                           uint8_t *dst_ptr,
+                           uint32_t dst_size,
+                           uint32_t *output_size_ptr) noexcept -> uint32_t {
+    const uint32_t element_size = element_width / 8u;
+
+    if ((16u != element_width && 32u != element_width) || 0u != src_size % element_size) {
+        return AD_STATUS_INVALID_INPUT_SIZE;
+    }
+
+    const auto kernel = own_kernels_table[own_get_isa_state().load(std::memory_order_relaxed)]
+                                         [kernel_idx + ((32u == element_width) ? 1u : 0u)];
+
+    return kernel(src_ptr, src_size, dst_ptr, dst_size, output_size_ptr);
+}
+
+extern "C" {
+
+uint32_t qplc_zero_compress(uint32_t element_width,
+                            const uint8_t *src_ptr,
+                            uint32_t src_size,
+                            uint8_t *dst_ptr,
+                            uint32_t dst_size,
+                            uint32_t *output_size_ptr) {
+    return own_run(0u, element_width, src_ptr, src_size, dst_ptr, dst_size, output_size_ptr);
+}
+
+uint32_t qplc_zero_decompress(uint32_t element_width,
+                              const uint8_t *src_ptr,
+                              uint32_t src_size,
+                              uint8_t *dst_ptr,
+                              uint32_t dst_size,
+                              uint32_t *output_size_ptr) {
+    return own_run(2u, element_width, src_ptr, src_size, dst_ptr, dst_size, output_size_ptr);
+}
+
+uint32_t qplc_zero_compress_bound(uint32_t element_width, uint32_t src_size) {
+    const uint32_t element_size = element_width / 8u;
+    const uint32_t block_size   = QPLC_ZERO_BLOCK_ELEMENTS * element_size;
+
+    return src_size + ((src_size + block_size - 1u) / block_size) * OWN_TAG_SIZE;
+}
+
+qplc_zero_isa qplc_zero_get_isa(void) {
+    return static_cast<qplc_zero_isa>(own_get_isa_state().load(std::memory_order_relaxed));
+}
+
+void qplc_zero_set_isa(qplc_zero_isa isa) {
+    if (static_cast<uint32_t>(isa) <= static_cast<uint32_t>(own_detect_isa())) {
+        own_get_isa_state().store(static_cast<uint32_t>(isa), std::memory_order_relaxed);
+    }
+}
+
+}
@@ -0,0 +1,84 @@
+/*******************************************************************************
+ * Copyright (C) 2022 Intel Corporation
+ *
+ * SPDX-License-Identifier: MIT
+ ******************************************************************************/
+
+/*
+ *  Intel® Query Processing Library (Intel® QPL)
+ *  Core API (private C API)
+ */
+
+#ifndef QPL_QPLC_ZERO_H_
+#define QPL_QPLC_ZERO_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define QPLC_ZERO_BLOCK_ELEMENTS    32u    /**< Elements one tag describes */
+
+/**
+ * @brief Instruction set the zero compression kernels were dispatched to
+ */
+typedef enum {
+    qplc_zero_isa_scalar  = 0u,    /**< Portable C++ */
+    qplc_zero_isa_avx512  = 1u     /**< Intel® AVX-512 (F, BW, VBMI2) */
+} qplc_zero_isa;
+
+/**
+ * @name Zero compression kernels
+ *
+ * @brief CPU implementations of the accelerator zero compress and zero decompress operations.
+ *
+ * @details The input is a sequence of 16-bit or 32-bit little-endian elements split into blocks of
+ * @ref QPLC_ZERO_BLOCK_ELEMENTS elements. Every block is written as a 32-bit tag, whose bit `i` is set if element
+ * `i` of the block is not zero, followed by the non-zero elements. The last block may be shorter. Decompression
+ * writes whole blocks, the last one is cut at the end of the destination if the elements past it are zero.
+ *
+ * Each function returns `AD_STATUS_SUCCESS`, `AD_STATUS_OUTPUT_OVERFLOW`, or `AD_STATUS_INVALID_INPUT_SIZE` for
+ * an input that is not a whole number of elements or ends inside a block, as the device would. The output size
+ * is written on success only.
+ *
+ * @param element_width 16 or 32
+ *
+ * @{
+ */
+uint32_t qplc_zero_compress(uint32_t element_width,
+                            const uint8_t *src_ptr,
+                            uint32_t src_size,
+                            uint8_t *dst_ptr,
+                            uint32_t dst_size,
+                            uint32_t *output_size_ptr);
+
+uint32_t qplc_zero_decompress(uint32_t element_width,
+                              const uint8_t *src_ptr,
+                              uint32_t src_size,
+                              uint8_t *dst_ptr,
+                              uint32_t dst_size,
+                              uint32_t *output_size_ptr);
+
+/**
+ * @brief Destination size that always holds the zero compressed input of the given size
+ */
+uint32_t qplc_zero_compress_bound(uint32_t element_width, uint32_t src_size);
+
+/**
+ * @brief Returns instruction set selected for the running CPU
+ */
+qplc_zero_isa qplc_zero_get_isa(void);
+
+/**
+ * @brief Forces a narrower instruction set, a request wider than the CPU supports is ignored
+ */
+void qplc_zero_set_isa(qplc_zero_isa isa);
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //QPL_QPLC_ZERO_H_